@@ -0,0 +1,206 @@
+/*
+================================================================================
+  API Server - Event-Driven HTTP Endpoints
+================================================================================
+
+  Implements the server declared in apiServer.h.
+
+  Handlers run in the AsyncTCP event task, never in the WiFi task, so a
+  request is answered while the WiFi task sleeps. This file must not
+  include WiFiManager.h (or webFunctions' WebServer): both libraries
+  define HTTP_GET and friends.
+
+================================================================================
+*/
+
+#define LOG_MODULE LogModule::NETWORK
+
+#include "apiServer.h"
+#include "glyphReader.h"
+#include "webFunctions.h"
+#include "wifiFunctions.h"
+#include "logFunctions.h"
+#include "memoryPolicy.h"
+#include "heapFunctions.h"
+#include "monitorFunctions.h"
+#include "mediaPrefetch.h"
+#include "fleetSync.h"
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include <memory>
+
+//=====================================
+// Route Table
+//=====================================
+
+const ApiRoute API_ROUTES[] = {
+  {"/status", apiStatusJson},
+  {"/memory", heapHeadroomJson},
+#ifdef TRACK_HEAP
+  {"/heap", heapReportJson},
+#endif
+#ifdef PREFETCH_MEDIA
+  {"/prefetch", prefetchStatsJson},
+#endif
+#ifdef MONITOR_TASKS
+  {"/tasks", taskReportJson},
+#endif
+#ifdef FLEET_SYNC
+  {"/fleet", fleetStatusJson},
+#endif
+};
+const size_t API_ROUTE_COUNT = sizeof(API_ROUTES) / sizeof(API_ROUTES[0]);
+
+//=====================================
+// Server State
+//=====================================
+
+static AsyncWebServer* apiServer = nullptr;
+static bool apiServerRunning = false;
+static std::atomic<uint8_t> requestsInFlight(0);
+static std::atomic<uint32_t> requestsServed(0);
+static std::atomic<uint32_t> requestsRejected(0);
+
+//=====================================
+// Request Helpers
+//=====================================
+
+/**
+ * Admit a request if under API_MAX_REQUESTS
+ * Admitted requests are counted until their connection closes.
+ * return false after answering 503 (the handler must return)
+ */
+static bool admitRequest(AsyncWebServerRequest* request) {
+  if (requestsInFlight.fetch_add(1) >= API_MAX_REQUESTS) {
+    requestsInFlight--;
+    requestsRejected++;
+    AsyncWebServerResponse* response = request->beginResponse(503, "text/plain", "Busy");
+    response->addHeader("Retry-After", "1");
+    request->send(response);
+    return false;
+  }
+  requestsServed++;
+  request->onDisconnect([]() { requestsInFlight--; });
+  return true;
+}
+
+/**
+ * Send a body chunked, at most API_CHUNK_SIZE bytes per write
+ * The body is kept alive by the filler until the last chunk is sent.
+ */
+static void sendChunked(AsyncWebServerRequest* request, const char* contentType, String body) {
+  std::shared_ptr<String> content = std::make_shared<String>(std::move(body));
+  request->send(request->beginChunkedResponse(contentType,
+    [content](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+      if (index >= content->length()) return 0;  // Done
+      size_t length = min(min(maxLen, (size_t)API_CHUNK_SIZE), content->length() - index);
+      memcpy(buffer, content->c_str() + index, length);
+      return length;
+    }));
+}
+
+/**
+ * Host part of the Host header (without a port)
+ */
+static String requestHost(AsyncWebServerRequest* request) {
+  String host = request->host();
+  int colon = host.indexOf(':');
+  if (colon >= 0) host = host.substring(0, colon);
+  if (host.length() == 0) host = WiFi.localIP().toString();
+  return host;
+}
+
+//=====================================
+// Handlers
+//=====================================
+
+/**
+ * Open the WiFiManager configuration pages and send the browser there
+ * The WiFi task opens them within a few milliseconds; the page retries
+ * after a second in case the redirect wins the race.
+ */
+static void handleConfig(AsyncWebServerRequest* request) {
+  if (!admitRequest(request)) return;
+  requestWebPortal();
+  String url = "http://" + requestHost(request) + ":" + String(WEB_PORTAL_PORT) + "/";
+  request->send(200, "text/html",
+    "<html><head><meta http-equiv=\"refresh\" content=\"1;url=" + url + "\"></head>"
+    "<body>Opening configuration portal... <a href=\"" + url + "\">" + url + "</a></body></html>");
+}
+
+/**
+ * Log levels; ?module=<name|all>&level=<off|always|debug> changes a level
+ */
+static void handleLog(AsyncWebServerRequest* request) {
+  if (!admitRequest(request)) return;
+  if (request->hasParam("module")) {
+    String level = request->hasParam("level") ? request->getParam("level")->value() : String();
+    if (!setLogLevelByName(request->getParam("module")->value(), level)) {
+      request->send(400, "text/plain", "Unknown module or level");
+      return;
+    }
+  }
+  sendChunked(request, "application/json", logStatusJson());
+}
+
+//=====================================
+// Server Control
+//=====================================
+
+void startApiServer() {
+  if (apiServerRunning) return;
+  HEAP_SCOPE(HeapTag::WEB);
+
+  if (apiServer == nullptr) {
+    // Routes are registered once; end()/begin() keep them
+    apiServer = new AsyncWebServer(API_PORT);
+    for (size_t i = 0; i < API_ROUTE_COUNT; i++) {
+      const ApiRoute* route = &API_ROUTES[i];
+      apiServer->on(route->path, HTTP_GET, [route](AsyncWebServerRequest* request) {
+        if (!admitRequest(request)) return;
+        sendChunked(request, "application/json", route->json());
+      });
+    }
+    apiServer->on("/log", HTTP_GET, handleLog);
+    apiServer->on("/config", HTTP_GET, handleConfig);
+    apiServer->on("/", HTTP_GET, handleConfig);
+    apiServer->onNotFound([](AsyncWebServerRequest* request) {
+      request->send(404, "text/plain", "Not found");
+    });
+  }
+
+  apiServer->begin();
+  apiServerRunning = true;
+  LOG_DEBUG("API server on port %d (%u routes)", API_PORT, (unsigned)API_ROUTE_COUNT + 2);
+}
+
+void stopApiServer() {
+  if (!apiServerRunning) return;
+  apiServer->end();
+  apiServerRunning = false;
+  LOG_DEBUG("API server stopped");
+}
+
+String apiStatusJson() {
+  JsonDocument doc(bulkJsonAllocator());
+
+  doc["link"] = wifiLinkStateName(getWiFiLinkState());
+  if (isWiFiConnected()) {
+    doc["ip"] = WiFi.localIP().toString();
+    doc["rssi"] = WiFi.RSSI();
+    doc["channel"] = WiFi.channel();
+  }
+  doc["mqtt"] = isMqttConnected();  // Never touch mqttClient off the WiFi task
+  doc["uptimeMs"] = millis();
+
+  JsonObject requests = doc["requests"].to<JsonObject>();
+  requests["inFlight"] = requestsInFlight.load();
+  requests["served"] = requestsServed.load();
+  requests["rejected"] = requestsRejected.load();
+  requests["limit"] = API_MAX_REQUESTS;
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
@@ -0,0 +1,87 @@
+/*
+================================================================================
+  API Server - Event-Driven HTTP Endpoints Header
+================================================================================
+
+  Serves the device's HTTP API from an event-driven server (AsyncTCP /
+  ESPAsyncWebServer) instead of the polled WiFiManager web server, so
+  requests are handled as they arrive rather than when the WiFi task next
+  wakes, and one slow client no longer holds up the others or MQTT.
+
+  Connections:
+    - AsyncTCP multiplexes every connection on one event task pinned to
+      core 0 (CONFIG_ASYNC_TCP_RUNNING_CORE in platformio.ini), so no
+      handler ever runs on the tracking core
+    - At most API_MAX_REQUESTS requests are in flight; more get 503 with
+      Retry-After instead of queueing behind the others
+    - JSON responses are streamed chunked, at most API_CHUNK_SIZE bytes
+      per write, so a large report never needs a matching TCP buffer
+
+  Ports:
+    - Station mode: this server owns port 80 (http://glyphreader.local).
+      The WiFiManager configuration pages open on demand on
+      WEB_PORTAL_PORT - "/" and "/config" open them and redirect there
+    - Setup AP: this server is stopped and WiFiManager's captive portal
+      takes port 80; the same JSON routes are bound on it by
+      bindPortalRoutes() (webFunctions.cpp)
+
+  Endpoints:
+    - /status   link state, IP, RSSI, MQTT and request counters
+    - /log      log levels (?module=&level= changes one)
+    - /memory   heap headroom (memoryPolicy.h)
+    - /heap, /prefetch, /tasks, /fleet with TRACK_HEAP, PREFETCH_MEDIA,
+      MONITOR_TASKS, FLEET_SYNC
+
+================================================================================
+*/
+
+#ifndef API_SERVER_H
+#define API_SERVER_H
+
+#include <Arduino.h>
+
+//=====================================
+// Configuration
+//=====================================
+
+#define API_PORT 80                     // Station-mode API port
+#define API_MAX_REQUESTS 6              // Requests in flight before answering 503
+#define API_CHUNK_SIZE 1024             // Largest chunk written per TCP send (bytes)
+
+//=====================================
+// Route Table
+//=====================================
+
+/**
+ * GET endpoint answered with a JSON report
+ * Shared by this server and the WiFiManager portal (bindPortalRoutes()).
+ */
+struct ApiRoute {
+  const char* path;         // URL path
+  String (*json)();         // Builds the response body
+};
+
+extern const ApiRoute API_ROUTES[];     ///< JSON endpoints (both servers)
+extern const size_t API_ROUTE_COUNT;    ///< Number of entries in API_ROUTES
+
+//=====================================
+// API Server Functions
+//=====================================
+
+/**
+ * Start the API server (no-op if running)
+ * Called by the WiFi link state machine when the station link comes up.
+ */
+void startApiServer();
+
+/**
+ * Stop the API server and free port 80 for the setup portal
+ */
+void stopApiServer();
+
+/**
+ * Link, MQTT and request statistics as JSON (the /status endpoint)
+ */
+String apiStatusJson();
+
+#endif // API_SERVER_H
@@ -24,19 +24,31 @@
     - Uses FreeRTOS task for audio playback
     - playSound() queues filename and returns immediately
     - Audio task handles file reading and I2S streaming
+    - With PREFETCH_MEDIA, prefetchSound() has the task open a sound and
+      buffer its first samples ahead of time; playing it then starts
+      without SD access
+    - With MEDIA_PARTITION, sounds not on the SD card are played from the
+      memory-mapped flash bundle (mediaBundle.h), written to I2S straight
+      from the mapping
   
 ================================================================================
 */
 
+#define LOG_MODULE LogModule::FEEDBACK
+
 #include "audioFunctions.h"
 #include "glyphReader.h"
 #include "sdFunctions.h"
 #include "preferenceFunctions.h"
+#include "heapFunctions.h"
+#include "memoryPolicy.h"
+#include "mediaBundle.h"
 #include <driver/i2s.h>
 #include <SD.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/queue.h>
+#include <atomic>
 
 //=====================================
 // I2S Configuration
@@ -66,6 +78,14 @@ static QueueHandle_t audioQueue = NULL;
 static bool playSound_internal(const char* filename);
 static void audioPlaybackTask(void* parameter);
 
+/**
+ * Request to the audio task
+ */
+struct AudioRequest {
+  bool prefetch;                          // Warm the file instead of playing it
+  char filename[AUDIO_FILENAME_LENGTH];   // Path on SD card
+};
+
 //=====================================
 // WAV File Header Structures
 //=====================================
@@ -121,29 +141,63 @@ static int16_t applyVolume(int16_t sample) {
   return (int16_t)((int32_t)sample * currentVolume / 100);
 }
 
+/**
+ * Check a WAV format chunk is one the player supports
+ * return true for 16-bit PCM, mono or stereo
+ */
+static bool isSupportedWav(const WAVFormat& wavFormat) {
+  // Validate format chunk
+  if (strncmp(wavFormat.fmt, "fmt ", 4) != 0) {
+    LOG_ALWAYS("Invalid WAV file - missing fmt chunk");
+    return false;
+  }
+  
+  // Check audio format
+  if (wavFormat.audioFormat != 1) {
+    LOG_ALWAYS("Unsupported audio format (must be PCM, got %d)", wavFormat.audioFormat);
+    return false;
+  }
+  
+  // Check bit depth
+  if (wavFormat.bitsPerSample != 16) {
+    LOG_ALWAYS("Unsupported bit depth (must be 16-bit, got %d-bit)", wavFormat.bitsPerSample);
+    return false;
+  }
+  
+  // Check channels
+  if (wavFormat.numChannels != 1 && wavFormat.numChannels != 2) {
+    LOG_ALWAYS("Unsupported channel count (must be 1 or 2, got %d)", wavFormat.numChannels);
+    return false;
+  }
+  
+  LOG_DEBUG("WAV Format:");
+  LOG_DEBUG("  Sample Rate: %d Hz", wavFormat.sampleRate);
+  LOG_DEBUG("  Channels: %d", wavFormat.numChannels);
+  LOG_DEBUG("  Bits/Sample: %d", wavFormat.bitsPerSample);
+  return true;
+}
+
 //=====================================
 // Audio Playback Implementation
 //=====================================
 
 /**
- * Internal blocking playback function
- * Called by audio task - does the actual file reading and I2S streaming
+ * Open a WAV file and position it at the start of the sample data
+ * Validates the RIFF/fmt headers (16-bit PCM, mono or stereo) and skips
+ * any chunks before "data".
+ * audioFile: Output, open file positioned at the first sample
+ * wavFormat: Output, format chunk
+ * dataSize: Output, sample data size in bytes
+ * return true if the file is playable (audioFile closed otherwise)
  */
-static bool playSound_internal(const char* filename) {
-  if (!audioInitialized) {
-    LOG_ALWAYS("Audio not initialized - call initAudio() first");
-    return false;
-  }
-  
+static bool openWav(const char* filename, File& audioFile, WAVFormat& wavFormat, uint32_t& dataSize) {
   if (!SD.exists(filename)) {
     LOG_ALWAYS("Audio file not found: %s", filename);
     return false;
   }
   
-  LOG_DEBUG("Playing sound: %s", filename);
-  
   // Open WAV file
-  File audioFile = SD.open(filename, FILE_READ);
+  audioFile = SD.open(filename, FILE_READ);
   if (!audioFile) {
     LOG_ALWAYS("Failed to open audio file: %s", filename);
     return false;
@@ -163,43 +217,13 @@ static bool playSound_internal(const char* filename) {
     return false;
   }
   
-  // Parse format chunk
-  WAVFormat wavFormat;
+  // Parse and validate format chunk
   audioFile.read((uint8_t*)&wavFormat, sizeof(WAVFormat));
-  
-  // Validate format chunk
-  if (strncmp(wavFormat.fmt, "fmt ", 4) != 0) {
-    LOG_ALWAYS("Invalid WAV file - missing fmt chunk");
-    audioFile.close();
-    return false;
-  }
-  
-  // Check audio format
-  if (wavFormat.audioFormat != 1) {
-    LOG_ALWAYS("Unsupported audio format (must be PCM, got %d)", wavFormat.audioFormat);
+  if (!isSupportedWav(wavFormat)) {
     audioFile.close();
     return false;
   }
   
-  // Check bit depth
-  if (wavFormat.bitsPerSample != 16) {
-    LOG_ALWAYS("Unsupported bit depth (must be 16-bit, got %d-bit)", wavFormat.bitsPerSample);
-    audioFile.close();
-    return false;
-  }
-  
-  // Check channels
-  if (wavFormat.numChannels != 1 && wavFormat.numChannels != 2) {
-    LOG_ALWAYS("Unsupported channel count (must be 1 or 2, got %d)", wavFormat.numChannels);
-    audioFile.close();
-    return false;
-  }
-  
-  LOG_DEBUG("WAV Format:");
-  LOG_DEBUG("  Sample Rate: %d Hz", wavFormat.sampleRate);
-  LOG_DEBUG("  Channels: %d", wavFormat.numChannels);
-  LOG_DEBUG("  Bits/Sample: %d", wavFormat.bitsPerSample);
-  
   // Skip any extra format bytes
   if (wavFormat.chunkSize > 16) {
     audioFile.seek(audioFile.position() + (wavFormat.chunkSize - 16));
@@ -228,7 +252,17 @@ static bool playSound_internal(const char* filename) {
   }
   
   LOG_DEBUG("  Data Size: %d bytes", wavData.dataSize);
-  
+  dataSize = wavData.dataSize;
+  return true;
+}
+
+/**
+ * Stream WAV sample data to I2S, then close the file
+ * prefix: Samples already read from the file (prefetched), played first
+ * prefixLength: Bytes in prefix (0 to read everything from the file)
+ */
+static void streamWav(File& audioFile, const WAVFormat& wavFormat, uint32_t dataSize,
+                      const uint8_t* prefix, size_t prefixLength) {
   //-----------------------------------
   // Configure I2S for this audio file
   //-----------------------------------
@@ -241,14 +275,23 @@ static bool playSound_internal(const char* filename) {
   //-----------------------------------
   
   isPlaying = true;
-  uint32_t bytesRemaining = wavData.dataSize;
+  uint32_t bytesRemaining = dataSize;
   uint8_t buffer[I2S_BUFFER_SIZE];
   size_t bytesWritten;
   
   while (bytesRemaining > 0 && isPlaying) {
-    // Read chunk from file
+    // Read chunk from the prefetched prefix, then from the file
     size_t bytesToRead = min(bytesRemaining, (uint32_t)I2S_BUFFER_SIZE);
-    size_t bytesRead = audioFile.read(buffer, bytesToRead);
+    size_t bytesRead;
+    if (prefixLength > 0) {
+      bytesToRead = min(bytesToRead, prefixLength);
+      memcpy(buffer, prefix, bytesToRead);
+      prefix += bytesToRead;
+      prefixLength -= bytesToRead;
+      bytesRead = bytesToRead;
+    } else {
+      bytesRead = audioFile.read(buffer, bytesToRead);
+    }
     
     if (bytesRead == 0) {
       break;  // End of file or read error
@@ -293,6 +336,209 @@ static bool playSound_internal(const char* filename) {
   // Close file
   audioFile.close();
   isPlaying = false;
+}
+
+#ifdef MEDIA_PARTITION
+//=====================================
+// Built-In (Flash) Sounds
+//=====================================
+
+/**
+ * Locate the sample data of a WAV in the mapped media bundle
+ * Same checks as openWav(), reading the headers in place.
+ * samples: Output, first sample in flash
+ * dataSize: Output, sample data size in bytes (clamped to the asset)
+ * return true if the sound is playable
+ */
+static bool parseMappedWav(const MediaAsset& asset, WAVFormat& wavFormat,
+                           const uint8_t*& samples, uint32_t& dataSize) {
+  if (asset.size < sizeof(WAVHeader) + sizeof(WAVFormat)) {
+    LOG_ALWAYS("Invalid WAV file - too small");
+    return false;
+  }
+  
+  const WAVHeader* wavHeader = (const WAVHeader*)asset.data;
+  if (strncmp(wavHeader->riff, "RIFF", 4) != 0 || strncmp(wavHeader->wave, "WAVE", 4) != 0) {
+    LOG_ALWAYS("Invalid WAV file - missing RIFF/WAVE header");
+    return false;
+  }
+  
+  memcpy(&wavFormat, asset.data + sizeof(WAVHeader), sizeof(WAVFormat));
+  if (!isSupportedWav(wavFormat)) {
+    return false;
+  }
+  
+  // Walk the chunks after the format chunk to "data"
+  uint32_t position = sizeof(WAVHeader) + 8 + wavFormat.chunkSize;
+  while (position + sizeof(WAVData) <= asset.size) {
+    WAVData wavData;
+    memcpy(&wavData, asset.data + position, sizeof(WAVData));
+    position += sizeof(WAVData);
+    
+    if (strncmp(wavData.data, "data", 4) == 0) {
+      samples = asset.data + position;
+      dataSize = min(wavData.dataSize, asset.size - position);
+      LOG_DEBUG("  Data Size: %d bytes", dataSize);
+      return true;
+    }
+    position += wavData.dataSize;
+  }
+  
+  LOG_ALWAYS("Invalid WAV file - no data chunk found");
+  return false;
+}
+
+/**
+ * Stream WAV samples from the mapped media bundle to I2S
+ * At full volume the mapping is handed to i2s_write() directly; otherwise
+ * each chunk is scaled in a stack buffer. The I2S channel format follows
+ * the file, so mono samples need no duplication.
+ */
+static void streamMappedWav(const WAVFormat& wavFormat, const uint8_t* samples, uint32_t dataSize) {
+  i2s_channel_t channelFormat = (wavFormat.numChannels == 2) ? I2S_CHANNEL_STEREO : I2S_CHANNEL_MONO;
+  i2s_set_clk(I2S_NUM, wavFormat.sampleRate, I2S_BITS_PER_SAMPLE_16BIT, channelFormat);
+  
+  isPlaying = true;
+  uint32_t position = 0;
+  uint8_t buffer[I2S_BUFFER_SIZE];
+  size_t bytesWritten;
+  
+  while (position < dataSize && isPlaying) {
+    size_t chunkSize = min(dataSize - position, (uint32_t)I2S_BUFFER_SIZE);
+    const uint8_t* chunk = samples + position;
+    
+    // Scaled samples can't be written back to flash
+    if (currentVolume != 100) {
+      memcpy(buffer, chunk, chunkSize);
+      int16_t* scaled = (int16_t*)buffer;
+      for (size_t i = 0; i < chunkSize / 2; i++) {
+        scaled[i] = applyVolume(scaled[i]);
+      }
+      chunk = buffer;
+    }
+    
+    i2s_write(I2S_NUM, chunk, chunkSize, &bytesWritten, portMAX_DELAY);
+    position += chunkSize;
+    
+    // Allow other tasks to run
+    yield();
+  }
+  
+  isPlaying = false;
+}
+
+/**
+ * Play a sound from the media bundle if it isn't overridden on SD card
+ * Called by audio task
+ * return true if the bundle had the sound (played or not playable)
+ */
+static bool playMappedSound(const char* filename) {
+  MediaAsset asset;
+  if (fileExists(filename) || !findMediaAsset(filename, asset)) {
+    return false;
+  }
+  
+  WAVFormat wavFormat;
+  const uint8_t* samples;
+  uint32_t dataSize;
+  if (parseMappedWav(asset, wavFormat, samples, dataSize)) {
+    streamMappedWav(wavFormat, samples, dataSize);
+    LOG_DEBUG("Sound playback complete (built-in)");
+  }
+  return true;
+}
+#endif
+
+#ifdef PREFETCH_MEDIA
+//=====================================
+// Prefetched (Warm) Sound
+//=====================================
+
+/**
+ * One sound held open with its header parsed and first samples buffered,
+ * so playback starts without touching the SD card. Only the audio task
+ * touches the file and buffer; warmReady/warmName are also read by
+ * isSoundWarm() on the loop task, which is also the only task that queues
+ * requests - the name can't change between its check and its playSound().
+ */
+static File warmFile;
+static WAVFormat warmFormat;
+static uint32_t warmDataSize = 0;
+static uint8_t* warmBuffer = nullptr;   // AUDIO_PREFETCH_BYTES, BULK, allocated on first use
+static size_t warmBytes = 0;
+static char warmName[AUDIO_FILENAME_LENGTH];
+static std::atomic<bool> warmReady(false);
+
+/**
+ * Drop the warm sound, closing its file
+ */
+static void releaseWarmSound() {
+  if (warmReady.exchange(false)) {
+    warmFile.close();
+  }
+}
+
+/**
+ * Open a sound and buffer its first AUDIO_PREFETCH_BYTES of samples
+ * Called by audio task
+ */
+static void warmSound_internal(const char* filename) {
+  if (warmReady.load() && strcmp(warmName, filename) == 0) return;  // Already warm
+#ifdef MEDIA_PARTITION
+  // Built-in sounds are already in mapped flash - nothing to warm
+  if (!fileExists(filename) && hasMediaAsset(filename)) return;
+#endif
+  releaseWarmSound();
+  
+  if (warmBuffer == nullptr) {
+    warmBuffer = policyNewArray<uint8_t>(AUDIO_PREFETCH_BYTES, AllocPolicy::BULK);
+    if (warmBuffer == nullptr) return;
+  }
+  if (!openWav(filename, warmFile, warmFormat, warmDataSize)) return;
+  warmBytes = warmFile.read(warmBuffer, min(warmDataSize, (uint32_t)AUDIO_PREFETCH_BYTES));
+  strncpy(warmName, filename, sizeof(warmName) - 1);
+  warmName[sizeof(warmName) - 1] = '\0';
+  warmReady.store(true);
+  LOG_DEBUG("Prefetched sound: %s (%d bytes)", filename, warmBytes);
+}
+#endif
+
+/**
+ * Internal blocking playback function
+ * Called by audio task - does the actual file reading and I2S streaming
+ */
+static bool playSound_internal(const char* filename) {
+  if (!audioInitialized) {
+    LOG_ALWAYS("Audio not initialized - call initAudio() first");
+    return false;
+  }
+  
+  LOG_DEBUG("Playing sound: %s", filename);
+  
+#ifdef PREFETCH_MEDIA
+  // Warm sound: already open and buffered, start streaming immediately
+  if (warmReady.load() && strcmp(warmName, filename) == 0) {
+    warmReady.store(false);
+    streamWav(warmFile, warmFormat, warmDataSize, warmBuffer, warmBytes);
+    LOG_DEBUG("Sound playback complete (prefetched)");
+    return true;
+  }
+#endif
+  
+#ifdef MEDIA_PARTITION
+  // Built-in sound, unless the SD card overrides it
+  if (playMappedSound(filename)) {
+    return true;
+  }
+#endif
+  
+  File audioFile;
+  WAVFormat wavFormat;
+  uint32_t dataSize;
+  if (!openWav(filename, audioFile, wavFormat, dataSize)) {
+    return false;
+  }
+  streamWav(audioFile, wavFormat, dataSize, nullptr, 0);
   
   LOG_DEBUG("Sound playback complete");
   return true;
@@ -303,13 +549,20 @@ static bool playSound_internal(const char* filename) {
  * Handles actual WAV file reading and I2S streaming
  */
 static void audioPlaybackTask(void* parameter) {
-  char filename[64];
+  AudioRequest request;
+  HEAP_TASK_TAG(HeapTag::AUDIO);
   
   while (true) {
-    // Wait for filename from queue
-    if (xQueueReceive(audioQueue, filename, portMAX_DELAY) == pdTRUE) {
+    // Wait for a request from the queue
+    if (xQueueReceive(audioQueue, &request, portMAX_DELAY) == pdTRUE) {
+#ifdef PREFETCH_MEDIA
+      if (request.prefetch) {
+        warmSound_internal(request.filename);
+        continue;
+      }
+#endif
       // Play the sound (blocking within this task only)
-      playSound_internal(filename);
+      playSound_internal(request.filename);
     }
   }
 }
@@ -365,8 +618,8 @@ bool initAudio() {
   // Set initial clock to avoid issues
   i2s_set_clk(I2S_NUM, 44100, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_STEREO);
   
-  // Create queue for audio filenames (holds up to 3 pending sounds)
-  audioQueue = xQueueCreate(3, sizeof(char) * 64);
+  // Create queue for audio requests (holds up to 3 pending sounds)
+  audioQueue = xQueueCreate(3, sizeof(AudioRequest));
   if (audioQueue == NULL) {
     LOG_ALWAYS("Failed to create audio queue");
     i2s_driver_uninstall(I2S_NUM);
@@ -432,13 +685,22 @@ bool playSound(const char* filename) {
     return false;
   }
   
-  if (!SD.exists(filename)) {
+  // A prefetched sound is known to exist - skip the SD lookup
+  bool found = isSoundWarm(filename) || SD.exists(filename);
+#ifdef MEDIA_PARTITION
+  found = found || hasMediaAsset(filename);
+#endif
+  if (!found) {
     LOG_DEBUG("Audio file not found: %s", filename);
     return false;
   }
   
   // Queue the filename for playback
-  if (xQueueSend(audioQueue, filename, 0) == pdTRUE) {
+  AudioRequest request;
+  request.prefetch = false;
+  strncpy(request.filename, filename, sizeof(request.filename) - 1);
+  request.filename[sizeof(request.filename) - 1] = '\0';
+  if (xQueueSend(audioQueue, &request, 0) == pdTRUE) {
     LOG_DEBUG("Queued sound: %s", filename);
     return true;
   } else {
@@ -447,6 +709,35 @@ bool playSound(const char* filename) {
   }
 }
 
+/**
+ * Queue a sound to be opened and buffered ahead of playback
+ */
+bool prefetchSound(const char* filename) {
+#ifdef PREFETCH_MEDIA
+  if (!SOUND_ENABLED || !audioInitialized) return false;
+  if (isSoundWarm(filename)) return true;
+  
+  AudioRequest request;
+  request.prefetch = true;
+  strncpy(request.filename, filename, sizeof(request.filename) - 1);
+  request.filename[sizeof(request.filename) - 1] = '\0';
+  return xQueueSend(audioQueue, &request, 0) == pdTRUE;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Check whether a sound is prefetched
+ */
+bool isSoundWarm(const char* filename) {
+#ifdef PREFETCH_MEDIA
+  return warmReady.load() && strcmp(warmName, filename) == 0;
+#else
+  return false;
+#endif
+}
+
 /**
  * Stop current audio playback
  */
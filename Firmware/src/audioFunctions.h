@@ -44,6 +44,8 @@
 //=====================================
 
 #define I2S_BUFFER_SIZE 512   // Buffer size for I2S DMA (bytes)
+#define AUDIO_FILENAME_LENGTH 64    // Longest queued path, including terminator
+#define AUDIO_PREFETCH_BYTES 4096   // Samples buffered for a prefetched sound (-D PREFETCH_MEDIA)
 
 //=====================================
 // Audio Functions
@@ -62,6 +64,9 @@ bool initAudio();
  * Queues audio file for playback in background task. File must be in WAV format
  * with PCM encoding, 16-bit samples, mono or stereo.
  * 
+ * With MEDIA_PARTITION, a built-in sound (mediaBundle.h) is played from
+ * flash when the SD card has no file at the path.
+ * 
  * filename: Path to WAV file on SD card (e.g., "/sounds/spell.wav")
  * return true if playback queued successfully, false on error
  * 
@@ -69,6 +74,25 @@ bool initAudio();
  */
 bool playSound(const char* filename);
 
+/**
+ * Open and buffer a sound ahead of playback (-D PREFETCH_MEDIA)
+ * The audio task parses the header and reads the first
+ * AUDIO_PREFETCH_BYTES of samples, keeping the file open; a later
+ * playSound() of the same file starts streaming without SD access.
+ * One sound is kept warm at a time - prefetching another replaces it.
+ * filename: Path to WAV file on SD card
+ * return true if queued (or already warm), false if sound is disabled
+ *        or the build has no prefetch
+ */
+bool prefetchSound(const char* filename);
+
+/**
+ * Check whether a sound is currently prefetched
+ * filename: Path to WAV file on SD card
+ * return true if playSound(filename) would start from the warm buffer
+ */
+bool isSoundWarm(const char* filename);
+
 /**
  * Stop current audio playback
  * Stops I2S playback immediately and releases resources.
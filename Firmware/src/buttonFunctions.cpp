@@ -21,6 +21,10 @@
         - Double click: Enter settings mode
         - Long press: Exit settings mode
   
+  Input Path (see buttonFunctions.h):
+    GPIO interrupt -> button task (Button2 decode) -> event queue ->
+    UI task (handlers, under the UI lock shared with loop())
+  
   Settings Menu Indices:
     0 - Nightlight ON Spell
     1 - Nightlight OFF Spell
@@ -40,6 +44,11 @@
 #include "screenFunctions.h"
 #include "spell_patterns.h"
 #include "customSpellFunctions.h"
+#include "spellActions.h"
+#include "heapFunctions.h"
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <atomic>
 
 //=====================================
 // Forward Declarations
@@ -52,30 +61,175 @@ int getCurrentColorIndex();
 Button2 button1;  // Primary action button (GPIO 11)
 Button2 button2;  // Navigation button (GPIO 33)
 
+//=====================================
+// Button Task State
+//=====================================
+static TaskHandle_t buttonTaskHandle = NULL;   // Decodes presses (woken by the pin interrupts)
+static TaskHandle_t uiTaskHandle = NULL;       // Runs the handlers
+static QueueHandle_t buttonQueue = NULL;       // ButtonEvents, button task -> UI task
+static SemaphoreHandle_t uiLock = NULL;        // Screen, LEDs and menu state (UI task vs loop)
+static std::atomic<bool> uiWanted(false);      // UI task is waiting for the lock - loop() backs off
+
+//=====================================
+// Button Input
+//=====================================
+
+/**
+ * Pin interrupt (either edge, either button): wake the button task
+ */
+static void IRAM_ATTR buttonEdgeISR() {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(buttonTaskHandle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * Queue an event for the UI task
+ * Called from the Button2 callbacks, on the button task. A full queue
+ * drops the event rather than stalling the decoding.
+ */
+static void postButtonEvent(Button2& btn, ButtonEventType type) {
+    ButtonEvent event = {(uint8_t)btn.getPin(), type, btn.getNumberOfClicks()};
+    if (xQueueSend(buttonQueue, &event, 0) != pdTRUE) {
+        LOG_DEBUG("Button event queue full - event dropped");
+    }
+}
+
+static void postClick(Button2& btn) { postButtonEvent(btn, ButtonEventType::CLICK); }
+static void postDoubleClick(Button2& btn) { postButtonEvent(btn, ButtonEventType::DOUBLE_CLICK); }
+static void postTripleClick(Button2& btn) { postButtonEvent(btn, ButtonEventType::TRIPLE_CLICK); }
+static void postLongDetected(Button2& btn) { postButtonEvent(btn, ButtonEventType::LONG_DETECTED); }
+static void postLongClick(Button2& btn) { postButtonEvent(btn, ButtonEventType::LONG_CLICK); }
+
+/**
+ * Button task: sleeps until a pin edge, then runs Button2 every
+ * BUTTON_POLL_MS until both buttons are released and settled
+ */
+static void buttonTask(void* parameter) {
+    LOG_DEBUG("Button task started on Core %d", xPortGetCoreID());
+    uint32_t lastEdge = 0;
+    bool active = false;
+
+    while (true) {
+        if (ulTaskNotifyTake(pdTRUE, active ? pdMS_TO_TICKS(BUTTON_POLL_MS) : portMAX_DELAY) > 0) {
+            lastEdge = millis();
+        }
+        button1.loop();
+        button2.loop();
+        active = button1.isPressed() || button2.isPressed() || millis() - lastEdge < BUTTON_SETTLE_MS;
+    }
+}
+
+//=====================================
+// Event Handling
+//=====================================
+
+/**
+ * Run the handler for one event
+ */
+static void handleButtonEvent(const ButtonEvent& event) {
+    switch (event.type) {
+        case ButtonEventType::CLICK:         click(event); break;
+        case ButtonEventType::DOUBLE_CLICK:  doubleClick(event); break;
+        case ButtonEventType::TRIPLE_CLICK:  tripleClick(event); break;
+        case ButtonEventType::LONG_DETECTED: longClickDetected(event); break;
+        case ButtonEventType::LONG_CLICK:    longClick(event); break;
+    }
+}
+
+/**
+ * Take the UI lock from the UI task
+ * loop() gives it back after each UI section but would take it again
+ * within microseconds, so lockUi() holds off while we are waiting.
+ */
+static void takeUiLock() {
+    uiWanted = true;
+    xSemaphoreTake(uiLock, portMAX_DELAY);
+    uiWanted = false;
+}
+
+/**
+ * UI task: runs each queued event's handler under the UI lock
+ */
+static void uiTask(void* parameter) {
+    LOG_DEBUG("UI task started on Core %d", xPortGetCoreID());
+    HEAP_TASK_TAG(HeapTag::DISPLAY);
+
+    ButtonEvent event;
+    while (true) {
+        if (xQueueReceive(buttonQueue, &event, portMAX_DELAY) != pdTRUE) continue;
+        takeUiLock();
+        handleButtonEvent(event);
+        xSemaphoreGive(uiLock);
+    }
+}
+
+//=====================================
+// UI Lock
+//=====================================
+
+void lockUi() {
+    if (uiLock == NULL) return;  // Before buttonInit(): no UI task yet
+    while (uiWanted) {
+        vTaskDelay(1);  // A handler is waiting - let it in first
+    }
+    xSemaphoreTake(uiLock, portMAX_DELAY);
+}
+
+void unlockUi() {
+    if (uiLock != NULL) xSemaphoreGive(uiLock);
+}
+
+/**
+ * Save the recorded spell with the UI lock released
+ * The SD write takes a while, and loop() keeps driving the screen and
+ * LEDs meanwhile; the library reload it requests runs on the loop task.
+ * The caller turns the camera off first (settings mode).
+ * UI task only.
+ * return true if saved
+ */
+static bool saveSpellUnlocked() {
+    xSemaphoreGive(uiLock);
+    bool saved = saveRecordedSpell();
+    takeUiLock();
+    return saved;
+}
+
+void uiPause(uint32_t ms) {
+    xSemaphoreGive(uiLock);
+    vTaskDelay(pdMS_TO_TICKS(ms));
+    takeUiLock();
+}
+
 //=====================================
 // Button Initialization
 //=====================================
 
 /**
- * Initialize button hardware and event handlers
+ * Initialize button hardware, event handlers and tasks
  * 
  * Configures both buttons with appropriate timing and registers
- * callbacks for all click types: single, double, triple, and long-press.
+ * callbacks that queue all click types: single, double, triple, and
+ * long-press. Pin interrupts wake the button task; the UI task runs
+ * the handlers.
  */
 void buttonInit() {
     LOG_DEBUG("Initializing buttons...");
 
+    buttonQueue = xQueueCreate(BUTTON_QUEUE_LENGTH, sizeof(ButtonEvent));
+    uiLock = xSemaphoreCreateMutex();
+
     //--- Button 1: Primary Action Button ---
     button1.begin(BUTTON_1_PIN);
     button1.setLongClickTime(1000);    // 1 second threshold for long-press
     button1.setDoubleClickTime(500);   // 500ms window for double-click detection
 
     // Register event handlers
-    button1.setClickHandler(click);
-    button1.setDoubleClickHandler(doubleClick);
-    button1.setTripleClickHandler(tripleClick);
-    button1.setLongClickDetectedHandler(longClickDetected);
-    button1.setLongClickHandler(longClick);
+    button1.setClickHandler(postClick);
+    button1.setDoubleClickHandler(postDoubleClick);
+    button1.setTripleClickHandler(postTripleClick);
+    button1.setLongClickDetectedHandler(postLongDetected);
+    button1.setLongClickHandler(postLongClick);
     button1.setLongClickDetectedRetriggerable(false);  // Fire once per long-press
 
     //--- Button 2: Navigation Button ---
@@ -83,33 +237,73 @@ void buttonInit() {
     button2.setLongClickTime(1000);    // 1 second threshold for long-press
     button2.setDoubleClickTime(500);   // 500ms window for double-click detection
 
-    // Register event handlers (same functions, differentiated by pin)
-    button2.setClickHandler(click);
-    button2.setDoubleClickHandler(doubleClick);
-    button2.setTripleClickHandler(tripleClick);
-    button2.setLongClickDetectedHandler(longClickDetected);
-    button2.setLongClickHandler(longClick);
+    // Register event handlers (same functions, differentiated by pin in the event)
+    button2.setClickHandler(postClick);
+    button2.setDoubleClickHandler(postDoubleClick);
+    button2.setTripleClickHandler(postTripleClick);
+    button2.setLongClickDetectedHandler(postLongDetected);
+    button2.setLongClickHandler(postLongClick);
     button2.setLongClickDetectedRetriggerable(false);  // Fire once per long-press
 
+    //--- Tasks and interrupts ---
+    xTaskCreatePinnedToCore(
+        uiTask,             // Task function
+        "UiTask",           // Task name
+        UI_TASK_STACK,      // Stack size
+        NULL,               // Parameters
+        1,                  // Priority (same as the WiFi task)
+        &uiTaskHandle,      // Task handle
+        0                   // Core 0, off the tracking core
+    );
+    xTaskCreatePinnedToCore(
+        buttonTask,         // Task function
+        "ButtonTask",       // Task name
+        BUTTON_TASK_STACK,  // Stack size
+        NULL,               // Parameters
+        3,                  // Priority (above the UI task, so clicks are timed while a handler runs)
+        &buttonTaskHandle,  // Task handle
+        0                   // Core 0
+    );
+    attachInterrupt(digitalPinToInterrupt(BUTTON_1_PIN), buttonEdgeISR, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(BUTTON_2_PIN), buttonEdgeISR, CHANGE);
+
     LOG_DEBUG("Buttons initialized.");
 }
 
-void click(Button2& btn) {
-    //LOG_DEBUG("Button %d: Click detected", btn.getPin());
+/**
+ * Leave spell recording and return to the settings menu
+ * 
+ * The camera goes off (settings mode) before the save, and stays off
+ * while the saved message shows; both the save and the wait release the
+ * UI lock so the loop keeps running.
+ * 
+ * param save: Whether to save the kept takes (shows the confirmation)
+ */
+static void finishSpellRecording(bool save) {
+    inSettingsMode = true;
+    bool saved = save && saveSpellUnlocked();
+    spellRecordingState = SPELL_RECORD_COMPLETE;
+    exitSpellRecordingMode();
+    if (saved) {
+        displayMessage("Spell Saved!", 0x07E0);  // Green
+        uiPause(1500);
+    }
+    enterSettingsMode();  // Return to settings
+}
+
+void click(const ButtonEvent& event) {
+    //LOG_DEBUG("Button %d: Click detected", event.pin);
     // switch case depending on which button is pressed
-    switch (btn.getPin()) {
+    switch (event.pin) {
         case BUTTON_1_PIN:
             // Handle button 1 click
             if (spellRecordingState == SPELL_RECORD_PREVIEW) {
-                // In spell recording preview - save the spell
-                if (saveRecordedSpell()) {
-                    // Show success message
-                    displayMessage("Spell Saved!", 0x07E0);  // Green
-                    delay(1500);
+                // In spell recording preview - keep the take, then record
+                // the next one until all takes are in
+                if (!keepRecordedTake()) {
+                    return;
                 }
-                spellRecordingState = SPELL_RECORD_COMPLETE;
-                exitSpellRecordingMode();
-                enterSettingsMode();  // Return to settings
+                finishSpellRecording(true);
                 return;
             }
             
@@ -160,10 +354,9 @@ void click(Button2& btn) {
         case BUTTON_2_PIN:
             // Check if in spell recording preview mode
             if (spellRecordingState == SPELL_RECORD_PREVIEW) {
-                // In spell recording preview - discard and return to settings
-                spellRecordingState = SPELL_RECORD_COMPLETE;
-                exitSpellRecordingMode();
-                enterSettingsMode();
+                // In spell recording preview - discard this take, save any
+                // takes already kept, and return to settings
+                finishSpellRecording(!recordedSpellTakes.empty());
                 return;
             }
             
@@ -210,10 +403,10 @@ void click(Button2& btn) {
  * Button 1: Currently unused (reserved)
  * Button 2: Enter settings menu mode (only from normal mode)
  * 
- * param btn: Reference to the Button2 object that was double-clicked
+ * param event: Double-click event
  */
-void doubleClick(Button2& btn) {
-    switch (btn.getPin()) {
+void doubleClick(const ButtonEvent& event) {
+    switch (event.pin) {
         case BUTTON_1_PIN:
             LOG_DEBUG("Button 1 double clicked");
             // Reserved for future use
@@ -239,16 +432,16 @@ void doubleClick(Button2& btn) {
  * Currently logs the event but takes no action.
  * Reserved for future advanced features.
  * 
- * param btn Reference to the Button2 object that was multi-clicked
+ * param event: Multi-click event (clicks = number of clicks)
  */
-void tripleClick(Button2& btn) {
-    switch (btn.getPin()) {
+void tripleClick(const ButtonEvent& event) {
+    switch (event.pin) {
         case BUTTON_1_PIN:
-            LOG_DEBUG("Button 1 multiple click: ", btn.getNumberOfClicks());
+            LOG_DEBUG("Button 1 multiple click: %d", event.clicks);
             // Reserved for future use
             break;
         case BUTTON_2_PIN:
-            LOG_DEBUG("Button 2 multiple click: ", btn.getNumberOfClicks());
+            LOG_DEBUG("Button 2 multiple click: %d", event.clicks);
             // Reserved for future use
             break;
         default:
@@ -266,10 +459,10 @@ void tripleClick(Button2& btn) {
  * Button 1: Currently unused (reserved)
  * Button 2: Exit settings mode immediately (for responsive UX)
  * 
- * param btn: Reference to the Button2 object being long-pressed
+ * param event: Long-press event
  */
-void longClickDetected(Button2& btn) {
-    switch (btn.getPin()) {
+void longClickDetected(const ButtonEvent& event) {
+    switch (event.pin) {
         case BUTTON_1_PIN:
             LOG_DEBUG("Button 1 long click detected");
             // Reserved for future use
@@ -294,10 +487,10 @@ void longClickDetected(Button2& btn) {
  * long-press threshold. Most long-press actions happen in longClickDetected()
  * for immediate feedback; this handler is for post-release cleanup if needed.
  * 
- * param btn: Reference to the Button2 object that was long-pressed
+ * param event: Long-press release event
  */
-void longClick(Button2& btn) {
-    switch (btn.getPin()) {
+void longClick(const ButtonEvent& event) {
+    switch (event.pin) {
         case BUTTON_1_PIN:
             LOG_DEBUG("Button 1 long click executed");
             // Reserved for future use
@@ -520,4 +713,5 @@ void saveSettingValue(int settingIndex, int valueIndex) {
             LOG_DEBUG("Invalid setting index: %d", settingIndex);
             break;
     }
+    invalidateSpellActions();  // Recompile nightlight roles before the next cast
 }
\ No newline at end of file
@@ -17,18 +17,32 @@
     - Triple-click detection
     - Long-press detection
   
+  Input Path:
+    - A GPIO interrupt on either pin wakes the button task (core 0),
+      which runs Button2's debounce and click counting only while a
+      button is pressed or a multi-click/long-press window is open -
+      nothing is polled from loop() and nothing runs while idle
+    - Detected clicks, double/triple clicks and long presses are posted
+      as ButtonEvents to a queue
+    - The UI task (core 0) takes each event and runs its handler holding
+      the UI lock; loop() takes the same lock only around the parts that
+      drive the screen, LEDs and menu state (its LED/timeout sections and
+      the camera state machine), so they are never driven from both tasks
+      at once
+    - The camera is sampled outside the lock, so a handler delays tracking
+      feedback by at most its own screen/LED work - never a camera read
+    - Handlers wait with uiPause(), which lets the loop run meanwhile;
+      the spell save (SD write) runs with the lock
+      released and the camera off
+  
   Functions:
-    - buttonInit(): Initialize Button2 library and attach handlers
+    - buttonInit(): Initialize Button2 library, interrupts and tasks
     - click(): Single click event handler
     - doubleClick(): Double-click event handler
     - tripleClick(): Triple-click event handler
     - longClickDetected(): Long-press start event handler
     - longClick(): Long-press release event handler
   
-  Note: Button functionality is reserved for future features.
-        Pin definitions exist in glyphReader.h but buttons are not
-        currently polled or used in main application loop.
-  
 ================================================================================
 */
 
@@ -37,6 +51,40 @@
 
 #include "Button2.h"
 
+//=====================================
+// Button Task Configuration
+//=====================================
+
+#define BUTTON_POLL_MS 5                // Button2 update interval while a button is active
+#define BUTTON_SETTLE_MS 700            // Keep updating this long after the last edge (double-click window + debounce)
+#define BUTTON_QUEUE_LENGTH 8           // Events waiting for the UI task
+#define BUTTON_TASK_STACK 2048          // Button (decode) task stack (bytes)
+#define UI_TASK_STACK 8192              // UI (handler) task stack (bytes) - spell saves parse spells.json
+
+//=====================================
+// Button Events
+//=====================================
+
+/**
+ * Kind of button event
+ */
+enum class ButtonEventType : uint8_t {
+  CLICK,
+  DOUBLE_CLICK,
+  TRIPLE_CLICK,     // Three or more clicks
+  LONG_DETECTED,    // Held past the long-press time (still down)
+  LONG_CLICK        // Released after a long press
+};
+
+/**
+ * One decoded button event, queued for the UI task
+ */
+struct ButtonEvent {
+  uint8_t pin;              // BUTTON_1_PIN or BUTTON_2_PIN
+  ButtonEventType type;
+  uint8_t clicks;           // Clicks counted (multi-clicks)
+};
+
 //=====================================
 // Global Button Objects
 //=====================================
@@ -52,15 +100,53 @@ extern Button2 button2;
 //=====================================
 
 /**
- * @brief Initialize button objects and attach event handlers
+ * @brief Initialize buttons, their interrupts and the button/UI tasks
  * 
- * Configures Button2 library for both buttons and registers callbacks
- * for click, double-click, triple-click, and long-press events.
- * 
- * Note: Currently not called from main application.
+ * Configures Button2 library for both buttons, registers callbacks
+ * that queue click, double-click, triple-click, and long-press events,
+ * and starts the tasks that decode and handle them.
  */
 void buttonInit();
 
+//=====================================
+// UI Lock
+//=====================================
+
+/**
+ * @brief Take the UI lock, waiting for a running button handler
+ * 
+ * For loop() code that drives the screen, LEDs or menu state. A handler
+ * waiting for the lock goes first. Never call from the UI task (the
+ * handlers already hold it).
+ */
+void lockUi();
+
+/**
+ * @brief Release the UI lock
+ */
+void unlockUi();
+
+/**
+ * @brief Holds the UI lock until end of scope (see lockUi())
+ */
+class UiLockScope {
+public:
+    UiLockScope() { lockUi(); }
+    ~UiLockScope() { unlockUi(); }
+    UiLockScope(const UiLockScope&) = delete;
+    UiLockScope& operator=(const UiLockScope&) = delete;
+};
+
+/**
+ * @brief Wait inside a button handler without holding up loop()
+ * 
+ * Releases the UI lock for the wait and takes it back after. Only for
+ * code running on the UI task (handlers and what they call).
+ * 
+ * @param ms Milliseconds to wait
+ */
+void uiPause(uint32_t ms);
+
 //=====================================
 // Event Handlers
 //=====================================
@@ -69,28 +155,31 @@ void buttonInit();
  * @brief Single click event handler
  * 
  * Called when button is pressed and released once.
+ * Runs on the UI task.
  * 
- * @param btn Reference to Button2 object that triggered event
+ * @param event Event with the pin of the button that triggered it
  */
-void click(Button2& btn);
+void click(const ButtonEvent& event);
 
 /**
  * @brief Double-click event handler
  * 
  * Called when button is clicked twice in rapid succession.
+ * Runs on the UI task.
  * 
- * @param btn Reference to Button2 object that triggered event
+ * @param event Event with the pin of the button that triggered it
  */
-void doubleClick(Button2& btn);
+void doubleClick(const ButtonEvent& event);
 
 /**
  * @brief Triple-click event handler
  * 
  * Called when button is clicked three times in rapid succession.
+ * Runs on the UI task.
  * 
- * @param btn Reference to Button2 object that triggered event
+ * @param event Event with the pin of the button that triggered it
  */
-void tripleClick(Button2& btn);
+void tripleClick(const ButtonEvent& event);
 
 //=====================================
 // Settings Management Functions
@@ -149,19 +238,20 @@ void saveSettingValue(int settingIndex, int valueIndex);
  * @brief Long-press start event handler
  * 
  * Called when button is held down for long-press threshold duration.
- * Fires once at the beginning of long-press.
+ * Fires once at the beginning of long-press. Runs on the UI task.
  * 
- * @param btn Reference to Button2 object that triggered event
+ * @param event Event with the pin of the button that triggered it
  */
-void longClickDetected(Button2& btn);
+void longClickDetected(const ButtonEvent& event);
 
 /**
  * @brief Long-press release event handler
  * 
  * Called when button is released after being held for long-press.
+ * Runs on the UI task.
  * 
- * @param btn Reference to Button2 object that triggered event
+ * @param event Event with the pin of the button that triggered it
  */
-void longClick(Button2& btn);
+void longClick(const ButtonEvent& event);
 
 #endif // BUTTON_FUNCTIONS_H
\ No newline at end of file
@@ -18,8 +18,16 @@
     
     RECORDING: Actively recording gesture (blue LED)
       → Collecting trajectory points until IR lost or timeout
+      → Points pass through a predictive tracker (motionFilter.h) that
+        rejects off-path blobs, bridges short dropouts and smooths jitter
       → Triggers spell matching when IR lost
       → WAITING_FOR_IR after processing
+    
+    SPOTTING: Continuous spotting, replaces READY/RECORDING when the
+    SPOTTING_ENABLED preference is set (green LED)
+      → Tracked points feed a sliding window (gestureSpotter.h) that
+        segments motion at velocity minima and casts spells mid-flow
+      → WAITING_FOR_IR when IR lost (pending candidates scored first)
   
   Tunable Parameters (from preferences):
     - MOVEMENT_THRESHOLD: Pixels of movement to trigger recording
@@ -29,6 +37,10 @@
     - GESTURE_TIMEOUT: Maximum milliseconds for a gesture
     - IR_LOSS_TIMEOUT: Milliseconds before IR loss is confirmed
   
+  MIN_BOUNDING_BOX_SIZE and POINT_JUMP_THRESHOLD can be overridden with -D
+  build flags; Tools/tuner replays OUTPUT_POINTS logs through this state
+  machine to pick them along with the preferences above.
+  
   Validation Checks:
     - Minimum trajectory points (50)
     - Minimum bounding box size (100 pixels)
@@ -37,10 +49,15 @@
   Special Spell Handling:
     - Nightlight on/off spells don't trigger sparkle effect or timeout
     - Regular spells trigger sparkle effect with 5-second timeout
+    - Every cast then advances the combo automaton (spellCombos.h); a
+      completed combo publishes (and plays its sound) at once, and its
+      image and LED effect follow once the spell's own display times out
   
 ================================================================================
 */
 
+#define LOG_MODULE LogModule::CAMERA
+
 #include "cameraFunctions.h"
 #include "glyphReader.h"
 #include "led_control.h"
@@ -51,6 +68,15 @@
 #include "screenFunctions.h"
 #include "audioFunctions.h"
 #include "customSpellFunctions.h"
+#include "heapFunctions.h"
+#include "motionFilter.h"
+#include "gestureSpotter.h"
+#include "spellActions.h"
+#include "spellCombos.h"
+#include "mediaPrefetch.h"
+#include "hotPath.h"
+#include "fleetSync.h"
+#include "buttonFunctions.h"
 
 #include <vector>
 #include <cmath>
@@ -77,15 +103,20 @@
  * Gestures with smaller bounding boxes are rejected as "too small".
  * Prevents accidental triggers from tiny movements or jitter.
  */
+#ifndef MIN_BOUNDING_BOX_SIZE
 #define MIN_BOUNDING_BOX_SIZE 200
+#endif
 
 /**
  * Tracking Point Jump Threshold (pixels)
- * If the tracked IR point jumps more than this distance between
- * frames, it is considered an invalid reading and ignored.
+ * Gate radius of the predictive tracker for back-to-back frames: a reading
+ * further than this from the *predicted* position is considered an invalid
+ * reading and ignored. The gate widens while no reading is accepted.
  * Helps filter out spurious readings from camera noise.
  */
+#ifndef POINT_JUMP_THRESHOLD
 #define POINT_JUMP_THRESHOLD 40
+#endif
 
 //=====================================
 // Gesture State Machine
@@ -98,7 +129,8 @@
 enum GestureState {
   WAITING_FOR_IR,      ///< No IR point detected, waiting for wand
   READY,               ///< IR point detected and stable (yellow → green LED)
-  RECORDING            ///< Movement detected, recording trajectory (blue LED)
+  RECORDING,           ///< Movement detected, recording trajectory (blue LED)
+  SPOTTING             ///< Spotting mode: spells recognized mid-motion (green LED)
 };
 
 /// Current state of the gesture detection state machine
@@ -110,7 +142,7 @@ GestureState currentState = WAITING_FOR_IR;
  * Fast polling (100Hz) when tracking, slow polling (20Hz) when idle.
  */
 bool isTrackingActive() {
-  return (currentState == READY || currentState == RECORDING);
+  return (currentState == READY || currentState == RECORDING || currentState == SPOTTING);
 }
 
 //=====================================
@@ -142,6 +174,25 @@ int lastY = -1;
 /// Stable "ready" position (center of stillness region)
 Point stablePosition = {-1, -1, 0};
 
+/// Predictive tracker smoothing and gating points during RECORDING
+WandTracker wandTracker;
+
+/// Online simplifier keeping currentTrajectory free of redundant samples
+PathSimplifier pathSimplifier;
+
+/**
+ * Append a point to the current trajectory
+ * The point passes through the path simplifier first, so it may be dropped
+ * or merged into the trailing point. Oldest points are discarded once
+ * MAX_TRAJECTORY_POINTS is reached.
+ */
+void HOT_CODE appendTrajectoryPoint(const Point& p) {
+  if (appendSimplified(pathSimplifier, currentTrajectory, p) &&
+      currentTrajectory.size() > MAX_TRAJECTORY_POINTS) {
+    currentTrajectory.erase(currentTrajectory.begin());
+  }
+}
+
 //=====================================
 // Validation Functions
 //=====================================
@@ -152,7 +203,7 @@ Point stablePosition = {-1, -1, 0};
  * the minimum size requirement in at least one dimension.
  * return true if bounding box is large enough, false otherwise
  */
-bool hasMinimumMovement(const std::vector<Point>& trajectory) {
+bool HOT_CODE hasMinimumMovement(const std::vector<Point>& trajectory) {
   if (trajectory.size() < 2) return false;
   
   // Find bounding box
@@ -171,7 +222,7 @@ bool hasMinimumMovement(const std::vector<Point>& trajectory) {
   int width = maxX - minX;
   int height = maxY - minY;
   
-  Serial.printf("Trajectory bounding box: %dx%d pixels\n", width, height);
+  LOG_DEBUG("Trajectory bounding box: %dx%d pixels", width, height);
   
   // Require minimum size in at least one dimension
   return (width >= MIN_BOUNDING_BOX_SIZE || height >= MIN_BOUNDING_BOX_SIZE);
@@ -335,27 +386,174 @@ bool initCamera() {
  * When SHOW_MATCHING is defined, shows side-by-side pattern comparison.
  * Otherwise, displays the spell name image.
  * 
- * bestSpell: Name of the matched spell
+ * spell: ID of the matched spell
+ * action: Its compiled actions (image)
  * resampled: User's normalized/resampled trajectory
  * bestMatch: Similarity score (0.0 to 1.0)
  */
-void displaySpellResult(const char* bestSpell, const std::vector<Point>& resampled, float bestMatch) {
+void displaySpellResult(SpellId spell, const SpellAction& action, const std::vector<Point>& resampled, float bestMatch) {
 #ifdef SHOW_MATCHING
   // Debug mode: show pattern comparison
-  for (const auto& spell : spellPatterns) {
-    if (strcasecmp(spell.name, bestSpell) == 0) {
-      std::vector<Point> spellNorm = normalizeTrajectory(spell.pattern);
-      std::vector<Point> spellResampled = resampleTrajectory(spellNorm, RESAMPLE_POINTS);
-      visualizeMatchComparison(bestSpell, spellResampled, resampled, bestMatch);
-      break;
-    }
+  if (spell != SPELL_ID_NONE) {
+    std::vector<Point> spellNorm = normalizeTrajectory(exemplarPoints(spellPatterns[spell], 0));
+    std::vector<Point> spellResampled = resampleTrajectory(spellNorm, RESAMPLE_POINTS);
+    visualizeMatchComparison(spellName(spell), spellResampled, resampled, bestMatch);
   }
 #else
   // Normal mode: show spell name/image
-  displaySpellName(bestSpell);
+  displaySpellName(spellName(spell), action.hasImage ? action.imageFile.c_str() : nullptr,
+                   action.animationFile.length() > 0 ? action.animationFile.c_str() : nullptr);
 #endif
 }
 
+/**
+ * Publish a cast to MQTT
+ * With FLEET_SYNC, only the reader that saw the cast best publishes it.
+ */
+static void publishCast(const char* payload, float bestMatch) {
+#ifdef FLEET_SYNC
+  fleetPublishSpell(payload, bestMatch);
+#else
+  publishSpell(payload);
+#endif
+}
+
+/// Completed combo waiting for the spell's display to time out
+static int pendingCombo = COMBO_NONE;
+
+void refreshSpellCombos() {
+  if (updateSpellCombos()) {
+    pendingCombo = COMBO_NONE;  // Its index refers to the old definitions
+  }
+}
+
+bool showPendingCombo() {
+  if (pendingCombo == COMBO_NONE) return false;
+  const SpellCombo& combo = spellCombo(pendingCombo);
+  pendingCombo = COMBO_NONE;
+  displaySpellName(combo.name, combo.imageFile.length() > 0 ? combo.imageFile.c_str() : nullptr,
+                   combo.animationFile.length() > 0 ? combo.animationFile.c_str() : nullptr);
+  ledRandomEffect();
+  ledOnTime = millis();
+  return true;
+}
+
+/**
+ * Carry out a completed combo (see spellCombos.h)
+ * Its own sound (if it has one) and MQTT publish go out at once; the
+ * image or name and a fresh LED effect wait for the completing spell's
+ * display to time out (showPendingCombo()), so the spell is still seen
+ * and the SD card decodes one image per cast. Shown at once if the spell
+ * put nothing on screen.
+ * index: Combo index (see spellCombo())
+ * bestMatch: Score of the completing cast
+ */
+static void castCombo(int index, float bestMatch) {
+  const SpellCombo& combo = spellCombo(index);
+  LOG_DEBUG("Combo: %s", combo.name);
+  if (combo.soundFile.length() > 0) playSound(combo.soundFile.c_str());
+  publishCast(combo.name, bestMatch);
+  pendingCombo = index;
+  if (screenSpellOnTime == 0) showPendingCombo();
+}
+
+/**
+ * Carry out a recognized spell
+ * Handles nightlight control spells (on/off/toggle, raise/lower) and
+ * otherwise plays a spell sound, publishes to MQTT and shows the spell
+ * with a random LED effect, then feeds the cast to the combo automaton.
+ * Shared by gesture recording and spotting.
+ * Everything per-spell comes from the action table (see spellActions.h).
+ * spell: ID of the matched spell
+ * resampled: User's normalized/resampled trajectory
+ * bestMatch: Similarity score (0.0 to 1.0)
+ */
+void castSpell(SpellId spell, const std::vector<Point>& resampled, float bestMatch) {
+  const SpellAction& action = spellAction(spell);
+  pendingCombo = COMBO_NONE;  // A newer cast replaces a combo not yet shown
+  const char* soundFile = randomSpellSound();
+#ifdef PREFETCH_MEDIA
+  noteSpellSound(soundFile);
+#endif
+  
+  NightlightRole role = action.nightlight;
+  if ((role == NightlightRole::RAISE || role == NightlightRole::LOWER) && !nightlightActive) {
+    role = NightlightRole::NONE;  // Brightness spells are regular spells with the nightlight off
+  }
+  
+  switch (role) {
+    case NightlightRole::TOGGLE:
+      // Toggle mode - same spell turns on and off
+      if (nightlightActive) {
+        nightlightActive = false;
+        ledOff();
+        LOG_DEBUG("Nightlight toggled OFF");
+      } else {
+        ledNightlight(NIGHTLIGHT_BRIGHTNESS);
+        LOG_DEBUG("Nightlight toggled ON");
+      }
+      playSound(soundFile);
+      publishCast(action.mqttPayload, bestMatch);
+      break;
+      
+    case NightlightRole::ON:
+      // Turn on nightlight mode
+      ledNightlight(NIGHTLIGHT_BRIGHTNESS);
+      playSound(soundFile);
+      displaySpellResult(spell, action, resampled, bestMatch);
+      publishCast(action.mqttPayload, bestMatch);
+      LOG_DEBUG("Nightlight turned ON");
+      break;
+      
+    case NightlightRole::OFF:
+      // Turn off nightlight mode
+      nightlightActive = false;
+      ledOff();
+      playSound(soundFile);
+      displaySpellResult(spell, action, resampled, bestMatch);
+      publishCast(action.mqttPayload, bestMatch);
+      ledOnTime = 0;
+      LOG_DEBUG("Nightlight turned OFF");
+      break;
+      
+    case NightlightRole::RAISE:
+    case NightlightRole::LOWER:
+      // Nightlight brightness adjustment - Raise/Lower spells
+      if (role == NightlightRole::RAISE) {
+        NIGHTLIGHT_BRIGHTNESS = constrain(NIGHTLIGHT_BRIGHTNESS + 50, 10, 255);
+        LOG_DEBUG("Nightlight brightness increased to %d", NIGHTLIGHT_BRIGHTNESS);
+      } else {
+        NIGHTLIGHT_BRIGHTNESS = constrain(NIGHTLIGHT_BRIGHTNESS - 50, 10, 255);
+        LOG_DEBUG("Nightlight brightness decreased to %d", NIGHTLIGHT_BRIGHTNESS);
+      }
+      
+      // Save new brightness to preferences
+      setPref(PrefKey::NIGHTLIGHT_BRIGHTNESS, NIGHTLIGHT_BRIGHTNESS);
+      
+      // Apply new brightness immediately
+      ledNightlight(NIGHTLIGHT_BRIGHTNESS);
+      playSound(soundFile);
+      
+      // Show spell feedback
+      displaySpellResult(spell, action, resampled, bestMatch);
+      publishCast(action.mqttPayload, bestMatch);
+      break;
+      
+    case NightlightRole::NONE:
+      // Regular spell - publish to MQTT and show the LED effect
+      playSound(soundFile);
+      publishCast(action.mqttPayload, bestMatch);
+      displaySpellResult(spell, action, resampled, bestMatch);
+      ledRandomEffect();  // Pick a random LED effect for variety
+      ledOnTime = millis();  // Start LED effect timer
+      break;
+  }
+  
+  // Combos only follow the spell's own feedback, never hold it up
+  int combo = advanceSpellCombos(spell, millis());
+  if (combo != COMBO_NONE) castCombo(combo, bestMatch);
+}
+
 /**
  * Read IR blob data from camera and process gesture state machine
  * 
@@ -376,7 +574,11 @@ void displaySpellResult(const char* bestSpell, const std::vector<Point>& resampl
  *     Size = SS & 0x0F           (blob size 0-15)
  *   Invalid blobs: X=0x3FF, Y=0x3FF
  */
-void readCameraData() {
+void HOT_CODE readCameraData() {
+  // Trajectory growth and matching are attributed to MATCHING;
+  // display/web calls made from here switch to their own tags
+  HEAP_SCOPE(HeapTag::MATCHING);
+  
   uint8_t data[16]; // IR camera returns 16 bytes of blob data
   
   //-----------------------------------
@@ -433,9 +635,47 @@ void readCameraData() {
     }
   }
   
+  //-----------------------------------
+  // Debugging Output of IR Points
+  //-----------------------------------
+  // Outputs the raw IR blob data to Serial for debugging. Use the
+  // visualize_ir.py script from the Tools folder to read and visualize
+  // the output. Every frame is logged here, before the state machine can
+  // return early, so saved logs replay exactly in Tools/tuner. Printed
+  // directly, not through the log task, which may drop lines when full.
+#ifdef OUTPUT_POINTS
+  Serial.print("IR,");
+  Serial.print(currentTime);
+  
+  for (int i = 0; i < 4; i++) {
+    int offset = 1 + (i * 3);
+    if (offset + 2 < 16) {
+      uint8_t xx = data[offset];
+      uint8_t yy = data[offset + 1];
+      uint8_t ss = data[offset + 2];
+      
+      int x = ((ss & 0x30) << 4) | xx;
+      int y = ((ss & 0xC0) << 2) | yy;
+      int size = ss & 0x0F;
+      
+      if (x == 0x3FF || y == 0x3FF) {
+        Serial.print(",-1,-1,-1");
+      } else {
+        Serial.printf(",%d,%d,%d", x, y, size);
+      }
+    }
+  }
+  Serial.println();
+#endif
+  
   //=====================================
   // Gesture State Machine
   //=====================================
+  // Drives the screen and LEDs, so it waits for a running button handler
+  // (the sampling above never does). The handler may have opened settings
+  // or started a spell save meanwhile: the camera is off then.
+  UiLockScope uiLockScope;
+  if (inSettingsMode) return;
   
   if (currentX >= 0 && currentY >= 0) {
     //-----------------------------------
@@ -459,6 +699,20 @@ void readCameraData() {
       // WAITING_FOR_IR State
       //=================================
       case WAITING_FOR_IR: {
+        if (SPOTTING_ENABLED && !isRecordingCustomSpell) {
+          // Spotting mode - no stillness phase, start watching motion right away
+          resetSpotter();
+          initTracker(wandTracker, currentX, currentY, currentTime, POINT_JUMP_THRESHOLD);
+          feedSpotter({currentX, currentY, currentTime});
+          currentState = SPOTTING;
+          ledOnTime = 0;
+          ledSolid("green");
+          backlightOn();
+          screenOnTime = millis();
+          LOG_DEBUG("STATE: IR detected (spotting)");
+          break;
+        }
+        
         // IR detected for the first time - transition to READY state
         // User needs to hold wand still for READY_STILLNESS_TIME before tracking begins
         stablePosition = {currentX, currentY, currentTime};  // Record initial position
@@ -485,12 +739,14 @@ void readCameraData() {
           if (distanceFromReady >= MOVEMENT_THRESHOLD) {
             // Moved outside boundary - start tracking!
             currentTrajectory.clear();
+            initSimplifier(pathSimplifier);
             // Save the stable ready position as the first point (the actual start of the gesture)
             Point startPoint = {stablePosition.x, stablePosition.y, stablePosition.timestamp};
-            currentTrajectory.push_back(startPoint);
+            appendTrajectoryPoint(startPoint);
             // Add the current position as the second point
             Point p = {currentX, currentY, currentTime};
-            currentTrajectory.push_back(p);
+            appendTrajectoryPoint(p);
+            initTracker(wandTracker, currentX, currentY, currentTime, POINT_JUMP_THRESHOLD);
             lastMovementTime = currentTime;
             hasMovedDuringRecording = false;
             currentState = RECORDING;
@@ -528,7 +784,7 @@ void readCameraData() {
         
         // Check for timeout in READY state
         if (currentTime - stillnessStartTime > GESTURE_TIMEOUT) {
-          Serial.println("STATE: Ready timeout");
+          LOG_DEBUG("STATE: Ready timeout");
           currentState = WAITING_FOR_IR;
           readyToTrack = false;
           if (nightlightActive) {
@@ -542,33 +798,32 @@ void readCameraData() {
       }
         
       case RECORDING: {
-        // Check if point is an outlier (too far from previous point - likely a reflection)
-        bool isOutlier = false;
-        if (currentTrajectory.size() > 0) {
-          Point& lastPoint = currentTrajectory.back();
-          float dx = currentX - lastPoint.x;
-          float dy = currentY - lastPoint.y;
-          float jumpDistance = sqrt(dx*dx + dy*dy);
-          
-          // Reject points that jump more than 150 pixels from previous point
-          // (normal wand movement should be continuous, reflections cause large jumps)
-          if (jumpDistance > POINT_JUMP_THRESHOLD) {
-            isOutlier = true;
-            LOG_DEBUG("Outlier rejected: jump=%.1f from (%d,%d) to (%d,%d)", 
-                     jumpDistance, lastPoint.x, lastPoint.y, currentX, currentY);
-          }
+        // Gate the reading against the tracker's predicted position.
+        // Accepted readings yield smoothed points, preceded by predicted
+        // samples if a short IR dropout was just bridged.
+        Point filtered[TRACKER_MAX_OUTPUT_POINTS];
+        uint8_t filteredCount = 0;
+        TrackResult result = updateTracker(wandTracker, currentX, currentY, currentTime,
+                                           filtered, filteredCount);
+        
+        if (result == TRACK_REJECTED) {
+          // Off the predicted path - likely a reflection
+          LOG_DEBUG("Outlier rejected: (%d,%d) vs track (%.0f,%.0f)",
+                    currentX, currentY, wandTracker.x, wandTracker.y);
+        } else if (result == TRACK_REACQUIRED) {
+          LOG_DEBUG("Tracker re-acquired at (%d,%d)", currentX, currentY);
         }
         
-        // Only add point if it's not an outlier
-        if (!isOutlier) {
-          Point p = {currentX, currentY, currentTime};
-          currentTrajectory.push_back(p);
-          
-          // Limit trajectory size
-          if (currentTrajectory.size() > MAX_TRAJECTORY_POINTS) {
-            currentTrajectory.erase(currentTrajectory.begin());
-          }
+        for (uint8_t i = 0; i < filteredCount; i++) {
+          appendTrajectoryPoint(filtered[i]);
+        }
+        
+#ifdef PREFETCH_MEDIA
+        // Warm the likely spells' media while the gesture is drawn
+        if (!isRecordingCustomSpell) {
+          updateMediaPrefetch(currentTrajectory, currentTime);
         }
+#endif
         
         // Check if this is significant movement
         if (movement >= MOVEMENT_THRESHOLD) {
@@ -584,6 +839,9 @@ void readCameraData() {
           LOG_DEBUG("STATE: Gesture timeout");
           ledSolid("red");
           currentTrajectory.clear();
+#ifdef PREFETCH_MEDIA
+          endMediaPrefetch();
+#endif
           drawIRPoint(-1, -1, false);  // Clear IR point from display
           lastX = -1;
           lastY = -1;
@@ -597,6 +855,28 @@ void readCameraData() {
         }
         break;
       }
+      
+      case SPOTTING: {
+        // Same gating/smoothing as RECORDING, but points feed the spotter
+        Point filtered[TRACKER_MAX_OUTPUT_POINTS];
+        uint8_t filteredCount = 0;
+        updateTracker(wandTracker, currentX, currentY, currentTime, filtered, filteredCount);
+        for (uint8_t i = 0; i < filteredCount; i++) {
+          feedSpotter(filtered[i]);
+        }
+        
+        SpotResult spotted;
+        if (pollSpotter(spotted)) {
+          castSpell(spotted.spell, spotted.resampled, spotted.score);
+        }
+        
+        // Mode switched off, or a custom spell is being recorded - fall
+        // back to the READY flow
+        if (!SPOTTING_ENABLED || isRecordingCustomSpell) {
+          currentState = WAITING_FOR_IR;
+        }
+        break;
+      }
     }
     
     lastX = currentX;
@@ -630,6 +910,9 @@ void readCameraData() {
         playSound("/sounds/error.wav");  // Play error sound
         displaySpellName("Too Small");
         currentTrajectory.clear();
+#ifdef PREFETCH_MEDIA
+        endMediaPrefetch();
+#endif
         currentState = WAITING_FOR_IR;
         irLostTime = 0;
         lastX = -1;
@@ -647,16 +930,21 @@ void readCameraData() {
       
       if (totalDistance > 50) {  // At least 50 pixels of movement
         // Valid gesture - try to match
-        LOG_DEBUG("Processing gesture (%.1f px total movement)...\n", totalDistance);
+        LOG_DEBUG("Processing gesture (%.1f px total movement, %d of %lu samples kept)...\n",
+                  totalDistance, currentTrajectory.size(), (unsigned long)pathSimplifier.rawCount);
         
-        // Check if trajectory has minimum points before matching
-        if (currentTrajectory.size() < MIN_TRAJECTORY_POINTS) {
-          LOG_DEBUG("Trajectory too short (%d points)\n", currentTrajectory.size());
+        // Check if enough samples were captured before matching
+        // (counted before simplification - the kept path is much shorter)
+        if (pathSimplifier.rawCount < MIN_TRAJECTORY_POINTS) {
+          LOG_DEBUG("Trajectory too short (%lu samples)\n", (unsigned long)pathSimplifier.rawCount);
           ledSolid("red");
           ledOnTime = millis();
           playSound("/sounds/error.wav");  // Play error sound
           displaySpellName("Too Short");
           currentTrajectory.clear();
+#ifdef PREFETCH_MEDIA
+          endMediaPrefetch();
+#endif
           currentState = WAITING_FOR_IR;
           readyToTrack = false;
           irLostTime = 0;
@@ -675,17 +963,20 @@ void readCameraData() {
           extern std::vector<Point> recordedSpellPattern;
           recordedSpellPattern = resampled;
           
-          // Show preview
-          visualizeSpellPattern("New Spell", resampled);
+          // Show preview, numbered by take
+          char takeTitle[24];
+          snprintf(takeTitle, sizeof(takeTitle), "Take %d/%d",
+                   (int)recordedSpellTakes.size() + 1, SPELL_RECORD_TAKES);
+          visualizeSpellPattern(takeTitle, resampled);
           
-          // Display save/discard prompt
+          // Display keep/discard prompt (discarding saves takes already kept)
           tft.setTextSize(1);
           tft.setTextColor(0x07E0);  // Green
           tft.setCursor(100, 210);
-          tft.print("BTN1:Save");
+          tft.print("BTN1:Keep");
           tft.setTextColor(0xF800);  // Red
           tft.setCursor(100, 190);
-          tft.print("BTN2:Discard");
+          tft.print(recordedSpellTakes.empty() ? "BTN2:Discard" : "BTN2:Drop+Save");
           
           extern SpellRecordingState spellRecordingState;
           spellRecordingState = SPELL_RECORD_PREVIEW;
@@ -701,113 +992,14 @@ void readCameraData() {
           return;
         }
         
-        matchSpell(currentTrajectory);
-        
-        // Check if we found a match
+        // Search the library once; the log reuses the answer
         std::vector<Point> normalized = normalizeTrajectory(currentTrajectory);
         std::vector<Point> resampled = resampleTrajectory(normalized, RESAMPLE_POINTS);
         float bestMatch = 0;
-        const char* bestSpell = "Unknown";
-        
-        for (const auto& spell : spellPatterns) {
-          std::vector<Point> spellNorm = normalizeTrajectory(spell.pattern);
-          std::vector<Point> spellResampled = resampleTrajectory(spellNorm, RESAMPLE_POINTS);
-          float similarity = calculateSimilarity(resampled, spellResampled);
-          if (similarity > bestMatch) {
-            bestMatch = similarity;
-            bestSpell = spell.name;
-          }
-        }
+        SpellId bestSpell = findBestSpellId(resampled, bestMatch);
         
         if (bestMatch >= MATCH_THRESHOLD) {
-          // Spell detected - check if it's a nightlight control spell
-          
-          
-          // Check if this spell is configured for nightlight control
-          bool isNightlightOnSpell = (NIGHTLIGHT_ON_SPELL.length() > 0 && strcasecmp(bestSpell, NIGHTLIGHT_ON_SPELL.c_str()) == 0);
-          bool isNightlightOffSpell = (NIGHTLIGHT_OFF_SPELL.length() > 0 && strcasecmp(bestSpell, NIGHTLIGHT_OFF_SPELL.c_str()) == 0);
-          
-          // Check if same spell is assigned to both (toggle mode)
-          bool isToggleMode = (NIGHTLIGHT_ON_SPELL.length() > 0 && 
-                               NIGHTLIGHT_OFF_SPELL.length() > 0 && 
-                               strcasecmp(NIGHTLIGHT_ON_SPELL.c_str(), NIGHTLIGHT_OFF_SPELL.c_str()) == 0);
-          
-          if (isToggleMode && (isNightlightOnSpell || isNightlightOffSpell)) {
-            // Toggle mode - same spell turns on and off
-            if (nightlightActive) {
-              nightlightActive = false;
-              ledOff();
-              LOG_DEBUG("Nightlight toggled OFF");
-            } else {
-              ledNightlight(NIGHTLIGHT_BRIGHTNESS);
-              LOG_DEBUG("Nightlight toggled ON");
-            }
-            // Play random spell sound (1-5)
-            char soundFile[32];
-            snprintf(soundFile, sizeof(soundFile), "/sounds/spell%d.wav", random(1, 6));
-            playSound(soundFile);
-            publishSpell(bestSpell);
-          } else if (isNightlightOnSpell) {
-            // Turn on nightlight mode
-            ledNightlight(NIGHTLIGHT_BRIGHTNESS);
-            // Play random spell sound (1-5)
-            char soundFile[32];
-            snprintf(soundFile, sizeof(soundFile), "/sounds/spell%d.wav", random(1, 6));
-            playSound(soundFile);
-            displaySpellResult(bestSpell, resampled, bestMatch);
-            publishSpell(bestSpell);
-            LOG_DEBUG("Nightlight turned ON");
-          } else if (isNightlightOffSpell) {
-            // Turn off nightlight mode
-            nightlightActive = false;
-            ledOff();
-            // Play random spell sound (1-5)
-            char soundFile[32];
-            snprintf(soundFile, sizeof(soundFile), "/sounds/spell%d.wav", random(1, 6));
-            playSound(soundFile);
-            displaySpellResult(bestSpell, resampled, bestMatch);
-            publishSpell(bestSpell);
-            ledOnTime = 0;
-            LOG_DEBUG("Nightlight turned OFF");
-          } else if (nightlightActive && 
-                     ((NIGHTLIGHT_RAISE_SPELL.length() > 0 && strcasecmp(bestSpell, NIGHTLIGHT_RAISE_SPELL.c_str()) == 0) || 
-                      (NIGHTLIGHT_LOWER_SPELL.length() > 0 && strcasecmp(bestSpell, NIGHTLIGHT_LOWER_SPELL.c_str()) == 0))) {
-            // Nightlight brightness adjustment - Raise/Lower spells
-            bool isRaise = (NIGHTLIGHT_RAISE_SPELL.length() > 0 && strcasecmp(bestSpell, NIGHTLIGHT_RAISE_SPELL.c_str()) == 0);
-            
-            if (isRaise) {
-              NIGHTLIGHT_BRIGHTNESS = constrain(NIGHTLIGHT_BRIGHTNESS + 50, 10, 255);
-              LOG_DEBUG("Nightlight brightness increased to %d", NIGHTLIGHT_BRIGHTNESS);
-            } else {
-              NIGHTLIGHT_BRIGHTNESS = constrain(NIGHTLIGHT_BRIGHTNESS - 50, 10, 255);
-              LOG_DEBUG("Nightlight brightness decreased to %d", NIGHTLIGHT_BRIGHTNESS);
-            }
-            
-            // Save new brightness to preferences
-            setPref(PrefKey::NIGHTLIGHT_BRIGHTNESS, NIGHTLIGHT_BRIGHTNESS);
-            
-            // Apply new brightness immediately
-            ledNightlight(NIGHTLIGHT_BRIGHTNESS);
-            
-            // Play random spell sound (1-5)
-            char soundFile[32];
-            snprintf(soundFile, sizeof(soundFile), "/sounds/spell%d.wav", random(1, 6));
-            playSound(soundFile);
-            
-            // Show spell feedback
-            displaySpellResult(bestSpell, resampled, bestMatch);
-            publishSpell(bestSpell);
-          } else {
-            // Regular spell - publish to MQTT and show random effect
-            // Play random spell sound (1-5)
-            char soundFile[32];
-            snprintf(soundFile, sizeof(soundFile), "/sounds/spell%d.wav", random(1, 6));
-            playSound(soundFile);
-            publishSpell(bestSpell);
-            displaySpellResult(bestSpell, resampled, bestMatch);
-            ledRandomEffect();  // Pick a random LED effect for variety
-            ledOnTime = millis();  // Start LED effect timer
-          }
+          castSpell(bestSpell, resampled, bestMatch);
         } else {
           // No match - blink red
           displaySpellName("No Match");
@@ -815,6 +1007,9 @@ void readCameraData() {
           ledOnTime = millis();  // Start LED effect timer
           playSound("/sounds/error.wav");  // Play error sound
         }
+        
+        // Log after the feedback, so the debug breakdown never delays it
+        matchSpell(currentTrajectory, resampled, bestSpell, bestMatch);
       } else {
         // Not enough movement - blink red
         LOG_DEBUG("Insufficient movement (%.1f px)\n", totalDistance);
@@ -824,6 +1019,9 @@ void readCameraData() {
         displaySpellName("No Match");
       }
       
+#ifdef PREFETCH_MEDIA
+      endMediaPrefetch();  // Cast done - release what wasn't used
+#endif
       currentTrajectory.clear();
       currentState = WAITING_FOR_IR;
       readyToTrack = false;
@@ -832,6 +1030,22 @@ void readCameraData() {
       lastY = -1;
       LOG_DEBUG("STATE: Waiting for next gesture");
       
+    } else if (currentState == SPOTTING) {
+      // IR lost while spotting - the wand leaving view ends any gesture
+      SpotResult spotted;
+      if (finishSpotter(spotted)) {
+        castSpell(spotted.spell, spotted.resampled, spotted.score);
+      } else if (nightlightActive) {
+        ledNightlight(NIGHTLIGHT_BRIGHTNESS);
+      } else {
+        ledOff();
+      }
+      currentState = WAITING_FOR_IR;
+      irLostTime = 0;
+      lastX = -1;
+      lastY = -1;
+      LOG_DEBUG("STATE: IR lost while spotting");
+      
     } else if (currentState != WAITING_FOR_IR) {
       // IR lost in READY state - reset
       LOG_DEBUG("STATE: IR lost before spell started");
@@ -850,39 +1064,6 @@ void readCameraData() {
       irLostTime = 0;
     }
   }
-  
-//=================================
-// Debuggung output of IR points
-//=================================
-/**
- * Outputs the current IR blob data to Serial for debugging.
- * Use the visualise_ir.py script from the Tools folder to read
- * and visualize the output.
- */
-#ifdef OUTPUT_POINTS
-  Serial.print("IR,");
-  Serial.print(currentTime);
-  
-  for (int i = 0; i < 4; i++) {
-    int offset = 1 + (i * 3);
-    if (offset + 2 < 16) {
-      uint8_t xx = data[offset];
-      uint8_t yy = data[offset + 1];
-      uint8_t ss = data[offset + 2];
-      
-      int x = ((ss & 0x30) << 4) | xx;
-      int y = ((ss & 0xC0) << 2) | yy;
-      int size = ss & 0x0F;
-      
-      if (x == 0x3FF || y == 0x3FF) {
-        Serial.print(",-1,-1,-1");
-      } else {
-        Serial.printf(",%d,%d,%d", x, y, size);
-      }
-    }
-  }
-  Serial.println();
-#endif
 }
 
 // Helper function to get current IR position for spell recording
@@ -54,6 +54,21 @@ void readCameraData();
  */
 bool isTrackingActive();
 
+/**
+ * Compile the combo automaton if the library or combos changed
+ * Called by the main loop between casts (see spellCombos.h); drops a
+ * combo still waiting to be shown, as its definition is gone.
+ */
+void refreshSpellCombos();
+
+/**
+ * Show a completed combo held back behind its spell
+ * Called by the main loop when the spell display times out, in place of
+ * restoring the idle background.
+ * return true if a combo was shown, false if none was pending
+ */
+bool showPendingCombo();
+
 /**
  * Get current IR position for spell recording
  * Helper function that reads camera data and returns the current IR position.
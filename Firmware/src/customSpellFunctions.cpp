@@ -12,9 +12,12 @@
     2. System checks for SD card presence (required for storage)
     3. User draws gesture with wand (tracked by normal camera state machine)
     4. Gesture captured and stored in recordedSpellPattern vector
-    5. User confirms save, pattern written to spells.json on SD card
-    6. Auto-generated name assigned ("Custom 1", "Custom 2", etc.)
-    7. Spell patterns reloaded to make new spell immediately available
+    5. User keeps the take (BTN1) and draws the next one, up to
+       SPELL_RECORD_TAKES; BTN2 drops the previewed take and saves early
+    6. Takes compacted to the SPELL_MAX_EXEMPLARS most representative
+       (k-medoids) and written to spells.json on SD card
+    7. Auto-generated name assigned ("Custom 1", "Custom 2", etc.)
+    8. Spell library reload requested (applied by the loop task)
   
   Storage Format (spells.json):
     {
@@ -25,10 +28,15 @@
             {"x": 100, "y": 200},
             {"x": 150, "y": 250},
             ...
+          ],
+          "takes": [
+            [{"x": 110, "y": 190}, ...],
+            ...
           ]
         }
       ]
     }
+  "pattern" is the most representative take, "takes" the other kept ones.
   
   Features:
     - Unlimited custom spells (limited only by SD card space)
@@ -40,11 +48,14 @@
   State Machine:
     SPELL_RECORD_IDLE:      Not recording
     SPELL_RECORD_TRACKING:  Actively recording gesture via camera
+    SPELL_RECORD_PREVIEW:   Take shown, waiting for keep (next take) or save
     SPELL_RECORD_COMPLETE:  Recording finished, returning to menu
   
 ================================================================================
 */
 
+#define LOG_MODULE LogModule::STORAGE
+
 #include "customSpellFunctions.h"
 #include "glyphReader.h"
 #include "sdFunctions.h"
@@ -54,11 +65,15 @@
 #include "spell_patterns.h"
 #include "cameraFunctions.h"
 #include "preferenceFunctions.h"
+#include "buttonFunctions.h"
+#include "heapFunctions.h"
+#include "memoryPolicy.h"
 #include <ArduinoJson.h>
 
 // Global state tracking for custom spell recording
 SpellRecordingState spellRecordingState = SPELL_RECORD_IDLE;
 std::vector<Point> recordedSpellPattern;  // Stores captured gesture points
+std::vector<std::vector<Point>> recordedSpellTakes;  // Takes kept so far
 
 /**
  * Enter spell recording mode
@@ -89,7 +104,7 @@ void enterSpellRecordingMode() {
   if (!isCardPresent()) {
     // Display error on screen for user feedback
     displayError("SD Card Required");
-    delay(2000);  // Give user time to read error message
+    uiPause(2000);  // Give user time to read error message (loop keeps running)
     spellRecordingState = SPELL_RECORD_COMPLETE;
     return;
   }
@@ -98,6 +113,7 @@ void enterSpellRecordingMode() {
   clearDisplay();
   clearIRTrail();  // Remove any previous tracking visualization
   recordedSpellPattern.clear();  // Start with empty pattern
+  recordedSpellTakes.clear();
   
   // Set global flag that camera state machine checks
   isRecordingCustomSpell = true;
@@ -126,13 +142,39 @@ void exitSpellRecordingMode() {
   isRecordingCustomSpell = false;
   spellRecordingState = SPELL_RECORD_IDLE;
   
-  // Free memory from captured pattern
+  // Free memory from captured patterns
   recordedSpellPattern.clear();
+  recordedSpellTakes.clear();
   
   // Clean up display
   clearDisplay();
 }
 
+/**
+ * Keep the previewed take
+ * 
+ * Moves the previewed gesture into recordedSpellTakes. If more takes are
+ * wanted, clears the preview and returns to tracking so the camera state
+ * machine captures the next one.
+ * 
+ * return true when SPELL_RECORD_TAKES takes have been kept
+ */
+bool keepRecordedTake() {
+  recordedSpellTakes.push_back(recordedSpellPattern);
+  recordedSpellPattern.clear();
+  LOG_DEBUG("Spell record: kept take %d of %d", recordedSpellTakes.size(), SPELL_RECORD_TAKES);
+  
+  if (recordedSpellTakes.size() >= SPELL_RECORD_TAKES) {
+    return true;
+  }
+  
+  // Ready the display and camera for the next take
+  clearDisplay();
+  clearIRTrail();
+  spellRecordingState = SPELL_RECORD_TRACKING;
+  return false;
+}
+
 /**
  * Save recorded pattern to spells.json
  * 
@@ -145,9 +187,10 @@ void exitSpellRecordingMode() {
  *   3. Parse JSON to get "custom" array
  *   4. Scan existing custom spells to find highest number (for auto-naming)
  *   5. Create new spell entry with "Custom N+1" name
- *   6. Add all points from recordedSpellPattern as x,y coordinates
+ *   6. Compact recordedSpellTakes to SPELL_MAX_EXEMPLARS medoids and add
+ *      them as x,y coordinates ("pattern" + "takes")
  *   7. Write updated JSON back to spells.json
- *   8. Reload spell patterns so new spell is immediately available
+ *   8. Request a library reload so the new spell becomes castable
  * 
  * Auto-Naming:
  *   - Scans existing custom spells for names like "Custom 1", "Custom 2"
@@ -164,6 +207,7 @@ void exitSpellRecordingMode() {
  * return true on successful save, false on any error
  */
 bool saveRecordedSpell() {
+  HEAP_SCOPE(HeapTag::SD);
   LOG_DEBUG("Saving custom spell to SD card");
   
   // Verify SD card still present (could have been removed during recording)
@@ -172,8 +216,17 @@ bool saveRecordedSpell() {
     return false;
   }
   
+  if (recordedSpellTakes.empty()) {
+    LOG_ALWAYS("Cannot save spell - no takes recorded");
+    return false;
+  }
+  
+  // Keep only the most representative takes (same selection as on load)
+  SpellPattern compacted;
+  compactSpellTakes(compacted, recordedSpellTakes);
+  
   const char* configFile = "/spells.json";
-  JsonDocument doc;
+  JsonDocument doc(bulkJsonAllocator());
   
   // Read existing file if it exists (to preserve other custom spells)
   if (SD.exists(configFile)) {
@@ -221,16 +274,29 @@ bool saveRecordedSpell() {
   JsonObject newSpell = customArray.add<JsonObject>();
   newSpell["name"] = newName;
   
-  // Add pattern array with all captured points
+  // Add pattern array with all points of the primary take
   // Format: [{"x": 100, "y": 200}, {"x": 110, "y": 210}, ...]
   JsonArray patternArray = newSpell["pattern"].to<JsonArray>();
-  for (const auto& p : recordedSpellPattern) {
+  for (const auto& p : resampleTrajectory(exemplarPoints(compacted, 0), SPELL_SAVE_POINTS)) {
     JsonObject pointObj = patternArray.add<JsonObject>();
     pointObj["x"] = p.x;
     pointObj["y"] = p.y;
     // Note: timestamp not saved, will be regenerated during normalization
   }
   
+  // Remaining kept takes, same point format
+  if (!compacted.alternates.empty()) {
+    JsonArray takesArray = newSpell["takes"].to<JsonArray>();
+    for (size_t e = 1; e < exemplarCount(compacted); e++) {
+      JsonArray takeArray = takesArray.add<JsonArray>();
+      for (const auto& p : resampleTrajectory(exemplarPoints(compacted, e), SPELL_SAVE_POINTS)) {
+        JsonObject pointObj = takeArray.add<JsonObject>();
+        pointObj["x"] = p.x;
+        pointObj["y"] = p.y;
+      }
+    }
+  }
+  
   // Write updated JSON back to file (overwrites existing)
   File file = SD.open(configFile, FILE_WRITE);
   if (!file) {
@@ -245,12 +311,12 @@ bool saveRecordedSpell() {
   }
   
   file.close();
-  LOG_DEBUG("Saved custom spell '%s' with %d points", newName, recordedSpellPattern.size());
+  LOG_DEBUG("Saved custom spell '%s' (%d of %d takes kept)", newName,
+            exemplarCount(compacted), recordedSpellTakes.size());
   
-  // Reload spell patterns so new spell is immediately available for matching
-  // This rebuilds the global spellPatterns vector with built-in + custom spells
-  initSpellPatterns();  // Load built-in spells
-  loadCustomSpells();   // Apply customizations from spells.json
+  // Rebuild spellPatterns with built-in + custom spells on the loop task,
+  // where matching reads it
+  requestSpellLibraryReload();
   
   return true;
 }
@@ -290,7 +356,7 @@ std::vector<String> getCustomSpellNames() {
 /**
  * Rename a custom spell
  * 
- * Updates a custom spell's name in spells.json and reloads patterns.
+ * Updates a custom spell's name in spells.json and requests a reload.
  * Used for manual spell renaming by editing the SD card file directly
  * or potentially through future web portal functionality.
  * 
@@ -300,7 +366,7 @@ std::vector<String> getCustomSpellNames() {
  *   3. Search "custom" array for spell matching oldName
  *   4. Update the name field to newName
  *   5. Write entire JSON back to file
- *   6. Reload spell patterns to apply change immediately
+ *   6. Request a library reload to apply the change
  * 
  * Validation:
  *   - Checks SD card availability before proceeding
@@ -310,8 +376,8 @@ std::vector<String> getCustomSpellNames() {
  * 
  * Side Effects:
  *   - Overwrites spells.json with updated content
- *   - Reloads global spellPatterns vector (expensive operation)
- *   - New name immediately available for matching
+ *   - Requests a spellPatterns reload (applied by the loop task)
+ *   - New name available for matching from the next loop pass
  * 
  * Example:
  *   renameCustomSpell("Custom 1", "Fireball") changes spell name from
@@ -322,6 +388,7 @@ std::vector<String> getCustomSpellNames() {
  * return true on successful rename, false on any error
  */
 bool renameCustomSpell(const char* oldName, const char* newName) {
+  HEAP_SCOPE(HeapTag::SD);
   LOG_DEBUG("Renaming spell '%s' to '%s'", oldName, newName);
   
   // Verify SD card is present
@@ -341,7 +408,7 @@ bool renameCustomSpell(const char* oldName, const char* newName) {
     return false;
   }
   
-  JsonDocument doc;
+  JsonDocument doc(bulkJsonAllocator());
   DeserializationError error = deserializeJson(doc, file);
   file.close();
   
@@ -369,10 +436,8 @@ bool renameCustomSpell(const char* oldName, const char* newName) {
         serializeJson(doc, file);
         file.close();
         
-        // Reload all spell patterns to apply change
-        // This rebuilds spellPatterns with new name
-        initSpellPatterns();  // Load built-in spells
-        loadCustomSpells();   // Apply customizations from spells.json
+        // Rebuild spellPatterns with the new name (on the loop task)
+        requestSpellLibraryReload();
         
         LOG_DEBUG("Successfully renamed spell");
         return true;
@@ -385,6 +450,7 @@ bool renameCustomSpell(const char* oldName, const char* newName) {
 }
 
 bool renameCustomSpellsBatch(const std::vector<SpellRenamePair>& renames) {
+  HEAP_SCOPE(HeapTag::SD);
   LOG_DEBUG("Batch renaming %d spells", (int)renames.size());
   if (!isCardPresent()) return false;
   const char* configFile = "/spells.json";
@@ -393,7 +459,7 @@ bool renameCustomSpellsBatch(const std::vector<SpellRenamePair>& renames) {
   File file = SD.open(configFile, FILE_READ);
   if (!file) return false;
 
-  JsonDocument doc;
+  JsonDocument doc(bulkJsonAllocator());
   DeserializationError error = deserializeJson(doc, file);
   file.close();
   if (error) return false;
@@ -424,10 +490,9 @@ bool renameCustomSpellsBatch(const std::vector<SpellRenamePair>& renames) {
   }
   file.close();
 
-  // Reload once
-  initSpellPatterns();
-  loadCustomSpells();
+  // Reload once, on the loop task
+  requestSpellLibraryReload();
 
-  LOG_DEBUG("Batch rename applied and spell patterns reloaded");
+  LOG_DEBUG("Batch rename applied, spell library reload requested");
   return true;
 }
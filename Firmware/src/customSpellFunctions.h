@@ -8,8 +8,9 @@
   save them to the SD card.
   
   Features:
-    - Record new spell patterns via wand tracking
-    - Save patterns to spells.json on SD card
+    - Record new spell patterns via wand tracking (several takes per spell)
+    - Save patterns to spells.json on SD card, compacted to the most
+      representative SPELL_MAX_EXEMPLARS takes
     - Auto-generate names (Custom 1, Custom 2, etc.)
     - Preview patterns before saving
     - Rename custom spells via web portal
@@ -22,6 +23,9 @@
 #include "spell_patterns.h"
 #include <vector>
 
+#define SPELL_RECORD_TAKES 5     // Takes recorded per new spell (compacted on save)
+#define SPELL_SAVE_POINTS 50     // Points written per kept take (spells.json is capped at 16KB)
+
 // State machine for custom spell recording
 enum SpellRecordingState {
   SPELL_RECORD_IDLE,           // Not recording
@@ -35,10 +39,12 @@ enum SpellRecordingState {
 // Global state
 extern SpellRecordingState spellRecordingState;
 extern std::vector<Point> recordedSpellPattern;
+extern std::vector<std::vector<Point>> recordedSpellTakes;
 
 /**
  * Enter spell recording mode
  * Checks for SD card, displays error if missing, or starts recording workflow
+ * Called from a button handler (UI task)
  */
 void enterSpellRecordingMode();
 
@@ -56,8 +62,17 @@ void exitSpellRecordingMode();
 bool updateSpellRecording();
 
 /**
- * Save recorded pattern to spells.json
- * Adds pattern to "custom" section with auto-generated name
+ * Keep the previewed take
+ * Adds recordedSpellPattern to recordedSpellTakes and, until
+ * SPELL_RECORD_TAKES takes are kept, re-arms tracking for the next take
+ * Returns true once every take is recorded (ready to save)
+ */
+bool keepRecordedTake();
+
+/**
+ * Save recorded takes to spells.json
+ * Adds the takes to "custom" section with auto-generated name, keeping
+ * the SPELL_MAX_EXEMPLARS most representative ones
  * Returns true on success, false on failure
  */
 bool saveRecordedSpell();
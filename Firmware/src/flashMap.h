@@ -0,0 +1,53 @@
+/*
+================================================================================
+  Flash Map - Partition Memory Mapping Across ESP-IDF Versions
+================================================================================
+
+  esp_partition_mmap() takes ESP-IDF 5.1's esp_partition_mmap_* handle and
+  memory types. Arduino-ESP32 2.x (ESP-IDF 4.4), which the unpinned
+  espressif32 platform still builds with, has the same call taking the
+  spi_flash_mmap_* ones and unmaps with spi_flash_munmap(). The names
+  here build against either.
+
+  Used by:
+    - mediaBundle.cpp (MEDIA_PARTITION): maps the media bundle
+    - hotPath.cpp (BENCHMARK_LATENCY): maps the app for the flash sweep
+
+================================================================================
+*/
+
+#ifndef FLASH_MAP_H
+#define FLASH_MAP_H
+
+#include <esp_idf_version.h>
+#include <esp_partition.h>
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+
+typedef esp_partition_mmap_handle_t FlashMapHandle;
+#define FLASH_MAP_DATA ESP_PARTITION_MMAP_DATA
+
+/**
+ * Release a mapping made with esp_partition_mmap()
+ */
+inline void flashUnmap(FlashMapHandle handle) {
+  esp_partition_munmap(handle);
+}
+
+#else // ESP-IDF 4.4
+
+#include <esp_spi_flash.h>
+
+typedef spi_flash_mmap_handle_t FlashMapHandle;
+#define FLASH_MAP_DATA SPI_FLASH_MMAP_DATA
+
+/**
+ * Release a mapping made with esp_partition_mmap()
+ */
+inline void flashUnmap(FlashMapHandle handle) {
+  spi_flash_munmap(handle);
+}
+
+#endif
+
+#endif // FLASH_MAP_H
@@ -0,0 +1,259 @@
+/*
+================================================================================
+  Fleet Protocol - Cast Arbitration Between Readers
+================================================================================
+
+  Implements the protocol core declared in fleetProtocol.h.
+
+  Everything here is plain C++ on caller-supplied clocks and buffers, so
+  Tools/fleet_sim runs it unchanged on a PC.
+
+================================================================================
+*/
+
+#include "fleetProtocol.h"
+#include <string.h>
+
+//=====================================
+// Helpers
+//=====================================
+
+/**
+ * Peer slot for an ID, claiming a free or expired slot for a new peer
+ * return Peer, or nullptr if the table is full
+ */
+static FleetPeer* peerSlot(FleetNode& node, uint32_t id, int64_t now) {
+  FleetPeer* freeSlot = nullptr;
+  for (FleetPeer& peer : node.peers) {
+    if (peer.id == id) return &peer;
+    bool expired = peer.id == 0 || now - peer.lastHeard > node.config.peerTimeout;
+    if (expired && freeSlot == nullptr) freeSlot = &peer;
+  }
+  if (freeSlot != nullptr) {
+    memset(freeSlot, 0, sizeof(*freeSlot));
+    freeSlot->id = id;
+  }
+  return freeSlot;
+}
+
+/**
+ * Start a packet header
+ */
+static void beginPacket(FleetNode& node, FleetPacket& packet, FleetPacketType type, int64_t now) {
+  memset(&packet, 0, sizeof(packet));
+  packet.magic = FLEET_MAGIC;
+  packet.version = FLEET_VERSION;
+  packet.type = type;
+  packet.sequence = node.sequence++;
+  packet.sender = node.id;
+  packet.sendTime = now;
+}
+
+
+/**
+ * Add a round-trip sample and re-pick the best offset
+ */
+static void addClockSample(FleetPeer& peer, int64_t offset, int64_t delay) {
+  peer.samples[peer.nextSample] = {offset, delay};
+  peer.nextSample = (peer.nextSample + 1) % FLEET_OFFSET_SAMPLES;
+  if (peer.sampleCount < FLEET_OFFSET_SAMPLES) peer.sampleCount++;
+
+  // Shortest round trip = least queueing, so the least asymmetric sample
+  const FleetClockSample* best = &peer.samples[0];
+  for (uint8_t i = 1; i < peer.sampleCount; i++) {
+    if (peer.samples[i].delay < best->delay) best = &peer.samples[i];
+  }
+  peer.offset = best->offset;
+  peer.delay = best->delay;
+  peer.synced = true;
+}
+
+//=====================================
+// Node Functions
+//=====================================
+
+void initFleetNode(FleetNode& node, uint32_t id, int64_t now) {
+  memset(&node, 0, sizeof(node));
+  node.id = id;
+  node.config.window = FLEET_WINDOW_MS * 1000LL;
+  node.config.match = FLEET_MATCH_MS * 1000LL;
+  node.config.helloInterval = FLEET_HELLO_MS * 1000LL;
+  node.config.peerTimeout = FLEET_PEER_TIMEOUT_MS * 1000LL;
+  node.nextHello = now;  // Announce at once
+}
+
+size_t fleetAnnounceCast(FleetNode& node, const char* payload, float score,
+                         int64_t now, FleetPacket& packet) {
+  FleetCast* slot = nullptr;
+  for (FleetCast& cast : node.pending) {
+    if (cast.reader == 0) {
+      slot = &cast;
+      break;
+    }
+  }
+  if (slot == nullptr) {
+    node.stats.unannounced++;
+    return 0;
+  }
+
+  slot->reader = node.id;
+  fleetCopyPayload(slot->payload, payload);
+  slot->score = score;
+  slot->castTime = now;
+  slot->decideAt = now + node.config.window;
+
+  beginPacket(node, packet, FLEET_CAST, now);
+  packet.castTime = now;
+  packet.score = score;
+  fleetCopyPayload(packet.payload, payload);
+  return sizeof(packet);
+}
+
+size_t fleetHello(FleetNode& node, int64_t now, FleetPacket& packet) {
+  if (now < node.nextHello) return 0;
+  node.nextHello = now + node.config.helloInterval;
+  beginPacket(node, packet, FLEET_HELLO, now);
+
+  // Echo one peer's last HELLO, taking turns so every peer gets samples
+  for (uint8_t i = 0; i < FLEET_MAX_PEERS; i++) {
+    FleetPeer& peer = node.peers[(node.nextEcho + i) % FLEET_MAX_PEERS];
+    if (peer.id == 0 || !peer.echoPending) continue;
+    packet.echoReader = peer.id;
+    packet.echoTime = peer.helloTime;
+    packet.echoHold = (int32_t)(now - peer.helloReceived);
+    peer.echoPending = false;
+    node.nextEcho = (node.nextEcho + i + 1) % FLEET_MAX_PEERS;
+    break;
+  }
+  return sizeof(packet);
+}
+
+void fleetReceive(FleetNode& node, const uint8_t* data, size_t length, int64_t now) {
+  FleetPacket packet;
+  if (length != sizeof(packet)) {
+    node.stats.rejected++;
+    return;
+  }
+  memcpy(&packet, data, sizeof(packet));
+  if (packet.magic != FLEET_MAGIC || packet.version != FLEET_VERSION || packet.sender == 0) {
+    node.stats.rejected++;
+    return;
+  }
+  if (packet.sender == node.id) return;  // Own datagram looped back
+
+  FleetPeer* peer = peerSlot(node, packet.sender, now);
+  if (peer == nullptr) return;  // Table full - arbitration falls back to duplicates
+  peer->lastHeard = now;
+
+  if (packet.type == FLEET_HELLO) {
+    peer->helloTime = packet.sendTime;
+    peer->helloReceived = now;
+    peer->echoPending = true;
+
+    if (packet.echoReader == node.id && packet.echoTime <= now) {
+      // t1 = our HELLO sent, t2/t3 = peer received/replied, t4 = now
+      int64_t t1 = packet.echoTime;
+      int64_t t3 = packet.sendTime;
+      int64_t t2 = t3 - packet.echoHold;
+      int64_t delay = (now - t1) - packet.echoHold;
+      if (delay >= 0) addClockSample(*peer, ((t2 - t1) + (t3 - now)) / 2, delay);
+    }
+  } else if (packet.type == FLEET_CAST || packet.type == FLEET_CLAIM) {
+    FleetCast& cast = node.peerCasts[node.nextPeerCast];
+    node.nextPeerCast = (node.nextPeerCast + 1) % FLEET_MAX_CASTS;
+    cast.reader = packet.sender;
+    packet.payload[FLEET_NAME_LENGTH - 1] = '\0';
+    fleetCopyPayload(cast.payload, packet.payload);
+    cast.score = packet.score;
+    if (peer->synced) {
+      cast.castTime = packet.castTime - peer->offset;
+    } else {
+      // No clock yet: the age the sender reports, ignoring transit
+      cast.castTime = now - (packet.sendTime - packet.castTime);
+    }
+    cast.claimed = packet.type == FLEET_CLAIM;
+    if (cast.claimed) {
+      node.stats.peerClaims++;
+    } else {
+      node.stats.peerCasts++;
+    }
+  } else {
+    node.stats.rejected++;
+  }
+}
+
+bool fleetDecide(FleetNode& node, int64_t now, FleetDecision& decision) {
+  for (FleetCast& own : node.pending) {
+    if (own.reader == 0 || now < own.decideAt) continue;
+
+    fleetCopyPayload(decision.payload, own.payload);
+    decision.score = own.score;
+    decision.castTime = own.castTime;
+    decision.publish = true;
+    decision.deferredTo = 0;
+    decision.latency = now - own.castTime;
+
+    for (const FleetCast& peer : node.peerCasts) {
+      if (peer.reader == 0 || strcmp(peer.payload, own.payload) != 0) continue;
+      int64_t lead = own.castTime - peer.castTime;
+      if (lead > node.config.match || lead < -node.config.match) continue;  // Another cast
+
+      // Only ever defer to a better cast or a finished publish, so
+      // following deferrals always ends at a reader that published
+      bool peerWins = peer.claimed || peer.score > own.score ||
+                      (peer.score == own.score && peer.reader < node.id);
+      if (peerWins) {
+        decision.publish = false;
+        decision.deferredTo = peer.reader;
+        break;
+      }
+    }
+
+    if (decision.publish) {
+      node.stats.published++;
+    } else {
+      node.stats.deferred++;
+    }
+    own.reader = 0;
+    return true;
+  }
+  return false;
+}
+
+size_t fleetClaim(FleetNode& node, const FleetDecision& decision, int64_t now, FleetPacket& packet) {
+  if (!decision.publish) return 0;
+  beginPacket(node, packet, FLEET_CLAIM, now);
+  packet.castTime = decision.castTime;
+  packet.score = decision.score;
+  fleetCopyPayload(packet.payload, decision.payload);
+  return sizeof(packet);
+}
+
+int64_t fleetNextEvent(const FleetNode& node) {
+  int64_t next = node.nextHello;
+  for (const FleetCast& own : node.pending) {
+    if (own.reader != 0 && own.decideAt < next) next = own.decideAt;
+  }
+  return next;
+}
+
+size_t fleetPeerCount(const FleetNode& node, int64_t now) {
+  size_t count = 0;
+  for (const FleetPeer& peer : node.peers) {
+    if (peer.id != 0 && now - peer.lastHeard <= node.config.peerTimeout) count++;
+  }
+  return count;
+}
+
+void fleetCopyPayload(char* destination, const char* source) {
+  size_t length = strnlen(source, FLEET_NAME_LENGTH - 1);
+  memcpy(destination, source, length);
+  memset(destination + length, 0, FLEET_NAME_LENGTH - length);
+}
+
+const FleetPeer* fleetFindPeer(const FleetNode& node, uint32_t id) {
+  for (const FleetPeer& peer : node.peers) {
+    if (peer.id == id) return &peer;
+  }
+  return nullptr;
+}
@@ -0,0 +1,261 @@
+/*
+================================================================================
+  Fleet Protocol - Cast Arbitration Between Readers Header
+================================================================================
+
+  When two or three readers share a room, one wand cast is often
+  recognized by several of them and each would publish it to MQTT,
+  firing the automation several times. Readers announce their casts to
+  each other over UDP multicast and only one of them publishes.
+
+  This file is the transport-free core: packet format, clock offset
+  estimation and the arbitration rule. It has no Arduino dependencies so
+  the host simulator (Tools/fleet_sim) runs the same code as the
+  firmware; fleetSync.h supplies the ESP32 socket and task.
+
+  Clocks:
+    - Every timestamp is the sender's monotonic clock in microseconds
+      (esp_timer_get_time()); nothing depends on NTP
+    - HELLOs go out every FLEET_HELLO_MS and each one echoes the last
+      HELLO heard from one peer (round robin) with the time it was held,
+      giving an NTP-style round trip: offset = ((t2 - t1) + (t3 - t4)) / 2
+    - Each peer keeps its last FLEET_OFFSET_SAMPLES samples and trusts the
+      one with the shortest round trip (least queueing, least asymmetry)
+
+  Arbitration:
+    - A reader announces a cast (payload, score, cast time) the moment it
+      recognizes it and decides FLEET_WINDOW_MS later
+    - Peer casts of the same payload within FLEET_MATCH_MS are the same
+      wand movement. A reader defers if it heard a better one (higher
+      score; ties: lower reader ID), otherwise it publishes and sends a
+      CLAIM; a reader that hears a CLAIM first defers too
+    - Readers casting within FLEET_TRANSIT_MS of each other hear each
+      other's casts before deciding; further apart, the later one hears
+      the earlier one's CLAIM (window >= 2 x transit) - exactly one
+      publish either way
+    - Every deferral points at a better cast or at a reader that already
+      published, so a lost datagram means a duplicate publish, never a
+      lost one
+
+================================================================================
+*/
+
+#ifndef FLEET_PROTOCOL_H
+#define FLEET_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//=====================================
+// Configuration
+//=====================================
+
+#define FLEET_MAGIC 0x4C465247          // "GRFL" little endian
+#define FLEET_VERSION 1
+#define FLEET_NAME_LENGTH 40            // Cast payload, including terminator
+#define FLEET_MAX_PEERS 4               // Other readers tracked
+#define FLEET_MAX_CASTS 16              // Recent peer casts and claims kept for arbitration
+#define FLEET_MAX_PENDING 4             // Own casts waiting for their window
+#define FLEET_OFFSET_SAMPLES 8          // Clock samples kept per peer
+
+#define FLEET_WINDOW_MS 12              // Own cast waits this long before deciding
+#define FLEET_TRANSIT_MS 4              // Assumed worst one-way delivery on the LAN
+#define FLEET_MATCH_MS 500              // Same payload this close = same cast
+#define FLEET_HELLO_MS 1000             // HELLO (clock sync) interval
+#define FLEET_PEER_TIMEOUT_MS 5000      // Peer forgotten after this silence
+
+static_assert(FLEET_WINDOW_MS >= 2 * FLEET_TRANSIT_MS,
+              "The window must cover a cast and a claim in transit");
+
+//=====================================
+// Packet Format
+//=====================================
+
+/**
+ * Packet types
+ */
+enum FleetPacketType : uint8_t {
+  FLEET_HELLO = 1,    ///< Presence and clock sync
+  FLEET_CAST = 2,     ///< Cast announcement
+  FLEET_CLAIM = 3     ///< Cast published by the sender
+};
+
+/**
+ * Datagram layout (little endian, packed)
+ */
+struct __attribute__((packed)) FleetPacket {
+  uint32_t magic;           // FLEET_MAGIC
+  uint8_t version;          // FLEET_VERSION
+  uint8_t type;             // FleetPacketType
+  uint16_t sequence;        // Per-sender counter
+  uint32_t sender;          // Reader ID
+  int64_t sendTime;         // Sender clock when sent (us)
+  uint32_t echoReader;      // HELLO: reader whose HELLO is echoed (0 = none)
+  int64_t echoTime;         // HELLO: sendTime of the echoed HELLO
+  int32_t echoHold;         // HELLO: held between receiving it and sending this (us)
+  int64_t castTime;         // CAST, CLAIM: sender clock when recognized (us)
+  float score;              // CAST, CLAIM: match score (0.0 to 1.0)
+  char payload[FLEET_NAME_LENGTH];  // CAST, CLAIM: MQTT payload (spell name)
+};
+
+//=====================================
+// Node State
+//=====================================
+
+/**
+ * Timing parameters (microseconds), from the defines above
+ * The simulator varies them; the firmware keeps the defaults.
+ */
+struct FleetConfig {
+  int64_t window;           // FLEET_WINDOW_MS
+  int64_t match;            // FLEET_MATCH_MS
+  int64_t helloInterval;    // FLEET_HELLO_MS
+  int64_t peerTimeout;      // FLEET_PEER_TIMEOUT_MS
+};
+
+/**
+ * One round-trip clock measurement
+ */
+struct FleetClockSample {
+  int64_t offset;           // Peer clock minus local clock (us)
+  int64_t delay;            // Round trip without the peer's hold time (us)
+};
+
+/**
+ * Another reader
+ */
+struct FleetPeer {
+  uint32_t id;              // Reader ID (0 = free slot)
+  int64_t lastHeard;        // Local time of its last packet
+  int64_t helloTime;        // sendTime of its last HELLO, echoed back
+  int64_t helloReceived;    // Local time that HELLO arrived
+  bool echoPending;         // That HELLO has not been echoed yet
+  FleetClockSample samples[FLEET_OFFSET_SAMPLES];
+  uint8_t sampleCount;      // Valid entries in samples
+  uint8_t nextSample;       // Ring position
+  bool synced;              // offset is valid
+  int64_t offset;           // Best estimate of peer clock minus local clock (us)
+  int64_t delay;            // Round trip of the sample it came from (us)
+};
+
+/**
+ * A cast, own or heard from a peer
+ */
+struct FleetCast {
+  uint32_t reader;          // Reader that recognized it (0 = free slot)
+  char payload[FLEET_NAME_LENGTH];
+  float score;
+  int64_t castTime;         // Local clock (peer casts converted)
+  int64_t decideAt;         // Own casts: end of the window
+  bool claimed;             // Peer casts: heard as a CLAIM (already published)
+};
+
+/**
+ * Arbitration outcome for one own cast
+ */
+struct FleetDecision {
+  char payload[FLEET_NAME_LENGTH];
+  float score;
+  int64_t castTime;         // Local clock
+  bool publish;             // This reader publishes
+  uint32_t deferredTo;      // Otherwise, the reader that does (or did)
+  int64_t latency;          // Cast to decision (us)
+};
+
+/**
+ * Counters since start
+ */
+struct FleetStats {
+  uint32_t published;       // Own casts published
+  uint32_t deferred;        // Own casts left to a peer
+  uint32_t unannounced;     // Own casts published without arbitration (queue full)
+  uint32_t peerCasts;       // Casts heard from peers
+  uint32_t peerClaims;      // Claims heard from peers
+  uint32_t rejected;        // Malformed or foreign packets
+};
+
+/**
+ * Protocol state of one reader
+ */
+struct FleetNode {
+  uint32_t id;              // This reader (non-zero)
+  FleetConfig config;
+  uint16_t sequence;        // Next packet sequence number
+  int64_t nextHello;        // Local time the next HELLO is due
+  uint8_t nextEcho;         // Round-robin start for the echoed peer
+  FleetPeer peers[FLEET_MAX_PEERS];
+  FleetCast peerCasts[FLEET_MAX_CASTS];
+  uint8_t nextPeerCast;     // Ring position in peerCasts
+  FleetCast pending[FLEET_MAX_PENDING];
+  FleetStats stats;
+};
+
+//=====================================
+// Node Functions
+//=====================================
+
+/**
+ * Reset a node with the default timing
+ * id: This reader's ID (non-zero, unique on the LAN)
+ * now: Local clock (us)
+ */
+void initFleetNode(FleetNode& node, uint32_t id, int64_t now);
+
+/**
+ * Queue an own cast for arbitration and build its announcement
+ * packet: Output datagram
+ * return Datagram length, or 0 if FLEET_MAX_PENDING casts are already
+ *        waiting (publish directly)
+ */
+size_t fleetAnnounceCast(FleetNode& node, const char* payload, float score,
+                         int64_t now, FleetPacket& packet);
+
+/**
+ * Build a HELLO if one is due
+ * return Datagram length, or 0 if not due yet
+ */
+size_t fleetHello(FleetNode& node, int64_t now, FleetPacket& packet);
+
+/**
+ * Handle a received datagram
+ * data, length: Datagram as received
+ * now: Local clock when it arrived (us)
+ */
+void fleetReceive(FleetNode& node, const uint8_t* data, size_t length, int64_t now);
+
+/**
+ * Take the next own cast whose window has closed
+ * return true if decision was filled in (call again for more)
+ */
+bool fleetDecide(FleetNode& node, int64_t now, FleetDecision& decision);
+
+/**
+ * Build the CLAIM for a decision to publish
+ * Send it as soon as the cast is published, so later readers defer.
+ * return Datagram length, or 0 if the decision was to defer
+ */
+size_t fleetClaim(FleetNode& node, const FleetDecision& decision, int64_t now, FleetPacket& packet);
+
+/**
+ * Local time of the next HELLO or decision (us)
+ */
+int64_t fleetNextEvent(const FleetNode& node);
+
+/**
+ * Number of peers heard within FLEET_PEER_TIMEOUT_MS
+ */
+size_t fleetPeerCount(const FleetNode& node, int64_t now);
+
+/**
+ * Peer entry by ID, or nullptr
+ */
+const FleetPeer* fleetFindPeer(const FleetNode& node, uint32_t id);
+
+/**
+ * Copy a payload into a FLEET_NAME_LENGTH field
+ * Truncated if longer, always terminated, and the rest of the field
+ * zeroed so no stale bytes go out on the wire.
+ */
+void fleetCopyPayload(char* destination, const char* source);
+
+#endif // FLEET_PROTOCOL_H
@@ -0,0 +1,253 @@
+/*
+================================================================================
+  Fleet Sync - Multi-Reader Cast Deduplication
+================================================================================
+
+  Implements the transport declared in fleetSync.h around the protocol
+  core in fleetProtocol.cpp.
+
+  The FleetNode is owned by the fleet task; the status endpoint reads it
+  under fleetMutex.
+
+================================================================================
+*/
+
+#define LOG_MODULE LogModule::NETWORK
+
+#include "fleetSync.h"
+
+#ifdef FLEET_SYNC
+
+#include "fleetProtocol.h"
+#include "glyphReader.h"
+#include "heapFunctions.h"
+#include "webFunctions.h"
+#include "wifiFunctions.h"
+#include "memoryPolicy.h"
+#include <AsyncUDP.h>
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+//=====================================
+// Fleet State
+//=====================================
+
+/**
+ * Work for the fleet task
+ */
+struct FleetEvent {
+  bool local;               // Own cast (else a received datagram)
+  int64_t time;             // Cast time or arrival time (us)
+  float score;              // Own cast score
+  uint16_t length;          // Datagram length as received
+  union {
+    char payload[FLEET_NAME_LENGTH];      // Own cast
+    uint8_t data[sizeof(FleetPacket)];    // Received datagram
+  };
+};
+
+static FleetNode fleetNode;
+static AsyncUDP fleetUdp;
+static QueueHandle_t fleetQueue = NULL;
+static SemaphoreHandle_t fleetMutex = NULL;
+static TaskHandle_t fleetTaskHandle = NULL;
+static volatile bool fleetListening = false;
+static volatile uint8_t fleetPeers = 0;
+
+//=====================================
+// Transport
+//=====================================
+
+/**
+ * Send a datagram to the group
+ */
+static void sendPacket(const FleetPacket& packet, size_t length) {
+  if (length == 0) return;
+  fleetUdp.writeTo((const uint8_t*)&packet, length, FLEET_GROUP, FLEET_PORT);
+}
+
+/**
+ * Join the group once the station link is up, leave when it drops
+ */
+static void updateMembership() {
+  bool connected = isWiFiConnected();
+  if (connected == fleetListening) return;
+
+  if (!connected) {
+    fleetUdp.close();
+    fleetListening = false;
+    fleetPeers = 0;
+    LOG_DEBUG("Fleet: left multicast group");
+    return;
+  }
+
+  if (!fleetUdp.listenMulticast(FLEET_GROUP, FLEET_PORT)) {
+    LOG_ALWAYS("Fleet: could not join %s:%d", FLEET_GROUP.toString().c_str(), FLEET_PORT);
+    return;
+  }
+  fleetUdp.onPacket([](AsyncUDPPacket& packet) {
+    FleetEvent event;
+    event.local = false;
+    event.time = esp_timer_get_time();  // Arrival, before any queueing
+    event.length = packet.length();
+    memcpy(event.data, packet.data(), min((size_t)packet.length(), sizeof(event.data)));
+    xQueueSend(fleetQueue, &event, 0);  // Full queue: drop, worst case a duplicate publish
+  });
+  fleetListening = true;
+  LOG_DEBUG("Fleet: reader %08lX on %s:%d", (unsigned long)fleetNode.id,
+            FLEET_GROUP.toString().c_str(), FLEET_PORT);
+}
+
+/**
+ * Publish (and claim) or drop each own cast whose window has closed
+ */
+static void applyDecisions(int64_t now) {
+  FleetDecision decision;
+  while (fleetDecide(fleetNode, now, decision)) {
+    if (decision.publish) {
+      publishSpell(decision.payload);
+      FleetPacket packet;
+      sendPacket(packet, fleetClaim(fleetNode, decision, now, packet));
+      LOG_DEBUG("Fleet: published %s (%.2f) after %ld us", decision.payload,
+                decision.score, (long)decision.latency);
+    } else {
+      LOG_DEBUG("Fleet: %s (%.2f) left to reader %08lX", decision.payload,
+                decision.score, (unsigned long)decision.deferredTo);
+    }
+  }
+}
+
+/**
+ * Handle one queued event
+ */
+static void handleEvent(const FleetEvent& event) {
+  if (!event.local) {
+    fleetReceive(fleetNode, event.data, event.length, event.time);
+    return;
+  }
+
+  FleetPacket packet;
+  size_t length = fleetListening ?
+      fleetAnnounceCast(fleetNode, event.payload, event.score, event.time, packet) : 0;
+  if (length == 0) {
+    publishSpell(event.payload);  // Offline or too many pending - no arbitration
+    return;
+  }
+  sendPacket(packet, length);
+}
+
+/**
+ * Fleet task: sleeps on the queue until an event or the next HELLO/decision
+ */
+static void fleetTask(void* parameter) {
+  LOG_DEBUG("Fleet task started on Core %d", xPortGetCoreID());
+  HEAP_TASK_TAG(HeapTag::WEB);
+
+  while (true) {
+    updateMembership();
+
+    TickType_t wait = pdMS_TO_TICKS(FLEET_IDLE_WAIT_MS);
+    if (fleetListening) {
+      int64_t untilNext = fleetNextEvent(fleetNode) - esp_timer_get_time();
+      wait = untilNext <= 0 ? 0 : pdMS_TO_TICKS((untilNext + 999) / 1000);
+    }
+
+    FleetEvent event;
+    bool received = xQueueReceive(fleetQueue, &event, wait) == pdTRUE;
+
+    xSemaphoreTake(fleetMutex, portMAX_DELAY);
+    if (received) handleEvent(event);
+    int64_t now = esp_timer_get_time();
+    applyDecisions(now);
+    if (fleetListening) {
+      FleetPacket packet;
+      sendPacket(packet, fleetHello(fleetNode, now, packet));
+      fleetPeers = fleetPeerCount(fleetNode, now);
+    }
+    xSemaphoreGive(fleetMutex);
+  }
+}
+
+//=====================================
+// Fleet Functions
+//=====================================
+
+void initFleetSync() {
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  uint32_t id = ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+  initFleetNode(fleetNode, id ? id : 1, esp_timer_get_time());
+
+  fleetQueue = xQueueCreate(FLEET_QUEUE_LENGTH, sizeof(FleetEvent));
+  fleetMutex = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(
+    fleetTask,          // Task function
+    "FleetTask",        // Task name
+    FLEET_TASK_STACK,   // Stack size
+    NULL,               // Parameters
+    2,                  // Priority (above the WiFi task, so decisions stay on time)
+    &fleetTaskHandle,   // Task handle
+    0                   // Core 0 (WiFi core)
+  );
+}
+
+void fleetPublishSpell(const char* payload, float score) {
+  if (fleetQueue == NULL || !fleetListening || fleetPeers == 0) {
+    publishSpell(payload);  // Alone on the LAN - nothing to arbitrate
+    return;
+  }
+
+  FleetEvent event;
+  event.local = true;
+  event.time = esp_timer_get_time();
+  event.score = score;
+  event.length = 0;
+  fleetCopyPayload(event.payload, payload);
+  if (xQueueSend(fleetQueue, &event, 0) != pdTRUE) {
+    publishSpell(payload);
+  }
+}
+
+String fleetStatusJson() {
+  if (fleetMutex == NULL) return "{}";
+  JsonDocument doc(bulkJsonAllocator());
+
+  xSemaphoreTake(fleetMutex, portMAX_DELAY);
+  int64_t now = esp_timer_get_time();
+  char id[9];
+  snprintf(id, sizeof(id), "%08lX", (unsigned long)fleetNode.id);
+  doc["reader"] = id;
+  doc["listening"] = fleetListening;
+  doc["windowMs"] = FLEET_WINDOW_MS;
+
+  JsonArray peers = doc["peers"].to<JsonArray>();
+  for (const FleetPeer& peer : fleetNode.peers) {
+    if (peer.id == 0 || now - peer.lastHeard > fleetNode.config.peerTimeout) continue;
+    JsonObject entry = peers.add<JsonObject>();
+    snprintf(id, sizeof(id), "%08lX", (unsigned long)peer.id);
+    entry["reader"] = id;
+    entry["lastHeardMs"] = (long)((now - peer.lastHeard) / 1000);
+    entry["synced"] = peer.synced;
+    if (peer.synced) {
+      entry["offsetUs"] = (long long)peer.offset;
+      entry["rttUs"] = (long long)peer.delay;
+    }
+  }
+
+  JsonObject stats = doc["casts"].to<JsonObject>();
+  stats["published"] = fleetNode.stats.published;
+  stats["deferred"] = fleetNode.stats.deferred;
+  stats["unannounced"] = fleetNode.stats.unannounced;
+  stats["peerCasts"] = fleetNode.stats.peerCasts;
+  stats["peerClaims"] = fleetNode.stats.peerClaims;
+  stats["rejected"] = fleetNode.stats.rejected;
+  xSemaphoreGive(fleetMutex);
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+
+#endif // FLEET_SYNC
@@ -0,0 +1,76 @@
+/*
+================================================================================
+  Fleet Sync - Multi-Reader Cast Deduplication Header
+================================================================================
+
+  Runs the fleet protocol (fleetProtocol.h) over UDP multicast so that
+  when several readers recognize the same cast, only the best-scoring
+  one publishes it to MQTT. Enabled with -D FLEET_SYNC; every reader in
+  the room needs it.
+
+  Transport:
+    - AsyncUDP on FLEET_GROUP:FLEET_PORT, TTL 1 (never leaves the LAN),
+      joined whenever the station link is up
+    - Received datagrams are timestamped in the AsyncUDP callback and
+      queued, with own casts, to the fleet task on core 0; the task
+      sleeps on that queue until the next HELLO or decision is due
+
+  Publishing:
+    - castSpell() hands the MQTT publish to fleetPublishSpell(); sound,
+      LEDs and screen still react on every reader at once
+    - With no peer heard recently (or no WiFi) the publish is immediate
+    - With peers, the cast is announced and published FLEET_WINDOW_MS
+      later only if this reader wins - the added latency is the window,
+      decided on core 0 so the loop on core 1 never waits
+    - Reader ID: last four bytes of the WiFi MAC
+
+  Status: peers with clock offsets and round trips, and decision counts,
+  as JSON at http://<device>/fleet
+
+================================================================================
+*/
+
+#ifndef FLEET_SYNC_H
+#define FLEET_SYNC_H
+
+#include <Arduino.h>
+
+//=====================================
+// Configuration
+//=====================================
+
+#define FLEET_GROUP IPAddress(239, 71, 82, 1)  // Multicast group ("GR")
+#define FLEET_PORT 47821                // UDP port
+#define FLEET_QUEUE_LENGTH 8            // Casts and datagrams waiting for the fleet task
+#define FLEET_IDLE_WAIT_MS 1000         // Fleet task wake-up while offline
+#define FLEET_TASK_STACK 4096           // Fleet task stack (bytes)
+
+#ifdef FLEET_SYNC
+
+//=====================================
+// Fleet Functions
+//=====================================
+
+/**
+ * Start the fleet task on core 0
+ * Call once in setup(), after the WiFi task is created. The multicast
+ * group is joined whenever the station link is up.
+ */
+void initFleetSync();
+
+/**
+ * Publish a recognized cast unless another reader saw it better
+ * Returns at once; the publish happens on core 0.
+ * payload: MQTT payload (spell name)
+ * score: Match score (0.0 to 1.0)
+ */
+void fleetPublishSpell(const char* payload, float score);
+
+/**
+ * Peers, clock offsets and decision counts as JSON (the /fleet endpoint)
+ */
+String fleetStatusJson();
+
+#endif // FLEET_SYNC
+
+#endif // FLEET_SYNC_H
@@ -0,0 +1,267 @@
+/*
+================================================================================
+  Gesture Spotter - Continuous Spell Spotting Implementation
+================================================================================
+
+  Implements the spotter declared in gestureSpotter.h.
+
+  Data Flow:
+    feedSpotter()   - point into ring buffer, speed update, boundary check,
+                      candidate segments queued on each gesture end
+    pollSpotter()   - scores up to SPOT_CANDIDATES_PER_FRAME queued segments,
+                      reports the best once the queue drains
+    finishSpotter() - IR lost: final gesture end, drains the whole queue
+
+  Boundaries and candidates are stored as timestamps rather than buffer
+  indices, so they stay valid while the ring buffer wraps. A boundary that
+  has fallen out of the window is skipped when candidates are queued.
+
+================================================================================
+*/
+
+#define LOG_MODULE LogModule::MATCHING
+
+#include "gestureSpotter.h"
+#include "glyphReader.h"
+#include "spell_matching.h"
+#include "preferenceFunctions.h"
+#include "hotPath.h"
+#include <cmath>
+#include <climits>
+
+//=====================================
+// Spotter State
+//=====================================
+
+/**
+ * Candidate segment awaiting scoring
+ */
+struct SpotCandidate {
+  uint32_t start;   // First point timestamp
+  uint32_t end;     // Last point timestamp
+};
+
+// Motion window (ring buffer, oldest at windowHead when full)
+static Point window[SPOT_WINDOW_POINTS];
+static uint16_t windowHead = 0;
+static uint16_t windowCount = 0;
+
+// Segment boundaries (ring buffer of timestamps, oldest first)
+static uint32_t boundaries[SPOT_MAX_BOUNDARIES];
+static uint8_t boundaryHead = 0;
+static uint8_t boundaryCount = 0;
+
+// Velocity minimum detection
+static float speed = 0;
+static float prevSpeed = 0;
+static float peakSpeed = 0;
+static bool moving = false;
+static bool slowing = false;
+
+// Pending candidates (ring buffer)
+static SpotCandidate queue[SPOT_QUEUE_SIZE];
+static uint8_t queueHead = 0;
+static uint8_t queueCount = 0;
+
+// Best candidate scored since the queue was last empty
+static SpotResult best = {SPELL_ID_NONE, 0, {}};
+
+//=====================================
+// Helpers
+//=====================================
+
+static const Point& HOT_CODE windowAt(uint16_t i) {
+  uint16_t start = (windowCount < SPOT_WINDOW_POINTS) ? 0 : windowHead;
+  return window[(start + i) % SPOT_WINDOW_POINTS];
+}
+
+static void HOT_CODE addBoundary(uint32_t timestamp) {
+  boundaries[(boundaryHead + boundaryCount) % SPOT_MAX_BOUNDARIES] = timestamp;
+  if (boundaryCount < SPOT_MAX_BOUNDARIES) {
+    boundaryCount++;
+  } else {
+    boundaryHead = (boundaryHead + 1) % SPOT_MAX_BOUNDARIES;
+  }
+}
+
+static void HOT_CODE enqueueCandidate(uint32_t start, uint32_t end) {
+  queue[(queueHead + queueCount) % SPOT_QUEUE_SIZE] = {start, end};
+  if (queueCount < SPOT_QUEUE_SIZE) {
+    queueCount++;
+  } else {
+    queueHead = (queueHead + 1) % SPOT_QUEUE_SIZE;  // Drop oldest
+  }
+}
+
+/**
+ * Record a gesture end and queue segments from earlier boundaries to it
+ * Newest starts are queued first so the shortest plausible segments are
+ * kept when a long window has more boundaries than SPOT_MAX_CANDIDATES.
+ */
+static void HOT_CODE addGestureEnd(uint32_t end) {
+  uint32_t oldest = windowAt(0).timestamp;
+  uint8_t queued = 0;
+
+  for (int i = boundaryCount - 1; i >= 0 && queued < SPOT_MAX_CANDIDATES; i--) {
+    uint32_t start = boundaries[(boundaryHead + i) % SPOT_MAX_BOUNDARIES];
+    uint32_t duration = end - start;
+    if (start < oldest || duration > (uint32_t)GESTURE_TIMEOUT) break;  // Older ones are too
+    if (duration < SPOT_MIN_DURATION) continue;
+    enqueueCandidate(start, end);
+    queued++;
+  }
+  addBoundary(end);
+}
+
+/**
+ * Score one candidate segment, keeping it if it beats the best so far
+ */
+static void HOT_CODE scoreCandidate(const SpotCandidate& candidate) {
+  std::vector<Point> segment;
+  int minX = INT_MAX, maxX = INT_MIN, minY = INT_MAX, maxY = INT_MIN;
+
+  for (uint16_t i = 0; i < windowCount; i++) {
+    const Point& p = windowAt(i);
+    if (p.timestamp < candidate.start) continue;
+    if (p.timestamp > candidate.end) break;
+    segment.push_back(p);
+    minX = min(minX, p.x);
+    maxX = max(maxX, p.x);
+    minY = min(minY, p.y);
+    maxY = max(maxY, p.y);
+  }
+
+  // Cheap rejections before resampling
+  if (segment.size() < SPOT_MIN_POINTS) return;
+  if (maxX - minX < SPOT_MIN_EXTENT && maxY - minY < SPOT_MIN_EXTENT) return;
+
+  std::vector<Point> resampled = resampleTrajectory(normalizeTrajectory(segment), RESAMPLE_POINTS);
+  float score = 0;
+  SpellId spell = findBestSpellId(resampled, score);
+
+  if (score > best.score) {
+    best.spell = spell;
+    best.score = score;
+    best.resampled = resampled;
+  }
+}
+
+/**
+ * Report the best candidate once the queue has drained
+ * return true if it cleared the spotting threshold
+ */
+static bool HOT_CODE takeBest(SpotResult& result) {
+  if (queueCount > 0 || best.spell == SPELL_ID_NONE) return false;
+
+  bool spotted = best.score >= MATCH_THRESHOLD + SPOT_MATCH_MARGIN;
+  if (spotted) {
+    result = best;
+    LOG_DEBUG("Spotted %s (%.2f%%)", spellName(best.spell), best.score * 100);
+
+    // Start afresh from the current position so the same motion can't fire twice
+    Point last = windowAt(windowCount - 1);
+    resetSpotter();
+    feedSpotter(last);
+  } else {
+    LOG_DEBUG("Spotting: best %s %.2f%% below threshold", spellName(best.spell), best.score * 100);
+  }
+  best.spell = SPELL_ID_NONE;
+  best.score = 0;
+  best.resampled.clear();
+  return spotted;
+}
+
+//=====================================
+// Public Interface
+//=====================================
+
+void resetSpotter() {
+  windowHead = 0;
+  windowCount = 0;
+  boundaryHead = 0;
+  boundaryCount = 0;
+  queueHead = 0;
+  queueCount = 0;
+  speed = 0;
+  prevSpeed = 0;
+  peakSpeed = 0;
+  moving = false;
+  slowing = false;
+  best.spell = SPELL_ID_NONE;
+  best.score = 0;
+  best.resampled.clear();
+}
+
+void HOT_CODE feedSpotter(const Point& p) {
+  uint32_t prevTimestamp = p.timestamp;
+  if (windowCount > 0) {
+    const Point& prev = windowAt(windowCount - 1);
+    prevTimestamp = prev.timestamp;
+    uint32_t dt = p.timestamp - prev.timestamp;
+    if (dt == 0) dt = 1;
+    float dx = p.x - prev.x;
+    float dy = p.y - prev.y;
+    speed += SPOT_SPEED_SMOOTHING * (sqrtf(dx * dx + dy * dy) / dt - speed);
+  }
+
+  // Append to window, overwriting the oldest point when full
+  window[windowHead] = p;
+  windowHead = (windowHead + 1) % SPOT_WINDOW_POINTS;
+  if (windowCount < SPOT_WINDOW_POINTS) windowCount++;
+
+  // The first point is where any gesture in this window can start
+  if (boundaryCount == 0) {
+    addBoundary(p.timestamp);
+    prevSpeed = speed;
+    return;
+  }
+
+  //-----------------------------------
+  // Velocity minimum detection
+  //-----------------------------------
+  if (!moving) {
+    if (speed > SPOT_MOVE_SPEED) {
+      // Motion resumed - a gesture may start at the preceding point
+      moving = true;
+      peakSpeed = speed;
+      addBoundary(prevTimestamp);
+    }
+  } else {
+    peakSpeed = max(peakSpeed, speed);
+    if (speed < SPOT_PAUSE_SPEED) {
+      // Wand paused
+      moving = false;
+      addGestureEnd(p.timestamp);
+    } else if (slowing && speed > prevSpeed && prevSpeed < peakSpeed * SPOT_DIP_RATIO) {
+      // Sharp dip without stopping (e.g. corner between strokes)
+      addGestureEnd(prevTimestamp);
+      peakSpeed = speed;
+    }
+  }
+
+  slowing = speed < prevSpeed;
+  prevSpeed = speed;
+}
+
+bool HOT_CODE pollSpotter(SpotResult& result) {
+  for (uint8_t i = 0; i < SPOT_CANDIDATES_PER_FRAME && queueCount > 0; i++) {
+    scoreCandidate(queue[queueHead]);
+    queueHead = (queueHead + 1) % SPOT_QUEUE_SIZE;
+    queueCount--;
+  }
+  return takeBest(result);
+}
+
+bool finishSpotter(SpotResult& result) {
+  if (windowCount > 0 && moving) {
+    addGestureEnd(windowAt(windowCount - 1).timestamp);
+  }
+  while (queueCount > 0) {
+    scoreCandidate(queue[queueHead]);
+    queueHead = (queueHead + 1) % SPOT_QUEUE_SIZE;
+    queueCount--;
+  }
+  bool spotted = takeBest(result);
+  resetSpotter();
+  return spotted;
+}
@@ -0,0 +1,105 @@
+/*
+================================================================================
+  Gesture Spotter - Continuous Spell Spotting Header
+================================================================================
+
+  Alternative to the READY/RECORDING flow (enabled with the SPOTTING_ENABLED
+  preference): spells are recognized mid-motion without first holding the
+  wand still.
+
+  Segmentation:
+    - The last SPOT_WINDOW_POINTS tracker outputs are kept in a ring buffer
+    - Smoothed wand speed is tracked per point; velocity minima (a pause,
+      or a sharp dip relative to the recent peak, as at a stroke corner)
+      mark segment boundaries
+    - Motion starting again after a pause also marks a boundary
+
+  Candidate Detection:
+    - Each velocity minimum is a candidate gesture END; the preceding
+      boundaries in the window are candidate STARTs
+    - Up to SPOT_MAX_CANDIDATES (start, end) segments are queued per end
+      and scored against the library like a recorded gesture
+    - At most SPOT_CANDIDATES_PER_FRAME segments are scored per camera
+      frame, bounding the findBestSpellId() searches per frame; each
+      search still grows with the spell library
+    - When the queue drains, the best segment fires if it beats
+      MATCH_THRESHOLD + SPOT_MATCH_MARGIN (stricter than the recorded flow,
+      since spotting sees all motion, not just deliberate gestures)
+
+================================================================================
+*/
+
+#ifndef GESTURE_SPOTTER_H
+#define GESTURE_SPOTTER_H
+
+#include <Arduino.h>
+#include <vector>
+#include "spell_patterns.h"
+
+//=====================================
+// Spotter Configuration
+//=====================================
+
+#define SPOT_WINDOW_POINTS 256          // Recent points kept (~2.5s at 100Hz)
+#define SPOT_MAX_BOUNDARIES 8           // Segment boundaries remembered
+#define SPOT_MAX_CANDIDATES 4           // Segments queued per gesture end
+#define SPOT_QUEUE_SIZE 8               // Pending segments across ends
+#define SPOT_CANDIDATES_PER_FRAME 1     // Segments scored per camera frame
+#define SPOT_SPEED_SMOOTHING 0.3f       // Speed EMA factor (0-1, higher = less smoothing)
+#define SPOT_MOVE_SPEED 0.3f            // Speed considered moving (pixels per ms)
+#define SPOT_PAUSE_SPEED 0.08f          // Speed considered paused (pixels per ms)
+#define SPOT_DIP_RATIO 0.35f            // Local speed minimum below this share of peak is a boundary
+#define SPOT_MIN_DURATION 250           // Shortest segment scored (ms)
+#define SPOT_MIN_POINTS 10              // Fewest points in a scored segment
+#define SPOT_MIN_EXTENT 200             // Smallest segment bounding box side (pixels, as MIN_BOUNDING_BOX_SIZE)
+#define SPOT_MATCH_MARGIN 0.05f         // Added to MATCH_THRESHOLD for spotted spells
+
+//=====================================
+// Spotter Data Structures
+//=====================================
+
+/**
+ * A spell spotted in the motion stream
+ */
+struct SpotResult {
+  SpellId spell;                    ///< Matched spell
+  float score;                      ///< Similarity (0.0 to 1.0)
+  std::vector<Point> resampled;     ///< Matched segment, normalized and resampled
+};
+
+//=====================================
+// Spotter Functions
+//=====================================
+
+/**
+ * Discard all spotting state
+ * Call when IR is (re)acquired.
+ */
+void resetSpotter();
+
+/**
+ * Add one tracked point to the motion window
+ * Detects velocity minima and queues candidate segments ending there.
+ * p: Filtered wand position with timestamp
+ */
+void feedSpotter(const Point& p);
+
+/**
+ * Score queued candidates within the per-frame budget
+ * Call once per camera frame. On a match the window is cleared so the
+ * same motion can't fire twice.
+ * result: Output spotted spell
+ * return true if a spell was spotted
+ */
+bool pollSpotter(SpotResult& result);
+
+/**
+ * Treat the latest point as a gesture end and score everything pending
+ * Call when IR is lost - the wand leaving view ends any gesture in
+ * progress. Not budgeted (runs once per IR loss).
+ * result: Output spotted spell
+ * return true if a spell was spotted
+ */
+bool finishSpotter(SpotResult& result);
+
+#endif // GESTURE_SPOTTER_H
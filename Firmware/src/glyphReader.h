@@ -6,7 +6,7 @@
   This header contains:
     - Hardware pin definitions (I2C, buttons)
     - Universal library includes (Arduino, Wire, SPI)
-    - Logging macros (development vs production builds)
+    - Logging macros (deferred, see logFunctions.h)
     - Global state variable declarations (extern)
   
   This file is included by all major modules to ensure consistent hardware
@@ -18,8 +18,8 @@
     - Button pins (currently defined but not fully implemented)
   
   Build Configurations:
-    - ENV_DEV: Full debug logging enabled
-    - ENV_PROD: Minimal logging (or conditional debug)
+    - ENV_DEV: Debug logging on by default
+    - ENV_PROD: Debug logging off by default (can be enabled at runtime)
   
 ================================================================================
 */
@@ -51,30 +51,9 @@
 // Logging Macros
 //=====================================
 
-/**
- * Always-on logging macro
- * Logs to serial console regardless of build configuration.
- * Use for critical errors and important status messages.
- */
-#define LOG_ALWAYS(format, ...) Serial.printf(format "\n", ##__VA_ARGS__)
-
-#ifdef ENV_DEV
-/**
- * Development build logging macro
- * Logs detailed debug information to serial console.
- * Only active when ENV_DEV is defined during compilation.
- */
-#define LOG_DEBUG(format, ...) Serial.printf(format "\n", ##__VA_ARGS__)
-#endif
-
-#ifdef ENV_PROD
-/**
- * Production build logging macro
- * Currently disabled in production builds to reduce serial overhead.
- * Can be enabled conditionally based on runtime debug flag if needed.
- */
-#define LOG_DEBUG(format, ...) ((void)0)
-#endif
+// LOG_ALWAYS()/LOG_DEBUG() queue messages for the log task, with runtime
+// levels per module (see logFunctions.h)
+#include "logFunctions.h"
 
 //=====================================
 // Global State Variables (Extern)
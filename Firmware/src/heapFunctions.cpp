@@ -0,0 +1,399 @@
+/*
+================================================================================
+  Heap Functions - Per-Module Heap Accounting Implementation
+================================================================================
+
+  Implements the TRACK_HEAP allocation tracker declared in heapFunctions.h.
+
+  Allocation Hooks:
+    - The linker flags -Wl,--wrap=malloc (and calloc/realloc/free) redirect
+      every call to the __wrap_* functions below, which forward to the real
+      allocator and then update the tracker
+    - Only allocations made under a tag other than OTHER are recorded, which
+      keeps the pointer table small and the untagged fast path cheap
+
+  Pointer Table:
+    - Open-addressed hash table (linear probing) of HEAP_TRACK_SLOTS entries
+    - Each entry stores address, requested size and tag (8 bytes)
+    - Removal uses backward-shift deletion so no tombstones accumulate
+    - When the table is full the allocation is counted as untracked
+
+  Concurrency:
+    - Table and statistics are guarded by a spinlock (portMUX) so both cores
+      and ISRs can allocate safely
+    - Allocations before the scheduler starts and from ISRs are untagged
+
+================================================================================
+*/
+
+#include "heapFunctions.h"
+
+#ifdef TRACK_HEAP
+
+#include "glyphReader.h"
+#include "memoryPolicy.h"
+#include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+//=====================================
+// Real Allocator Entry Points
+//=====================================
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+}
+
+//=====================================
+// Tracker State
+//=====================================
+
+/// Spinlock guarding the pointer table and statistics
+static portMUX_TYPE heapTrackerMux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * Tracked allocation entry
+ * Size and tag share one word: low 24 bits size, high 8 bits tag.
+ */
+struct TrackedAllocation {
+  uintptr_t address;     // 0 = empty slot
+  uint32_t sizeAndTag;
+};
+
+static TrackedAllocation trackedAllocations[HEAP_TRACK_SLOTS];
+static uint32_t trackedCount = 0;
+static uint32_t untrackedAllocations = 0;
+static HeapTagStats tagStats[(size_t)HeapTag::COUNT];
+
+/**
+ * Per-task active tag
+ * A task claims a slot the first time it sets a tag and keeps it for life.
+ */
+#define HEAP_MAX_TAGGED_TASKS 12
+
+struct TaskTagEntry {
+  TaskHandle_t task;
+  HeapTag tag;
+};
+
+static TaskTagEntry taskTags[HEAP_MAX_TAGGED_TASKS];
+
+// Fragmentation timeline ring buffer
+static HeapSample heapTimeline[HEAP_TIMELINE_SIZE];
+static size_t timelineHead = 0;    // Next slot to write
+static size_t timelineCount = 0;   // Valid samples (<= HEAP_TIMELINE_SIZE)
+static uint32_t lastHeapSample = 0;
+static uint32_t lastHeapReport = 0;
+
+static const char* const HEAP_TAG_NAMES[(size_t)HeapTag::COUNT] = {
+  "other", "matching", "display", "web", "sd", "audio"
+};
+
+//=====================================
+// Task Tag Lookup
+//=====================================
+
+/**
+ * Find the tag entry of a task
+ * return Entry pointer, or nullptr if the task never set a tag
+ */
+static TaskTagEntry* findTaskTagEntry(TaskHandle_t task) {
+  for (size_t i = 0; i < HEAP_MAX_TAGGED_TASKS; i++) {
+    if (taskTags[i].task == task) return &taskTags[i];
+  }
+  return nullptr;
+}
+
+/**
+ * Get the active tag of the calling context
+ * Always OTHER before the scheduler starts and inside ISRs.
+ */
+static HeapTag currentHeapTag() {
+  if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED || xPortInIsrContext()) {
+    return HeapTag::OTHER;
+  }
+  TaskTagEntry* entry = findTaskTagEntry(xTaskGetCurrentTaskHandle());
+  return entry ? entry->tag : HeapTag::OTHER;
+}
+
+/**
+ * Set the active tag of the calling task
+ * return Previously active tag
+ */
+static HeapTag swapHeapTag(HeapTag tag) {
+  if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED || xPortInIsrContext()) {
+    return HeapTag::OTHER;
+  }
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  TaskTagEntry* entry = findTaskTagEntry(self);
+
+  if (entry == nullptr) {
+    // Claim a free slot (other tasks may be claiming concurrently)
+    portENTER_CRITICAL_SAFE(&heapTrackerMux);
+    for (size_t i = 0; i < HEAP_MAX_TAGGED_TASKS; i++) {
+      if (taskTags[i].task == nullptr) {
+        taskTags[i].task = self;
+        taskTags[i].tag = HeapTag::OTHER;
+        entry = &taskTags[i];
+        break;
+      }
+    }
+    portEXIT_CRITICAL_SAFE(&heapTrackerMux);
+    if (entry == nullptr) return HeapTag::OTHER;  // Table full - stay untagged
+  }
+
+  HeapTag previous = entry->tag;
+  entry->tag = tag;
+  return previous;
+}
+
+HeapScope::HeapScope(HeapTag tag) : previousTag(swapHeapTag(tag)) {}
+
+HeapScope::~HeapScope() {
+  swapHeapTag(previousTag);
+}
+
+void setHeapTaskTag(HeapTag tag) {
+  swapHeapTag(tag);
+}
+
+const char* heapTagName(HeapTag tag) {
+  size_t index = (size_t)tag;
+  return index < (size_t)HeapTag::COUNT ? HEAP_TAG_NAMES[index] : "?";
+}
+
+//=====================================
+// Pointer Table
+//=====================================
+
+static inline size_t slotFor(uintptr_t address) {
+  // Fibonacci hash of the 8-byte aligned address
+  return ((uint32_t)(address >> 3) * 2654435761u) % HEAP_TRACK_SLOTS;
+}
+
+/**
+ * Record a tagged allocation (caller holds heapTrackerMux)
+ */
+static void recordAllocationLocked(void* ptr, size_t size, HeapTag tag) {
+  if (trackedCount >= HEAP_TRACK_SLOTS - 1 || size > 0xFFFFFF) {
+    untrackedAllocations++;
+    return;
+  }
+
+  uintptr_t address = (uintptr_t)ptr;
+  size_t slot = slotFor(address);
+  while (trackedAllocations[slot].address != 0) {
+    slot = (slot + 1) % HEAP_TRACK_SLOTS;
+  }
+  trackedAllocations[slot].address = address;
+  trackedAllocations[slot].sizeAndTag = (uint32_t)size | ((uint32_t)tag << 24);
+  trackedCount++;
+
+  HeapTagStats& stats = tagStats[(size_t)tag];
+  stats.liveBytes += size;
+  stats.allocCount++;
+  if (stats.liveBytes > stats.peakBytes) {
+    stats.peakBytes = stats.liveBytes;
+  }
+}
+
+/**
+ * Remove a tracked allocation (caller holds heapTrackerMux)
+ * return true if the pointer was tracked; size and tag returned via outputs
+ */
+static bool forgetAllocationLocked(void* ptr, size_t& size, HeapTag& tag) {
+  uintptr_t address = (uintptr_t)ptr;
+  size_t slot = slotFor(address);
+
+  while (trackedAllocations[slot].address != address) {
+    if (trackedAllocations[slot].address == 0) return false;
+    slot = (slot + 1) % HEAP_TRACK_SLOTS;
+  }
+
+  size = trackedAllocations[slot].sizeAndTag & 0xFFFFFF;
+  tag = (HeapTag)(trackedAllocations[slot].sizeAndTag >> 24);
+
+  // Backward-shift deletion: pull later entries of the probe chain forward
+  size_t hole = slot;
+  size_t next = (hole + 1) % HEAP_TRACK_SLOTS;
+  while (trackedAllocations[next].address != 0) {
+    size_t home = slotFor(trackedAllocations[next].address);
+    bool movable = (hole <= next) ? (home <= hole || home > next)
+                                  : (home <= hole && home > next);
+    if (movable) {
+      trackedAllocations[hole] = trackedAllocations[next];
+      hole = next;
+    }
+    next = (next + 1) % HEAP_TRACK_SLOTS;
+  }
+  trackedAllocations[hole].address = 0;
+  trackedCount--;
+
+  HeapTagStats& stats = tagStats[(size_t)tag];
+  stats.liveBytes -= size;
+  stats.freeCount++;
+  return true;
+}
+
+//=====================================
+// Allocator Wrappers
+//=====================================
+
+extern "C" void* __wrap_malloc(size_t size) {
+  void* ptr = __real_malloc(size);
+  if (ptr != nullptr) {
+    HeapTag tag = currentHeapTag();
+    if (tag != HeapTag::OTHER) {
+      portENTER_CRITICAL_SAFE(&heapTrackerMux);
+      recordAllocationLocked(ptr, size, tag);
+      portEXIT_CRITICAL_SAFE(&heapTrackerMux);
+    }
+  }
+  return ptr;
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+  void* ptr = __real_calloc(count, size);
+  if (ptr != nullptr) {
+    HeapTag tag = currentHeapTag();
+    if (tag != HeapTag::OTHER) {
+      portENTER_CRITICAL_SAFE(&heapTrackerMux);
+      recordAllocationLocked(ptr, count * size, tag);
+      portEXIT_CRITICAL_SAFE(&heapTrackerMux);
+    }
+  }
+  return ptr;
+}
+
+extern "C" void __wrap_free(void* ptr) {
+  if (ptr != nullptr && trackedCount > 0) {
+    // Forget before releasing so a concurrent malloc reusing the
+    // address can't have its fresh record removed by mistake
+    size_t size;
+    HeapTag tag;
+    portENTER_CRITICAL_SAFE(&heapTrackerMux);
+    forgetAllocationLocked(ptr, size, tag);
+    portEXIT_CRITICAL_SAFE(&heapTrackerMux);
+  }
+  __real_free(ptr);
+}
+
+extern "C" void* __wrap_realloc(void* ptr, size_t size) {
+  if (ptr == nullptr) return __wrap_malloc(size);
+  if (size == 0) {
+    __wrap_free(ptr);
+    return nullptr;
+  }
+
+  size_t oldSize = 0;
+  HeapTag oldTag = HeapTag::OTHER;
+  portENTER_CRITICAL_SAFE(&heapTrackerMux);
+  bool wasTracked = forgetAllocationLocked(ptr, oldSize, oldTag);
+  portEXIT_CRITICAL_SAFE(&heapTrackerMux);
+
+  void* newPtr = __real_realloc(ptr, size);
+
+  // Growth keeps the original owner unless the caller is inside a tagged scope
+  HeapTag tag = currentHeapTag();
+  if (tag == HeapTag::OTHER && wasTracked) tag = oldTag;
+
+  portENTER_CRITICAL_SAFE(&heapTrackerMux);
+  if (newPtr == nullptr) {
+    // Original block is untouched on failure - restore its record
+    if (wasTracked) recordAllocationLocked(ptr, oldSize, oldTag);
+  } else if (tag != HeapTag::OTHER) {
+    recordAllocationLocked(newPtr, size, tag);
+  }
+  portEXIT_CRITICAL_SAFE(&heapTrackerMux);
+
+  return newPtr;
+}
+
+//=====================================
+// Reporting
+//=====================================
+
+HeapTagStats getHeapTagStats(HeapTag tag) {
+  portENTER_CRITICAL_SAFE(&heapTrackerMux);
+  HeapTagStats stats = tagStats[(size_t)tag];
+  portEXIT_CRITICAL_SAFE(&heapTrackerMux);
+  return stats;
+}
+
+void updateHeapTracker(uint32_t currentTime) {
+  if (timelineCount == 0 || currentTime - lastHeapSample >= HEAP_SAMPLE_INTERVAL) {
+    lastHeapSample = currentTime;
+    heapTimeline[timelineHead] = {currentTime, ESP.getFreeHeap(), ESP.getMaxAllocHeap()};
+    timelineHead = (timelineHead + 1) % HEAP_TIMELINE_SIZE;
+    if (timelineCount < HEAP_TIMELINE_SIZE) timelineCount++;
+  }
+
+  if (currentTime - lastHeapReport >= HEAP_REPORT_INTERVAL) {
+    lastHeapReport = currentTime;
+    logHeapReport();
+  }
+}
+
+void logHeapReport() {
+  LOG_ALWAYS("=== Heap Tracker ===");
+  LOG_ALWAYS("Free: %lu, min: %lu, largest block: %lu, tracked ptrs: %lu, untracked: %lu",
+             (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(),
+             (unsigned long)ESP.getMaxAllocHeap(), (unsigned long)trackedCount,
+             (unsigned long)untrackedAllocations);
+
+  for (size_t i = 1; i < (size_t)HeapTag::COUNT; i++) {
+    HeapTagStats stats = getHeapTagStats((HeapTag)i);
+    LOG_ALWAYS("  %-8s live=%lu peak=%lu allocs=%lu frees=%lu",
+               HEAP_TAG_NAMES[i], (unsigned long)stats.liveBytes, (unsigned long)stats.peakBytes,
+               (unsigned long)stats.allocCount, (unsigned long)stats.freeCount);
+  }
+
+  // Oldest and newest sample show the largest-block trend at a glance
+  if (timelineCount > 0) {
+    const HeapSample& oldest = heapTimeline[(timelineHead + HEAP_TIMELINE_SIZE - timelineCount) % HEAP_TIMELINE_SIZE];
+    const HeapSample& newest = heapTimeline[(timelineHead + HEAP_TIMELINE_SIZE - 1) % HEAP_TIMELINE_SIZE];
+    LOG_ALWAYS("  Largest block: %lu @ %lus -> %lu @ %lus (%u samples)",
+               (unsigned long)oldest.largestBlock, (unsigned long)(oldest.timestamp / 1000),
+               (unsigned long)newest.largestBlock, (unsigned long)(newest.timestamp / 1000),
+               (unsigned)timelineCount);
+  }
+}
+
+String heapReportJson() {
+  JsonDocument doc(bulkJsonAllocator());
+  doc["free"] = ESP.getFreeHeap();
+  doc["minFree"] = ESP.getMinFreeHeap();
+  doc["largestBlock"] = ESP.getMaxAllocHeap();
+  doc["trackedPointers"] = trackedCount;
+  doc["untracked"] = untrackedAllocations;
+
+  JsonObject tags = doc["tags"].to<JsonObject>();
+  for (size_t i = 1; i < (size_t)HeapTag::COUNT; i++) {
+    HeapTagStats stats = getHeapTagStats((HeapTag)i);
+    JsonObject tag = tags[HEAP_TAG_NAMES[i]].to<JsonObject>();
+    tag["live"] = stats.liveBytes;
+    tag["peak"] = stats.peakBytes;
+    tag["allocs"] = stats.allocCount;
+    tag["frees"] = stats.freeCount;
+  }
+
+  // Timeline oldest first: [timestamp, free, largestBlock]
+  JsonArray timeline = doc["timeline"].to<JsonArray>();
+  for (size_t i = 0; i < timelineCount; i++) {
+    const HeapSample& sample = heapTimeline[(timelineHead + HEAP_TIMELINE_SIZE - timelineCount + i) % HEAP_TIMELINE_SIZE];
+    JsonArray entry = timeline.add<JsonArray>();
+    entry.add(sample.timestamp);
+    entry.add(sample.freeBytes);
+    entry.add(sample.largestBlock);
+  }
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+
+#endif // TRACK_HEAP
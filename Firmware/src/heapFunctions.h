@@ -0,0 +1,165 @@
+/*
+================================================================================
+  Heap Functions - Per-Module Heap Accounting Header
+================================================================================
+
+  Opt-in allocation tracker used to attribute heap churn to the module that
+  caused it. Enabled with the TRACK_HEAP build flag (see platformio.ini),
+  which also wraps malloc/calloc/realloc/free at link time.
+
+  Tracking Model:
+    - Every task has an active heap tag (default HeapTag::OTHER)
+    - HEAP_SCOPE(tag) switches the calling task's tag until end of scope
+    - HEAP_TASK_TAG(tag) sets the default tag of a long-running task
+    - Allocations made under a tag other than OTHER are recorded in a fixed
+      pointer table so the matching free() is credited to the same tag,
+      even when it happens on a different task or much later
+
+  Reported Statistics (per tag):
+    - Live bytes and peak live bytes
+    - Allocation and free counts
+
+  Fragmentation Timeline:
+    - Free heap and largest free block sampled every HEAP_SAMPLE_INTERVAL
+    - Last HEAP_TIMELINE_SIZE samples kept in a ring buffer
+
+  Output:
+    - Serial: report logged every HEAP_REPORT_INTERVAL
+    - Portal: JSON at http://<device>/heap
+
+  When TRACK_HEAP is not defined, the macros compile to nothing and no
+  wrapper is linked, so release builds are unaffected.
+
+================================================================================
+*/
+
+#ifndef HEAP_FUNCTIONS_H
+#define HEAP_FUNCTIONS_H
+
+#include <Arduino.h>
+
+//=====================================
+// Heap Tags
+//=====================================
+
+/**
+ * Module tags used to attribute allocations
+ * OTHER covers everything outside a tagged scope and is not individually
+ * tracked; its usage is derived from total heap use minus tagged bytes.
+ */
+enum class HeapTag : uint8_t {
+  OTHER = 0,   ///< Untagged (framework, WiFi stack, etc.)
+  MATCHING,    ///< Trajectory normalization, resampling, matching
+  DISPLAY,     ///< Image decoding and screen drawing
+  WEB,         ///< Portal, HTTP and MQTT handling
+  SD,          ///< SD card file and JSON handling
+  AUDIO,       ///< WAV parsing and I2S streaming
+  COUNT        ///< Number of tags (not a valid tag)
+};
+
+//=====================================
+// Configuration
+//=====================================
+
+#define HEAP_TRACK_SLOTS 1024          // Max simultaneously live tagged allocations
+#define HEAP_TIMELINE_SIZE 64          // Number of fragmentation samples kept
+#define HEAP_SAMPLE_INTERVAL 10000     // Milliseconds between timeline samples
+#define HEAP_REPORT_INTERVAL 60000     // Milliseconds between serial reports
+
+#ifdef TRACK_HEAP
+
+//=====================================
+// Tracking Data Structures
+//=====================================
+
+/**
+ * Accumulated statistics for one heap tag
+ */
+struct HeapTagStats {
+  uint32_t liveBytes;    // Bytes currently allocated under this tag
+  uint32_t peakBytes;    // Highest liveBytes observed
+  uint32_t allocCount;   // Total allocations (including realloc moves)
+  uint32_t freeCount;    // Total frees of tracked pointers
+};
+
+/**
+ * One fragmentation timeline sample
+ */
+struct HeapSample {
+  uint32_t timestamp;     // millis() when sampled
+  uint32_t freeBytes;     // Total free internal heap
+  uint32_t largestBlock;  // Largest contiguous free block
+};
+
+//=====================================
+// Scoped Tagging
+//=====================================
+
+/**
+ * RAII helper that tags allocations made by the current task
+ * Restores the previous tag when it goes out of scope, so scopes nest.
+ */
+class HeapScope {
+public:
+  explicit HeapScope(HeapTag tag);
+  ~HeapScope();
+  HeapScope(const HeapScope&) = delete;
+  HeapScope& operator=(const HeapScope&) = delete;
+private:
+  HeapTag previousTag;
+};
+
+#define HEAP_SCOPE_CONCAT_(a, b) a##b
+#define HEAP_SCOPE_CONCAT(a, b) HEAP_SCOPE_CONCAT_(a, b)
+#define HEAP_SCOPE(tag) HeapScope HEAP_SCOPE_CONCAT(heapScope_, __LINE__)(tag)
+#define HEAP_TASK_TAG(tag) setHeapTaskTag(tag)
+
+//=====================================
+// Heap Tracker Functions
+//=====================================
+
+/**
+ * Set the default heap tag of the calling task
+ * Call once at the start of a task body (e.g., WiFi or audio task).
+ */
+void setHeapTaskTag(HeapTag tag);
+
+/**
+ * Get display name of a heap tag
+ * return Lowercase tag name (e.g., "matching")
+ */
+const char* heapTagName(HeapTag tag);
+
+/**
+ * Copy the current statistics of a tag
+ * Copies under the tracker lock so the values are consistent.
+ */
+HeapTagStats getHeapTagStats(HeapTag tag);
+
+/**
+ * Periodic tracker update - call from main loop
+ * Records a timeline sample every HEAP_SAMPLE_INTERVAL and logs a full
+ * report every HEAP_REPORT_INTERVAL.
+ * currentTime: Current millis() value
+ */
+void updateHeapTracker(uint32_t currentTime);
+
+/**
+ * Log the full heap report to serial
+ * Per-tag statistics followed by the fragmentation timeline.
+ */
+void logHeapReport();
+
+/**
+ * Build the heap report as a JSON string (served at /heap)
+ */
+String heapReportJson();
+
+#else
+
+#define HEAP_SCOPE(tag) ((void)0)
+#define HEAP_TASK_TAG(tag) ((void)0)
+
+#endif // TRACK_HEAP
+
+#endif // HEAP_FUNCTIONS_H
@@ -0,0 +1,351 @@
+/*
+================================================================================
+  Hot Path - IRAM/DRAM Placement of Capture and Match Code
+================================================================================
+
+  Implements the placement report and latency benchmark declared in
+  hotPath.h. The HOT_CODE attributes themselves sit on the function
+  definitions in cameraFunction.cpp, motionFilter.cpp, gestureSpotter.cpp,
+  spell_matching.cpp and spellIndex.cpp.
+
+  Benchmark load tasks are pinned to core 0 (with WiFi and the spell
+  index worker) so the timed matches on core 1 only see the contention a
+  real cast sees: shared flash cache, SPI bus and memory, not a stolen
+  CPU.
+
+================================================================================
+*/
+
+#define LOG_MODULE LogModule::MATCHING
+
+#include "hotPath.h"
+#include "glyphReader.h"
+#include "cameraFunctions.h"
+#include "motionFilter.h"
+#include "gestureSpotter.h"
+#include "spell_matching.h"
+#include "spell_patterns.h"
+#include "spellIndex.h"
+#include <esp_heap_caps.h>
+#include <soc/soc.h>
+#if __has_include(<esp_memory_utils.h>)
+#include <esp_memory_utils.h>
+#else
+#include <soc/soc_memory_layout.h>
+#endif
+
+#ifdef BENCHMARK_LATENCY
+#include "sdFunctions.h"
+#include "flashMap.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <esp_ota_ops.h>
+#include <atomic>
+#include <algorithm>
+#endif
+
+// IRAM text section bounds (ESP-IDF linker script)
+extern "C" int _iram_text_start;
+extern "C" int _iram_text_end;
+
+//=====================================
+// Placement Report
+//=====================================
+
+/**
+ * A function or table checked by the report
+ */
+struct HotSymbol {
+  const char* name;
+  const void* address;
+};
+
+/**
+ * Memory region an address falls in
+ */
+static const char* regionName(const void* address) {
+  uintptr_t a = (uintptr_t)address;
+  if (esp_ptr_in_iram(address)) return "IRAM";
+  if (esp_ptr_external_ram(address)) return "PSRAM";
+  if (esp_ptr_in_dram(address)) return "DRAM";
+  if (a >= SOC_IROM_LOW && a < SOC_IROM_HIGH) return "flash (code)";
+  if (a >= SOC_DROM_LOW && a < SOC_DROM_HIGH) return "flash (data)";
+  return "other";
+}
+
+/**
+ * First byte of a template's points, whichever representation is built
+ */
+static const void* templateData(const std::vector<Point>& pattern) {
+  return pattern.data();
+}
+
+static const void* templateData(const QuantizedPattern& pattern) {
+  return &pattern;
+}
+
+void reportHotPathPlacement() {
+  // Overloads need their exact type to take an address
+  typedef float (*PointSimilarity)(const std::vector<Point>&, const std::vector<Point>&);
+  typedef void (*ChainSymbols)(const std::vector<Point>&, uint8_t*);
+
+  const HotSymbol functions[] = {
+    {"readCameraData", (const void*)&readCameraData},
+    {"updateTracker", (const void*)&updateTracker},
+    {"appendSimplified", (const void*)&appendSimplified},
+    {"feedSpotter", (const void*)&feedSpotter},
+    {"normalizeTrajectory", (const void*)&normalizeTrajectory},
+    {"resampleTrajectory", (const void*)&resampleTrajectory},
+    {"computeSignature", (const void*)&computeSignature},
+    {"signatureDistance", (const void*)&signatureDistance},
+    {"calculateSimilarity", (const void*)(PointSimilarity)&calculateSimilarity},
+    {"calculateCloudSimilarity", (const void*)&calculateCloudSimilarity},
+    {"computeChainSymbols", (const void*)(ChainSymbols)&computeChainSymbols},
+    {"calculateChainSimilarity", (const void*)&calculateChainSimilarity},
+    {"findBestSpellId", (const void*)&findBestSpellId},
+    {"searchSpellIndex", (const void*)&searchSpellIndex},
+  };
+
+  LOG_ALWAYS("=== Hot Path Placement ===");
+#ifdef HOT_PATH_IRAM
+  LOG_ALWAYS("  HOT_PATH_IRAM on: hot code expected in IRAM");
+#else
+  LOG_ALWAYS("  HOT_PATH_IRAM off: hot code expected in flash");
+#endif
+  int misplaced = 0;
+  for (const HotSymbol& symbol : functions) {
+#ifdef HOT_PATH_IRAM
+    if (!esp_ptr_in_iram(symbol.address)) misplaced++;
+#endif
+    LOG_ALWAYS("  %-26s %p  %s", symbol.name, symbol.address, regionName(symbol.address));
+  }
+
+  // Tables: the loaded library (heap), checked through its first spell
+  if (!spellPatterns.empty()) {
+    const SpellPattern& spell = spellPatterns[0];
+    const HotSymbol tables[] = {
+      {"spell patterns", spellPatterns.data()},
+      {"templates", templateData(exemplarTemplate(spell, 0))},
+      {"chain codes", &exemplarChain(spell, 0)},
+      {"signatures", &exemplarSignature(spell, 0)},
+    };
+    for (const HotSymbol& table : tables) {
+      if (!esp_ptr_in_dram(table.address)) misplaced++;
+      LOG_ALWAYS("  %-26s %p  %s", table.name, table.address, regionName(table.address));
+    }
+  }
+
+  LOG_ALWAYS("  IRAM text: %u bytes, free internal heap: %u (largest block %u)",
+             (unsigned)((uintptr_t)&_iram_text_end - (uintptr_t)&_iram_text_start),
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+  if (misplaced > 0) {
+    LOG_ALWAYS("  %d hot symbol(s) outside their intended region", misplaced);
+  }
+  LOG_ALWAYS("==========================");
+}
+
+//=====================================
+// Latency Benchmark
+//=====================================
+
+#ifdef BENCHMARK_LATENCY
+
+#define LOAD_SD 0x01
+#define LOAD_WIFI 0x02
+#define LOAD_FLASH 0x04
+
+#define LATENCY_JITTER 40               // Max per-point jitter (normalized units)
+#define LATENCY_SD_CHUNK 4096           // SD load read size (bytes)
+#define LATENCY_UDP_SIZE 1024           // WiFi load packet size (bytes)
+#define LATENCY_UDP_PORT 9              // Discard service on the gateway
+#define LATENCY_CACHE_LINE 32           // Flash load stride (bytes)
+
+static std::atomic<bool> loadRunning(false);
+static std::atomic<int> activeLoads(0);
+static String loadFile;                            // SD file read by the SD load
+static const uint8_t* flashSpan = nullptr;         // Mapping swept by the flash load
+static uint32_t flashSpanSize = 0;
+
+/**
+ * SD load: read a spell image over and over
+ */
+static void sdLoadTask(void* parameter) {
+  uint8_t* chunk = (uint8_t*)malloc(LATENCY_SD_CHUNK);
+  File file = openFile(loadFile.c_str(), FILE_READ);
+  while (loadRunning && chunk != nullptr && file) {
+    if (file.read(chunk, LATENCY_SD_CHUNK) < LATENCY_SD_CHUNK) file.seek(0);
+    vTaskDelay(1);
+  }
+  if (file) file.close();
+  free(chunk);
+  activeLoads--;
+  vTaskDelete(NULL);
+}
+
+/**
+ * WiFi load: stream UDP packets at the gateway
+ */
+static void wifiLoadTask(void* parameter) {
+  WiFiUDP udp;
+  uint8_t packet[LATENCY_UDP_SIZE];
+  memset(packet, 0xA5, sizeof(packet));
+  IPAddress gateway = WiFi.gatewayIP();
+  while (loadRunning) {
+    for (int i = 0; i < 4; i++) {
+      udp.beginPacket(gateway, LATENCY_UDP_PORT);
+      udp.write(packet, sizeof(packet));
+      udp.endPacket();
+    }
+    vTaskDelay(1);
+  }
+  activeLoads--;
+  vTaskDelete(NULL);
+}
+
+/**
+ * Flash load: touch one byte per cache line across a large mapping,
+ * evicting whatever the match code left in the cache
+ */
+static void flashLoadTask(void* parameter) {
+  volatile uint8_t sink = 0;
+  while (loadRunning) {
+    for (uint32_t block = 0; block < flashSpanSize && loadRunning; block += 0x10000) {
+      uint32_t end = min(block + 0x10000, flashSpanSize);
+      for (uint32_t i = block; i < end; i += LATENCY_CACHE_LINE) sink += flashSpan[i];
+      vTaskDelay(1);
+    }
+  }
+  activeLoads--;
+  vTaskDelete(NULL);
+}
+
+/**
+ * Start the load tasks in a mask on core 0
+ */
+static void startLoads(uint8_t loads) {
+  loadRunning = true;
+  struct { uint8_t bit; TaskFunction_t task; const char* name; } tasks[] = {
+    {LOAD_SD, sdLoadTask, "SDLoad"},
+    {LOAD_WIFI, wifiLoadTask, "WiFiLoad"},
+    {LOAD_FLASH, flashLoadTask, "FlashLoad"},
+  };
+  for (const auto& load : tasks) {
+    if (!(loads & load.bit)) continue;
+    activeLoads++;
+    if (xTaskCreatePinnedToCore(load.task, load.name, LATENCY_LOAD_STACK, NULL, 1, NULL, 0) != pdPASS) {
+      activeLoads--;
+      LOG_ALWAYS("  %s task failed to start", load.name);
+    }
+  }
+  delay(LATENCY_SETTLE_MS);
+}
+
+/**
+ * Stop all load tasks and wait for them to exit
+ */
+static void stopLoads() {
+  loadRunning = false;
+  while (activeLoads > 0) delay(5);
+}
+
+/**
+ * Raw gesture from a spell: a jittered copy of its first exemplar
+ * Jitter is a random walk so the copy stays a plausible stroke.
+ */
+static std::vector<Point> jitteredGesture(const SpellPattern& spell) {
+  std::vector<Point> source = exemplarPoints(spell, 0);
+  int ox = 0, oy = 0;
+  for (Point& p : source) {
+    ox = constrain(ox + (int)random(-8, 9), -LATENCY_JITTER, LATENCY_JITTER);
+    oy = constrain(oy + (int)random(-8, 9), -LATENCY_JITTER, LATENCY_JITTER);
+    p.x += ox;
+    p.y += oy;
+  }
+  return source;
+}
+
+/**
+ * Time the cast pipeline for each gesture and log the distribution
+ * One tick between matches lets the load run in the gaps, as between
+ * real casts.
+ */
+static void timePhase(const char* name, const std::vector<std::vector<Point>>& gestures) {
+  std::vector<uint32_t> samples;
+  samples.reserve(gestures.size());
+  for (const auto& gesture : gestures) {
+    int64_t start = esp_timer_get_time();
+    std::vector<Point> resampled = resampleTrajectory(normalizeTrajectory(gesture), RESAMPLE_POINTS);
+    float score = 0;
+    findBestSpellId(resampled, score);
+    samples.push_back((uint32_t)(esp_timer_get_time() - start));
+    vTaskDelay(1);
+  }
+  std::sort(samples.begin(), samples.end());
+  size_t n = samples.size();
+  LOG_ALWAYS("  %-10s %7lu %7lu %7lu %7lu", name, (unsigned long)samples[0],
+             (unsigned long)samples[n / 2], (unsigned long)samples[(n * 99) / 100],
+             (unsigned long)samples[n - 1]);
+}
+
+void benchmarkMatchLatency() {
+  if (spellPatterns.empty()) {
+    LOG_ALWAYS("Latency benchmark: no spells loaded");
+    return;
+  }
+
+  std::vector<std::vector<Point>> gestures;
+  for (size_t i = 0; gestures.size() < LATENCY_GESTURES; i++) {
+    gestures.push_back(jitteredGesture(spellPatterns[i % spellPatterns.size()]));
+  }
+
+  // Available loads: a spell image on the card, WiFi, the app's own flash
+  uint8_t available = LOAD_FLASH;
+  if (isCardPresent()) {
+    for (size_t s = 0; s < spellPatterns.size() && loadFile.length() == 0; s++) {
+      const char* name = spellName((SpellId)s);
+      if (hasSpellImage(name)) loadFile = getSpellImageFilename(name);
+    }
+  }
+  if (loadFile.length() > 0) available |= LOAD_SD;
+
+  uint32_t waitStart = millis();
+  while (WiFi.status() != WL_CONNECTED && millis() - waitStart < LATENCY_WIFI_WAIT_MS) delay(100);
+  if (WiFi.status() == WL_CONNECTED) available |= LOAD_WIFI;
+
+  const esp_partition_t* app = esp_ota_get_running_partition();
+  FlashMapHandle handle;
+  const void* mapped = nullptr;
+  flashSpanSize = min((uint32_t)LATENCY_FLASH_SPAN, (uint32_t)app->size);
+  if (esp_partition_mmap(app, 0, flashSpanSize, FLASH_MAP_DATA, &mapped, &handle) != ESP_OK) {
+    available &= ~LOAD_FLASH;
+  }
+  flashSpan = (const uint8_t*)mapped;
+
+  LOG_ALWAYS("=== Match Latency (us, %d gestures per phase) ===", LATENCY_GESTURES);
+  LOG_ALWAYS("  load           min  median     p99     max");
+  // The last phase runs every load that is available
+  struct { const char* name; uint8_t loads; const char* unavailable; } phases[] = {
+    {"idle", 0, nullptr},
+    {"sd", LOAD_SD, "no spell image on SD"},
+    {"wifi", LOAD_WIFI, "WiFi not connected"},
+    {"flash", LOAD_FLASH, "flash mapping failed"},
+    {"all", LOAD_SD | LOAD_WIFI | LOAD_FLASH, nullptr},
+  };
+  for (const auto& phase : phases) {
+    if (phase.unavailable != nullptr && !(phase.loads & available)) {
+      LOG_ALWAYS("  %-10s skipped (%s)", phase.name, phase.unavailable);
+      continue;
+    }
+    startLoads(phase.loads & available);
+    timePhase(phase.name, gestures);
+    stopLoads();
+  }
+
+  if (available & LOAD_FLASH) flashUnmap(handle);
+  flashSpan = nullptr;
+  loadFile = "";
+  LOG_ALWAYS("=================================================");
+}
+
+#endif // BENCHMARK_LATENCY
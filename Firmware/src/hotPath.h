@@ -0,0 +1,91 @@
+/*
+================================================================================
+  Hot Path - IRAM/DRAM Placement of Capture and Match Code Header
+================================================================================
+
+  Keeps the per-frame capture and per-cast match code out of the flash
+  cache's way. Code normally runs from flash through a small cache, and
+  the SD card, display and WiFi drivers all compete for it; a cache miss
+  in the middle of a match stalls the cast for as long as the refill
+  waits on the flash bus.
+
+  Placement Policy (-D HOT_PATH_IRAM):
+    - Functions marked HOT_CODE are linked into internal instruction RAM
+      (IRAM_ATTR): readCameraData() and the blob parsing in it, the
+      motion filter, gesture spotting, normalize/resample, signatures,
+      every similarity metric and the spell index search
+    - Hot data stays in internal DRAM: templates, chain codes, the index
+      and the trajectory are heap vectors, and with no PSRAM the heap is
+      internal; the placement report checks this at boot rather than
+      assuming it
+    - Library code called from the hot path (libm atan2/sqrt, std::vector
+      growth, Wire) still runs from flash - only our own code moves
+    - Without the flag HOT_CODE is empty and nothing changes; host tools
+      (Tools/tuner, Tools/match_bench) build the same sources without it
+
+  Section Map Report:
+    - reportHotPathPlacement() logs where each hot function and table
+      actually landed (IRAM, DRAM, PSRAM or flash) and the size of the
+      IRAM text section, so a missing attribute or a table that moved to
+      PSRAM shows up on the serial console
+
+  Latency Benchmark (-D BENCHMARK_LATENCY):
+    - Times the whole cast pipeline (normalize, resample, signature,
+      findBestSpellId) for jittered copies of the loaded spells on the
+      loop core, first idle, then with load tasks on core 0 reading the
+      SD card, flooding WiFi with UDP and sweeping a flash mapping to
+      evict the cache, then all three at once
+    - Reports min/median/p99/max per phase; build with and without
+      HOT_PATH_IRAM to compare the tails
+
+================================================================================
+*/
+
+#ifndef HOT_PATH_H
+#define HOT_PATH_H
+
+#include <Arduino.h>
+
+//=====================================
+// Placement Attributes
+//=====================================
+
+#ifdef HOT_PATH_IRAM
+#include <esp_attr.h>
+#define HOT_CODE IRAM_ATTR              // Run from internal IRAM, not through the flash cache
+#else
+#define HOT_CODE
+#endif
+
+//=====================================
+// Benchmark Configuration
+//=====================================
+
+#define LATENCY_GESTURES 200            // Matches timed per phase
+#define LATENCY_SETTLE_MS 500           // Load runs this long before timing starts
+#define LATENCY_WIFI_WAIT_MS 15000      // Longest wait for WiFi before skipping its phases
+#define LATENCY_FLASH_SPAN 0x100000     // Flash swept by the cache load (bytes)
+#define LATENCY_LOAD_STACK 4096         // Load task stack (bytes)
+
+//=====================================
+// Hot Path Functions
+//=====================================
+
+/**
+ * Log where the hot functions and tables are placed
+ * Call after the spell patterns are loaded (the tables are checked
+ * through the loaded library).
+ */
+void reportHotPathPlacement();
+
+#ifdef BENCHMARK_LATENCY
+/**
+ * Time worst-case cast latency under SD, WiFi and flash cache load
+ * Blocks for a few seconds per phase and waits up to
+ * LATENCY_WIFI_WAIT_MS for WiFi. Call at the end of setup(), after
+ * initSpellIndexWorker().
+ */
+void benchmarkMatchLatency();
+#endif
+
+#endif // HOT_PATH_H
@@ -27,6 +27,8 @@
 ================================================================================
 */
 
+#define LOG_MODULE LogModule::FEEDBACK
+
 #include "led_control.h"
 #include "glyphReader.h"
 #include "preferenceFunctions.h"
@@ -0,0 +1,335 @@
+/*
+================================================================================
+  Log Functions - Deferred Serial Logging
+================================================================================
+
+  Implements the ring buffer and log task declared in logFunctions.h.
+
+  Ring Buffer:
+    - Bounded multi-producer/single-consumer queue over LOG_BUFFER_SLOTS
+      slots. Each slot's sequence number says whose turn it is: free for
+      the producer at position p when it equals p, ready for the consumer
+      once the producer sets it to p + 1, free again for the next lap when
+      the consumer sets it to p + LOG_BUFFER_SLOTS
+    - Sequences are stored relative to the slot index, so the
+      zero-initialized ring starts out free without an init step
+    - Producers never wait: a slot still in use one lap behind means the
+      ring is full, and the message is counted as dropped
+
+  Log Task:
+    - Formats one message at a time, following the format string and
+      passing each stored argument to snprintf() with the matching type
+      (length modifiers in the format are replaced, so %lu/%d/%zu all work
+      whatever integer width the caller passed)
+    - Sleeps LOG_DRAIN_INTERVAL when the ring is empty
+
+================================================================================
+*/
+
+#include "logFunctions.h"
+#include "memoryPolicy.h"
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+//=====================================
+// Logger State
+//=====================================
+
+uint8_t logLevels[(size_t)LogModule::COUNT] = {
+  LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL,
+  LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL
+};
+
+static LogSlot ring[LOG_BUFFER_SLOTS];
+static std::atomic<uint32_t> enqueuePosition(0);
+static uint32_t dequeuePosition = 0;      // Log task only
+static std::atomic<uint32_t> dropCount(0);
+static TaskHandle_t logTaskHandle = NULL;
+
+static const char* moduleNames[(size_t)LogModule::COUNT] = {
+  "core", "camera", "matching", "network", "storage", "feedback"
+};
+static const char* levelNames[] = {"off", "always", "debug"};
+
+//=====================================
+// Ring Buffer
+//=====================================
+
+LogSlot* logReserve() {
+  uint32_t position = enqueuePosition.load(std::memory_order_relaxed);
+  while (true) {
+    uint32_t index = position & (LOG_BUFFER_SLOTS - 1);
+    LogSlot& slot = ring[index];
+    int32_t difference = (int32_t)(slot.sequence.load(std::memory_order_acquire) + index - position);
+    if (difference == 0) {
+      // Free for this position - claim it unless another task got there first
+      if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        return &slot;
+      }
+    } else if (difference < 0) {
+      // Still holds the message from a lap ago - full
+      dropCount.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    } else {
+      // Another task claimed it meanwhile
+      position = enqueuePosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void logPublish(LogSlot* slot) {
+  // Only the claiming task touches the slot until this store
+  slot->sequence.store(slot->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void logPack(LogPacker& packer, const char* value) {
+  if (!value) value = "(null)";
+  LogSlot* slot = packer.slot;
+  if (slot->length + 2 > LOG_SLOT_DATA) {
+    slot->length = LOG_SLOT_DATA;
+    return;
+  }
+  // Truncate to the space left
+  size_t room = LOG_SLOT_DATA - slot->length - 2;
+  size_t length = strnlen(value, room);
+  slot->data[slot->length] = LOG_ARG_STRING;
+  slot->data[slot->length + 1] = (uint8_t)length;
+  memcpy(slot->data + slot->length + 2, value, length);
+  slot->length += 2 + length;
+}
+
+//=====================================
+// Formatting
+//=====================================
+
+/**
+ * One stored argument, unpacked
+ */
+struct LogArg {
+  LogArgType type;
+  int64_t integer;
+  float real;
+  char text[LOG_SLOT_DATA];
+};
+
+/**
+ * Read the next argument of a slot
+ * offset: Read position in slot.data, advanced past the argument
+ * return false if there are no more arguments
+ */
+static bool readArg(const LogSlot& slot, uint8_t& offset, LogArg& arg) {
+  if (offset >= slot.length) return false;
+  arg.type = (LogArgType)slot.data[offset++];
+  arg.integer = 0;
+  arg.real = 0;
+  arg.text[0] = '\0';
+  switch (arg.type) {
+    case LOG_ARG_INT32: {
+      int32_t value;
+      memcpy(&value, slot.data + offset, 4);
+      arg.integer = value;
+      offset += 4;
+      break;
+    }
+    case LOG_ARG_INT64:
+      memcpy(&arg.integer, slot.data + offset, 8);
+      offset += 8;
+      break;
+    case LOG_ARG_FLOAT:
+      memcpy(&arg.real, slot.data + offset, 4);
+      offset += 4;
+      break;
+    case LOG_ARG_STRING: {
+      uint8_t length = slot.data[offset++];
+      memcpy(arg.text, slot.data + offset, length);
+      arg.text[length] = '\0';
+      offset += length;
+      break;
+    }
+  }
+  return true;
+}
+
+/**
+ * Format a queued message like printf() would have
+ * return Length written to line (excluding the terminator)
+ */
+static size_t formatMessage(const LogSlot& slot, char* line, size_t size) {
+  const char* format = slot.format;
+  size_t length = 0;
+  uint8_t offset = 0;
+  LogArg arg;
+
+  while (*format && length < size - 1) {
+    if (*format != '%') {
+      line[length++] = *format++;
+      continue;
+    }
+    if (format[1] == '%') {
+      line[length++] = '%';
+      format += 2;
+      continue;
+    }
+
+    // Keep flags, width and precision; the length modifier is chosen below
+    char spec[16] = "%";
+    size_t specLength = 1;
+    format++;
+    while (*format && strchr("-+ #0123456789.", *format) && specLength < 10) {
+      spec[specLength++] = *format++;
+    }
+    while (*format && strchr("hlzjtL", *format)) format++;
+    char conversion = *format;
+    if (!conversion) break;
+    format++;
+
+    if (!readArg(slot, offset, arg)) continue;  // Dropped for space - print nothing
+    if (arg.type == LOG_ARG_FLOAT) arg.integer = (int64_t)arg.real;
+    else arg.real = (float)arg.integer;
+
+    char* out = line + length;
+    size_t room = size - length;
+    int written = 0;
+    switch (conversion) {
+      case 'd': case 'i':
+        strcpy(spec + specLength, "lld");
+        written = snprintf(out, room, spec, (long long)arg.integer);
+        break;
+      case 'u': case 'x': case 'X': case 'o': {
+        // 32-bit values were stored signed; undo the sign extension
+        unsigned long long value = (arg.type == LOG_ARG_INT64) ? (unsigned long long)arg.integer
+                                                               : (unsigned long long)(uint32_t)arg.integer;
+        const char tail[] = {'l', 'l', conversion, '\0'};
+        strcpy(spec + specLength, tail);
+        written = snprintf(out, room, spec, value);
+        break;
+      }
+      case 'c':
+        strcpy(spec + specLength, "c");
+        written = snprintf(out, room, spec, (int)arg.integer);
+        break;
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+        const char tail[] = {conversion, '\0'};
+        strcpy(spec + specLength, tail);
+        written = snprintf(out, room, spec, (double)arg.real);
+        break;
+      }
+      case 's':
+        strcpy(spec + specLength, "s");
+        written = snprintf(out, room, spec, arg.type == LOG_ARG_STRING ? arg.text : "?");
+        break;
+      case 'p':
+        written = snprintf(out, room, "%p", (void*)(uintptr_t)(uint32_t)arg.integer);
+        break;
+      default:
+        written = 0;
+        break;
+    }
+    if (written > 0) length += min((size_t)written, room - 1);
+  }
+  line[length] = '\0';
+  return length;
+}
+
+//=====================================
+// Log Task
+//=====================================
+
+/**
+ * Format and print the oldest queued message
+ * return false if the ring was empty
+ */
+static bool drainOne() {
+  static char line[LOG_LINE_LENGTH];
+  static uint32_t reportedDrops = 0;
+
+  // Report losses first, so they appear where the gap is
+  uint32_t drops = dropCount.load(std::memory_order_relaxed);
+  if (drops != reportedDrops) {
+    Serial.printf("[log] %lu messages dropped (ring full)\n", (unsigned long)(drops - reportedDrops));
+    reportedDrops = drops;
+  }
+
+  uint32_t index = dequeuePosition & (LOG_BUFFER_SLOTS - 1);
+  LogSlot& slot = ring[index];
+  uint32_t sequence = slot.sequence.load(std::memory_order_acquire) + index;
+  if (sequence != dequeuePosition + 1) return false;
+
+  size_t length = formatMessage(slot, line, sizeof(line));
+  // Hand the slot back for the next lap before the slow part
+  slot.sequence.store(dequeuePosition + LOG_BUFFER_SLOTS - index, std::memory_order_release);
+  dequeuePosition++;
+
+  Serial.write((const uint8_t*)line, length);
+  return true;
+}
+
+static void logTask(void* parameter) {
+  while (true) {
+    if (!drainOne()) {
+      vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL));
+    }
+  }
+}
+
+//=====================================
+// Public Interface
+//=====================================
+
+void initLogger() {
+  if (logTaskHandle != NULL) return;
+
+  xTaskCreate(
+    logTask,
+    "Logger",
+    LOG_TASK_STACK_SIZE,
+    NULL,
+    LOG_TASK_PRIORITY,
+    &logTaskHandle
+  );
+}
+
+void setLogLevel(LogModule module, LogLevel level) {
+  if (module < LogModule::COUNT) logLevels[(size_t)module] = level;
+}
+
+uint32_t getLogDropCount() {
+  return dropCount.load(std::memory_order_relaxed);
+}
+
+const char* logModuleName(LogModule module) {
+  return module < LogModule::COUNT ? moduleNames[(size_t)module] : "?";
+}
+
+bool setLogLevelByName(const String& module, const String& level) {
+  int levelIndex = -1;
+  for (int i = 0; i <= LOG_LEVEL_DEBUG; i++) {
+    if (level.equalsIgnoreCase(levelNames[i])) levelIndex = i;
+  }
+  if (levelIndex < 0) return false;
+
+  bool found = false;
+  for (size_t i = 0; i < (size_t)LogModule::COUNT; i++) {
+    if (module.equalsIgnoreCase("all") || module.equalsIgnoreCase(moduleNames[i])) {
+      logLevels[i] = (uint8_t)levelIndex;
+      found = true;
+    }
+  }
+  return found;
+}
+
+String logStatusJson() {
+  JsonDocument doc(bulkJsonAllocator());
+  JsonObject levels = doc["levels"].to<JsonObject>();
+  for (size_t i = 0; i < (size_t)LogModule::COUNT; i++) {
+    levels[moduleNames[i]] = levelNames[min(logLevels[i], (uint8_t)LOG_LEVEL_DEBUG)];
+  }
+  doc["dropped"] = getLogDropCount();
+  doc["queued"] = enqueuePosition.load(std::memory_order_relaxed) - dequeuePosition;
+  doc["slots"] = LOG_BUFFER_SLOTS;
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
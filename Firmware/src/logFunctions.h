@@ -0,0 +1,261 @@
+/*
+================================================================================
+  Log Functions - Deferred Serial Logging Header
+================================================================================
+
+  LOG_ALWAYS()/LOG_DEBUG() no longer write to Serial on the calling task.
+  The caller stores the format string pointer and its arguments in a ring
+  buffer slot; a low-priority task formats and prints them. A line at
+  115200 baud takes milliseconds to send, which used to land in the
+  capture-to-feedback path (matchSpell() logs every template per cast).
+
+  Ring Buffer:
+    - LOG_BUFFER_SLOTS fixed-size slots, bounded multi-producer queue:
+      a slot is claimed with one compare-and-swap and published through
+      its sequence number, so tasks on both cores log without a lock
+    - When full, a message is dropped and counted - logging never waits;
+      the log task reports the count before the next line it prints
+    - Arguments are copied as values: integers, floats (as float) and
+      strings (copied, truncated to fit the slot). Formatting happens
+      later, so nothing the caller owns has to outlive the call
+
+  Levels:
+    - Per module, changeable at runtime (setLogLevel(), or the portal's
+      /log endpoint); the check is one byte compare before any copying
+    - Each source file picks its module by defining LOG_MODULE before its
+      includes; files that don't log as CORE
+    - Defaults: DEBUG in dev builds, ALWAYS in production builds (debug
+      lines are compiled in, so they can be turned on in the field)
+
+================================================================================
+*/
+
+#ifndef LOG_FUNCTIONS_H
+#define LOG_FUNCTIONS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <type_traits>
+
+//=====================================
+// Configuration
+//=====================================
+
+#define LOG_BUFFER_SLOTS 64           // Ring size (power of 2)
+#define LOG_SLOT_DATA 64              // Argument bytes per message
+#define LOG_LINE_LENGTH 256           // Longest formatted line
+#define LOG_TASK_STACK_SIZE 3072      // Log task stack (bytes)
+#define LOG_TASK_PRIORITY 1           // Same as the app tasks - the idle priority is reserved
+#define LOG_DRAIN_INTERVAL 10         // Milliseconds between checks of an empty ring
+
+#ifdef ENV_DEV
+#define LOG_DEFAULT_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_DEFAULT_LEVEL LOG_LEVEL_ALWAYS
+#endif
+
+//=====================================
+// Modules and Levels
+//=====================================
+
+/**
+ * Source of a log message, each with its own runtime level
+ */
+enum class LogModule : uint8_t {
+  CORE,       ///< main loop, buttons, heap/task monitors
+  CAMERA,     ///< IR capture state machine and tracking
+  MATCHING,   ///< Spell patterns, matching, index, spotting
+  NETWORK,    ///< WiFi, portal, MQTT
+  STORAGE,    ///< SD card, preferences, custom spells
+  FEEDBACK,   ///< Screen, LEDs, audio
+  COUNT
+};
+
+/**
+ * Log levels - a message is kept if its level is at or below the module's
+ */
+enum LogLevel : uint8_t {
+  LOG_LEVEL_OFF = 0,
+  LOG_LEVEL_ALWAYS = 1,
+  LOG_LEVEL_DEBUG = 2
+};
+
+#ifndef LOG_MODULE
+#define LOG_MODULE LogModule::CORE
+#endif
+
+/// Current level per module (indexed by LogModule)
+extern uint8_t logLevels[(size_t)LogModule::COUNT];
+
+//=====================================
+// Ring Buffer Slot
+//=====================================
+
+/**
+ * One queued message
+ * sequence: slot position while free, position + 1 once published
+ * data: Arguments as (type tag, value) pairs, see LogArgType
+ */
+struct LogSlot {
+  std::atomic<uint32_t> sequence;
+  const char* format;
+  uint8_t length;
+  uint8_t data[LOG_SLOT_DATA];
+};
+
+/// Argument type tags in LogSlot::data
+enum LogArgType : uint8_t {
+  LOG_ARG_INT32,    ///< 4 bytes
+  LOG_ARG_INT64,    ///< 8 bytes
+  LOG_ARG_FLOAT,    ///< 4 bytes
+  LOG_ARG_STRING    ///< Length byte, then the characters
+};
+
+//=====================================
+// Logging Functions
+//=====================================
+
+/**
+ * Start the log task
+ * Call first in setup(); messages logged before are queued, not lost
+ * (until the ring fills).
+ */
+void initLogger();
+
+/**
+ * Claim a free slot
+ * return The slot to fill, or nullptr (message dropped) if the ring is full
+ */
+LogSlot* logReserve();
+
+/**
+ * Publish a filled slot to the log task
+ */
+void logPublish(LogSlot* slot);
+
+/**
+ * Change a module's level at runtime
+ */
+void setLogLevel(LogModule module, LogLevel level);
+
+/**
+ * Messages dropped because the ring was full, since boot
+ */
+uint32_t getLogDropCount();
+
+/**
+ * Module name as used by the /log endpoint ("camera", ...)
+ */
+const char* logModuleName(LogModule module);
+
+/**
+ * Levels, drop count and ring usage as JSON (for the /log endpoint)
+ */
+String logStatusJson();
+
+/**
+ * Apply /log?module=<name>&level=<off|always|debug> ("all" for every module)
+ * return false if the module or level name is unknown
+ */
+bool setLogLevelByName(const String& module, const String& level);
+
+//=====================================
+// Argument Capture
+//=====================================
+
+/**
+ * Appends arguments to a slot, dropping any that don't fit
+ */
+struct LogPacker {
+  LogSlot* slot;
+
+  void put(LogArgType type, const void* value, uint8_t size) {
+    if (slot->length + 1 + size > LOG_SLOT_DATA) {
+      slot->length = LOG_SLOT_DATA;  // Later arguments would be misread
+      return;
+    }
+    slot->data[slot->length] = type;
+    memcpy(slot->data + slot->length + 1, value, size);
+    slot->length += 1 + size;
+  }
+};
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+logPack(LogPacker& packer, T value) {
+  if (sizeof(T) > 4) {
+    int64_t wide = (int64_t)value;
+    packer.put(LOG_ARG_INT64, &wide, 8);
+  } else {
+    int32_t narrow = (int32_t)value;
+    packer.put(LOG_ARG_INT32, &narrow, 4);
+  }
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type
+logPack(LogPacker& packer, T value) {
+  float narrow = (float)value;
+  packer.put(LOG_ARG_FLOAT, &narrow, 4);
+}
+
+void logPack(LogPacker& packer, const char* value);
+
+inline void logPack(LogPacker& packer, const String& value) { logPack(packer, value.c_str()); }
+
+inline void logPack(LogPacker& packer, const void* value) {
+  int32_t address = (int32_t)(uintptr_t)value;
+  packer.put(LOG_ARG_INT32, &address, 4);
+}
+
+inline void logPackAll(LogPacker&) {}
+
+template <typename T, typename... Rest>
+inline void logPackAll(LogPacker& packer, const T& first, const Rest&... rest) {
+  logPack(packer, first);
+  logPackAll(packer, rest...);
+}
+
+/**
+ * Queue one message (called by the LOG_ macros after the level check)
+ * format: String literal - only its address is stored
+ */
+template <typename... Args>
+void logDeferred(const char* format, const Args&... args) {
+  LogSlot* slot = logReserve();
+  if (!slot) return;
+  slot->format = format;
+  slot->length = 0;
+  LogPacker packer = {slot};
+  logPackAll(packer, args...);
+  logPublish(slot);
+}
+
+//=====================================
+// Logging Macros
+//=====================================
+
+/**
+ * True if this file's module currently keeps messages of a level
+ * Use to skip work done only to produce log output.
+ */
+#define LOG_ENABLED(level) (logLevels[(size_t)(LOG_MODULE)] >= (level))
+
+#define LOG_AT(level, format, ...) \
+  do { \
+    if (LOG_ENABLED(level)) logDeferred(format "\n", ##__VA_ARGS__); \
+  } while (0)
+
+/**
+ * Always-on logging macro
+ * Use for critical errors and important status messages.
+ */
+#define LOG_ALWAYS(format, ...) LOG_AT(LOG_LEVEL_ALWAYS, format, ##__VA_ARGS__)
+
+/**
+ * Debug logging macro
+ * On by default in dev builds; enable per module at runtime in production.
+ */
+#define LOG_DEBUG(format, ...) LOG_AT(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+
+#endif // LOG_FUNCTIONS_H
@@ -45,16 +45,26 @@
 #include "buttonFunctions.h"      // Button handling
 #include "customSpellFunctions.h" // Custom spell recording
 #include "audioFunctions.h"       // I2S audio playback
+#include "mediaPrefetch.h"        // Opt-in speculative spell media loading
+#include "mediaBundle.h"          // Opt-in built-in media in a flash partition
+#include "spellAnimation.h"       // Animated spell images
 
 // Spell recognition system
 #include "spell_patterns.h"       // Predefined gesture patterns
 #include "spell_matching.h"       // Pattern matching algorithms
+#include "spellIndex.h"           // Template index and dual-core search
+#include "spellActions.h"         // Per-spell cast dispatch table
+#include "hotPath.h"              // Opt-in IRAM placement of capture/match code
 
 // Configuration and network
 #include "preferenceFunctions.h"  // NVS preference storage
 #include "webFunctions.h"         // WiFiManager web portal
 #include "wifiFunctions.h"        // MQTT client management
+#include "fleetSync.h"            // Opt-in cast deduplication between readers
 #include "sdFunctions.h"          // SD card operations
+#include "heapFunctions.h"        // Opt-in per-module heap accounting
+#include "memoryPolicy.h"         // Internal/PSRAM buffer placement
+#include "monitorFunctions.h"     // Opt-in task/core utilization monitor
 
 // Global definitions and hardware pins
 #include "glyphReader.h"
@@ -117,7 +127,8 @@ volatile bool wifiTaskRunning = false;
  * Dedicated WiFi processing task running on Core 0
  * 
  * Handles all WiFi-related operations separately from main application:
- * - WiFiManager portal processing (wm.process())
+ * - WiFi link state machine: connect, AP/STA switching, channel scan and
+ *   portal processing (processWiFiLink())
  * - MQTT connection maintenance and message processing
  * - Background NVS/SD saves triggered by web portal
  * 
@@ -125,16 +136,21 @@ volatile bool wifiTaskRunning = false;
  * I2C operations, display updates, and LED animations from starving
  * the WiFi stack of CPU time.
  * 
+ * HTTP API requests are not handled here - the event-driven API server
+ * (apiServer.h) answers them from the AsyncTCP task. Between passes the
+ * task sleeps until a WiFi event or request wakes it, or wifiTaskWaitMs().
+ * 
  * Stack size: 8KB (WiFiManager uses significant stack for HTML generation)
  * Priority: 1 (same as main loop, but on different core)
  */
 void wifiTask(void* parameter) {
   LOG_DEBUG("WiFi task started on Core %d", xPortGetCoreID());
   wifiTaskRunning = true;
+  HEAP_TASK_TAG(HeapTag::WEB);
   
   while (true) {
-    // Process WiFiManager web portal
-    wm.process();
+    // Advance the WiFi link and serve an open WiFiManager portal
+    processWiFiLink();
     
     // Process background saves (NVS/SD writes from web portal)
     processBackgroundSaves();
@@ -143,9 +159,58 @@ void wifiTask(void* parameter) {
     reconnectMQTT();
     mqttClient.loop();
     
-    // Give other tasks and WiFi stack time to run
-    // 10ms delay provides ~100Hz processing rate which is plenty for web portal
-    vTaskDelay(pdMS_TO_TICKS(10));
+    // Sleep until woken (WiFi event, portal request) or the next pass is due:
+    // 10ms only while WiFiManager's polled server is open
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wifiTaskWaitMs()));
+  }
+}
+
+/**
+ * Network setup run when the station link comes up
+ * Called from the WiFi task by the link state machine (see webFunctions.h),
+ * so the location lookup never holds up setup() or the tracking loop.
+ * Only the first connection does the work; reconnects need nothing.
+ */
+void onWiFiConnected() {
+  static bool networkServicesStarted = false;
+  if (networkServicesStarted) return;
+  networkServicesStarted = true;
+  
+  // Configure NTP time synchronization for accurate date/time
+  // This is critical for sunrise/sunset calculations; SNTP syncs in the background
+  LOG_DEBUG("Configuring NTP time sync...");
+  configTime(0, 0, "pool.ntp.org", "time.nist.gov");  // GMT+0, will use timezone offset from preferences
+  
+  // If latitude/longitude not set, fetch from ipapi.co
+  if (LATITUDE.length() == 0 || LONGITUDE.length() == 0) {
+    LOG_DEBUG("Location not configured - fetching from ipapi.co...");
+    ApiData locationData = fetchIpApiData();
+    
+    if (!locationData.error) {
+      // Save fetched location to preferences
+      LATITUDE = locationData.strings[0];
+      LONGITUDE = locationData.strings[1];
+      TIMEZONE_OFFSET = locationData.ints[0];
+      
+      setPref(PrefKey::LATITUDE, LATITUDE);
+      setPref(PrefKey::LONGITUDE, LONGITUDE);
+      setPref(PrefKey::TIMEZONE_OFFSET, TIMEZONE_OFFSET);
+      
+      LOG_DEBUG("Location configured: %s, %s (UTC%+d)", 
+                LATITUDE.c_str(), LONGITUDE.c_str(), TIMEZONE_OFFSET / 3600);
+    } else {
+      LOG_ALWAYS("Failed to fetch location from ipapi.co");
+    }
+  } else {
+    LOG_DEBUG("Location already configured: %s, %s", LATITUDE.c_str(), LONGITUDE.c_str());
+  }
+  
+  // Configure mDNS for easy access via http://glyphreader.local
+  if (!MDNS.begin("glyphreader")) {
+    LOG_ALWAYS("Error setting up MDNS responder!");
+  } else {
+    LOG_DEBUG("mDNS responder started: http://glyphreader.local");
+    MDNS.addService("http", "tcp", 80);
   }
 }
 
@@ -195,6 +260,12 @@ void setup() {
   Serial.begin(115200);
   delay(1000); // Give serial time to initialize
   
+  // Log output is printed by its own task from here on
+  initLogger();
+  
+  // Large buffers to PSRAM when fitted, before any are allocated
+  initMemoryPolicy();
+  
   LOG_DEBUG("\n\n=================================");
   LOG_DEBUG("Glyph Reader Startup");
   LOG_DEBUG("Version: %s", getVersionStringComplete());
@@ -273,6 +344,11 @@ void setup() {
   updateSetupDisplay(step, "SD Card", "init");
   bool sdCardReady = false;
   
+#ifdef MEDIA_PARTITION
+  // Built-in sounds and images, used where the SD card has no override
+  initMediaBundle();
+#endif
+  
   if (initSD()) {
     updateSetupDisplay(step, "SD Card", "pass");
     listDirectory("/", 0);  // List root directory contents
@@ -300,86 +376,23 @@ void setup() {
   
   // Check for spell image files 
   // Validates that .bmp image files exist on SD card for each spell
+#ifdef MEDIA_PARTITION
+  checkSpellImages();  // Built-in images are available without a card
+#else
   if (sdCardReady) {
     checkSpellImages();
   }
+#endif
   
   //-----------------------------------
   // Step 8: WiFi Configuration
   //-----------------------------------
-  // Setup WiFi with WiFiManager
+  // Setup WiFiManager parameters; the connection (or the setup portal if it
+  // fails) comes up in the background once the WiFi task starts below
   updateSetupDisplay(step, "WiFi Manager", "init");
-  
-  // Attempt WiFi connection or start AP mode
-  // Returns true if connected to WiFi, false if in AP mode
-  bool wifiConnected = initWM(120);
-  
-  if (wifiConnected) {
-    updateSetupDisplay(step, "WiFi Manager", "pass");
-    
-    //-----------------------------------
-    // Step 8a: Configure NTP Time Sync
-    //-----------------------------------
-    // Configure NTP time synchronization for accurate date/time
-    // This is critical for sunrise/sunset calculations
-    LOG_DEBUG("Configuring NTP time sync...");
-    configTime(0, 0, "pool.ntp.org", "time.nist.gov");  // GMT+0, will use timezone offset from preferences
-    
-    // Wait briefly for time to sync
-    int retries = 0;
-    while (time(nullptr) < 100000 && retries < 20) {  // Valid time is > 100000 (past Jan 1970)
-      delay(100);
-      retries++;
-    }
-    
-    if (time(nullptr) > 100000) {
-      LOG_DEBUG("Time synchronized successfully");
-    } else {
-      LOG_ALWAYS("Warning: NTP time sync may have failed");
-    }
-    
-    //-----------------------------------
-    // Step 8b: Fetch Location Data (if not configured)
-    //-----------------------------------
-    // If latitude/longitude not set, fetch from ipapi.co
-    if (LATITUDE.length() == 0 || LONGITUDE.length() == 0) {
-      LOG_DEBUG("Location not configured - fetching from ipapi.co...");
-      ApiData locationData = fetchIpApiData();
-      
-      if (!locationData.error) {
-        // Save fetched location to preferences
-        LATITUDE = locationData.strings[0];
-        LONGITUDE = locationData.strings[1];
-        TIMEZONE_OFFSET = locationData.ints[0];
-        
-        setPref(PrefKey::LATITUDE, LATITUDE);
-        setPref(PrefKey::LONGITUDE, LONGITUDE);
-        setPref(PrefKey::TIMEZONE_OFFSET, TIMEZONE_OFFSET);
-        
-        LOG_DEBUG("Location configured: %s, %s (UTC%+d)", 
-                  LATITUDE.c_str(), LONGITUDE.c_str(), TIMEZONE_OFFSET / 3600);
-      } else {
-        LOG_ALWAYS("Failed to fetch location from ipapi.co");
-      }
-    } else {
-      LOG_DEBUG("Location already configured: %s, %s", LATITUDE.c_str(), LONGITUDE.c_str());
-    }
-    
-    //-----------------------------------
-    // Step 8c: mDNS Responder
-    //-----------------------------------
-    // Configure mDNS for easy access via http://glyphreader.local
-    if (!MDNS.begin("glyphreader")) {
-      LOG_ALWAYS("Error setting up MDNS responder!");
-    } else {
-      LOG_DEBUG("mDNS responder started: http://glyphreader.local");
-      MDNS.addService("http", "tcp", 80);
-    }
-  } else {
-    // WiFi not connected - offline mode (AP mode active)
-    updateSetupDisplay(step, "WiFi Manager", "offline");
-    LOG_ALWAYS("Continuing in offline mode - web portal available at 192.168.4.1");
-  }
+  initWM();
+  setWiFiConnectedCallback(onWiFiConnected);
+  updateSetupDisplay(step, "WiFi Manager", "pass");
   step++;
   
   //-----------------------------------
@@ -395,24 +408,45 @@ void setup() {
   //-----------------------------------
   // Step 10: MQTT Configuration
   //-----------------------------------
-  // Setup MQTT (only if WiFi connected AND MQTT host is configured)
+  // Setup MQTT (only if MQTT host is configured)
   updateSetupDisplay(step, "MQTT", "init");
   
-  if (wifiConnected && MQTT_HOST.length() > 0) {
+  if (MQTT_HOST.length() > 0) {
     // Configure MQTT client with broker address and port
     mqttClient.setServer(MQTT_HOST.c_str(), MQTT_PORT);
     LOG_DEBUG("MQTT configured for %s:%d\n", MQTT_HOST.c_str(), MQTT_PORT);
     updateSetupDisplay(step, "MQTT", "ready");
-    // Note: MQTT will auto-connect in loop() via reconnectMQTT()
-  } else if (!wifiConnected) {
-    updateSetupDisplay(step, "MQTT", "skip");
-    LOG_DEBUG("MQTT skipped - no WiFi connection");
+    // Note: MQTT connects from wifiTask() via reconnectMQTT() once WiFi is up
   } else {
     updateSetupDisplay(step, "MQTT", "skip");
     LOG_DEBUG("MQTT skipped - no broker configured (set via web portal)");
   }
   step++;
   
+  //-----------------------------------
+  // Step 10a: Start WiFi Task on Core 0
+  //-----------------------------------
+  // Create dedicated WiFi task on Core 0 for reliable portal/MQTT operation
+  // Main loop runs on Core 1 (default Arduino core)
+  // This separation prevents I2C/display operations from starving WiFi stack,
+  // and lets WiFi connect while the rest of the hardware initializes
+  xTaskCreatePinnedToCore(
+    wifiTask,           // Task function
+    "WiFiTask",         // Task name
+    8192,               // Stack size (8KB - WiFiManager needs significant stack)
+    NULL,               // Parameters
+    1,                  // Priority (same as main loop)
+    &wifiTaskHandle,    // Task handle
+    0                   // Core 0 (WiFi core)
+  );
+  
+  LOG_DEBUG("WiFi task created on Core 0, main loop on Core %d", xPortGetCoreID());
+  
+#ifdef FLEET_SYNC
+  // Other readers in the room: only the best-placed one publishes a cast
+  initFleetSync();
+#endif
+  
   //-----------------------------------
   // Step 11: I2C Bus Initialization
   //-----------------------------------
@@ -478,6 +512,11 @@ void setup() {
   }
   step++;
   
+#ifdef PREFETCH_MEDIA
+  // Warm likely spells' images/sounds while gestures are drawn
+  initMediaPrefetch();
+#endif
+  
   //-----------------------------------
   // Setup Complete
   //-----------------------------------
@@ -491,23 +530,26 @@ void setup() {
   // Set screen on time for timeout tracking
   screenOnTime = millis();
   
-  //-----------------------------------
-  // Step 15: Start WiFi Task on Core 0
-  //-----------------------------------
-  // Create dedicated WiFi task on Core 0 for reliable portal/MQTT operation
-  // Main loop runs on Core 1 (default Arduino core)
-  // This separation prevents I2C/display operations from starving WiFi stack
-  xTaskCreatePinnedToCore(
-    wifiTask,           // Task function
-    "WiFiTask",         // Task name
-    8192,               // Stack size (8KB - WiFiManager needs significant stack)
-    NULL,               // Parameters
-    1,                  // Priority (same as main loop)
-    &wifiTaskHandle,    // Task handle
-    0                   // Core 0 (WiFi core)
-  );
+  // Spell index worker shares Core 0, idle until a large library is searched
+  initSpellIndexWorker();
   
-  LOG_DEBUG("WiFi task created on Core 0, main loop on Core %d", xPortGetCoreID());
+#ifdef BENCHMARK_MATCHING
+  benchmarkSpellIndex();
+#endif
+  
+#if defined(HOT_PATH_IRAM) || defined(BENCHMARK_LATENCY)
+  // Where the capture/match code and tables landed (see hotPath.h)
+  reportHotPathPlacement();
+#endif
+  
+#ifdef BENCHMARK_LATENCY
+  benchmarkMatchLatency();
+#endif
+  
+#ifdef MONITOR_TASKS
+  // Start task/core utilization monitor once all application tasks exist
+  initTaskMonitor();
+#endif
 }
 
 
@@ -525,27 +567,42 @@ void loop() {
   static uint32_t lastHeapCheck = 0;
   if (currentTime - lastHeapCheck > 10000) {
     lastHeapCheck = currentTime;
-    LOG_DEBUG("Heap: free=%u, min=%u, maxAlloc=%u", 
-              ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap());
+    logHeapHeadroom();
   }
   #endif
   
+  // Per-module heap accounting and fragmentation timeline
+  #ifdef TRACK_HEAP
+  updateHeapTracker(currentTime);
+  #endif
+  
+  //-----------------------------------
+  // UI Lock
+  //-----------------------------------
+  // Button handlers run on the UI task (see buttonFunctions.h). The
+  // sections below that drive the screen, LEDs and menu state hold the
+  // lock; the camera section samples without it (readCameraData() locks
+  // around its own feedback), so a handler never costs a camera read.
+  lockUi();
+  
+  // Apply a spell library reload asked for by another task (portal
+  // rename, spell save) - here, between casts, where matching runs
+  reloadSpellLibraryIfPending();
+  refreshSpellCombos();  // Compile combos for the (re)loaded library
+  updateSpellActions();  // Recompile cast actions after library/prefs changes
+  
   //-----------------------------------
   // LED Animation Updates
   //-----------------------------------
   // Update LED effects 
   updateLEDs();
   
+  // Draw the next spell animation frame when due
+  updateSpellAnimation(currentTime);
+  
   // NOTE: WiFi portal (wm.process), MQTT, and background saves are now
   // handled by wifiTask() running on Core 0 for reliable operation
 
-  //-----------------------------------
-  // Button Processing
-  //-----------------------------------
-  // Check for button presses and process them
-  button1.loop();
-  button2.loop();
-
   //-----------------------------------
   // Sensor Reinitialization (with exponential backoff)
   //-----------------------------------
@@ -581,6 +638,8 @@ void loop() {
     // Don't return - allow rest of loop to process (buttons, etc.)
   }
   
+  unlockUi();
+  
   // NOTE: MQTT is now handled by wifiTask() on Core 0
   
   //-----------------------------------
@@ -597,6 +656,8 @@ void loop() {
     readCameraData();  // Process IR tracking and gesture recognition
     lastReadTime = currentTime;
   }
+  
+  lockUi();
 
   //-----------------------------------
   // Screen Timeout Handling
@@ -607,8 +668,8 @@ void loop() {
   if (screenSpellOnTime > 0 && (millis() - screenSpellOnTime >= screenSpellDuration)) {
     // Clear spell name after 3 seconds
     screenSpellOnTime = 0;
-    // Restore idle background after spell display timeout
-    clearDisplay();
+    // Show a combo waiting behind the spell, else restore idle background
+    if (!showPendingCombo()) clearDisplay();
   }
 
   // Check if the screen has been on for too long without activity
@@ -642,4 +703,6 @@ void loop() {
     setLEDMode(LED_OFF);
     LOG_DEBUG("Nightlight mode timed out - LEDs turned off");
   }
+  
+  unlockUi();
 }
\ No newline at end of file
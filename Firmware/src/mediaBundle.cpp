@@ -0,0 +1,114 @@
+/*
+================================================================================
+  Media Bundle - Built-In Media in a Memory-Mapped Flash Partition
+================================================================================
+
+  Implements the MEDIA_PARTITION bundle declared in mediaBundle.h.
+
+  The header is checked through a small mapping first, then the whole
+  bundle is mapped once and kept for the life of the firmware; the index
+  is read in place. Every function is read-only after initMediaBundle(),
+  so assets can be used from any task.
+
+================================================================================
+*/
+
+#define LOG_MODULE LogModule::STORAGE
+
+#include "mediaBundle.h"
+
+#ifdef MEDIA_PARTITION
+
+#include "glyphReader.h"
+#include "flashMap.h"
+
+//=====================================
+// Bundle State
+//=====================================
+
+static const MediaBundleEntry* bundleIndex = nullptr;  // Mapped index
+static const uint8_t* bundleBase = nullptr;            // Mapped bundle
+static uint16_t bundleCount = 0;
+static uint32_t bundleSize = 0;
+
+//=====================================
+// Public Interface
+//=====================================
+
+bool initMediaBundle() {
+  const esp_partition_t* partition = esp_partition_find_first(
+    ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, MEDIA_PARTITION_LABEL);
+  if (partition == NULL) {
+    LOG_ALWAYS("No media partition - built-in media unavailable (see partitions_media.csv)");
+    return false;
+  }
+
+  // Check the header before mapping the whole bundle
+  const void* mapped;
+  FlashMapHandle handle;
+  if (esp_partition_mmap(partition, 0, sizeof(MediaBundleHeader), FLASH_MAP_DATA,
+                         &mapped, &handle) != ESP_OK) {
+    LOG_ALWAYS("Failed to map media partition header");
+    return false;
+  }
+  MediaBundleHeader header = *(const MediaBundleHeader*)mapped;
+  flashUnmap(handle);
+
+  if (header.magic != MEDIA_BUNDLE_MAGIC || header.version != MEDIA_BUNDLE_VERSION) {
+    LOG_ALWAYS("Media partition is empty or not a bundle - flash it with Tools/bundle_media.py");
+    return false;
+  }
+  uint32_t indexEnd = sizeof(MediaBundleHeader) + header.count * sizeof(MediaBundleEntry);
+  if (header.size > partition->size || indexEnd > header.size) {
+    LOG_ALWAYS("Media bundle size %u does not fit its partition (%u)", header.size, partition->size);
+    return false;
+  }
+
+  // Mapped for the life of the firmware
+  if (esp_partition_mmap(partition, 0, header.size, FLASH_MAP_DATA,
+                         &mapped, &handle) != ESP_OK) {
+    LOG_ALWAYS("Failed to map media bundle (%u bytes)", header.size);
+    return false;
+  }
+  bundleBase = (const uint8_t*)mapped;
+  bundleIndex = (const MediaBundleEntry*)(bundleBase + sizeof(MediaBundleHeader));
+  bundleSize = header.size;
+
+  // Drop entries pointing outside the bundle rather than trusting them later
+  uint16_t valid = 0;
+  for (uint16_t i = 0; i < header.count; i++) {
+    const MediaBundleEntry& entry = bundleIndex[i];
+    if (entry.offset < indexEnd || entry.offset > bundleSize || entry.size > bundleSize - entry.offset ||
+        memchr(entry.path, '\0', MEDIA_PATH_LENGTH) == NULL) {
+      LOG_ALWAYS("Media bundle entry %d is corrupt - ignoring the rest", i);
+      break;
+    }
+    valid++;
+  }
+  bundleCount = valid;
+
+  LOG_DEBUG("Media bundle mapped: %d files, %u bytes", bundleCount, bundleSize);
+  return bundleCount > 0;
+}
+
+bool findMediaAsset(const char* path, MediaAsset& asset) {
+  for (uint16_t i = 0; i < bundleCount; i++) {
+    if (strcasecmp(bundleIndex[i].path, path) == 0) {
+      asset.data = bundleBase + bundleIndex[i].offset;
+      asset.size = bundleIndex[i].size;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool hasMediaAsset(const char* path) {
+  MediaAsset asset;
+  return findMediaAsset(path, asset);
+}
+
+uint16_t mediaAssetCount() {
+  return bundleCount;
+}
+
+#endif // MEDIA_PARTITION
@@ -0,0 +1,110 @@
+/*
+================================================================================
+  Media Bundle - Built-In Media in a Memory-Mapped Flash Partition Header
+================================================================================
+
+  Serves the built-in spell images and sounds from the "media" partition
+  of internal flash, so a reader without an SD card still shows images and
+  plays sounds. Enabled with the MEDIA_PARTITION build flag (see
+  platformio.ini), which needs the partitions_media.csv partition table.
+
+  Bundle:
+    - Packed on the host by Tools/bundle_media.py and flashed alongside
+      the firmware (the script can flash it with --port)
+    - Header and index are followed by the files, unchanged, 4-byte
+      aligned; paths are the SD card paths (/<spell>.bmp, /sounds/<name>.wav)
+
+  Access:
+    - The whole bundle is mapped into the data address space once at boot
+      (esp_partition_mmap), so an asset is a pointer and a size - reads go
+      through the flash cache with no file system or copy
+    - Sounds are written to I2S straight from the mapping and images are
+      drawn a row at a time from it (no decoded frame in heap)
+
+  SD Card Overrides:
+    - A file on the SD card with the same path wins over the built-in one;
+      audio and image loading check the card first
+
+================================================================================
+*/
+
+#ifndef MEDIA_BUNDLE_H
+#define MEDIA_BUNDLE_H
+
+#include <Arduino.h>
+
+//=====================================
+// Configuration
+//=====================================
+
+#define MEDIA_PARTITION_LABEL "media"   // Partition name in partitions_media.csv
+#define MEDIA_BUNDLE_MAGIC 0x424D5247   // "GRMB" little endian
+#define MEDIA_BUNDLE_VERSION 1
+#define MEDIA_PATH_LENGTH 56            // Index path field, including terminator
+
+#ifdef MEDIA_PARTITION
+
+//=====================================
+// Bundle Data Structures
+//=====================================
+
+/**
+ * Bundle header at the start of the partition
+ */
+struct MediaBundleHeader {
+  uint32_t magic;           // MEDIA_BUNDLE_MAGIC
+  uint16_t version;         // MEDIA_BUNDLE_VERSION
+  uint16_t count;           // Index entries
+  uint32_t size;            // Header, index and data (bytes)
+  uint32_t reserved;
+};
+
+/**
+ * Index entry, one per file
+ */
+struct MediaBundleEntry {
+  char path[MEDIA_PATH_LENGTH];   // SD-style path, lowercase
+  uint32_t offset;                // From the start of the bundle
+  uint32_t size;                  // File size (bytes)
+};
+
+/**
+ * A file in the mapped bundle
+ */
+struct MediaAsset {
+  const uint8_t* data;      // Mapped file contents (read-only, flash)
+  uint32_t size;            // Bytes
+};
+
+//=====================================
+// Bundle Functions
+//=====================================
+
+/**
+ * Find and map the media partition
+ * Call once in setup() before checkSpellImages().
+ * return true if a valid bundle is mapped
+ */
+bool initMediaBundle();
+
+/**
+ * Look up a built-in file (case-insensitive)
+ * path: SD-style path, e.g. "/illuminate.bmp"
+ * asset: Output on success, valid until reboot
+ * return true if the bundle has the file
+ */
+bool findMediaAsset(const char* path, MediaAsset& asset);
+
+/**
+ * Check whether the bundle has a file
+ */
+bool hasMediaAsset(const char* path);
+
+/**
+ * Number of files in the mapped bundle (0 if none)
+ */
+uint16_t mediaAssetCount();
+
+#endif // MEDIA_PARTITION
+
+#endif // MEDIA_BUNDLE_H
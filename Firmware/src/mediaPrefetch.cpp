@@ -0,0 +1,366 @@
+/*
+================================================================================
+  Media Prefetch - Speculative Spell Image/Sound Loading Implementation
+================================================================================
+
+  Implements the PREFETCH_MEDIA prefetcher declared in mediaPrefetch.h.
+
+  Threading:
+    - The loop task ranks, publishes the wanted set and takes images;
+      the prefetch task owns decoding. Slots, the wanted set and the
+      counters are guarded by prefetchLock (a mutex - slots are freed
+      while it is held)
+    - wantedGeneration changes with every new wanted set, so the decoder
+      only re-checks the set (under the lock) when it may have changed
+
+================================================================================
+*/
+
+#define LOG_MODULE LogModule::FEEDBACK
+
+#include "mediaPrefetch.h"
+
+#ifdef PREFETCH_MEDIA
+
+#include "glyphReader.h"
+#include "audioFunctions.h"
+#include "heapFunctions.h"
+#include "memoryPolicy.h"
+#include "preferenceFunctions.h"
+#include "spellActions.h"
+#include "spell_matching.h"
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <atomic>
+
+//=====================================
+// Prefetch State
+//=====================================
+
+enum class SlotState : uint8_t {
+  EMPTY,
+  LOADING,    // Being decoded by the prefetch task
+  READY       // Decoded, waiting for a cast
+};
+
+/**
+ * One prefetched image
+ */
+struct PrefetchSlot {
+  SlotState state;
+  char file[PREFETCH_PATH_LENGTH];
+  SpellImage image;
+};
+
+/**
+ * Images the latest ranking wants, best first, and the colors to tint them
+ */
+struct PrefetchWanted {
+  uint8_t count;
+  char files[PREFETCH_IMAGE_SLOTS][PREFETCH_PATH_LENGTH];
+  uint16_t primary;
+  uint16_t accent;
+};
+
+// Guarded by prefetchLock
+static PrefetchSlot slots[PREFETCH_IMAGE_SLOTS];
+static PrefetchWanted wanted;
+static PrefetchStats stats;
+
+static SemaphoreHandle_t prefetchLock = NULL;
+static TaskHandle_t prefetchTaskHandle = NULL;
+static std::atomic<uint32_t> wantedGeneration(0);
+
+// Loop task only
+static bool gestureActive = false;   // A gesture is being prefetched
+static uint32_t lastRankTime = 0;
+static uint16_t gesturePrimary = 0;
+static uint16_t gestureAccent = 0;
+
+// Prefetch task only - the decode in progress
+static char loadingFile[PREFETCH_PATH_LENGTH];
+static uint32_t loadingGeneration = 0;
+static bool loadAborted = false;
+
+//=====================================
+// Helpers
+//=====================================
+
+/**
+ * Check whether a file is in the wanted set (caller holds prefetchLock)
+ */
+static bool isWanted(const char* file) {
+  for (uint8_t i = 0; i < wanted.count; i++) {
+    if (strcmp(wanted.files[i], file) == 0) return true;
+  }
+  return false;
+}
+
+/**
+ * Free a slot's image (caller holds prefetchLock)
+ * READY slots dropped without being taken count as cancelled.
+ */
+static void releaseSlot(PrefetchSlot& slot) {
+  if (slot.state == SlotState::READY) {
+    freeSpellImage(slot.image);
+    stats.cancelled++;
+  }
+  slot.state = SlotState::EMPTY;
+}
+
+/**
+ * Decode abort check - true once the image being loaded is no longer wanted
+ */
+static bool abortLoading() {
+  uint32_t generation = wantedGeneration.load();
+  if (generation == loadingGeneration) return false;
+  loadingGeneration = generation;
+
+  xSemaphoreTake(prefetchLock, portMAX_DELAY);
+  loadAborted = !isWanted(loadingFile);
+  xSemaphoreGive(prefetchLock);
+  return loadAborted;
+}
+
+/**
+ * Publish a new wanted set and wake the prefetch task if it changed
+ */
+static void setWanted(const PrefetchWanted& next) {
+  xSemaphoreTake(prefetchLock, portMAX_DELAY);
+  bool changed = next.count != wanted.count || next.primary != wanted.primary || next.accent != wanted.accent;
+  for (uint8_t i = 0; !changed && i < next.count; i++) {
+    changed = strcmp(next.files[i], wanted.files[i]) != 0;
+  }
+  if (changed) {
+    wanted = next;
+    wantedGeneration++;
+  }
+  xSemaphoreGive(prefetchLock);
+
+  if (changed) xTaskNotifyGive(prefetchTaskHandle);
+}
+
+//=====================================
+// Prefetch Task
+//=====================================
+
+/**
+ * Make slots match the wanted set, one decode at a time
+ */
+static void prefetchTask(void* parameter) {
+  HEAP_TASK_TAG(HeapTag::DISPLAY);
+  uint16_t lut[256];
+
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    while (true) {
+      // Drop unwanted slots and pick the next image to load
+      xSemaphoreTake(prefetchLock, portMAX_DELAY);
+      for (auto& slot : slots) {
+        if (slot.state == SlotState::READY && !isWanted(slot.file)) releaseSlot(slot);
+      }
+      PrefetchSlot* target = nullptr;
+      const char* next = nullptr;
+      for (uint8_t i = 0; i < wanted.count && next == nullptr; i++) {
+        bool held = false;
+        for (const auto& slot : slots) {
+          if (slot.state != SlotState::EMPTY && strcmp(slot.file, wanted.files[i]) == 0) held = true;
+        }
+        if (!held) next = wanted.files[i];
+      }
+      for (auto& slot : slots) {
+        if (slot.state == SlotState::EMPTY) target = &slot;
+      }
+      uint16_t primary = wanted.primary;
+      uint16_t accent = wanted.accent;
+      if (next != nullptr && target != nullptr) {
+        target->state = SlotState::LOADING;
+        strcpy(target->file, next);
+        strcpy(loadingFile, next);
+        loadingGeneration = wantedGeneration.load();
+      }
+      xSemaphoreGive(prefetchLock);
+
+      if (next == nullptr || target == nullptr) break;  // Nothing to do or no free slot
+
+      // Don't let a speculative load starve the rest of the system
+      if (policyFreeSize(AllocPolicy::BULK) < PREFETCH_IMAGE_BYTES + PREFETCH_MIN_FREE_HEAP) {
+        xSemaphoreTake(prefetchLock, portMAX_DELAY);
+        target->state = SlotState::EMPTY;
+        stats.lowHeap++;
+        xSemaphoreGive(prefetchLock);
+        break;
+      }
+
+      buildSpellImageLUT(primary, lut);
+      SpellImage image;
+      loadAborted = false;
+      bool decoded = decodeImageFromSD(loadingFile, lut, accent, image, abortLoading);
+      image.primary = primary;
+      image.accent = accent;
+
+      xSemaphoreTake(prefetchLock, portMAX_DELAY);
+      if (decoded && isWanted(target->file)) {
+        target->image = image;
+        target->state = SlotState::READY;
+        stats.loaded++;
+      } else {
+        if (decoded) freeSpellImage(image);
+        target->state = SlotState::EMPTY;
+        if (decoded || loadAborted) stats.cancelled++;
+      }
+      xSemaphoreGive(prefetchLock);
+
+      if (!decoded && !loadAborted) {
+        LOG_DEBUG("Prefetch failed: %s", loadingFile);
+        break;  // Retried on the next ranking change
+      }
+    }
+  }
+}
+
+//=====================================
+// Public Interface
+//=====================================
+
+void initMediaPrefetch() {
+  prefetchLock = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(
+    prefetchTask,
+    "MediaPrefetch",
+    PREFETCH_TASK_STACK,
+    NULL,
+    1,                      // Same as audio - below WiFi/camera
+    &prefetchTaskHandle,
+    0                       // Core 0, beside the WiFi and audio tasks
+  );
+  LOG_DEBUG("Media prefetch started (%d candidates, %d image slots)",
+            PREFETCH_CANDIDATES, PREFETCH_IMAGE_SLOTS);
+}
+
+void updateMediaPrefetch(const std::vector<Point>& trajectory, uint32_t currentTime) {
+  if (prefetchTaskHandle == NULL) return;
+  if (trajectory.size() < PREFETCH_MIN_POINTS) return;
+  if (gestureActive && currentTime - lastRankTime < PREFETCH_RANK_INTERVAL) return;
+  lastRankTime = currentTime;
+
+  if (!gestureActive) {
+    // New gesture: fix its colors and warm the sound it will play
+    gestureActive = true;
+    gesturePrimary = pickSpellImagePrimaryColor();
+    gestureAccent = getSpellAccentColor();
+    prefetchSound(upcomingSpellSound());
+  }
+
+  SpellId ids[PREFETCH_CANDIDATES];
+  float scores[PREFETCH_CANDIDATES];
+  size_t ranked = rankSpellPrefixes(trajectory, ids, scores, PREFETCH_CANDIDATES);
+
+  // Images of the ranked spells that have one, best first
+  PrefetchWanted next;
+  next.count = 0;
+  next.primary = gesturePrimary;
+  next.accent = gestureAccent;
+  for (size_t i = 0; i < ranked && next.count < PREFETCH_IMAGE_SLOTS; i++) {
+    const SpellAction& action = spellAction(ids[i]);
+    if (!action.hasImage || action.imageFile.length() >= PREFETCH_PATH_LENGTH) continue;
+    if (action.animationFile.length() > 0) continue;  // Animated - the image isn't shown
+#ifdef MEDIA_PARTITION
+    if (action.imageBuiltIn) continue;  // Drawn straight from flash, nothing to gain
+#endif
+    strcpy(next.files[next.count++], action.imageFile.c_str());
+  }
+  setWanted(next);
+}
+
+void endMediaPrefetch() {
+  if (prefetchTaskHandle == NULL || !gestureActive) return;
+  gestureActive = false;
+
+  xSemaphoreTake(prefetchLock, portMAX_DELAY);
+  wanted.count = 0;
+  wantedGeneration++;  // Abandons a decode in progress
+  for (auto& slot : slots) {
+    if (slot.state == SlotState::READY) releaseSlot(slot);
+  }
+  xSemaphoreGive(prefetchLock);
+}
+
+bool takePrefetchedImage(const char* filename, bool anyColor, uint16_t primary, uint16_t accent, SpellImage& image) {
+  if (prefetchTaskHandle == NULL || !gestureActive) return false;
+
+  bool hit = false;
+  xSemaphoreTake(prefetchLock, portMAX_DELAY);
+  for (auto& slot : slots) {
+    if (slot.state != SlotState::READY || strcmp(slot.file, filename) != 0) continue;
+    if (!anyColor && (slot.image.primary != primary || slot.image.accent != accent)) continue;
+    image = slot.image;
+    slot.image.rows = nullptr;
+    slot.state = SlotState::EMPTY;
+    hit = true;
+    break;
+  }
+  if (hit) {
+    stats.imageHits++;
+  } else {
+    // Free the heap for the caller's own decode
+    stats.imageMisses++;
+    wanted.count = 0;
+    wantedGeneration++;
+    for (auto& slot : slots) {
+      if (slot.state == SlotState::READY) releaseSlot(slot);
+    }
+  }
+  xSemaphoreGive(prefetchLock);
+  return hit;
+}
+
+void noteSpellSound(const char* filename) {
+  if (prefetchTaskHandle == NULL || !gestureActive || !SOUND_ENABLED) return;
+  bool warm = isSoundWarm(filename);
+  xSemaphoreTake(prefetchLock, portMAX_DELAY);
+  if (warm) {
+    stats.soundHits++;
+  } else {
+    stats.soundMisses++;
+  }
+  xSemaphoreGive(prefetchLock);
+}
+
+PrefetchStats getPrefetchStats() {
+  PrefetchStats copy = {};
+  if (prefetchLock == NULL) return copy;
+  xSemaphoreTake(prefetchLock, portMAX_DELAY);
+  copy = stats;
+  xSemaphoreGive(prefetchLock);
+  return copy;
+}
+
+String prefetchStatsJson() {
+  PrefetchStats s = getPrefetchStats();
+  JsonDocument doc(bulkJsonAllocator());
+
+  JsonObject image = doc["image"].to<JsonObject>();
+  image["hits"] = s.imageHits;
+  image["misses"] = s.imageMisses;
+  image["hitRate"] = (s.imageHits + s.imageMisses) ? (float)s.imageHits / (s.imageHits + s.imageMisses) : 0;
+
+  JsonObject sound = doc["sound"].to<JsonObject>();
+  sound["hits"] = s.soundHits;
+  sound["misses"] = s.soundMisses;
+  sound["hitRate"] = (s.soundHits + s.soundMisses) ? (float)s.soundHits / (s.soundHits + s.soundMisses) : 0;
+
+  doc["loaded"] = s.loaded;
+  doc["cancelled"] = s.cancelled;
+  doc["lowHeap"] = s.lowHeap;
+  doc["slots"] = PREFETCH_IMAGE_SLOTS;
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+
+#endif // PREFETCH_MEDIA
@@ -0,0 +1,147 @@
+/*
+================================================================================
+  Media Prefetch - Speculative Spell Image/Sound Loading Header
+================================================================================
+
+  Warms the media of the spells most likely being drawn while a gesture
+  is still being recorded, so the image and sound are ready the moment
+  the match completes. Enabled with the PREFETCH_MEDIA build flag (see
+  platformio.ini) - each prefetched image holds a full decoded frame
+  (~115KB for 240x240) in heap while the gesture is drawn.
+
+  Ranking:
+    - Every PREFETCH_RANK_INTERVAL ms during RECORDING, the trajectory so
+      far is ranked against template prefixes (rankSpellPrefixes() in
+      spell_matching.h) - cheap chain-code comparisons, no resampling of
+      the library
+    - The images of the top PREFETCH_CANDIDATES spells (those that have
+      one, best first) are wanted in up to PREFETCH_IMAGE_SLOTS slots
+
+  Prefetch Task (core 0):
+    - Woken when the wanted set changes; drops slots no longer wanted and
+      decodes wanted images into free slots (decodeImageFromSD())
+    - A decode in progress is abandoned as soon as its image falls out of
+      the wanted set, so stale prefetches don't delay fresh ones
+    - Skips a load that would leave less than PREFETCH_MIN_FREE_HEAP free
+      in the image's region (PSRAM if fitted, see memoryPolicy.h)
+    - Built-in images (MEDIA_PARTITION) are not prefetched - they are
+      drawn straight from mapped flash
+    - Images are tinted with the colors picked for this gesture (a random
+      palette color is picked once per gesture in Random mode)
+
+  Sound:
+    - The spell sound is random per cast, not per spell, so it is picked
+      one cast ahead (see randomSpellSound()) and warmed in the audio task
+      when a gesture starts (prefetchSound())
+
+  Cast:
+    - displaySpellName() takes a ready image with takePrefetchedImage()
+      and only writes it out; a miss releases all slots before the
+      normal decode so the two never hold frames at once
+    - endMediaPrefetch() drops whatever is left when the gesture ends
+
+  Counters:
+    - Image and sound hits/misses (for casts from a prefetched gesture),
+      images loaded, prefetches cancelled unused and loads skipped for
+      heap; served as JSON at /prefetch
+
+================================================================================
+*/
+
+#ifndef MEDIA_PREFETCH_H
+#define MEDIA_PREFETCH_H
+
+#include <Arduino.h>
+#include <vector>
+#include "spell_patterns.h"
+#include "screenFunctions.h"
+
+//=====================================
+// Configuration
+//=====================================
+
+#define PREFETCH_CANDIDATES 3           // Spells ranked per update
+#define PREFETCH_IMAGE_SLOTS 2          // Images held at once (~115KB each)
+#define PREFETCH_RANK_INTERVAL 100      // Milliseconds between rankings
+#define PREFETCH_MIN_POINTS 10          // Trajectory points before the first ranking
+#define PREFETCH_IMAGE_BYTES (240 * 240 * 2)  // Decoded full-screen image
+#define PREFETCH_MIN_FREE_HEAP 65536    // Heap left free after a prefetched image (bytes)
+#define PREFETCH_PATH_LENGTH 64         // Longest image path, including terminator
+#define PREFETCH_TASK_STACK 4096        // Prefetch task stack (bytes)
+
+#ifdef PREFETCH_MEDIA
+
+//=====================================
+// Prefetch Data Structures
+//=====================================
+
+/**
+ * Prefetch counters since boot
+ * Hits and misses only count casts made while a gesture was prefetched.
+ */
+struct PrefetchStats {
+  uint32_t imageHits;       // Cast image was ready
+  uint32_t imageMisses;     // Cast image had to be loaded
+  uint32_t soundHits;       // Cast sound was warm
+  uint32_t soundMisses;     // Cast sound had to be opened
+  uint32_t loaded;          // Images decoded ahead of time
+  uint32_t cancelled;       // Prefetched or loading images dropped unused
+  uint32_t lowHeap;         // Loads skipped to keep PREFETCH_MIN_FREE_HEAP
+};
+
+//=====================================
+// Prefetch Functions
+//=====================================
+
+/**
+ * Start the prefetch task
+ * Call once in setup() after the SD card and audio are initialized.
+ */
+void initMediaPrefetch();
+
+/**
+ * Rank the gesture so far and update the wanted images
+ * Call every frame while RECORDING; rate-limited to PREFETCH_RANK_INTERVAL.
+ * The first ranking of a gesture also warms the next spell sound.
+ * trajectory: Points recorded so far
+ * currentTime: millis()
+ */
+void updateMediaPrefetch(const std::vector<Point>& trajectory, uint32_t currentTime);
+
+/**
+ * Gesture finished (cast, no match or timeout) - release all slots
+ */
+void endMediaPrefetch();
+
+/**
+ * Take a prefetched image for display
+ * On a hit the slot's rows move to image (caller frees them). On a miss
+ * every slot is released so the caller can decode the image itself.
+ * filename: Image path
+ * anyColor: Accept an image tinted with any color (Random mode)
+ * primary: Required primary color otherwise
+ * accent: Required accent color otherwise
+ * image: Output on a hit
+ * return true on a hit
+ */
+bool takePrefetchedImage(const char* filename, bool anyColor, uint16_t primary, uint16_t accent, SpellImage& image);
+
+/**
+ * Count a cast's spell sound as a prefetch hit or miss
+ * filename: Sound about to be played
+ */
+void noteSpellSound(const char* filename);
+
+/**
+ * Copy the counters
+ */
+PrefetchStats getPrefetchStats();
+
+/**
+ * Counters and hit rates as a JSON string (served at /prefetch)
+ */
+String prefetchStatsJson();
+
+#endif // PREFETCH_MEDIA
+
+#endif // MEDIA_PREFETCH_H
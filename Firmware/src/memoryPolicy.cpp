@@ -0,0 +1,207 @@
+/*
+================================================================================
+  Memory Policy - Capability-Based Placement of Heap Buffers
+================================================================================
+
+  Implements the allocation policy declared in memoryPolicy.h.
+
+  Whether PSRAM is present is read once in initMemoryPolicy(); until then
+  (static constructors) every request is served as if there were none.
+  Without PSRAM every call is plain malloc()/free(), so the TRACK_HEAP
+  wrappers keep attributing the allocations to their modules.
+
+================================================================================
+*/
+
+#define LOG_MODULE LogModule::CORE
+
+#include "memoryPolicy.h"
+#include "glyphReader.h"
+#include <esp_heap_caps.h>
+#if __has_include(<esp_memory_utils.h>)
+#include <esp_memory_utils.h>
+#else
+#include <soc/soc_memory_layout.h>
+#endif
+#include <atomic>
+
+//=====================================
+// Policy State
+//=====================================
+
+#define INTERNAL_CAPS (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define PSRAM_CAPS (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+
+static bool psramAvailable = false;
+static std::atomic<uint32_t> bulkPsram(0);
+static std::atomic<uint32_t> bulkInternal(0);
+static std::atomic<uint32_t> failedAllocations(0);
+
+/**
+ * Count where a request went
+ */
+static void* countAllocation(void* buffer, AllocPolicy policy) {
+  if (buffer == nullptr) {
+    failedAllocations++;
+  } else if (policy == AllocPolicy::BULK) {
+    if (esp_ptr_external_ram(buffer)) {
+      bulkPsram++;
+    } else {
+      bulkInternal++;
+    }
+  }
+  return buffer;
+}
+
+//=====================================
+// Allocation
+//=====================================
+
+void initMemoryPolicy() {
+  psramAvailable = psramFound();
+  if (psramAvailable) {
+    // Small requests through plain malloc() stay internal
+    heap_caps_malloc_extmem_enable(MEMORY_INTERNAL_LIMIT);
+    LOG_DEBUG("Memory policy: BULK buffers in PSRAM (%u bytes), malloc() below %u bytes internal",
+              (unsigned)heap_caps_get_total_size(PSRAM_CAPS), MEMORY_INTERNAL_LIMIT);
+  } else {
+    LOG_DEBUG("Memory policy: no PSRAM, all buffers internal");
+  }
+}
+
+void* policyMalloc(size_t size, AllocPolicy policy) {
+  if (!psramAvailable) return countAllocation(malloc(size), policy);
+  if (policy == AllocPolicy::FAST) return countAllocation(heap_caps_malloc(size, INTERNAL_CAPS), policy);
+  return countAllocation(heap_caps_malloc_prefer(size, 2, PSRAM_CAPS, INTERNAL_CAPS), policy);
+}
+
+void* policyCalloc(size_t count, size_t size, AllocPolicy policy) {
+  if (!psramAvailable) return countAllocation(calloc(count, size), policy);
+  if (policy == AllocPolicy::FAST) return countAllocation(heap_caps_calloc(count, size, INTERNAL_CAPS), policy);
+  return countAllocation(heap_caps_calloc_prefer(count, size, 2, PSRAM_CAPS, INTERNAL_CAPS), policy);
+}
+
+void* policyRealloc(void* buffer, size_t size, AllocPolicy policy) {
+  if (buffer == nullptr) return policyMalloc(size, policy);
+  if (!psramAvailable) return realloc(buffer, size);
+  if (policy == AllocPolicy::FAST) return heap_caps_realloc(buffer, size, INTERNAL_CAPS);
+  return heap_caps_realloc_prefer(buffer, size, 2, PSRAM_CAPS, INTERNAL_CAPS);
+}
+
+void policyFree(void* buffer) {
+  free(buffer);
+}
+
+size_t policyFreeSize(AllocPolicy policy) {
+  if (policy == AllocPolicy::BULK && psramAvailable) return heap_caps_get_free_size(PSRAM_CAPS);
+  return heap_caps_get_free_size(INTERNAL_CAPS);
+}
+
+//=====================================
+// JSON Allocator
+//=====================================
+
+/**
+ * ArduinoJson allocator over the BULK policy
+ */
+class BulkJsonAllocator : public ArduinoJson::Allocator {
+ public:
+  void* allocate(size_t size) override {
+    return policyMalloc(size, AllocPolicy::BULK);
+  }
+  void deallocate(void* buffer) override {
+    policyFree(buffer);
+  }
+  void* reallocate(void* buffer, size_t size) override {
+    return policyRealloc(buffer, size, AllocPolicy::BULK);
+  }
+};
+
+ArduinoJson::Allocator* bulkJsonAllocator() {
+  static BulkJsonAllocator allocator;
+  return &allocator;
+}
+
+//=====================================
+// Headroom Report
+//=====================================
+
+/**
+ * Headroom of the heaps with the given capabilities
+ */
+static RegionHeadroom regionHeadroom(uint32_t caps) {
+  RegionHeadroom region;
+  region.total = heap_caps_get_total_size(caps);
+  region.free = heap_caps_get_free_size(caps);
+  region.minFree = heap_caps_get_minimum_free_size(caps);
+  region.largestBlock = heap_caps_get_largest_free_block(caps);
+  return region;
+}
+
+RegionHeadroom internalHeadroom() {
+  return regionHeadroom(INTERNAL_CAPS);
+}
+
+RegionHeadroom psramHeadroom() {
+  if (!psramAvailable) return RegionHeadroom();
+  return regionHeadroom(PSRAM_CAPS);
+}
+
+PolicyStats getPolicyStats() {
+  PolicyStats stats;
+  stats.bulkPsram = bulkPsram;
+  stats.bulkInternal = bulkInternal;
+  stats.failed = failedAllocations;
+  return stats;
+}
+
+void logHeapHeadroom() {
+  RegionHeadroom internal = internalHeadroom();
+  LOG_DEBUG("Heap internal: free=%u/%u, min=%u, largest=%u",
+            (unsigned)internal.free, (unsigned)internal.total,
+            (unsigned)internal.minFree, (unsigned)internal.largestBlock);
+  if (psramAvailable) {
+    RegionHeadroom psram = psramHeadroom();
+    LOG_DEBUG("Heap PSRAM: free=%u/%u, min=%u, largest=%u",
+              (unsigned)psram.free, (unsigned)psram.total,
+              (unsigned)psram.minFree, (unsigned)psram.largestBlock);
+  }
+  PolicyStats stats = getPolicyStats();
+  LOG_DEBUG("Bulk buffers: %lu PSRAM, %lu internal, %lu failed",
+            (unsigned long)stats.bulkPsram, (unsigned long)stats.bulkInternal,
+            (unsigned long)stats.failed);
+}
+
+/**
+ * Add one region's headroom to a JSON object
+ */
+static void addRegionJson(JsonObject object, const RegionHeadroom& region) {
+  object["total"] = region.total;
+  object["free"] = region.free;
+  object["minFree"] = region.minFree;
+  object["largestBlock"] = region.largestBlock;
+  // Share of free memory unusable for one allocation of its size
+  object["fragmentation"] = region.free ? 1.0f - (float)region.largestBlock / region.free : 0;
+}
+
+String heapHeadroomJson() {
+  JsonDocument doc(bulkJsonAllocator());
+
+  addRegionJson(doc["internal"].to<JsonObject>(), internalHeadroom());
+  if (psramAvailable) {
+    addRegionJson(doc["psram"].to<JsonObject>(), psramHeadroom());
+  } else {
+    doc["psram"] = nullptr;
+  }
+
+  PolicyStats stats = getPolicyStats();
+  JsonObject bulk = doc["bulk"].to<JsonObject>();
+  bulk["psram"] = stats.bulkPsram;
+  bulk["internal"] = stats.bulkInternal;
+  doc["failed"] = stats.failed;
+  doc["internalLimit"] = MEMORY_INTERNAL_LIMIT;
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
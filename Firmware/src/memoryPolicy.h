@@ -0,0 +1,211 @@
+/*
+================================================================================
+  Memory Policy - Capability-Based Placement of Heap Buffers Header
+================================================================================
+
+  One place that decides which heap region a buffer comes from, so large
+  transient buffers stop fragmenting the internal SRAM that latency
+  critical code depends on.
+
+  Policies:
+    - FAST: latency-critical, touched every frame or every cast (spell
+      library, spell index, trajectory). Always internal SRAM
+    - BULK: large or cold (decoded images, JSON documents, media caches,
+      HTTP payloads). PSRAM when the board has it, otherwise internal
+
+  Placement:
+    - With PSRAM, initMemoryPolicy() also caps plain malloc() (and so
+      new, String and std::vector) at MEMORY_INTERNAL_LIMIT: smaller
+      requests always stay internal, so small hot objects never land in
+      PSRAM by accident
+    - Without PSRAM (this board's default), both policies are plain
+      malloc(): behaviour is unchanged, and TRACK_HEAP still sees every
+      allocation
+    - Anything allocated here is released with policyFree() (free() works
+      too - ESP-IDF frees any region)
+
+  Interfaces:
+    - policyMalloc/policyCalloc/policyRealloc/policyFree
+    - policyNewArray<T>() typed helper for plain-data arrays
+    - PolicyAllocator<T, P> for STL containers, with FastVector<T> and
+      BulkVector<T> shorthands
+    - bulkJsonAllocator() for JsonDocument (ArduinoJson v7)
+
+  Headroom Report:
+    - Total, free, lowest-ever free and largest block per region, plus
+      where BULK requests actually went; logged with CHECK_HEAP and
+      served as JSON at http://<device>/memory
+
+================================================================================
+*/
+
+#ifndef MEMORY_POLICY_H
+#define MEMORY_POLICY_H
+
+#include <Arduino.h>
+#include <new>
+#include <vector>
+
+//=====================================
+// Configuration
+//=====================================
+
+#define MEMORY_INTERNAL_LIMIT 4096      // With PSRAM, plain malloc() below this stays internal (bytes)
+
+//=====================================
+// Policy Types
+//=====================================
+
+/**
+ * Where a buffer should live
+ */
+enum class AllocPolicy : uint8_t {
+  FAST,     ///< Internal SRAM only (latency-critical)
+  BULK      ///< PSRAM if fitted, else internal (large or cold)
+};
+
+/**
+ * Headroom of one heap region
+ */
+struct RegionHeadroom {
+  size_t total;             // Region size (bytes, 0 if absent)
+  size_t free;              // Free now
+  size_t minFree;           // Lowest free since boot
+  size_t largestBlock;      // Largest single allocation possible now
+};
+
+/**
+ * Where BULK requests ended up since boot
+ */
+struct PolicyStats {
+  uint32_t bulkPsram;       // Placed in PSRAM
+  uint32_t bulkInternal;    // Placed internal (no PSRAM, or PSRAM full)
+  uint32_t failed;          // Returned nullptr (either policy)
+};
+
+//=====================================
+// Allocation Functions
+//=====================================
+
+/**
+ * Set up the policy
+ * Call at the start of setup(), right after initLogger() and before any
+ * large buffer is allocated.
+ */
+void initMemoryPolicy();
+
+/**
+ * Allocate by policy
+ * return Buffer, or nullptr if no region has room
+ */
+void* policyMalloc(size_t size, AllocPolicy policy);
+
+/**
+ * Allocate zeroed memory by policy
+ */
+void* policyCalloc(size_t count, size_t size, AllocPolicy policy);
+
+/**
+ * Resize a policy buffer, keeping to the same policy
+ * return Resized buffer, or nullptr (the original is left untouched)
+ */
+void* policyRealloc(void* buffer, size_t size, AllocPolicy policy);
+
+/**
+ * Free a policy buffer (nullptr is ignored)
+ */
+void policyFree(void* buffer);
+
+/**
+ * Free bytes in the region a policy allocates from
+ * For "is there room" checks before a large BULK allocation.
+ */
+size_t policyFreeSize(AllocPolicy policy);
+
+/**
+ * Zeroed array of plain-data elements by policy
+ * Release with policyFree(); no constructors or destructors run.
+ * return Array, or nullptr if no region has room
+ */
+template <typename T>
+T* policyNewArray(size_t count, AllocPolicy policy) {
+  return static_cast<T*>(policyCalloc(count, sizeof(T), policy));
+}
+
+//=====================================
+// STL Allocator
+//=====================================
+
+/**
+ * Standard allocator placing container storage by policy
+ * Running out of memory is handled as std::allocator does.
+ */
+template <typename T, AllocPolicy P>
+struct PolicyAllocator {
+  typedef T value_type;
+
+  PolicyAllocator() {}
+  template <typename U> PolicyAllocator(const PolicyAllocator<U, P>&) {}
+  template <typename U> struct rebind { typedef PolicyAllocator<U, P> other; };
+
+  T* allocate(size_t count) {
+    void* buffer = policyMalloc(count * sizeof(T), P);
+    if (buffer == nullptr) std::__throw_bad_alloc();
+    return static_cast<T*>(buffer);
+  }
+  void deallocate(T* buffer, size_t) { policyFree(buffer); }
+};
+
+template <typename T, typename U, AllocPolicy P>
+bool operator==(const PolicyAllocator<T, P>&, const PolicyAllocator<U, P>&) { return true; }
+template <typename T, typename U, AllocPolicy P>
+bool operator!=(const PolicyAllocator<T, P>&, const PolicyAllocator<U, P>&) { return false; }
+
+template <typename T> using FastVector = std::vector<T, PolicyAllocator<T, AllocPolicy::FAST>>;
+template <typename T> using BulkVector = std::vector<T, PolicyAllocator<T, AllocPolicy::BULK>>;
+
+//=====================================
+// JSON Allocator
+//=====================================
+
+// Host tool builds (Tools/tuner, Tools/match_bench) have no ArduinoJson
+#if __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>
+
+/**
+ * ArduinoJson allocator for BULK documents
+ * Usage: JsonDocument doc(bulkJsonAllocator());
+ */
+ArduinoJson::Allocator* bulkJsonAllocator();
+#endif
+
+//=====================================
+// Headroom Report
+//=====================================
+
+/**
+ * Headroom of internal SRAM (8-bit capable)
+ */
+RegionHeadroom internalHeadroom();
+
+/**
+ * Headroom of PSRAM (all zero without PSRAM)
+ */
+RegionHeadroom psramHeadroom();
+
+/**
+ * Where BULK requests went since boot
+ */
+PolicyStats getPolicyStats();
+
+/**
+ * Log headroom of both regions and the BULK placement counts
+ */
+void logHeapHeadroom();
+
+/**
+ * Headroom and placement counts as JSON (for the /memory endpoint)
+ */
+String heapHeadroomJson();
+
+#endif // MEMORY_POLICY_H
@@ -0,0 +1,281 @@
+/*
+================================================================================
+  Monitor Functions - FreeRTOS Task and Core Utilization Monitor
+================================================================================
+
+  Implements the MONITOR_TASKS runtime monitor declared in monitorFunctions.h.
+
+  Sampling Task:
+    - Wakes every TASK_MONITOR_SAMPLE_INTERVAL and calls uxTaskGetSystemState()
+    - Counts, per task, how many samples found it blocked/suspended and how
+      many found it ready but not running
+    - Every TASK_MONITOR_REPORT_INTERVAL converts run-time counter deltas
+      into CPU percentages, publishes a SystemReport and logs it
+
+  Requirements:
+    - configUSE_TRACE_FACILITY for uxTaskGetSystemState()
+    - configGENERATE_RUN_TIME_STATS for CPU percentages (reported as -1
+      when the framework was built without it)
+
+================================================================================
+*/
+
+#include "monitorFunctions.h"
+
+#ifdef MONITOR_TASKS
+
+#include "glyphReader.h"
+#include "memoryPolicy.h"
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#if !configUSE_TRACE_FACILITY
+#error "MONITOR_TASKS requires configUSE_TRACE_FACILITY"
+#endif
+
+//=====================================
+// Monitor State
+//=====================================
+
+/**
+ * Accumulators for one task over the current report window
+ * Tasks are matched across samples by handle.
+ */
+struct TaskAccumulator {
+  TaskHandle_t handle;
+  uint32_t runTimeAtWindowStart;
+  uint16_t samples;
+  uint16_t blockedSamples;
+  uint16_t readySamples;
+  bool seen;                    // Present in latest sample
+};
+
+static TaskAccumulator accumulators[TASK_MONITOR_MAX_TASKS];
+static TaskStatus_t taskStatus[TASK_MONITOR_MAX_TASKS];
+static uint32_t totalRunTimeAtWindowStart = 0;
+static uint32_t windowStartMs = 0;
+
+// Last completed report, guarded by reportMux
+static SystemReport latestReport;
+static bool reportAvailable = false;
+static portMUX_TYPE reportMux = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t monitorTaskHandle = NULL;
+
+//=====================================
+// Helpers
+//=====================================
+
+/**
+ * Find or create the accumulator for a task
+ * return Accumulator, or nullptr if the table is full
+ */
+static TaskAccumulator* accumulatorFor(TaskHandle_t handle, uint32_t runTime) {
+  TaskAccumulator* freeSlot = nullptr;
+  for (size_t i = 0; i < TASK_MONITOR_MAX_TASKS; i++) {
+    if (accumulators[i].handle == handle) return &accumulators[i];
+    if (accumulators[i].handle == NULL && freeSlot == nullptr) freeSlot = &accumulators[i];
+  }
+  if (freeSlot != nullptr) {
+    // New task - its window starts now
+    *freeSlot = {handle, runTime, 0, 0, 0, false};
+  }
+  return freeSlot;
+}
+
+/**
+ * Take one state sample of every task
+ * return Number of tasks in taskStatus[]
+ */
+static UBaseType_t sampleTaskStates(uint32_t* totalRunTime) {
+  UBaseType_t count = uxTaskGetSystemState(taskStatus, TASK_MONITOR_MAX_TASKS, totalRunTime);
+
+  for (size_t i = 0; i < TASK_MONITOR_MAX_TASKS; i++) {
+    accumulators[i].seen = false;
+  }
+
+  for (UBaseType_t i = 0; i < count; i++) {
+    const TaskStatus_t& status = taskStatus[i];
+    TaskAccumulator* acc = accumulatorFor(status.xHandle, status.ulRunTimeCounter);
+    if (acc == nullptr) continue;
+
+    acc->seen = true;
+    acc->samples++;
+    if (status.eCurrentState == eBlocked || status.eCurrentState == eSuspended) {
+      acc->blockedSamples++;
+    } else if (status.eCurrentState == eReady) {
+      acc->readySamples++;
+    }
+  }
+
+  // Release slots of deleted tasks
+  for (size_t i = 0; i < TASK_MONITOR_MAX_TASKS; i++) {
+    if (!accumulators[i].seen) accumulators[i].handle = NULL;
+  }
+  return count;
+}
+
+/**
+ * Close the current window: build a report from the latest sample
+ */
+static void buildReport(UBaseType_t count, uint32_t totalRunTime, uint32_t now) {
+  static SystemReport report;   // Too large for the monitor task stack
+  report.windowMs = now - windowStartMs;
+  report.taskCount = 0;
+  report.coreUtilization[0] = -1;
+  report.coreUtilization[1] = -1;
+
+  uint32_t totalDelta = totalRunTime - totalRunTimeAtWindowStart;
+
+  for (UBaseType_t i = 0; i < count && report.taskCount < TASK_MONITOR_MAX_TASKS; i++) {
+    const TaskStatus_t& status = taskStatus[i];
+    TaskAccumulator* acc = accumulatorFor(status.xHandle, status.ulRunTimeCounter);
+    if (acc == nullptr || acc->samples == 0) continue;
+
+    TaskReport& task = report.tasks[report.taskCount++];
+    strncpy(task.name, status.pcTaskName, sizeof(task.name) - 1);
+    task.name[sizeof(task.name) - 1] = '\0';
+#if configTASKLIST_INCLUDE_COREID
+    task.core = (status.xCoreID == tskNO_AFFINITY) ? -1 : (int8_t)status.xCoreID;
+#else
+    task.core = -1;
+#endif
+    task.priority = (uint8_t)status.uxCurrentPriority;
+    task.stackHighWater = status.usStackHighWaterMark;  // Bytes on ESP-IDF
+    task.blockedPercent = 100.0f * acc->blockedSamples / acc->samples;
+    task.readyPercent = 100.0f * acc->readySamples / acc->samples;
+
+#if configGENERATE_RUN_TIME_STATS
+    uint32_t taskDelta = status.ulRunTimeCounter - acc->runTimeAtWindowStart;
+    task.cpuPercent = totalDelta > 0 ? 100.0f * taskDelta / totalDelta : 0;
+
+    // Core utilization is the complement of each core's idle task
+    for (int core = 0; core < portNUM_PROCESSORS && core < 2; core++) {
+      if (status.xHandle == xTaskGetIdleTaskHandleForCPU(core)) {
+        report.coreUtilization[core] = constrain(100.0f - task.cpuPercent, 0.0f, 100.0f);
+      }
+    }
+#else
+    task.cpuPercent = -1;
+#endif
+
+    // Start the next window for this task
+    acc->runTimeAtWindowStart = status.ulRunTimeCounter;
+    acc->samples = 0;
+    acc->blockedSamples = 0;
+    acc->readySamples = 0;
+  }
+
+  totalRunTimeAtWindowStart = totalRunTime;
+  windowStartMs = now;
+
+  portENTER_CRITICAL(&reportMux);
+  latestReport = report;
+  reportAvailable = true;
+  portEXIT_CRITICAL(&reportMux);
+}
+
+/**
+ * Log a report through the logging macros
+ */
+static void logTaskReport(const SystemReport& report) {
+  LOG_ALWAYS("=== Task Monitor (%lus window) ===", (unsigned long)(report.windowMs / 1000));
+  LOG_ALWAYS("Core 0: %.1f%% busy, Core 1: %.1f%% busy",
+             report.coreUtilization[0], report.coreUtilization[1]);
+  LOG_ALWAYS("  %-15s core prio   cpu%%  stackFree blocked%% ready%%", "task");
+  for (uint8_t i = 0; i < report.taskCount; i++) {
+    const TaskReport& task = report.tasks[i];
+    LOG_ALWAYS("  %-15s %4d %4u %6.1f %10lu %8.1f %6.1f",
+               task.name, task.core, task.priority, task.cpuPercent,
+               (unsigned long)task.stackHighWater, task.blockedPercent, task.readyPercent);
+  }
+}
+
+//=====================================
+// Monitor Task
+//=====================================
+
+static void taskMonitorTask(void* parameter) {
+  TickType_t lastWake = xTaskGetTickCount();
+  uint32_t totalRunTime = 0;
+
+  // Prime the window so the first report covers a full interval
+  sampleTaskStates(&totalRunTimeAtWindowStart);
+  windowStartMs = millis();
+
+  while (true) {
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(TASK_MONITOR_SAMPLE_INTERVAL));
+
+    UBaseType_t count = sampleTaskStates(&totalRunTime);
+    uint32_t now = millis();
+
+    if (now - windowStartMs >= TASK_MONITOR_REPORT_INTERVAL) {
+      buildReport(count, totalRunTime, now);
+      logTaskReport(latestReport);
+    }
+  }
+}
+
+//=====================================
+// Public Interface
+//=====================================
+
+void initTaskMonitor() {
+  if (monitorTaskHandle != NULL) return;
+
+  xTaskCreate(
+    taskMonitorTask,
+    "TaskMonitor",
+    TASK_MONITOR_STACK_SIZE,
+    NULL,
+    TASK_MONITOR_PRIORITY,
+    &monitorTaskHandle
+  );
+  LOG_DEBUG("Task monitor started (sample %dms, report %ds)",
+            TASK_MONITOR_SAMPLE_INTERVAL, TASK_MONITOR_REPORT_INTERVAL / 1000);
+}
+
+bool getTaskReport(SystemReport& report) {
+  portENTER_CRITICAL(&reportMux);
+  bool available = reportAvailable;
+  if (available) report = latestReport;
+  portEXIT_CRITICAL(&reportMux);
+  return available;
+}
+
+String taskReportJson() {
+  // A copy per call: the API server and WiFiManager's server both serve
+  // this route, on different tasks. Too large for their stacks.
+  BulkVector<SystemReport> copy(1);
+  SystemReport& report = copy[0];
+  JsonDocument doc(bulkJsonAllocator());
+
+  if (!getTaskReport(report)) {
+    doc["error"] = "No report yet";
+  } else {
+    doc["windowMs"] = report.windowMs;
+    JsonArray cores = doc["coreUtilization"].to<JsonArray>();
+    cores.add(report.coreUtilization[0]);
+    cores.add(report.coreUtilization[1]);
+
+    JsonArray tasks = doc["tasks"].to<JsonArray>();
+    for (uint8_t i = 0; i < report.taskCount; i++) {
+      const TaskReport& task = report.tasks[i];
+      JsonObject entry = tasks.add<JsonObject>();
+      entry["name"] = task.name;
+      entry["core"] = task.core;
+      entry["priority"] = task.priority;
+      entry["cpu"] = task.cpuPercent;
+      entry["stackFree"] = task.stackHighWater;
+      entry["blocked"] = task.blockedPercent;
+      entry["ready"] = task.readyPercent;
+    }
+  }
+
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+
+#endif // MONITOR_TASKS
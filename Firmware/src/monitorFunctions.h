@@ -0,0 +1,102 @@
+/*
+================================================================================
+  Monitor Functions - FreeRTOS Task and Core Utilization Monitor Header
+================================================================================
+
+  Opt-in runtime monitor for sizing task stacks and balancing work between
+  the two ESP32-S3 cores. Enabled with the MONITOR_TASKS build flag (see
+  platformio.ini).
+
+  Collected Per Task:
+    - CPU percentage of its core (from FreeRTOS run-time stats)
+    - Core affinity and priority
+    - Stack high-water mark (minimum free stack ever, in bytes)
+    - Share of samples spent blocked, and ready-but-not-running
+
+  Collected Per Core:
+    - Utilization (100% minus the core's idle task share)
+
+  Sampling:
+    - A small high-priority task snapshots task states every
+      TASK_MONITOR_SAMPLE_INTERVAL; CPU shares are computed from run-time
+      counter deltas at each report
+    - The sampler preempts whatever runs on its core, so that task is seen
+      as "ready" for one sample; the sampler has no core affinity so the
+      bias spreads across both cores
+
+  Output:
+    - Serial: report logged every TASK_MONITOR_REPORT_INTERVAL
+    - Portal: JSON at http://<device>/tasks
+
+================================================================================
+*/
+
+#ifndef MONITOR_FUNCTIONS_H
+#define MONITOR_FUNCTIONS_H
+
+#include <Arduino.h>
+
+//=====================================
+// Configuration
+//=====================================
+
+#define TASK_MONITOR_MAX_TASKS 24            // Max tasks tracked
+#define TASK_MONITOR_SAMPLE_INTERVAL 50      // Milliseconds between state samples
+#define TASK_MONITOR_REPORT_INTERVAL 30000   // Milliseconds between reports
+#define TASK_MONITOR_STACK_SIZE 3072         // Monitor task stack (bytes)
+#define TASK_MONITOR_PRIORITY 5              // Above app tasks so it can observe them
+
+#ifdef MONITOR_TASKS
+
+//=====================================
+// Report Data Structures
+//=====================================
+
+/**
+ * Per-task statistics from the most recent report window
+ */
+struct TaskReport {
+  char name[16];              // Task name
+  int8_t core;                // Pinned core, or -1 for no affinity
+  uint8_t priority;           // Current priority
+  float cpuPercent;           // Share of one core over the window (-1 if unavailable)
+  uint32_t stackHighWater;    // Minimum free stack ever seen (bytes)
+  float blockedPercent;       // Share of samples in blocked/suspended state
+  float readyPercent;         // Share of samples ready but not running
+};
+
+/**
+ * Whole-system statistics from the most recent report window
+ */
+struct SystemReport {
+  uint32_t windowMs;          // Report window length
+  float coreUtilization[2];   // Per-core busy percentage (-1 if unavailable)
+  uint8_t taskCount;          // Valid entries in tasks[]
+  TaskReport tasks[TASK_MONITOR_MAX_TASKS];
+};
+
+//=====================================
+// Monitor Functions
+//=====================================
+
+/**
+ * Start the task monitor
+ * Creates the sampling task; call once at the end of setup() after all
+ * application tasks exist.
+ */
+void initTaskMonitor();
+
+/**
+ * Copy the most recent report
+ * return false if no report window has completed yet
+ */
+bool getTaskReport(SystemReport& report);
+
+/**
+ * Build the most recent report as a JSON string (served at /tasks)
+ */
+String taskReportJson();
+
+#endif // MONITOR_TASKS
+
+#endif // MONITOR_FUNCTIONS_H
@@ -0,0 +1,157 @@
+/*
+================================================================================
+  Motion Filter - Predictive Wand Tracking Implementation
+================================================================================
+
+  Implements the alpha-beta tracker declared in motionFilter.h.
+
+  Gate:
+    The acceptance radius grows with the time since the last accepted
+    measurement (gateBase + TRACKER_GATE_GROWTH * dt), since the longer the
+    wand has gone unobserved the less certain the prediction is.
+
+  Gap Fill:
+    When a measurement arrives more than 1.5 frame intervals after the last
+    accepted one (and no later than TRACKER_MAX_GAP_MS), predicted samples
+    are emitted at each missed frame time before the filtered point. Gaps
+    are only filled once IR returns, so a gesture that ends with IR loss
+    never gets an extrapolated tail.
+
+  Simplifier:
+    Operates directly on the trajectory vector so the newest sample is
+    always its last element (end-of-gesture handling needs no flush).
+    Replacing the trailing point keeps the newest timestamp for the newest
+    position, so path length and duration are unaffected by the decimation.
+
+================================================================================
+*/
+
+#include "motionFilter.h"
+#include "hotPath.h"
+#include <cmath>
+
+//=====================================
+// Tracker Implementation
+//=====================================
+
+void initTracker(WandTracker& tracker, int x, int y, uint32_t timestamp, float gateBase) {
+  tracker.x = x;
+  tracker.y = y;
+  tracker.vx = 0;
+  tracker.vy = 0;
+  tracker.lastUpdate = timestamp;
+  tracker.gateBase = gateBase;
+  tracker.rejectStreak = 0;
+}
+
+void HOT_CODE predictTracker(const WandTracker& tracker, uint32_t timestamp, float& px, float& py) {
+  float dt = (float)(timestamp - tracker.lastUpdate);
+  px = tracker.x + tracker.vx * dt;
+  py = tracker.y + tracker.vy * dt;
+}
+
+TrackResult HOT_CODE updateTracker(WandTracker& tracker, int x, int y, uint32_t timestamp,
+                          Point* out, uint8_t& outCount) {
+  outCount = 0;
+  uint32_t dtMs = timestamp - tracker.lastUpdate;
+  if (dtMs == 0) dtMs = 1;  // Same-millisecond frames: avoid division by zero
+  float dt = (float)dtMs;
+
+  //-----------------------------------
+  // Predict and gate
+  //-----------------------------------
+  float px, py;
+  predictTracker(tracker, timestamp, px, py);
+  float rx = x - px;
+  float ry = y - py;
+  float gate = tracker.gateBase + TRACKER_GATE_GROWTH * dt;
+
+  if (rx * rx + ry * ry > gate * gate) {
+    if (++tracker.rejectStreak < TRACKER_MAX_REJECTS) {
+      return TRACK_REJECTED;
+    }
+    // Consistently off-prediction: trust the measurements again
+    initTracker(tracker, x, y, timestamp, tracker.gateBase);
+    out[outCount++] = {x, y, timestamp};
+    return TRACK_REACQUIRED;
+  }
+  tracker.rejectStreak = 0;
+
+  //-----------------------------------
+  // Bridge short dropouts
+  //-----------------------------------
+  if (dtMs * 2 > TRACKER_FRAME_INTERVAL * 3 && dtMs <= TRACKER_MAX_GAP_MS) {
+    for (uint32_t t = tracker.lastUpdate + TRACKER_FRAME_INTERVAL;
+         t + TRACKER_FRAME_INTERVAL / 2 < timestamp && outCount < TRACKER_MAX_OUTPUT_POINTS - 1;
+         t += TRACKER_FRAME_INTERVAL) {
+      float fx, fy;
+      predictTracker(tracker, t, fx, fy);
+      out[outCount++] = {(int)lroundf(fx), (int)lroundf(fy), t};
+    }
+  }
+
+  //-----------------------------------
+  // Correct
+  //-----------------------------------
+  tracker.x = px + TRACKER_ALPHA * rx;
+  tracker.y = py + TRACKER_ALPHA * ry;
+  tracker.vx = constrain(tracker.vx + (TRACKER_BETA / dt) * rx, -TRACKER_MAX_VELOCITY, TRACKER_MAX_VELOCITY);
+  tracker.vy = constrain(tracker.vy + (TRACKER_BETA / dt) * ry, -TRACKER_MAX_VELOCITY, TRACKER_MAX_VELOCITY);
+  tracker.lastUpdate = timestamp;
+
+  out[outCount++] = {(int)lroundf(tracker.x), (int)lroundf(tracker.y), timestamp};
+  return TRACK_ACCEPTED;
+}
+
+//=====================================
+// Simplifier Implementation
+//=====================================
+
+void initSimplifier(PathSimplifier& simplifier) {
+  simplifier.dirX = 0;
+  simplifier.dirY = 0;
+  simplifier.lastProjection = 0;
+  simplifier.hasDirection = false;
+  simplifier.rawCount = 0;
+}
+
+bool HOT_CODE appendSimplified(PathSimplifier& simplifier, std::vector<Point>& path, const Point& p) {
+  simplifier.rawCount++;
+  if (path.empty()) {
+    path.push_back(p);
+    return true;
+  }
+
+  // Duplicate suppression: ignore samples that barely moved
+  const Point& tail = path.back();
+  float tx = p.x - tail.x;
+  float ty = p.y - tail.y;
+  float tailDist = sqrtf(tx * tx + ty * ty);
+  if (tailDist < SIMPLIFY_MIN_DISTANCE) {
+    return false;
+  }
+
+  if (simplifier.hasDirection && path.size() >= 2) {
+    // Position relative to the strip anchored at the second-last point
+    const Point& anchor = path[path.size() - 2];
+    float ax = p.x - anchor.x;
+    float ay = p.y - anchor.y;
+    float along = ax * simplifier.dirX + ay * simplifier.dirY;
+    float across = fabsf(ax * simplifier.dirY - ay * simplifier.dirX);
+
+    if (across <= SIMPLIFY_TOLERANCE && along > simplifier.lastProjection) {
+      // Still inside the strip and moving forward: slide the trailing point
+      path.back() = p;
+      simplifier.lastProjection = along;
+      return false;
+    }
+  }
+
+  // Leaving the strip: the trailing point becomes the new anchor
+  simplifier.dirX = tx / tailDist;
+  simplifier.dirY = ty / tailDist;
+  simplifier.lastProjection = tailDist;
+  simplifier.hasDirection = true;
+  path.push_back(p);
+  return true;
+}
@@ -0,0 +1,158 @@
+/*
+================================================================================
+  Motion Filter - Predictive Wand Tracking Header
+================================================================================
+
+  Filters applied to raw IR camera positions while a gesture is recorded.
+
+  Alpha-Beta Tracker (constant-velocity model):
+    - Predicts the wand position from the last estimate and velocity
+    - Gates each measurement against the prediction: a fast flick that
+      follows the predicted path is accepted even if it jumps far from the
+      last point, while a spurious blob off the path is rejected
+    - Re-acquires on the measurement after TRACKER_MAX_REJECTS consecutive
+      rejections, so a single bad blob can't lock tracking out for good
+    - Bridges short IR dropouts (up to TRACKER_MAX_GAP_MS) by inserting
+      predicted samples at the missed frame times once IR returns
+    - Outputs smoothed positions instead of raw measurements
+
+  Filter Equations (dt in milliseconds, velocity in pixels/ms):
+    predicted = position + velocity * dt
+    residual  = measurement - predicted
+    position  = predicted + ALPHA * residual
+    velocity  = velocity + (BETA / dt) * residual
+
+  Path Simplifier (Reumann-Witkam, streaming):
+    - Drops samples closer than SIMPLIFY_MIN_DISTANCE to the previous one,
+      so a paused or slow wand stops flooding the trajectory
+    - Each new segment starts a "strip" along the direction from its anchor
+      to the first sample after it; later samples that stay within
+      SIMPLIFY_TOLERANCE of that line and keep moving forward along it just
+      replace the trailing point instead of being appended
+    - A sample outside the strip (or one that turns back along it) commits
+      the trailing point as the next anchor
+    - Kept points retain their original timestamps, so pauses still show
+      up as gaps between consecutive points
+
+================================================================================
+*/
+
+#ifndef MOTION_FILTER_H
+#define MOTION_FILTER_H
+
+#include <Arduino.h>
+#include "spell_patterns.h"
+#include <vector>
+
+//=====================================
+// Tracker Configuration
+//=====================================
+
+#define TRACKER_ALPHA 0.6f          // Position correction gain (0-1, higher = less smoothing)
+#define TRACKER_BETA 0.2f           // Velocity correction gain (0-1)
+#define TRACKER_GATE_GROWTH 0.5f    // Gate radius growth (pixels per ms since last update)
+#define TRACKER_MAX_VELOCITY 5.0f   // Velocity clamp (pixels per ms)
+#define TRACKER_MAX_REJECTS 3       // Consecutive rejections before re-acquiring
+#define TRACKER_MAX_GAP_MS 80       // Longest dropout bridged with predicted samples
+#define TRACKER_FRAME_INTERVAL 10   // Expected frame spacing while tracking (ms)
+
+/// Max points one tracker update can emit (gap fill + measurement)
+#define TRACKER_MAX_OUTPUT_POINTS (TRACKER_MAX_GAP_MS / TRACKER_FRAME_INTERVAL + 1)
+
+//=====================================
+// Simplifier Configuration
+//=====================================
+
+#define SIMPLIFY_MIN_DISTANCE 3.0f  // Samples closer than this to the last point are dropped (pixels)
+#define SIMPLIFY_TOLERANCE 4.0f     // Max deviation of dropped samples from the kept path (pixels)
+
+//=====================================
+// Tracker State
+//=====================================
+
+/**
+ * Alpha-beta tracker state for one wand
+ */
+struct WandTracker {
+  float x, y;               // Filtered position (camera pixels)
+  float vx, vy;             // Estimated velocity (pixels per ms)
+  uint32_t lastUpdate;      // Timestamp of last accepted measurement
+  float gateBase;           // Gate radius at dt = 0 (pixels)
+  uint8_t rejectStreak;     // Consecutive rejected measurements
+};
+
+/**
+ * Result of feeding one measurement to the tracker
+ */
+enum TrackResult {
+  TRACK_ACCEPTED,     ///< Measurement inside gate, filtered point emitted
+  TRACK_REJECTED,     ///< Measurement outside gate, nothing emitted
+  TRACK_REACQUIRED    ///< Too many rejections, tracker reset to measurement
+};
+
+/**
+ * Streaming simplifier state for one trajectory
+ * The trajectory's last point is the trailing (uncommitted) point; the one
+ * before it is the anchor of the current strip.
+ */
+struct PathSimplifier {
+  float dirX, dirY;         // Unit direction of the current strip
+  float lastProjection;     // Trailing point's distance along the strip
+  bool hasDirection;        // Strip direction established
+  uint32_t rawCount;        // Samples offered, including dropped ones
+};
+
+//=====================================
+// Tracker Functions
+//=====================================
+
+/**
+ * Reset tracker to a known position with zero velocity
+ * tracker: Tracker to reset
+ * x, y: Starting position (camera pixels)
+ * timestamp: Time of the starting position (ms)
+ * gateBase: Gate radius in pixels for back-to-back frames
+ */
+void initTracker(WandTracker& tracker, int x, int y, uint32_t timestamp, float gateBase);
+
+/**
+ * Predict tracker position at a given time (constant velocity)
+ * timestamp: Time to predict for (ms, >= lastUpdate)
+ * px, py: Output predicted position
+ */
+void predictTracker(const WandTracker& tracker, uint32_t timestamp, float& px, float& py);
+
+/**
+ * Feed one measurement to the tracker
+ * Emits any gap-fill samples followed by the filtered point.
+ * tracker: Tracker state (updated)
+ * x, y: Measured position (camera pixels)
+ * timestamp: Measurement time (ms)
+ * out: Output buffer of at least TRACKER_MAX_OUTPUT_POINTS points
+ * outCount: Number of points written to out
+ * return Result of the gate check
+ */
+TrackResult updateTracker(WandTracker& tracker, int x, int y, uint32_t timestamp,
+                          Point* out, uint8_t& outCount);
+
+//=====================================
+// Simplifier Functions
+//=====================================
+
+/**
+ * Reset simplifier for a new trajectory
+ * Call whenever the trajectory it feeds is cleared.
+ */
+void initSimplifier(PathSimplifier& simplifier);
+
+/**
+ * Offer one sample to a trajectory through the simplifier
+ * The sample is dropped, replaces the trailing point, or is appended.
+ * simplifier: Simplifier state (updated)
+ * path: Trajectory being built
+ * p: New sample
+ * return true if path grew by one point
+ */
+bool appendSimplified(PathSimplifier& simplifier, std::vector<Point>& path, const Point& p);
+
+#endif // MOTION_FILTER_H
@@ -23,8 +23,11 @@
  *   String host = MQTT_HOST;  // Access cached global variable
  */
 
+#define LOG_MODULE LogModule::STORAGE
+
 #include "glyphReader.h"
 #include "preferenceFunctions.h"
+#include "spellActions.h"
 
 // Preferences instance
 Preferences preferences;
@@ -42,6 +45,8 @@ int READY_STILLNESS_TIME;
 int END_STILLNESS_TIME;
 int GESTURE_TIMEOUT;
 int IR_LOSS_TIMEOUT;
+bool SPOTTING_ENABLED;
+bool CHAIN_MATCHING;
 String NIGHTLIGHT_ON_SPELL;
 String NIGHTLIGHT_OFF_SPELL;
 String NIGHTLIGHT_RAISE_SPELL;
@@ -52,6 +57,7 @@ String LONGITUDE;
 int TIMEZONE_OFFSET;
 bool SOUND_ENABLED;
 int SPELL_PRIMARY_COLOR_INDEX;
+int WIFI_AP_CHANNEL;
 
 // Define preference specifications
 static const PrefSpec PREF_SPECS[] = {
@@ -232,13 +238,19 @@ void loadPreferences() {
     MQTT_TOPIC = getPrefString(PrefKey::MQTT_TOPIC, ""); // Empty by default - user must configure
     
     // Motion Detection Thresholds
-    MOVEMENT_THRESHOLD = getPrefInt(PrefKey::MOVEMENT_THRESHOLD, 15);  // Pixels to start tracking
-    STILLNESS_THRESHOLD = getPrefInt(PrefKey::STILLNESS_THRESHOLD, 20);  // Max pixels still "still"
+    MOVEMENT_THRESHOLD = getPrefInt(PrefKey::MOVEMENT_THRESHOLD, DEFAULT_MOVEMENT_THRESHOLD);  // Pixels to start tracking
+    STILLNESS_THRESHOLD = getPrefInt(PrefKey::STILLNESS_THRESHOLD, DEFAULT_STILLNESS_THRESHOLD);  // Max pixels still "still"
     
     // Timing Parameters (milliseconds)
-    READY_STILLNESS_TIME = getPrefInt(PrefKey::READY_STILLNESS_TIME, 600);  // Enter READY state
-    GESTURE_TIMEOUT = getPrefInt(PrefKey::GESTURE_TIMEOUT, 5000);  // Max gesture duration
-    IR_LOSS_TIMEOUT = getPrefInt(PrefKey::IR_LOSS_TIMEOUT, 300);  // Max IR loss time
+    READY_STILLNESS_TIME = getPrefInt(PrefKey::READY_STILLNESS_TIME, DEFAULT_READY_STILLNESS_TIME);  // Enter READY state
+    GESTURE_TIMEOUT = getPrefInt(PrefKey::GESTURE_TIMEOUT, DEFAULT_GESTURE_TIMEOUT);  // Max gesture duration
+    IR_LOSS_TIMEOUT = getPrefInt(PrefKey::IR_LOSS_TIMEOUT, DEFAULT_IR_LOSS_TIMEOUT);  // Max IR loss time
+    
+    // Continuous spotting (default off - classic hold-still-then-cast flow)
+    SPOTTING_ENABLED = getPrefBool(PrefKey::SPOTTING_ENABLED, false);
+    
+    // Lightweight chain-code matching (default off - point/direction matcher)
+    CHAIN_MATCHING = getPrefBool(PrefKey::CHAIN_MATCHING, false);
     
     // Nightlight Control Spells
     NIGHTLIGHT_ON_SPELL = getPrefString(PrefKey::NIGHTLIGHT_ON_SPELL, "");  // No default spell
@@ -246,6 +258,7 @@ void loadPreferences() {
     NIGHTLIGHT_RAISE_SPELL = getPrefString(PrefKey::NIGHTLIGHT_RAISE_SPELL, "Raise");  // Default "Raise"
     NIGHTLIGHT_LOWER_SPELL = getPrefString(PrefKey::NIGHTLIGHT_LOWER_SPELL, "Lower");  // Default "Lower"
     NIGHTLIGHT_BRIGHTNESS = getPrefInt(PrefKey::NIGHTLIGHT_BRIGHTNESS, 150);  // Default medium brightness
+    invalidateSpellActions();  // Nightlight roles are compiled from the spells above
     
     // Location settings (empty = not configured, will fetch from ipapi.co on boot)
     LATITUDE = getPrefString(PrefKey::LATITUDE, "");
@@ -257,4 +270,7 @@ void loadPreferences() {
 
     // Spell color preference (index into predefined palette)
     SPELL_PRIMARY_COLOR_INDEX = getPrefInt(PrefKey::SPELL_PRIMARY_COLOR_INDEX, 0);
+
+    // Setup AP channel cached from the last background scan (0 = scan before first AP)
+    WIFI_AP_CHANNEL = getPrefInt(PrefKey::WIFI_AP_CHANNEL, 0);
 }
\ No newline at end of file
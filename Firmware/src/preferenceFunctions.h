@@ -78,6 +78,35 @@ enum class PrefType {
     PREF_X(LONGITUDE,            STRING, "longitude")    \
     PREF_X(TIMEZONE_OFFSET,      INT,    "tzOffset")    \
     PREF_X(SOUND_ENABLED,        BOOL,   "soundEn")     \
+    PREF_X(SPOTTING_ENABLED,     BOOL,   "spotEn")      \
+    PREF_X(CHAIN_MATCHING,       BOOL,   "chainMt")     \
+    PREF_X(WIFI_AP_CHANNEL,      INT,    "apChannel")   \
+
+//=====================================
+// Gesture Tuning Defaults
+//=====================================
+
+/**
+ * Defaults for the gesture tuning preferences
+ * Used until a value is saved from the portal. Overridable with -D build
+ * flags (Tools/tuner emits these), so a tuned build applies them to any
+ * device without saved tuning values.
+ */
+#ifndef DEFAULT_MOVEMENT_THRESHOLD
+#define DEFAULT_MOVEMENT_THRESHOLD 15       ///< Pixels to start tracking
+#endif
+#ifndef DEFAULT_STILLNESS_THRESHOLD
+#define DEFAULT_STILLNESS_THRESHOLD 20      ///< Max pixels still "still"
+#endif
+#ifndef DEFAULT_READY_STILLNESS_TIME
+#define DEFAULT_READY_STILLNESS_TIME 600    ///< Milliseconds to enter READY
+#endif
+#ifndef DEFAULT_GESTURE_TIMEOUT
+#define DEFAULT_GESTURE_TIMEOUT 5000        ///< Max gesture duration (ms)
+#endif
+#ifndef DEFAULT_IR_LOSS_TIMEOUT
+#define DEFAULT_IR_LOSS_TIMEOUT 300         ///< Max IR loss time (ms)
+#endif
 
 //=====================================
 // Preference Key Enumeration
@@ -171,6 +200,8 @@ extern int READY_STILLNESS_TIME;  ///< Milliseconds of stillness for ready state
 extern int END_STILLNESS_TIME;    ///< Milliseconds of stillness to end gesture (default 500)
 extern int GESTURE_TIMEOUT;       ///< Maximum milliseconds for gesture (default 5000)
 extern int IR_LOSS_TIMEOUT;       ///< Milliseconds before IR loss confirmed (default 200)
+extern bool SPOTTING_ENABLED;     ///< Continuous spotting instead of READY pause (default false)
+extern bool CHAIN_MATCHING;       ///< Chain-code edit distance instead of point matching (default false)
 
 // Nightlight Configuration
 extern String NIGHTLIGHT_ON_SPELL;    ///< Spell name to activate nightlight (e.g., "Illuminate")
@@ -188,4 +219,7 @@ extern int TIMEZONE_OFFSET;       ///< Timezone offset from UTC in seconds (e.g.
 // Sound Configuration
 extern bool SOUND_ENABLED;        ///< Enable/disable sound effects (default false)
 
+// WiFi Configuration
+extern int WIFI_AP_CHANNEL;       ///< Setup AP channel from the last scan (0 = never scanned)
+
 #endif // PREFERNCE_FUNCTIONS_H
@@ -27,11 +27,18 @@
  * - Falls back to text display if image load fails
  */
 
+#define LOG_MODULE LogModule::FEEDBACK
+
 #include "screenFunctions.h"
 #include "glyphReader.h"
 #include "sdFunctions.h"
 #include "spell_patterns.h"
 #include "spell_matching.h"
+#include "heapFunctions.h"
+#include "memoryPolicy.h"
+#include "mediaPrefetch.h"
+#include "mediaBundle.h"
+#include "spellAnimation.h"
 #include <Fonts/FreeSansBold18pt7b.h>
 #include <Fonts/FreeSansBold24pt7b.h>
 #include <Fonts/FreeSansBold12pt7b.h>
@@ -505,6 +512,7 @@ void showReadyBackground() {
   const int innerR = outerR - borderThickness;
 
   // Start with black background so we never show a full green fill
+  stopSpellAnimation();
   tft.fillScreen(BLACK);
 
   // Draw concentric outlines to form a solid-looking ring without filling
@@ -524,6 +532,9 @@ void showReadyBackground() {
  * spellName: Null-terminated string containing spell name (e.g., "Illuminate")
  * Shows spell on display when match is found. Tries to load BMP image from SD
  * card first, falls back to centered text if no image or load fails.
+ * ANIMATION MODE:
+ * - Plays the spell's .anim file (getSpellAnimationFilename()) in place
+ *   of the image when it has one; frames are drawn by loop()
  * IMAGE MODE:
  * - Checks hasSpellImage() to see if spell has associated BMP file
  * - Gets filename from getSpellImageFilename() (custom or default naming)
@@ -541,31 +552,71 @@ void showReadyBackground() {
  * - Display cleared after timeout (handled in main loop)
  */
 void displaySpellName(const char* spellName) {
+  // Check if there's a BMP image for this spell on SD card
+  String filename = hasSpellImage(spellName) ? getSpellImageFilename(spellName) : String();
+  String animation = getSpellAnimationFilename(spellName);
+  displaySpellName(spellName, filename.length() > 0 ? filename.c_str() : nullptr,
+                   animation.length() > 0 ? animation.c_str() : nullptr);
+}
+
+/**
+ * Display recognized spell with a pre-resolved image
+ * Body of displaySpellName(); imageFile/animationFile are nullptr when
+ * the spell has none.
+ */
+void displaySpellName(const char* spellName, const char* imageFile, const char* animationFile) {
+  HEAP_SCOPE(HeapTag::DISPLAY);
+  stopSpellAnimation();
+  
+  // Animation replaces the still image; later frames are drawn from loop()
+  if (animationFile != nullptr) {
+    if (randomColorMode) {
+      setSpellImageColors(pickSpellImagePrimaryColor(), spellAccentColorRGB565);
+    }
+    tft.fillScreen(0x0000);
+    if (startSpellAnimation(animationFile)) {
+      screenSpellOnTime = millis();
+      screenOnTime = millis();
+      return;
+    }
+    LOG_ALWAYS("Failed to play animation, falling back to image");
+  }
+  
+#ifdef PREFETCH_MEDIA
+  // Decoded while the gesture was drawn - only needs writing out. In
+  // Random mode the prefetcher already picked this display's color.
+  if (imageFile != nullptr) {
+    SpellImage image;
+    if (takePrefetchedImage(imageFile, randomColorMode, spellPrimaryColorRGB565, spellAccentColorRGB565, image)) {
+      LOG_DEBUG("Displaying prefetched image for spell: %s", imageFile);
+      drawSpellImage(image, 0, 0);
+      freeSpellImage(image);
+      screenSpellOnTime = millis();
+      screenOnTime = millis();
+      return;
+    }
+  }
+#endif
+  
   // Clear screen to black
   tft.fillScreen(0x0000);
   
-  // Check if there's a BMP image for this spell on SD card
-  if (hasSpellImage(spellName)) {
-    // Get the appropriate filename (custom or default naming convention)
-    String filename = getSpellImageFilename(spellName);
-    
-    Serial.printf("Displaying image for spell: %s\n", filename.c_str());
+  if (imageFile != nullptr) {
+    LOG_DEBUG("Displaying image for spell: %s", imageFile);
     
     // Try to display the image centered on screen (0, 0 for 240x240 image)
     // If user preference is Random, pick a random predefined color for this display
     if (randomColorMode) {
-      ensurePredefinedColorsInit();
-      int r = (int)(esp_random() % PREDEFINED_COLOR_COUNT);
-      setSpellImageColors(predefinedRGB565[r], spellAccentColorRGB565);
+      setSpellImageColors(pickSpellImagePrimaryColor(), spellAccentColorRGB565);
     }
-    if (displayImageFromSD(filename.c_str(), 0, 0)) {
+    if (displayImageFromSD(imageFile, 0, 0)) {
       // Image displayed successfully - set timeouts and return
       screenSpellOnTime = millis();
       screenOnTime = millis();
       return;
     } else {
       // Image failed to load, fall through to text display
-      Serial.println("Failed to load image, falling back to text");
+      LOG_ALWAYS("Failed to load image, falling back to text");
       tft.fillScreen(0x0000);  // Clear any partial image artifacts
     }
   }
@@ -638,6 +689,7 @@ void displaySpellName(const char* spellName) {
  * - User manually clears display
  */
 void clearDisplay() {
+  stopSpellAnimation();
   tft.fillScreen(0x0000);  // Fill entire display with black
   tft.drawCircle(120, 120, 119, 0x4208);  // Redraw dark gray border circle
   lastIRX = -1;  // Reset IR trail tracking
@@ -650,6 +702,7 @@ void clearDisplay() {
  * Also clears screen to black to prevent burn-in.
  */
 void backlightOff() {
+    stopSpellAnimation();
     // Clear screen to black to prevent burn-in while backlight is off
     tft.fillScreen(0x0000);  // Black
     
@@ -687,20 +740,38 @@ void backlightOn() {
 void setSpellImageColors(uint16_t primaryColorRGB565, uint16_t accentColorRGB565) {
   spellPrimaryColorRGB565 = primaryColorRGB565;
   spellAccentColorRGB565 = accentColorRGB565;
+  buildSpellImageLUT(spellPrimaryColorRGB565, primaryLUT);
+  primaryLUTInitialized = true;
+}
 
+/**
+ * Build a grayscale-to-tint lookup table for a primary color
+ * Used for the display's own LUT and for images decoded ahead of time.
+ */
+void buildSpellImageLUT(uint16_t primaryColorRGB565, uint16_t lut[256]) {
   // Reconstruct approximate 8-bit RGB components from RGB565 primary color
-  uint8_t p_r = (uint8_t)(((spellPrimaryColorRGB565 >> 11) & 0x1F) << 3);
-  uint8_t p_g = (uint8_t)(((spellPrimaryColorRGB565 >> 5) & 0x3F) << 2);
-  uint8_t p_b = (uint8_t)((spellPrimaryColorRGB565 & 0x1F) << 3);
+  uint8_t p_r = (uint8_t)(((primaryColorRGB565 >> 11) & 0x1F) << 3);
+  uint8_t p_g = (uint8_t)(((primaryColorRGB565 >> 5) & 0x3F) << 2);
+  uint8_t p_b = (uint8_t)((primaryColorRGB565 & 0x1F) << 3);
 
   // Build LUT: map grayscale intensity to tinted color scaled by intensity
   for (int i = 0; i < 256; i++) {
     uint8_t r = (uint8_t)((p_r * i + 127) / 255);
     uint8_t g = (uint8_t)((p_g * i + 127) / 255);
     uint8_t b = (uint8_t)((p_b * i + 127) / 255);
-    primaryLUT[i] = packRGB565(r, g, b);
+    lut[i] = packRGB565(r, g, b);
   }
-  primaryLUTInitialized = true;
+}
+
+/**
+ * Primary color for the next spell image
+ * A random palette color in Random mode, otherwise the selected color.
+ */
+uint16_t pickSpellImagePrimaryColor() {
+  if (!randomColorMode) return spellPrimaryColorRGB565;
+  ensurePredefinedColorsInit();
+  int r = (int)(esp_random() % PREDEFINED_COLOR_COUNT);
+  return predefinedRGB565[r];
 }
 
 uint16_t getSpellPrimaryColor() {
@@ -711,6 +782,143 @@ uint16_t getSpellAccentColor() {
   return spellAccentColorRGB565;
 }
 
+/**
+ * Convert one spell image pixel to RGB565
+ * If the artist used one of the placeholder colors (magenta for primary,
+ * lime for accent), substitute the user-selected RGB565 color to allow
+ * runtime recoloring.
+ */
+static uint16_t tintSpellPixel(uint8_t r, uint8_t g, uint8_t b,
+                               const uint16_t primaryLUT[256], uint16_t accentColor) {
+  // Preserve pure black background
+  if (r == 0 && g == 0 && b == 0) {
+    return 0x0000;
+  }
+
+  // Accent placeholder (lime: R=0,G=255,B=0) -> flat accent color
+  if (r == PLACEHOLDER_ACCENT_R && g == PLACEHOLDER_ACCENT_G && b == PLACEHOLDER_ACCENT_B) {
+    return accentColor;
+  }
+
+  // If pixel is pure grayscale (R==G==B), tint using LUT (very fast)
+  if (r == g && g == b) {
+    return primaryLUT[r];
+  }
+
+  // For any other colored pixel, fall back to direct packing
+  return packRGB565(r, g, b);
+}
+
+/**
+ * Convert one BMP row from BGR888 to RGB565
+ */
+static void convertBMPRow(const uint8_t* bgr, uint16_t* out, uint16_t width,
+                          const uint16_t primaryLUT[256], uint16_t accentColor) {
+  for (int col = 0; col < width; col++) {
+    // BMP stores blue, green, red
+    out[col] = tintSpellPixel(bgr[col * 3 + 2], bgr[col * 3 + 1], bgr[col * 3], primaryLUT, accentColor);
+  }
+}
+
+/**
+ * Tint an animation palette like spell image pixels
+ * Uses the current spell image colors.
+ */
+void buildSpellPaletteLUT(const uint8_t* rgb, uint16_t count, uint16_t* lut) {
+  if (!primaryLUTInitialized) {
+    setSpellImageColors(spellPrimaryColorRGB565, spellAccentColorRGB565);
+  }
+  for (uint16_t i = 0; i < count; i++) {
+    lut[i] = tintSpellPixel(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2], primaryLUT, spellAccentColorRGB565);
+  }
+}
+
+/**
+ * Make sure the backlight is on before writing an image
+ * Rules out transient toggles during the write.
+ */
+static void prepareImageWrite(uint16_t width, uint16_t height) {
+  LOG_DEBUG("About to write %dx%d image to display (backlightStateOn=%d)", width, height, backlightStateOn);
+  if (!backlightStateOn) {
+    LOG_DEBUG("Forcing backlight on for image write");
+    backlightOn();
+    delay(10);
+  }
+}
+
+#ifdef MEDIA_PARTITION
+/**
+ * Find a built-in BMP in the media bundle
+ * Used when the SD card has no file at the path (a card file overrides
+ * the built-in one). Same format checks as readBMPHeader().
+ * pixels: Output, bottom row of pixel data in mapped flash
+ * rowSize: Output, padded row stride in bytes
+ * return true if the bundle has a drawable BMP at the path
+ */
+static bool findMappedBMP(const char* filename, uint16_t& width, uint16_t& height,
+                          uint16_t& rowSize, const uint8_t*& pixels) {
+  MediaAsset asset;
+  if (fileExists(filename) || !findMediaAsset(filename, asset)) {
+    return false;
+  }
+  if (asset.size < 54 || asset.data[0] != 'B' || asset.data[1] != 'M') {
+    LOG_DEBUG("Built-in image is not a valid BMP: %s", filename);
+    return false;
+  }
+  
+  uint32_t dataOffset, bmpWidth, bmpHeight, compression;
+  uint16_t bitDepth;
+  memcpy(&dataOffset, asset.data + 10, 4);
+  memcpy(&bmpWidth, asset.data + 18, 4);
+  memcpy(&bmpHeight, asset.data + 22, 4);
+  memcpy(&bitDepth, asset.data + 28, 2);
+  memcpy(&compression, asset.data + 30, 4);
+  if (bitDepth != 24 || compression != 0) {
+    LOG_ALWAYS("Only 24-bit uncompressed BMPs are supported");
+    return false;
+  }
+  
+  width = bmpWidth;
+  height = bmpHeight;
+  rowSize = ((width * 3) + 3) & ~3;
+  if (dataOffset > asset.size || (uint32_t)rowSize * height > asset.size - dataOffset) {
+    LOG_ALWAYS("Built-in image is truncated: %s", filename);
+    return false;
+  }
+  pixels = asset.data + dataOffset;
+  LOG_DEBUG("Built-in image: %s (%dx%d)", filename, width, height);
+  return true;
+}
+
+/**
+ * Write a built-in BMP to the display straight from mapped flash
+ * Only one converted row is held in heap. BMP rows are stored
+ * bottom-to-top, so they are read in reverse for the display.
+ */
+static bool drawMappedBMP(const uint8_t* pixels, uint16_t width, uint16_t height, uint16_t rowSize,
+                          int16_t x, int16_t y) {
+  uint16_t* line = (uint16_t*)malloc(width * sizeof(uint16_t));
+  if (line == NULL) {
+    LOG_DEBUG("Failed to allocate row buffer");
+    return false;
+  }
+  
+  prepareImageWrite(width, height);
+  tft.startWrite();  // Begin SPI transaction for bulk write
+  tft.setAddrWindow(x, y, width, height);  // Set drawing window
+  
+  for (int row = height - 1; row >= 0; row--) {  // Reverse row order
+    convertBMPRow(pixels + (uint32_t)row * rowSize, line, width, primaryLUT, spellAccentColorRGB565);
+    tft.writePixels(line, width);
+  }
+  
+  tft.endWrite();  // End SPI transaction
+  free(line);
+  delay(20);
+  return true;
+}
+#endif
+
 /**
  * Load and display BMP image from SD card
  * filename: Path to BMP file on SD card (e.g., "/lumos.bmp")
@@ -750,76 +958,106 @@ uint16_t getSpellAccentColor() {
  * Called from displaySpellName() when spell has associated image file.
  */
 bool displayImageFromSD(const char* filename, int16_t x, int16_t y) {
-  LOG_DEBUG("Loading image from SD: %s", filename);
+  HEAP_SCOPE(HeapTag::DISPLAY);
   
-  // Check if card is present
-  if (!isCardPresent()) {
-    LOG_DEBUG("No SD card present");
-    return false;
+  // Ensure LUT is built (use current primary color default if user hasn't set one)
+  if (!primaryLUTInitialized) {
+    setSpellImageColors(spellPrimaryColorRGB565, spellAccentColorRGB565);
   }
   
-  // Open file
-  File file = openFile(filename, FILE_READ);
-  if (!file) {
-    LOG_DEBUG("Failed to open file: %s", filename);
-    return false;
+#ifdef MEDIA_PARTITION
+  // Built-in image: converted and written a row at a time straight from
+  // flash, no decoded frame in heap
+  uint16_t width, height, rowSize;
+  const uint8_t* pixels;
+  if (findMappedBMP(filename, width, height, rowSize, pixels)) {
+    return drawMappedBMP(pixels, width, height, rowSize, x, y);
   }
+#endif
   
-  // Read BMP header
-  uint16_t width, height, bitDepth;
-  if (!readBMPHeader(file, &width, &height, &bitDepth)) {
-    file.close();
+  SpellImage image;
+  if (!decodeImageFromSD(filename, primaryLUT, spellAccentColorRGB565, image)) {
     return false;
   }
-
-  // Ensure LUT is built (use current primary color default if user hasn't set one)
-  if (!primaryLUTInitialized) {
-    setSpellImageColors(spellPrimaryColorRGB565, spellAccentColorRGB565);
-  }
+  drawSpellImage(image, x, y);
+  freeSpellImage(image);
   
-  // Get the data offset (where pixel data starts)
-  uint32_t dataOffset = file.position();
+  LOG_DEBUG("Successfully displayed image: %s", filename);
+  return true;
+}
+
+/**
+ * Decode a 24-bit BMP from SD card into RGB565 rows
+ * Steps 1-5 of displayImageFromSD(); rows are kept in BMP (bottom-to-top)
+ * order. abortCheck is polled once per row so a prefetch can be cancelled.
+ * With MEDIA_PARTITION, a built-in image is decoded from mapped flash
+ * when the SD card has no file at the path.
+ */
+bool decodeImageFromSD(const char* filename, const uint16_t primaryLUT[256], uint16_t accentColor,
+                       SpellImage& image, bool (*abortCheck)()) {
+  LOG_DEBUG("Loading image from SD: %s", filename);
+  image.rows = nullptr;
   
-  // BMP rows are padded to 4-byte boundaries
-  uint16_t rowSize = ((width * 3) + 3) & ~3;
-  uint8_t* rowBuffer = (uint8_t*)malloc(rowSize);
+  File file;
+  uint8_t* rowBuffer = NULL;
+  const uint8_t* mappedPixels = NULL;  // Built-in image rows, read in place
+  uint16_t width, height, rowSize;
   
-  if (rowBuffer == NULL) {
-    LOG_DEBUG("Failed to allocate row buffer");
-    file.close();
-    return false;
-  }
+#ifdef MEDIA_PARTITION
+  findMappedBMP(filename, width, height, rowSize, mappedPixels);
+#endif
   
-  // Allocate RGB565 buffer for one row
-  uint16_t* rgb565Buffer = (uint16_t*)malloc(width * sizeof(uint16_t));
-  if (rgb565Buffer == NULL) {
-    LOG_DEBUG("Failed to allocate RGB565 buffer");
-    free(rowBuffer);
-    file.close();
-    return false;
+  if (mappedPixels == NULL) {
+    // Check if card is present
+    if (!isCardPresent()) {
+      LOG_DEBUG("No SD card present");
+      return false;
+    }
+    
+    // Open file
+    file = openFile(filename, FILE_READ);
+    if (!file) {
+      LOG_DEBUG("Failed to open file: %s", filename);
+      return false;
+    }
+    
+    // Read BMP header
+    uint16_t bitDepth;
+    if (!readBMPHeader(file, &width, &height, &bitDepth)) {
+      file.close();
+      return false;
+    }
+    
+    // BMP rows are padded to 4-byte boundaries
+    rowSize = ((width * 3) + 3) & ~3;
+    rowBuffer = (uint8_t*)malloc(rowSize);
+    
+    if (rowBuffer == NULL) {
+      LOG_DEBUG("Failed to allocate row buffer");
+      file.close();
+      return false;
+    }
   }
   
-  // Allocate buffer to hold all rows in memory (so we can reorder without seeking)
-  uint16_t** imageRows = (uint16_t**)malloc(height * sizeof(uint16_t*));
+  // Allocate buffer to hold all rows in memory (so we can reorder without seeking).
+  // Decoded images are large and outlive the draw (prefetch cache): BULK
+  uint16_t** imageRows = policyNewArray<uint16_t*>(height, AllocPolicy::BULK);
   if (imageRows == NULL) {
     LOG_DEBUG("Failed to allocate image rows array");
-    free(rgb565Buffer);
     free(rowBuffer);
     file.close();
     return false;
   }
+  image.width = width;
+  image.height = height;
+  image.rows = imageRows;
   
   // Allocate memory for each row
   for (int i = 0; i < height; i++) {
-    imageRows[i] = (uint16_t*)malloc(width * sizeof(uint16_t));
+    imageRows[i] = (uint16_t*)policyMalloc(width * sizeof(uint16_t), AllocPolicy::BULK);
     if (imageRows[i] == NULL) {
       LOG_DEBUG("Failed to allocate row buffer");
-      // Free previously allocated rows
-      for (int j = 0; j < i; j++) {
-        free(imageRows[j]);
-      }
-      free(imageRows);
-      free(rgb565Buffer);
+      freeSpellImage(image);  // Frees the rows allocated so far
       free(rowBuffer);
       file.close();
       return false;
@@ -828,73 +1066,60 @@ bool displayImageFromSD(const char* filename, int16_t x, int16_t y) {
   
   // Read all rows sequentially from file (BMP stores bottom-to-top)
   for (int row = 0; row < height; row++) {
-    file.read(rowBuffer, rowSize);  // Read one row (with padding)
+    if (abortCheck != nullptr && abortCheck()) {
+      freeSpellImage(image);
+      free(rowBuffer);
+      file.close();
+      return false;
+    }
+    const uint8_t* source;
+    if (mappedPixels != NULL) {
+      source = mappedPixels + (uint32_t)row * rowSize;  // Built-in, in place
+    } else {
+      file.read(rowBuffer, rowSize);  // Read one row (with padding)
+      source = rowBuffer;
+    }
     
     // Convert each pixel from BGR888 to RGB565 and store in row buffer
-    // If the artist used one of the placeholder colors in the BMP
-    // (magenta for primary, lime for accent), substitute the
-    // user-selected RGB565 color to allow runtime recoloring.
-    for (int col = 0; col < width; col++) {
-      uint8_t b = rowBuffer[col * 3];      // Blue channel
-      uint8_t g = rowBuffer[col * 3 + 1];  // Green channel
-      uint8_t r = rowBuffer[col * 3 + 2];  // Red channel
-
-      // Preserve pure black background
-      if (r == 0 && g == 0 && b == 0) {
-        imageRows[row][col] = 0x0000;
-        continue;
-      }
-
-      // Accent placeholder (lime: R=0,G=255,B=0) -> flat accent color
-      if (r == PLACEHOLDER_ACCENT_R && g == PLACEHOLDER_ACCENT_G && b == PLACEHOLDER_ACCENT_B) {
-        imageRows[row][col] = spellAccentColorRGB565;
-        continue;
-      }
-
-      // If pixel is pure grayscale (R==G==B), tint using LUT (very fast)
-      if (r == g && g == b) {
-        imageRows[row][col] = primaryLUT[r];
-        continue;
-      }
-
-      // For any other colored pixel, fall back to direct packing
-      imageRows[row][col] = packRGB565(r, g, b);
-    }
+    convertBMPRow(source, imageRows[row], width, primaryLUT, accentColor);
   }
   
+  free(rowBuffer);  // Free BMP row buffer
+  file.close();  // Close SD file
+  return true;
+}
+
+/**
+ * Write decoded image rows to the display
+ * Reverses BMP bottom-to-top row order into display top-to-bottom.
+ */
+void drawSpellImage(const SpellImage& image, int16_t x, int16_t y) {
   // Write to display in reverse order (convert BMP bottom-to-top to display top-to-bottom)
-  LOG_DEBUG("About to write %dx%d image to display (backlightStateOn=%d)", width, height, backlightStateOn);
-  // Ensure backlight is on during the write to rule out transient toggles
-  if (!backlightStateOn) {
-    LOG_DEBUG("Forcing backlight on for image write");
-    backlightOn();
-    delay(10);
-  }
+  prepareImageWrite(image.width, image.height);
 
   tft.startWrite();  // Begin SPI transaction for bulk write
-  tft.setAddrWindow(x, y, width, height);  // Set drawing window
+  tft.setAddrWindow(x, y, image.width, image.height);  // Set drawing window
 
-  for (int row = height - 1; row >= 0; row--) {  // Reverse row order
-    tft.writePixels(imageRows[row], width);  // Write entire row at once
+  for (int row = image.height - 1; row >= 0; row--) {  // Reverse row order
+    tft.writePixels(image.rows[row], image.width);  // Write entire row at once
   }
 
   tft.endWrite();  // End SPI transaction
   LOG_DEBUG("Finished writing image to display");
   // Small delay to allow any hardware/LED drivers to settle
   delay(20);
-  
-  // Free all allocated memory (row arrays, pointer array, temp buffers)
-  for (int i = 0; i < height; i++) {
-    free(imageRows[i]);  // Free each row buffer
+}
+
+/**
+ * Free decoded image rows (safe on a partially decoded or empty image)
+ */
+void freeSpellImage(SpellImage& image) {
+  if (image.rows == nullptr) return;
+  for (int i = 0; i < image.height; i++) {
+    policyFree(image.rows[i]);  // Free each row buffer (NULL if never allocated)
   }
-  free(imageRows);  // Free row pointer array
-  free(rgb565Buffer);  // Free temporary row buffer
-  
-  free(rowBuffer);  // Free BMP row buffer
-  file.close();  // Close SD file
-  
-  LOG_DEBUG("Successfully displayed image: %s", filename);
-  return true;
+  policyFree(image.rows);  // Free row pointer array
+  image.rows = nullptr;
 }
 
 /**
@@ -1239,6 +1464,7 @@ void displaySettingsMenu(int settingIndex, int valueIndex, bool isEditing) {
  * Shows the message in red with FreeSansBold18pt font
  */
 void displayError(const char* message) {
+  stopSpellAnimation();
   tft.fillScreen(0x0000);
   tft.setFont(&FreeSansBold12pt7b);
   tft.setTextColor(0xF800);  // Red
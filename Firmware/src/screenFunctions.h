@@ -98,6 +98,17 @@ void clearIRTrail();
  */
 void displaySpellName(const char* spellName);
 
+/**
+ * Display a spell with its image already resolved
+ * As displaySpellName(), for casts that have the image path from the
+ * spell action table - skips the by-name image lookup. An animation is
+ * played instead of the image when given (see spellAnimation.h).
+ * spellName: Name of detected spell (text fallback)
+ * imageFile: Image path on SD, or nullptr for text only
+ * animationFile: Animation path, or nullptr for none
+ */
+void displaySpellName(const char* spellName, const char* imageFile, const char* animationFile = nullptr);
+
 /**
  * Clear entire display to black
  * Fills screen with black pixels, removing all trails, text, and images.
@@ -130,6 +141,8 @@ void updateSetupDisplay(int line, const String &function, const String &status);
 /**
  * Display .bmp image file from SD card
  * Loads and displays a raw RGB565 image file in .bmp format.
+ * With MEDIA_PARTITION, a built-in image (mediaBundle.h) is drawn
+ * straight from flash when the SD card has no file at the path.
  * filename: Path to .bmp image file on SD card
  * x: X offset for image display (default 0)
  * y: Y offset for image display (default 0)
@@ -137,6 +150,68 @@ void updateSetupDisplay(int line, const String &function, const String &status);
  */
 bool displayImageFromSD(const char* filename, int16_t x = 0, int16_t y = 0);
 
+/**
+ * Spell image decoded to RGB565 rows, ready to write to the display
+ * Rows are in BMP order (bottom row first); each is width pixels.
+ */
+struct SpellImage {
+  uint16_t width;
+  uint16_t height;
+  uint16_t primary;     ///< Primary color the image was tinted with
+  uint16_t accent;      ///< Accent color the image was tinted with
+  uint16_t** rows;      ///< height row buffers, nullptr when empty
+};
+
+/**
+ * Decode a BMP file from SD card without drawing it
+ * The decode half of displayImageFromSD(), for images prepared ahead of
+ * time (see mediaPrefetch.h). Does not touch the display.
+ * filename: Path to .bmp image file on SD card (or built-in, as above)
+ * primaryLUT: Grayscale tint table (see buildSpellImageLUT())
+ * accentColor: Color for accent placeholder pixels (RGB565)
+ * image: Output, free with freeSpellImage()
+ * abortCheck: Polled once per row; returning true abandons the decode
+ * return true if decoded, false on error or abort (image left empty)
+ */
+bool decodeImageFromSD(const char* filename, const uint16_t primaryLUT[256], uint16_t accentColor,
+                       SpellImage& image, bool (*abortCheck)() = nullptr);
+
+/**
+ * Write a decoded image to the display
+ * image: Decoded image
+ * x: X offset for image display
+ * y: Y offset for image display
+ */
+void drawSpellImage(const SpellImage& image, int16_t x, int16_t y);
+
+/**
+ * Free a decoded image's rows (no-op if already empty)
+ */
+void freeSpellImage(SpellImage& image);
+
+/**
+ * Build the grayscale-to-tint lookup table for a primary color
+ * primaryColorRGB565: Tint color
+ * lut: Output, 256 entries
+ */
+void buildSpellImageLUT(uint16_t primaryColorRGB565, uint16_t lut[256]);
+
+/**
+ * Tint animation palette colors the way spell image pixels are tinted
+ * Black stays black, the accent placeholder takes the accent color,
+ * grays are tinted by the primary color and other colors are kept
+ * (current spell image colors, see setSpellImageColors()).
+ * rgb: count RGB888 entries
+ * lut: Output, count RGB565 entries
+ */
+void buildSpellPaletteLUT(const uint8_t* rgb, uint16_t count, uint16_t* lut);
+
+/**
+ * Primary color for the next spell image
+ * return A random palette color in Random mode, otherwise the selected color
+ */
+uint16_t pickSpellImagePrimaryColor();
+
 /**
  * Set spell image colors
  * primaryColorRGB565: Main color to substitute for primary placeholder in BMP (RGB565)
@@ -36,9 +36,19 @@
  * - Custom naming via JSON "imageFile" field
  */
 
+#define LOG_MODULE LogModule::STORAGE
+
 #include "sdFunctions.h"
 #include "glyphReader.h"
 #include "spell_patterns.h"
+#include "spell_matching.h"
+#include "spellIndex.h"
+#include "spellActions.h"
+#include "spellCombos.h"
+#include "heapFunctions.h"
+#include "memoryPolicy.h"
+#include "mediaBundle.h"
+#include "spellAnimation.h"
 #include <map>
 #include <ArduinoJson.h>
 
@@ -53,6 +63,14 @@ SPIClass sdSPI(HSPI);  // Use HSPI bus for SD card
 // Map to track which spells have image files
 std::map<String, bool> spellImageAvailable;
 
+#ifdef MEDIA_PARTITION
+// Spells whose image comes from the flash media bundle (no SD override)
+std::map<String, bool> spellImageBuiltIn;
+#endif
+
+// Animation path per spell that has one (see spellAnimation.h)
+std::map<String, String> spellAnimationFile;
+
 // Variable to track number of custom spells loaded
 int numCustomSpells = 0;
 
@@ -159,16 +177,12 @@ void listDirectory(const char* dirname, uint8_t levels) {
   File file = root.openNextFile();
   while (file) {
     if (file.isDirectory()) {
-      Serial.print("  DIR : ");
-      Serial.println(file.name());
+      LOG_DEBUG("  DIR : %s", file.name());
       if (levels) {
         listDirectory(file.path(), levels - 1);
       }
     } else {
-      Serial.print("  FILE: ");
-      Serial.print(file.name());
-      Serial.print("\tSIZE: ");
-      Serial.println(file.size());
+      LOG_DEBUG("  FILE: %s\tSIZE: %lu", file.name(), (unsigned long)file.size());
     }
     file = root.openNextFile();
   }
@@ -210,7 +224,7 @@ bool readBMPHeader(File& file, uint16_t* width, uint16_t* height, uint16_t* bitD
   // Read bit depth (2 bytes)
   *bitDepth = file.read() | (file.read() << 8);
   
-  Serial.printf("BMP Info: %dx%d, %d-bit\n", *width, *height, *bitDepth);
+  LOG_DEBUG("BMP Info: %dx%d, %d-bit", *width, *height, *bitDepth);
   
   // Only support 24-bit uncompressed BMPs
   if (*bitDepth != 24) {
@@ -253,7 +267,7 @@ bool loadImageData(const char* filename, uint8_t** buffer, uint16_t* width, uint
   
   // Calculate buffer size (RGB565 format = 2 bytes per pixel)
   uint32_t bufferSize = (*width) * (*height) * 2;
-  *buffer = (uint8_t*)malloc(bufferSize);
+  *buffer = (uint8_t*)policyMalloc(bufferSize, AllocPolicy::BULK);
   
   if (*buffer == NULL) {
     LOG_DEBUG("Failed to allocate memory for image buffer");
@@ -267,7 +281,7 @@ bool loadImageData(const char* filename, uint8_t** buffer, uint16_t* width, uint
   
   if (rowBuffer == NULL) {
     LOG_DEBUG("Failed to allocate row buffer");
-    free(*buffer);
+    policyFree(*buffer);
     file.close();
     return false;
   }
@@ -310,12 +324,23 @@ int countSpellImages() {
 
 // Check for spell image files on SD card
 void checkSpellImages() {
+  HEAP_SCOPE(HeapTag::SD);
   LOG_DEBUG("Checking for spell image files...");
   
-  if (!isCardPresent()) {
+  bool cardPresent = isCardPresent();
+  spellAnimationFile.clear();
+#ifdef MEDIA_PARTITION
+  // Built-in images are available with or without a card
+  spellImageBuiltIn.clear();
+  if (!cardPresent) {
+    LOG_DEBUG("No SD card present - built-in spell images only");
+  }
+#else
+  if (!cardPresent) {
     LOG_DEBUG("No SD card present - no spell images available");
     return;
   }
+#endif
   
   // Check each spell pattern for a corresponding BMP file
   for (const auto& spell : spellPatterns) {
@@ -335,18 +360,33 @@ void checkSpellImages() {
       filename = "/" + spellNameLower + ".bmp";
     }
     
-    // Check if file exists
-    if (SD.exists(filename)) {
+    // Check if file exists (an SD file overrides a built-in one)
+    if (cardPresent && SD.exists(filename)) {
       spellImageAvailable[spellNameLower] = true;
       LOG_DEBUG("  ✓ Found image for '%s': %s", spell.name, filename.c_str());
+#ifdef MEDIA_PARTITION
+    } else if (hasMediaAsset(filename.c_str())) {
+      spellImageAvailable[spellNameLower] = true;
+      spellImageBuiltIn[spellNameLower] = true;
+      LOG_DEBUG("  ✓ Built-in image for '%s': %s", spell.name, filename.c_str());
+#endif
     } else {
       spellImageAvailable[spellNameLower] = false;
       LOG_DEBUG("  ✗ No image for '%s' (will use text)", spell.name);
     }
+    
+    // Animation: same name as the image, .anim extension
+    int extension = filename.lastIndexOf('.');
+    String animation = (extension > 0 ? filename.substring(0, extension) : filename) + ".anim";
+    if (animationFileExists(animation.c_str())) {
+      spellAnimationFile[spellNameLower] = animation;
+      LOG_DEBUG("  ✓ Found animation for '%s': %s", spell.name, animation.c_str());
+    }
   }
   
   LOG_DEBUG("Spell image check complete: %d/%d spells have images", 
                 countSpellImages(), spellPatterns.size());
+  invalidateSpellActions();  // Image availability changed
 }
 
 // Check if a spell has an associated image
@@ -360,6 +400,27 @@ bool hasSpellImage(const char* spellName) {
   return false;
 }
 
+#ifdef MEDIA_PARTITION
+// Check if a spell's image is served from the flash media bundle
+bool isSpellImageBuiltIn(const char* spellName) {
+  String name = String(spellName);
+  name.toLowerCase();
+  auto it = spellImageBuiltIn.find(name);
+  return it != spellImageBuiltIn.end() && it->second;
+}
+#endif
+
+// Get the animation filename for a spell (returns empty string if none)
+String getSpellAnimationFilename(const char* spellName) {
+  String name = String(spellName);
+  name.toLowerCase();
+  auto it = spellAnimationFile.find(name);
+  if (it != spellAnimationFile.end()) {
+    return it->second;
+  }
+  return "";
+}
+
 // Get the image filename for a spell (returns empty string if no image)
 String getSpellImageFilename(const char* spellName) {
   if (!hasSpellImage(spellName)) {
@@ -390,11 +451,38 @@ String getSpellImageFilename(const char* spellName) {
   return filename;
 }
 
+// Read a [{"x": .., "y": ..}, ...] pattern array (no-op if not an array)
+static void readPatternPoints(JsonVariantConst patternArray, std::vector<Point>& points) {
+  if (!patternArray.is<JsonArrayConst>()) return;
+  int pointIndex = 0;
+  for (JsonObjectConst pointObj : patternArray.as<JsonArrayConst>()) {
+    Point p;
+    p.x = pointObj["x"] | 0;
+    p.y = pointObj["y"] | 0;
+    p.timestamp = pointIndex * 100;  // Auto-generate timestamps
+    points.push_back(p);
+    pointIndex++;
+  }
+}
+
+// Append each pattern of a "takes" array (array of pattern arrays)
+static void readTakes(JsonVariantConst takesArray, std::vector<std::vector<Point>>& takes) {
+  if (!takesArray.is<JsonArrayConst>()) return;
+  for (JsonVariantConst takeArray : takesArray.as<JsonArrayConst>()) {
+    std::vector<Point> take;
+    readPatternPoints(takeArray, take);
+    if (!take.empty()) takes.push_back(take);
+  }
+}
+
 // Load custom spell configurations from SD card
 // Expected file: /spells.json
 // Returns true if file was successfully parsed (or doesn't exist), false on error
 bool loadCustomSpells() {
+  HEAP_SCOPE(HeapTag::SD);
   const char* configFile = "/spells.json";
+  numCustomSpells = 0;  // Recounted below (also called to reload after edits)
+  clearSpellCombos();   // Likewise re-read below
   
   if (!isCardPresent()) {
     LOG_DEBUG("No SD card present - skipping custom spells");
@@ -428,7 +516,7 @@ bool loadCustomSpells() {
   file.close();
   
   // Parse JSON
-  JsonDocument doc;
+  JsonDocument doc(bulkJsonAllocator());
   DeserializationError error = deserializeJson(doc, jsonString);
   
   if (error) {
@@ -463,22 +551,28 @@ bool loadCustomSpells() {
             LOG_DEBUG("  Custom image for '%s': %s", spell.name, spell.customImageFilename.c_str());
           }
           
-          // Apply custom pattern if provided
-          if (mod["pattern"].is<JsonArray>()) {
-            JsonArray patternArray = mod["pattern"].as<JsonArray>();
-            if (patternArray.size() > 0) {
-              spell.pattern.clear();
-              int pointIndex = 0;
-              for (JsonObject pointObj : patternArray) {
-                Point p;
-                p.x = pointObj["x"] | 0;
-                p.y = pointObj["y"] | 0;
-                p.timestamp = pointIndex * 100;  // Auto-generate timestamps
-                spell.pattern.push_back(p);
-                pointIndex++;
-              }
-              LOG_DEBUG("  Redefined pattern for '%s' with %d points", spell.name, spell.pattern.size());
-            }
+          // Apply matching mode if provided ("any" = ignore drawing order)
+          if (mod["order"].is<const char*>()) {
+            spell.anyOrder = (strcasecmp(mod["order"].as<const char*>(), "any") == 0);
+            LOG_DEBUG("  Drawing order for '%s': %s", spell.name, spell.anyOrder ? "any" : "fixed");
+          }
+          
+          // Apply custom pattern and/or extra takes if provided
+          std::vector<std::vector<Point>> takes(1);
+          readPatternPoints(mod["pattern"], takes[0]);
+          if (takes[0].empty()) {
+            takes[0] = exemplarPoints(spell, 0);  // Keep the built-in pattern as the first take
+          } else {
+            LOG_DEBUG("  Redefined pattern for '%s' with %d points", spell.name, takes[0].size());
+          }
+          readTakes(mod["takes"], takes);
+          
+          // Rebuild matching data for the new patterns/mode
+          if (mod["pattern"].is<JsonArray>() || mod["takes"].is<JsonArray>()) {
+            compactSpellTakes(spell, takes);
+            LOG_DEBUG("  '%s' matches %d of %d takes", spell.name, exemplarCount(spell), takes.size());
+          } else if (mod["order"].is<const char*>()) {
+            finalizeSpellPattern(spell);
           }
           
           break;
@@ -509,31 +603,78 @@ bool loadCustomSpells() {
         newSpell.customImageFilename = custom["imageFile"].as<String>();
       }
       
-      // Get pattern points
-      if (custom["pattern"].is<JsonArray>()) {
-        JsonArray patternArray = custom["pattern"].as<JsonArray>();
-        int pointIndex = 0;
-        for (JsonObject pointObj : patternArray) {
-          Point p;
-          p.x = pointObj["x"] | 0;
-          p.y = pointObj["y"] | 0;
-          p.timestamp = pointIndex * 100;  // Auto-generate timestamps
-          newSpell.pattern.push_back(p);
-          pointIndex++;
-        }
+      // Get matching mode if provided ("any" = ignore drawing order)
+      if (custom["order"].is<const char*>()) {
+        newSpell.anyOrder = (strcasecmp(custom["order"].as<const char*>(), "any") == 0);
       }
       
-      if (newSpell.pattern.size() > 0) {
+      // Get pattern points and any extra recorded takes
+      std::vector<std::vector<Point>> takes(1);
+      readPatternPoints(custom["pattern"], takes[0]);
+      if (takes[0].empty()) takes.clear();
+      readTakes(custom["takes"], takes);
+      
+      if (takes.size() > 0) {
+        // Keep the most representative takes in the built-in library's
+        // normalized/resampled form
+        compactSpellTakes(newSpell, takes);
         spellPatterns.push_back(newSpell);
         numCustomSpells++;
-        LOG_DEBUG("  Added custom spell '%s' with %d points", name, newSpell.pattern.size());
+        LOG_DEBUG("  Added custom spell '%s' (%d of %d takes kept)", name, exemplarCount(newSpell), takes.size());
       } else {
         LOG_DEBUG("  Skipping custom spell '%s' - no pattern defined", name);
       }
     }
   }
   
+  // Process spell combos (compiled on the next cast, once names resolve)
+  if (doc["combos"].is<JsonArray>()) {
+    for (JsonObject entry : doc["combos"].as<JsonArray>()) {
+      SpellCombo combo = {};
+      combo.name = entry["name"];
+      combo.withinMs = entry["withinMs"] | COMBO_DEFAULT_WINDOW_MS;
+      if (entry["sequence"].is<JsonArray>()) {
+        for (JsonVariant step : entry["sequence"].as<JsonArray>()) {
+          if (combo.stepCount == COMBO_MAX_STEPS) {
+            combo.stepCount++;  // Too long - rejected below
+            break;
+          }
+          if (step.is<const char*>()) combo.steps[combo.stepCount++] = step.as<const char*>();
+        }
+      }
+      if (!combo.name) {
+        LOG_DEBUG("  Skipping combo with no name");
+        continue;
+      }
+
+      // Image (and animation beside it) and sound, if on the card
+      if (entry["imageFile"].is<const char*>()) {
+        String filename = entry["imageFile"].as<String>();
+        if (!filename.startsWith("/")) filename = "/" + filename;
+        if (SD.exists(filename)) combo.imageFile = filename;
+        int extension = filename.lastIndexOf('.');
+        String animation = (extension > 0 ? filename.substring(0, extension) : filename) + ".anim";
+        if (animationFileExists(animation.c_str())) combo.animationFile = animation;
+      }
+      if (entry["soundFile"].is<const char*>()) {
+        String filename = entry["soundFile"].as<String>();
+        if (!filename.startsWith("/")) filename = "/" + filename;
+        if (SD.exists(filename)) combo.soundFile = filename;
+      }
+
+      if (addSpellCombo(combo)) {
+        LOG_DEBUG("  Added combo '%s' (%d spells within %lu ms)", combo.name, combo.stepCount,
+                  (unsigned long)combo.withinMs);
+      } else {
+        LOG_DEBUG("  Skipping combo '%s' - needs 2 to %d spells", combo.name, COMBO_MAX_STEPS);
+      }
+    }
+  }
+  
   LOG_DEBUG("Custom spell configuration applied. Total spells: %d", spellPatterns.size());
+  buildSpellIndex();  // Patterns changed - rebuild over the full library
+  invalidateSpellActions();  // IDs and image names may have changed
+  invalidateSpellCombos();
   return true;
 }
 
@@ -101,7 +101,7 @@ void listDirectory(const char* dirname, uint8_t levels = 1);
 /**
  * Load image file into memory buffer
  * Allocates memory and reads image data from SD card.
- * Caller is responsible for freeing buffer with free().
+ * The buffer is BULK (see memoryPolicy.h); caller frees it with policyFree().
  * filename: Path to image file
  * buffer: Pointer to buffer pointer (allocated by function)
  * width: Pointer to store image width
@@ -128,7 +128,9 @@ bool readBMPHeader(File& file, uint16_t* width, uint16_t* height, uint16_t* bitD
 
 /**
  * Check which spells have image files available
- * Scans SD card for .bmp image files matching spell names.
+ * Scans SD card for .bmp image files matching spell names, and .anim
+ * animations beside them. With MEDIA_PARTITION, built-in images count
+ * too (also without a card).
  * Logs results to serial console.
  * Called during setup() after spell patterns are initialized.
  */
@@ -141,6 +143,16 @@ void checkSpellImages();
  */
 bool hasSpellImage(const char* spellName);
 
+#ifdef MEDIA_PARTITION
+/**
+ * Check if a spell's image comes from the flash media bundle
+ * True when checkSpellImages() found no SD file but a built-in image
+ * (see mediaBundle.h).
+ * spellName: Spell name to check
+ */
+bool isSpellImageBuiltIn(const char* spellName);
+#endif
+
 /**
  * Get image filename for a spell
  * Returns the filename that should be used for spell image.
@@ -151,6 +163,15 @@ bool hasSpellImage(const char* spellName);
  */
 String getSpellImageFilename(const char* spellName);
 
+/**
+ * Get animation filename for a spell
+ * Found by checkSpellImages(): the image filename with a .anim
+ * extension (e.g., "/ignite.anim"), see spellAnimation.h.
+ * spellName: Spell name
+ * return Animation filename, or empty string if the spell has none
+ */
+String getSpellAnimationFilename(const char* spellName);
+
 //=====================================
 // Custom Spell Configuration
 //=====================================
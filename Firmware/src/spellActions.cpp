@@ -0,0 +1,123 @@
+/*
+================================================================================
+  Spell Actions - Per-Spell Cast Dispatch Table Implementation
+================================================================================
+
+  Implements the table declared in spellActions.h.
+
+  The table is a vector parallel to spellPatterns. It is rebuilt on the
+  loop task between casts (updateSpellActions()) and read there; the stale
+  flag may be set from the portal handler, so it is an atomic that is
+  cleared before the rebuild reads the preferences.
+
+================================================================================
+*/
+
+#define LOG_MODULE LogModule::MATCHING
+
+#include "spellActions.h"
+#include "glyphReader.h"
+#include "preferenceFunctions.h"
+#include "sdFunctions.h"
+#include <atomic>
+
+//=====================================
+// Action Table State
+//=====================================
+
+static std::vector<SpellAction> spellActions;
+static std::atomic<bool> spellActionsStale(true);
+
+// Spell sound paths, built once instead of formatted per cast
+static const char* const SPELL_SOUNDS[SPELL_SOUND_COUNT] = {
+  "/sounds/spell1.wav",
+  "/sounds/spell2.wav",
+  "/sounds/spell3.wav",
+  "/sounds/spell4.wav",
+  "/sounds/spell5.wav"
+};
+
+static int8_t upcomingSound = -1;  // Next randomSpellSound() (-1 = not picked yet)
+
+// Returned for SPELL_ID_NONE - casts nothing special
+static const SpellAction NO_ACTION = {NightlightRole::NONE, "Unknown", false, String(), String()};
+
+//=====================================
+// Table Build
+//=====================================
+
+/**
+ * Assign a nightlight role to the spell named by a preference
+ * Earlier roles win, matching the order castSpell() used to test them.
+ */
+static void assignNightlightRole(const String& prefSpell, NightlightRole role) {
+  SpellId id = findSpellId(prefSpell.c_str());
+  if (id == SPELL_ID_NONE) return;
+  SpellAction& action = spellActions[id];
+  if (action.nightlight != NightlightRole::NONE) return;
+  action.nightlight = role;
+}
+
+/**
+ * Compile the action table from the library and preferences
+ */
+static void buildSpellActions() {
+  spellActions.clear();
+  spellActions.reserve(spellPatterns.size());
+
+  for (const auto& spell : spellPatterns) {
+    SpellAction action;
+    action.nightlight = NightlightRole::NONE;
+    action.mqttPayload = spell.name;
+    action.hasImage = hasSpellImage(spell.name);
+    if (action.hasImage) action.imageFile = getSpellImageFilename(spell.name);
+    action.animationFile = getSpellAnimationFilename(spell.name);
+#ifdef MEDIA_PARTITION
+    action.imageBuiltIn = action.hasImage && isSpellImageBuiltIn(spell.name);
+#endif
+    spellActions.push_back(action);
+  }
+
+  // Same spell for on and off is toggle mode
+  if (NIGHTLIGHT_ON_SPELL.length() > 0 &&
+      strcasecmp(NIGHTLIGHT_ON_SPELL.c_str(), NIGHTLIGHT_OFF_SPELL.c_str()) == 0) {
+    assignNightlightRole(NIGHTLIGHT_ON_SPELL, NightlightRole::TOGGLE);
+  }
+  assignNightlightRole(NIGHTLIGHT_ON_SPELL, NightlightRole::ON);
+  assignNightlightRole(NIGHTLIGHT_OFF_SPELL, NightlightRole::OFF);
+  assignNightlightRole(NIGHTLIGHT_RAISE_SPELL, NightlightRole::RAISE);
+  assignNightlightRole(NIGHTLIGHT_LOWER_SPELL, NightlightRole::LOWER);
+
+  LOG_DEBUG("Spell action table built (%d spells)", spellActions.size());
+}
+
+//=====================================
+// Public Interface
+//=====================================
+
+void invalidateSpellActions() {
+  spellActionsStale.store(true);
+}
+
+bool updateSpellActions() {
+  if (!spellActionsStale.exchange(false)) return false;
+  buildSpellActions();
+  return true;
+}
+
+const SpellAction& spellAction(SpellId id) {
+  if (id < 0 || (size_t)id >= spellActions.size()) return NO_ACTION;
+  return spellActions[id];
+}
+
+const char* randomSpellSound() {
+  // Picked one cast ahead, so the media prefetcher can warm it
+  const char* sound = upcomingSpellSound();
+  upcomingSound = random(SPELL_SOUND_COUNT);
+  return sound;
+}
+
+const char* upcomingSpellSound() {
+  if (upcomingSound < 0) upcomingSound = random(SPELL_SOUND_COUNT);
+  return SPELL_SOUNDS[upcomingSound];
+}
@@ -0,0 +1,114 @@
+/*
+================================================================================
+  Spell Actions - Per-Spell Cast Dispatch Table Header
+================================================================================
+
+  What a cast does, compiled per spell ID so that casting after a match
+  is one indexed lookup with no string work.
+
+  Compilation:
+    - One SpellAction per entry in spellPatterns, indexed by SpellId
+    - Nightlight preference names are resolved to IDs once, giving each
+      spell its nightlight role (toggle when the on/off spells are the same)
+    - Image and animation paths are resolved from the SD image check
+    - LED effect follows the role (nightlight spells drive the nightlight,
+      others a random effect); the sound is one of SPELL_SOUND_COUNT
+      precomputed paths, still picked at random per cast
+
+  Rebuild:
+    - invalidateSpellActions() marks the table stale; it is called when
+      the library is reloaded, images are re-checked or a nightlight spell
+      preference changes
+    - loop() rebuilds it with updateSpellActions() outside readCameraData(),
+      so several changes in a row (e.g. a portal save) cost one rebuild and
+      spellAction() is always a plain indexed lookup
+
+================================================================================
+*/
+
+#ifndef SPELL_ACTIONS_H
+#define SPELL_ACTIONS_H
+
+#include <Arduino.h>
+#include <vector>
+#include "spell_patterns.h"
+
+//=====================================
+// Action Configuration
+//=====================================
+
+#define SPELL_SOUND_COUNT 5             // /sounds/spell1.wav .. spell5.wav
+
+//=====================================
+// Action Data Structures
+//=====================================
+
+/**
+ * Nightlight control assigned to a spell by the NIGHTLIGHT_*_SPELL preferences
+ */
+enum class NightlightRole : uint8_t {
+  NONE,     // Regular spell
+  TOGGLE,   // Same spell assigned to on and off
+  ON,
+  OFF,
+  RAISE,    // Brightness up (regular spell while the nightlight is off)
+  LOWER     // Brightness down (regular spell while the nightlight is off)
+};
+
+/**
+ * Everything castSpell() needs for one spell
+ */
+struct SpellAction {
+  NightlightRole nightlight;      ///< Nightlight control role
+  const char* mqttPayload;        ///< Published to MQTT_TOPIC (the spell name)
+  bool hasImage;                  ///< Image found on SD by checkSpellImages()
+  String imageFile;               ///< Image path (valid when hasImage)
+  String animationFile;           ///< Animation path, empty when none
+#ifdef MEDIA_PARTITION
+  bool imageBuiltIn;              ///< Image drawn from the flash media bundle
+#endif
+};
+
+//=====================================
+// Public Interface
+//=====================================
+
+/**
+ * Mark the action table stale
+ * Call after anything it is compiled from changes: the spell library,
+ * spell images, or a NIGHTLIGHT_*_SPELL preference. Cheap - the rebuild
+ * happens on the next updateSpellActions().
+ */
+void invalidateSpellActions();
+
+/**
+ * Rebuild the action table if it is stale
+ * Loop task only, between casts: the rebuild does the image checks and
+ * spell name lookups the casting path must not.
+ * return true if rebuilt
+ */
+bool updateSpellActions();
+
+/**
+ * Look up the compiled actions for a spell
+ * A plain indexed lookup; the table may trail a change until the next
+ * updateSpellActions().
+ * id: Spell ID (SPELL_ID_NONE or out of range gives a no-op action)
+ * return Action record, valid until the next invalidateSpellActions()
+ */
+const SpellAction& spellAction(SpellId id);
+
+/**
+ * Path of a random spell sound from the precomputed table
+ * The pick is made one call ahead (see upcomingSpellSound()).
+ * return One of /sounds/spell1.wav .. spellN.wav
+ */
+const char* randomSpellSound();
+
+/**
+ * The sound the next randomSpellSound() will return
+ * Lets the media prefetcher warm it before the cast.
+ */
+const char* upcomingSpellSound();
+
+#endif // SPELL_ACTIONS_H
@@ -0,0 +1,329 @@
+/*
+================================================================================
+  Spell Animation - Streamed Frame-Sequence Spell Images Implementation
+================================================================================
+
+  Implements the player declared in spellAnimation.h.
+
+  All state lives in one static player, used only from the loop task
+  (displaySpellName() starts playback, loop() updates it). Encoded frame
+  bytes come either from the SD file through a small read buffer or, for
+  a built-in animation, straight from the mapped media bundle.
+
+================================================================================
+*/
+
+#define LOG_MODULE LogModule::FEEDBACK
+
+#include "spellAnimation.h"
+#include "glyphReader.h"
+#include "screenFunctions.h"
+#include "sdFunctions.h"
+#include "mediaBundle.h"
+
+//=====================================
+// Player State
+//=====================================
+
+/**
+ * Encoded bytes of one frame, from SD or mapped flash
+ */
+struct FrameReader {
+  const uint8_t* mapped;              // Built-in source, nullptr for SD
+  uint8_t buffer[ANIM_READ_BUFFER];   // SD read buffer
+  uint16_t position;                  // Next byte in buffer
+  uint16_t length;                    // Bytes in buffer
+  uint32_t remaining;                 // Frame bytes not yet returned
+  bool overrun;                       // Read past the end of the frame
+};
+
+/**
+ * The animation being played
+ */
+struct AnimationPlayer {
+  bool active;
+  File file;                          // SD source (closed for built-in)
+  const uint8_t* mapped;              // Built-in source, nullptr for SD
+  uint32_t fileSize;
+  AnimHeader header;
+  uint32_t tableOffset;               // Frame table position in the file
+  int16_t x;                          // Top-left corner on the display
+  int16_t y;
+  uint16_t nextFrame;                 // Next frame to draw
+  uint32_t startTime;                 // millis() when frame 0 was due
+};
+
+static AnimationPlayer player;
+static FrameReader reader;
+static AnimationStats stats;
+static uint16_t paletteLUT[256];                       // Palette tinted to RGB565
+static uint16_t lineBuffers[2][ANIM_MAX_WIDTH];        // Decode one while sending the other
+
+//=====================================
+// Source Access
+//=====================================
+
+/**
+ * Read bytes at an offset in the animation file
+ * return true if all bytes were read
+ */
+static bool readAt(uint32_t offset, void* destination, size_t length) {
+  if (player.mapped != nullptr) {
+    memcpy(destination, player.mapped + offset, length);
+    return true;
+  }
+  return player.file.seek(offset) && player.file.read((uint8_t*)destination, length) == length;
+}
+
+/**
+ * Next encoded byte of the frame being drawn
+ * Past the end of the frame, returns 0 and sets reader.overrun.
+ */
+static uint8_t nextByte() {
+  if (reader.remaining == 0) {
+    reader.overrun = true;
+    return 0;
+  }
+  reader.remaining--;
+  if (reader.mapped != nullptr) {
+    return *reader.mapped++;
+  }
+  if (reader.position == reader.length) {
+    uint32_t chunk = min(reader.remaining + 1, (uint32_t)ANIM_READ_BUFFER);
+    reader.length = player.file.read(reader.buffer, chunk);
+    reader.position = 0;
+    if (reader.length == 0) {
+      reader.remaining = 0;
+      reader.overrun = true;
+      return 0;
+    }
+  }
+  return reader.buffer[reader.position++];
+}
+
+//=====================================
+// Frame Decoding
+//=====================================
+
+/**
+ * Send a decoded span and switch to the other line buffer
+ * The transfer may still be running on return; the next span waits for
+ * it before reusing the display (writePixels is blocking on targets
+ * without display DMA, where this degrades to one buffer at a time).
+ */
+static void flushSpan(uint8_t& buffer, int16_t row, int16_t start, int16_t length) {
+  if (length == 0) return;
+  tft.dmaWait();
+  tft.setAddrWindow(player.x + start, player.y + row, length, 1);
+  tft.writePixels(lineBuffers[buffer] + start, length, false);
+  buffer ^= 1;
+}
+
+/**
+ * Decode one frame and write its changed spans to the display
+ * return false if the frame data is corrupt (the frame may be partly drawn)
+ */
+static bool drawFrame(uint16_t index) {
+  AnimFrameEntry entry;
+  if (!readAt(player.tableOffset + index * sizeof(AnimFrameEntry), &entry, sizeof(entry)) ||
+      entry.offset > player.fileSize || entry.size > player.fileSize - entry.offset) {
+    return false;
+  }
+
+  reader.remaining = entry.size;
+  reader.position = 0;
+  reader.length = 0;
+  reader.overrun = false;
+  if (player.mapped != nullptr) {
+    reader.mapped = player.mapped + entry.offset;
+  } else {
+    reader.mapped = nullptr;
+    if (!player.file.seek(entry.offset)) return false;
+  }
+
+  const uint16_t width = player.header.width;
+  const uint16_t height = player.header.height;
+  uint8_t buffer = 0;
+
+  tft.startWrite();
+  uint16_t row = 0;
+  while (row < height && reader.remaining > 0) {
+    uint16_t col = 0;
+    int16_t spanStart = 0;     // First pixel of the span being decoded
+    int16_t spanLength = 0;
+    bool rowsSkipped = false;
+
+    while (col < width) {
+      uint8_t op = nextByte();
+      AnimOp type = (AnimOp)(op >> 6);
+      uint16_t count = (op & 0x3F) + 1;
+      if (reader.overrun) break;
+
+      if (type == AnimOp::SKIP_ROWS) {
+        if (col != 0) { reader.overrun = true; break; }   // Only valid at a row start
+        row += count;
+        rowsSkipped = true;
+        break;
+      }
+      if (col + count > width) { reader.overrun = true; break; }
+
+      if (type == AnimOp::SKIP) {
+        flushSpan(buffer, row, spanStart, spanLength);
+        col += count;
+        spanStart = col;
+        spanLength = 0;
+        continue;
+      }
+
+      uint16_t* line = lineBuffers[buffer];
+      if (type == AnimOp::RUN) {
+        uint16_t color = paletteLUT[nextByte()];
+        for (uint16_t i = 0; i < count; i++) line[col + i] = color;
+      } else {
+        for (uint16_t i = 0; i < count; i++) line[col + i] = paletteLUT[nextByte()];
+      }
+      col += count;
+      spanLength += count;
+    }
+
+    if (reader.overrun) break;
+    if (!rowsSkipped) {
+      flushSpan(buffer, row, spanStart, spanLength);
+      row++;
+    }
+  }
+  tft.dmaWait();
+  tft.endWrite();
+
+  return !reader.overrun;
+}
+
+//=====================================
+// Public Interface
+//=====================================
+
+bool animationFileExists(const char* path) {
+  if (fileExists(path)) return true;
+#ifdef MEDIA_PARTITION
+  return hasMediaAsset(path);
+#else
+  return false;
+#endif
+}
+
+bool startSpellAnimation(const char* filename) {
+  stopSpellAnimation();
+  stats = AnimationStats();
+
+  // SD card first (overrides a built-in animation), then the media bundle
+  player.mapped = nullptr;
+  if (fileExists(filename)) {
+    player.file = openFile(filename, FILE_READ);
+    if (!player.file) return false;
+    player.fileSize = player.file.size();
+  } else {
+#ifdef MEDIA_PARTITION
+    MediaAsset asset;
+    if (!findMediaAsset(filename, asset)) return false;
+    player.mapped = asset.data;
+    player.fileSize = asset.size;
+#else
+    return false;
+#endif
+  }
+
+  // Validate header, palette and frame table bounds
+  AnimHeader& header = player.header;
+  uint8_t palette[256 * 3];
+  bool valid = player.fileSize >= sizeof(AnimHeader) && readAt(0, &header, sizeof(header)) &&
+               header.magic == ANIM_MAGIC && header.version == ANIM_VERSION &&
+               header.width > 0 && header.width <= ANIM_MAX_WIDTH &&
+               header.height > 0 && header.height <= tft.height() &&
+               header.frameCount > 0 && header.keyInterval > 0 &&
+               header.frameRate > 0 && header.frameRate <= ANIM_MAX_FRAME_RATE &&
+               header.paletteSize > 0 && header.paletteSize <= 256;
+  if (valid) {
+    uint32_t paletteBytes = header.paletteSize * 3;
+    player.tableOffset = sizeof(AnimHeader) + ((paletteBytes + 3) & ~3);
+    valid = player.tableOffset + (uint32_t)header.frameCount * sizeof(AnimFrameEntry) <= player.fileSize &&
+            readAt(sizeof(AnimHeader), palette, paletteBytes);
+  }
+  if (!valid) {
+    LOG_ALWAYS("Invalid animation file: %s", filename);
+    if (player.file) player.file.close();
+    return false;
+  }
+
+  // Unused codes stay black
+  memset(paletteLUT, 0, sizeof(paletteLUT));
+  buildSpellPaletteLUT(palette, header.paletteSize, paletteLUT);
+
+  player.x = (tft.width() - header.width) / 2;
+  player.y = (tft.height() - header.height) / 2;
+  player.nextFrame = 0;
+  player.startTime = millis();
+  player.active = true;
+  LOG_DEBUG("Playing animation %s: %dx%d, %d frames at %d fps", filename,
+            header.width, header.height, header.frameCount, header.frameRate);
+
+  updateSpellAnimation(player.startTime);  // First frame right away
+  return player.active;
+}
+
+void updateSpellAnimation(uint32_t currentTime) {
+  if (!player.active) return;
+  const AnimHeader& header = player.header;
+
+  // Frame that should be on screen now
+  uint32_t due = (uint32_t)(currentTime - player.startTime) * header.frameRate / 1000;
+  if (due < player.nextFrame) return;
+  if (due >= header.frameCount) due = header.frameCount - 1;
+
+  uint16_t frame = player.nextFrame;
+  if (due > frame) {
+    // Behind: jump to the newest due keyframe if it is past the next frame
+    uint16_t key = due - due % header.keyInterval;
+    if (key > frame) {
+      stats.dropped += key - frame;
+      frame = key;
+    } else {
+      stats.late++;
+    }
+  } else {
+    stats.drawn++;
+  }
+
+  uint32_t started = micros();
+  if (!drawFrame(frame)) {
+    LOG_ALWAYS("Animation frame %d is corrupt - stopping", frame);
+    stopSpellAnimation();
+    return;
+  }
+  uint32_t frameTime = micros() - started;
+  if (frameTime > stats.longestFrame) stats.longestFrame = frameTime;
+  player.nextFrame = frame + 1;
+
+  // Keep the spell on screen until the animation ends, then for the usual time
+  screenSpellOnTime = millis();
+  screenOnTime = millis();
+
+  if (player.nextFrame >= header.frameCount) {
+    LOG_DEBUG("Animation done: %d on time, %d late, %d dropped, slowest frame %lu us",
+              stats.drawn, stats.late, stats.dropped, (unsigned long)stats.longestFrame);
+    stopSpellAnimation();
+  }
+}
+
+void stopSpellAnimation() {
+  if (!player.active) return;
+  player.active = false;
+  if (player.file) player.file.close();
+}
+
+bool isSpellAnimationPlaying() {
+  return player.active;
+}
+
+AnimationStats getAnimationStats() {
+  return stats;
+}
@@ -0,0 +1,152 @@
+/*
+================================================================================
+  Spell Animation - Streamed Frame-Sequence Spell Images Header
+================================================================================
+
+  Plays short per-spell animations on the round display in place of the
+  static spell BMP. An animation is a "/<spell>.anim" file next to the
+  spell's image (same name, .anim extension), on SD card or - with
+  MEDIA_PARTITION - in the flash media bundle. Encode one from a frame
+  sequence or GIF with Tools/encode_animation.py.
+
+  Container (little endian):
+    header   magic "GRAN", u16 version, width, height, frame count,
+             frame rate (fps), key interval, palette size, reserved
+    palette  palette size x RGB888, padded to 4 bytes
+    table    frame count x (u32 offset, u32 size) from the start of file
+    frames   encoded frames
+
+  Frame Encoding:
+    - Pixels are 8-bit palette codes; the palette is tinted like spell
+      image pixels (grays by the primary color, lime by the accent), so
+      animations follow the color preference
+    - Each frame is a run of op bytes, (type << 6) | (count - 1), with
+      counts of 1-64; ops never cross the end of a row:
+        SKIP       count pixels unchanged from the previous frame
+        RUN        count pixels of the code that follows
+        LITERAL    count codes follow
+        SKIP_ROWS  count whole rows unchanged (at the start of a row)
+    - Every key interval'th frame is a keyframe with no skips, so it
+      draws correctly without the frames before it
+
+  Playback:
+    - Non-blocking: startSpellAnimation() draws the first frame,
+      updateSpellAnimation() in loop() draws each later frame when due
+    - Only changed spans are written. A span is decoded into one of two
+      line buffers while the other is being sent, so memory is two line
+      buffers, the tinted palette and a small read buffer regardless of
+      the animation's length
+    - Fixed frame rate: a frame is never drawn early. When playback falls
+      behind, it jumps to the newest due keyframe (the skipped frames are
+      counted as dropped); with no keyframe to jump to, the next frame is
+      drawn late and counted as such
+    - The last frame is held for the usual spell display time
+
+================================================================================
+*/
+
+#ifndef SPELL_ANIMATION_H
+#define SPELL_ANIMATION_H
+
+#include <Arduino.h>
+
+//=====================================
+// Configuration
+//=====================================
+
+#define ANIM_MAGIC 0x4E415247           // "GRAN" little endian
+#define ANIM_VERSION 1
+#define ANIM_MAX_WIDTH 240              // Line buffer width (display width)
+#define ANIM_MAX_FRAME_RATE 30          // Highest accepted frame rate (fps)
+#define ANIM_READ_BUFFER 256            // SD read buffer (bytes)
+
+//=====================================
+// Animation Data Structures
+//=====================================
+
+/**
+ * Animation file header
+ */
+struct AnimHeader {
+  uint32_t magic;           // ANIM_MAGIC
+  uint16_t version;         // ANIM_VERSION
+  uint16_t width;
+  uint16_t height;
+  uint16_t frameCount;
+  uint16_t frameRate;       // Frames per second
+  uint16_t keyInterval;     // Frames 0, keyInterval, 2*keyInterval... are keyframes
+  uint16_t paletteSize;     // RGB888 entries (1-256)
+  uint16_t reserved;
+};
+
+/**
+ * Frame table entry
+ */
+struct AnimFrameEntry {
+  uint32_t offset;          // From the start of the file
+  uint32_t size;            // Encoded bytes
+};
+
+/**
+ * Frame op types (top two bits of an op byte)
+ */
+enum class AnimOp : uint8_t {
+  SKIP = 0,
+  RUN = 1,
+  LITERAL = 2,
+  SKIP_ROWS = 3
+};
+
+/**
+ * Counters for the current (or last) animation
+ */
+struct AnimationStats {
+  uint16_t drawn;           // Frames drawn on time
+  uint16_t late;            // Frames drawn after their successor was due
+  uint16_t dropped;         // Frames skipped by jumping to a keyframe
+  uint32_t longestFrame;    // Slowest frame decode and write (microseconds)
+};
+
+//=====================================
+// Animation Functions
+//=====================================
+
+/**
+ * Start playing an animation, replacing any that is playing
+ * Draws the first frame. Tints with the current spell image colors
+ * (see setSpellImageColors()).
+ * filename: Path to the .anim file (SD card first, then the media bundle)
+ * return true if the file is valid and playback started
+ */
+bool startSpellAnimation(const char* filename);
+
+/**
+ * Draw the next frame if it is due
+ * Call every loop(); does nothing when no animation is playing.
+ * currentTime: millis()
+ */
+void updateSpellAnimation(uint32_t currentTime);
+
+/**
+ * Stop playback (the frame on screen is left as is)
+ * Called when anything else takes over the display.
+ */
+void stopSpellAnimation();
+
+/**
+ * Check whether an animation is playing
+ */
+bool isSpellAnimationPlaying();
+
+/**
+ * Counters of the current or last animation
+ */
+AnimationStats getAnimationStats();
+
+/**
+ * Check whether an animation file exists (SD card or media bundle)
+ * path: Path to the .anim file
+ */
+bool animationFileExists(const char* path);
+
+#endif // SPELL_ANIMATION_H
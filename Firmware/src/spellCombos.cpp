@@ -0,0 +1,221 @@
+/*
+================================================================================
+  Spell Combos - Spell Sequence Recognition Implementation
+================================================================================
+
+  Implements the automaton declared in spellCombos.h.
+
+  The automaton is rebuilt (updateSpellCombos()) and advanced on the
+  loop task, the rebuild between casts; the stale flag is an atomic so
+  it may be set from elsewhere.
+
+================================================================================
+*/
+
+#define LOG_MODULE LogModule::MATCHING
+
+#include "spellCombos.h"
+#include "glyphReader.h"
+#include "memoryPolicy.h"
+#include <atomic>
+
+//=====================================
+// Automaton State
+//=====================================
+
+/**
+ * One automaton state: a partial sequence of casts
+ */
+struct ComboState {
+  uint16_t fail;            // State of the longest proper suffix that is also a prefix
+  int16_t combo;            // Combo ending exactly here, COMBO_NONE if none
+  uint8_t depth;            // Casts in the partial sequence
+  uint32_t span;            // Longest withinMs of the combos through here
+};
+
+#define COMBO_MAX_STATES 0xFFFF         // State numbers are uint16_t
+
+static std::vector<SpellCombo> combos;
+static std::vector<ComboState> comboStates;
+static BulkVector<uint16_t> comboNext;   // Dense transitions, comboStates.size() x comboSpells
+static size_t comboSpells = 0;           // Spell IDs the table covers
+static std::atomic<bool> combosStale(true);
+
+static uint16_t comboState = 0;          // Current state (0 = no partial sequence)
+static uint32_t castTimes[COMBO_MAX_STEPS];  // Times of the last casts (ring)
+static uint32_t castCount = 0;           // Casts fed since the last build
+
+static const SpellCombo NO_COMBO = {"Unknown", {}, 0, 0, String(), String(), String()};
+
+//=====================================
+// Automaton Build
+//=====================================
+
+/**
+ * Time of the first cast of a partial sequence
+ * depth: Casts in the sequence, the last one being the latest cast
+ */
+static uint32_t firstCastTime(uint8_t depth) {
+  return castTimes[(castCount - depth) % COMBO_MAX_STEPS];
+}
+
+/**
+ * Add a combo's path to the trie
+ * return false if the table is full
+ */
+static bool insertCombo(int index, const SpellId* ids) {
+  const SpellCombo& combo = combos[index];
+  uint16_t state = 0;
+  for (uint8_t step = 0; step < combo.stepCount; step++) {
+    size_t edge = state * comboSpells + ids[step];
+    if (comboNext[edge] == 0) {
+      if (comboStates.size() >= COMBO_MAX_STATES) return false;
+      comboNext[edge] = comboStates.size();
+      comboStates.push_back({0, COMBO_NONE, (uint8_t)(step + 1), 0});
+      comboNext.resize(comboStates.size() * comboSpells, 0);
+    }
+    state = comboNext[edge];
+    comboStates[state].span = max(comboStates[state].span, combo.withinMs);
+  }
+  if (comboStates[state].combo == COMBO_NONE) {
+    comboStates[state].combo = index;
+  } else {
+    LOG_DEBUG("Combo '%s' repeats '%s' - ignored", combo.name, combos[comboStates[state].combo].name);
+  }
+  return true;
+}
+
+/**
+ * Link each state to its longest suffix and fill in every missing
+ * transition, breadth first so suffix states are always complete first
+ */
+static void linkComboStates() {
+  std::vector<uint16_t> queue;
+  queue.reserve(comboStates.size());
+  for (size_t spell = 0; spell < comboSpells; spell++) {
+    if (comboNext[spell] != 0) queue.push_back(comboNext[spell]);  // Fail to the root
+  }
+
+  for (size_t head = 0; head < queue.size(); head++) {
+    uint16_t state = queue[head];
+    size_t suffix = comboStates[state].fail * comboSpells;
+    for (size_t spell = 0; spell < comboSpells; spell++) {
+      uint16_t& next = comboNext[state * comboSpells + spell];
+      if (next != 0) {
+        comboStates[next].fail = comboNext[suffix + spell];
+        queue.push_back(next);
+      } else {
+        next = comboNext[suffix + spell];
+      }
+    }
+  }
+}
+
+/**
+ * Compile the automaton from the definitions and the current spell IDs
+ */
+static void buildSpellCombos() {
+  comboSpells = spellPatterns.size();
+  comboStates.assign(1, {0, COMBO_NONE, 0, 0});
+  comboNext.assign(comboSpells, 0);
+  comboState = 0;
+  castCount = 0;
+  if (combos.empty() || comboSpells == 0) return;
+
+  size_t compiled = 0;
+  for (size_t i = 0; i < combos.size(); i++) {
+    const SpellCombo& combo = combos[i];
+    SpellId ids[COMBO_MAX_STEPS];
+    bool resolved = true;
+    for (uint8_t step = 0; step < combo.stepCount && resolved; step++) {
+      ids[step] = findSpellId(combo.steps[step]);
+      if (ids[step] == SPELL_ID_NONE) {
+        LOG_ALWAYS("Combo '%s': no spell named '%s'", combo.name, combo.steps[step]);
+        resolved = false;
+      }
+    }
+    if (!resolved) continue;
+    if (!insertCombo(i, ids)) {
+      LOG_ALWAYS("Combo table full - '%s' and later combos ignored", combo.name);
+      break;
+    }
+    compiled++;
+  }
+
+  linkComboStates();
+  LOG_DEBUG("Combo automaton built (%d combos, %d states, %d bytes)", compiled,
+            comboStates.size(), comboNext.size() * sizeof(uint16_t));
+}
+
+//=====================================
+// Public Interface
+//=====================================
+
+void clearSpellCombos() {
+  for (SpellCombo& combo : combos) {
+    free((void*)combo.name);
+    for (uint8_t step = 0; step < combo.stepCount; step++) free((void*)combo.steps[step]);
+  }
+  combos.clear();
+  invalidateSpellCombos();
+}
+
+bool addSpellCombo(const SpellCombo& combo) {
+  if (combo.stepCount < 2 || combo.stepCount > COMBO_MAX_STEPS) return false;
+  SpellCombo copy = combo;
+  copy.name = strdup(combo.name);
+  for (uint8_t step = 0; step < combo.stepCount; step++) copy.steps[step] = strdup(combo.steps[step]);
+  combos.push_back(copy);
+  invalidateSpellCombos();
+  return true;
+}
+
+void invalidateSpellCombos() {
+  combosStale.store(true);
+}
+
+bool updateSpellCombos() {
+  if (!combosStale.exchange(false)) return false;
+  buildSpellCombos();
+  return true;
+}
+
+int advanceSpellCombos(SpellId spell, uint32_t now) {
+  // Spell IDs changed since the last build - wait for updateSpellCombos()
+  if (combosStale.load()) return COMBO_NONE;
+  if (comboStates.size() <= 1 || spell < 0 || (size_t)spell >= comboSpells) return COMBO_NONE;
+
+  castTimes[castCount++ % COMBO_MAX_STEPS] = now;
+  uint16_t state = comboNext[comboState * comboSpells + spell];
+
+  // Drop partial sequences too old to finish any combo through them
+  while (state != 0 && now - firstCastTime(comboStates[state].depth) > comboStates[state].span) {
+    state = comboStates[state].fail;
+  }
+
+  // Longest combo ending on this cast, in time
+  int completed = COMBO_NONE;
+  for (uint16_t s = state; s != 0; s = comboStates[s].fail) {
+    const ComboState& candidate = comboStates[s];
+    if (candidate.combo != COMBO_NONE &&
+        now - firstCastTime(candidate.depth) <= combos[candidate.combo].withinMs) {
+      completed = candidate.combo;
+      break;
+    }
+  }
+
+  // Stay put even after a combo: the completing cast can also start or
+  // continue another one, and states with no longer combo already lead
+  // on through their suffixes
+  comboState = state;
+  return completed;
+}
+
+const SpellCombo& spellCombo(int index) {
+  if (index < 0 || (size_t)index >= combos.size()) return NO_COMBO;
+  return combos[index];
+}
+
+size_t spellComboCount() {
+  return combos.size();
+}
@@ -0,0 +1,123 @@
+/*
+================================================================================
+  Spell Combos - Spell Sequence Recognition Header
+================================================================================
+
+  Casting spells in a set order within a time limit ("Unlock then
+  Illuminate within 3 s") triggers a combo: its own MQTT payload, image
+  and sound, on top of the feedback of the spell that completed it.
+
+  Definitions:
+    - Read from the "combos" section of spells.json (see CUSTOM_SPELLS.md)
+      by loadCustomSpells(): a name, 2 to COMBO_MAX_STEPS spell names and
+      the time from the first cast to the last (withinMs)
+
+  Automaton:
+    - Compiled from the definitions whenever spell IDs change: a trie over
+      spell IDs with failure links (Aho-Corasick), flattened into a dense
+      transition table of states x spells, so a combo may start at any
+      cast and each cast advances it with one table lookup
+    - Each state keeps the longest time limit of the combos through it;
+      a partial sequence older than that falls back to its longest
+      suffix still in time (at most COMBO_MAX_STEPS hops)
+    - When several combos end on one cast, the longest one in time wins;
+      casts are not consumed, so the cast completing one combo can also
+      start the next ("Unlock, Terminate" then "Terminate, Ignite")
+    - The table lives in BULK memory (PSRAM when fitted): hundreds of
+      combos over a few dozen spells is tens of kilobytes
+
+  Rebuild:
+    - invalidateSpellCombos() marks the automaton stale; loop() compiles
+      it with updateSpellCombos() right after the library loads, between
+      casts, so a large combo table never compiles on the capture path
+
+================================================================================
+*/
+
+#ifndef SPELL_COMBOS_H
+#define SPELL_COMBOS_H
+
+#include <Arduino.h>
+#include "spell_patterns.h"
+
+//=====================================
+// Combo Configuration
+//=====================================
+
+#define COMBO_MAX_STEPS 6               // Most spells in one combo
+#define COMBO_DEFAULT_WINDOW_MS 3000    // withinMs when spells.json gives none
+#define COMBO_NONE -1                   // No combo completed
+
+//=====================================
+// Combo Data Structures
+//=====================================
+
+/**
+ * One combo as defined in spells.json
+ * Steps are kept by name and resolved to IDs when the automaton is built,
+ * so definitions survive the spell library being reloaded.
+ */
+struct SpellCombo {
+  const char* name;                       ///< Published to MQTT_TOPIC and shown
+  const char* steps[COMBO_MAX_STEPS];     ///< Spell names, in casting order
+  uint8_t stepCount;                      ///< Valid entries in steps (2 or more)
+  uint32_t withinMs;                      ///< First cast to last cast
+  String imageFile;                       ///< Image path, empty for text only
+  String animationFile;                   ///< Animation path, empty when none
+  String soundFile;                       ///< Sound path, empty to keep the spell's
+};
+
+//=====================================
+// Public Interface
+//=====================================
+
+/**
+ * Drop every combo definition
+ * Called by loadCustomSpells() before reading spells.json.
+ */
+void clearSpellCombos();
+
+/**
+ * Add a combo definition
+ * Names are copied; unknown spell names are reported when the automaton
+ * is built, and that combo is left out.
+ * return false if the combo has fewer than 2 or more than COMBO_MAX_STEPS steps
+ */
+bool addSpellCombo(const SpellCombo& combo);
+
+/**
+ * Mark the automaton stale
+ * Call after spell IDs change (library reloaded) or combos are added.
+ */
+void invalidateSpellCombos();
+
+/**
+ * Compile the automaton if it is stale
+ * Loop task only, between casts. Combo indexes from before a rebuild
+ * refer to the old definitions and must be dropped.
+ * return true if rebuilt
+ */
+bool updateSpellCombos();
+
+/**
+ * Feed a cast to the automaton
+ * Completes nothing while the automaton is stale. Call after the spell's
+ * own feedback has started, so combos never delay it.
+ * spell: ID of the cast spell
+ * now: Cast time (millis())
+ * return Index of the completed combo (see spellCombo()), or COMBO_NONE
+ */
+int advanceSpellCombos(SpellId spell, uint32_t now);
+
+/**
+ * Combo definition by index
+ * return Definition, valid until the next clearSpellCombos()
+ */
+const SpellCombo& spellCombo(int index);
+
+/**
+ * Number of combo definitions
+ */
+size_t spellComboCount();
+
+#endif // SPELL_COMBOS_H
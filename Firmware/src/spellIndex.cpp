@@ -0,0 +1,425 @@
+/*
+================================================================================
+  Spell Index - Vantage-Point Tree Over Spell Templates Implementation
+================================================================================
+
+  Implements the VP-tree declared in spellIndex.h.
+
+  Layout:
+    Every exemplar of an ordered spell is a separate template in the
+    tree; a match reports the spell it belongs to.
+    Nodes live in one vector and refer to children by position, so a
+    rebuild is a single allocation and the tree holds no pointers into
+    spellPatterns (only indices).
+
+  Build:
+    The vantage template of each subtree is its first member; the rest
+    are split at the median distance to it with nth_element. Build cost
+    is O(n log n) distance evaluations.
+
+  Parallel Search:
+    The root's median split halves the library, so the outside subtree is
+    handed to a worker task pinned to core 0 while the calling task
+    searches the root and the inside subtree. Each half keeps its own
+    radius and best score (no shared state while searching); the two
+    results are merged once the worker notifies back. Both halves start
+    from the caller's score to beat, so the merged result is the same as
+    a single-core search.
+
+================================================================================
+*/
+
+#define LOG_MODULE LogModule::MATCHING
+
+#include "spellIndex.h"
+#include "spell_matching.h"
+#include "glyphReader.h"
+#include "hotPath.h"
+#include <algorithm>
+
+//=====================================
+// Index Storage
+//=====================================
+
+/**
+ * One tree node: a vantage template and its split radius
+ */
+struct VPNode {
+  uint16_t spell;     // Index into spellPatterns
+  uint8_t exemplar;   // Exemplar of that spell (0 = primary pattern)
+  float mu;           // Median distance from vantage to templates below
+  int16_t inside;     // Subtree with distance <= mu (-1 if empty)
+  int16_t outside;    // Subtree with distance > mu (-1 if empty)
+};
+
+static FastVector<VPNode> nodes;     // Walked on every cast - internal SRAM
+static int16_t root = -1;
+static size_t evaluations = 0;
+static bool lastSearchParallel = false;
+
+/**
+ * Template with its distance to the current vantage point (build only)
+ */
+struct BuildItem {
+  uint16_t spell;
+  uint8_t exemplar;
+  float distance;
+};
+
+static const MatchTemplate& itemPattern(const BuildItem& item) {
+  return exemplarTemplate(spellPatterns[item.spell], item.exemplar);
+}
+
+//=====================================
+// Build
+//=====================================
+
+static int16_t buildNode(std::vector<BuildItem>& items, size_t begin, size_t end) {
+  if (begin >= end) return -1;
+
+  int16_t index = (int16_t)nodes.size();
+  nodes.push_back({items[begin].spell, items[begin].exemplar, 0, -1, -1});
+  const MatchTemplate& vantage = itemPattern(items[begin]);
+
+  // Distances from the vantage template to the rest of this subtree
+  size_t first = begin + 1;
+  for (size_t i = first; i < end; i++) {
+    items[i].distance = averagePointDistance(vantage, itemPattern(items[i]));
+  }
+  if (first == end) return index;
+
+  // Split at the median: [first, middle) inside, [middle, end) outside
+  size_t middle = first + (end - first) / 2;
+  std::nth_element(items.begin() + first, items.begin() + middle, items.begin() + end,
+                   [](const BuildItem& a, const BuildItem& b) { return a.distance < b.distance; });
+  float mu = items[middle].distance;
+
+  int16_t inside = buildNode(items, first, middle);
+  int16_t outside = buildNode(items, middle, end);
+
+  nodes[index].mu = mu;
+  nodes[index].inside = inside;
+  nodes[index].outside = outside;
+  return index;
+}
+
+void buildSpellIndex() {
+  std::vector<BuildItem> items;
+  for (size_t i = 0; i < spellPatterns.size(); i++) {
+    const SpellPattern& spell = spellPatterns[i];
+    if (spell.anyOrder) continue;
+    for (size_t e = 0; e < exemplarCount(spell); e++) {
+      if (exemplarMatchable(spell, e)) {
+        items.push_back({(uint16_t)i, (uint8_t)e, 0});
+      }
+    }
+  }
+
+  nodes.clear();
+  nodes.reserve(items.size());
+  root = buildNode(items, 0, items.size());
+  LOG_DEBUG("Spell index built over %d templates", nodes.size());
+}
+
+//=====================================
+// Search
+//=====================================
+
+/**
+ * Search radius for a score to beat
+ * Largest average distance at which a template with perfect direction
+ * similarity could still score above `score`.
+ */
+static float HOT_CODE radiusForScore(float score) {
+  return MAX_POINT_DISTANCE * (1.0f - (score - DIRECTION_WEIGHT) / POSITION_WEIGHT);
+}
+
+/**
+ * Search state shared across the recursion
+ */
+struct SearchState {
+  const MatchTemplate* gesture;
+  const ShapeSignature* signature;
+  float bestScore;
+  int bestSpell;
+  float radius;
+  size_t evaluations;
+};
+
+/**
+ * Start a search from a score to beat
+ */
+static SearchState HOT_CODE startSearch(const MatchTemplate& gesture, const ShapeSignature& signature,
+                               float bestScore) {
+  SearchState state;
+  state.gesture = &gesture;
+  state.signature = &signature;
+  state.bestScore = bestScore;
+  state.bestSpell = -1;
+  state.radius = radiusForScore(max(bestScore, (float)MATCH_THRESHOLD));
+  state.evaluations = 0;
+  return state;
+}
+
+/**
+ * Score a node's vantage template, updating the best match
+ * return Distance from the gesture to the vantage template
+ */
+static float HOT_CODE visitNode(const VPNode& node, SearchState& state) {
+  const SpellPattern& spell = spellPatterns[node.spell];
+  const MatchTemplate& pattern = exemplarTemplate(spell, node.exemplar);
+
+  float d = averagePointDistance(*state.gesture, pattern);
+  state.evaluations++;
+
+  // Full score only for templates inside the radius that pass the prefilter
+  if (d <= state.radius &&
+      signatureDistance(*state.signature, exemplarSignature(spell, node.exemplar), false) <= SIGNATURE_MAX_DISTANCE) {
+    float directionSimilarity = calculateDirectionSimilarity(*state.gesture, pattern);
+    float score = (1.0f - d / MAX_POINT_DISTANCE) * POSITION_WEIGHT + directionSimilarity * DIRECTION_WEIGHT;
+    if (score > state.bestScore) {
+      state.bestScore = score;
+      state.bestSpell = node.spell;
+      state.radius = radiusForScore(score);
+    }
+  }
+  return d;
+}
+
+static void HOT_CODE searchNode(int16_t index, SearchState& state) {
+  if (index < 0) return;
+  const VPNode& node = nodes[index];
+  float d = visitNode(node, state);
+
+  // Triangle inequality: inside templates are >= d - mu away, outside
+  // ones >= mu - d. Visit the side the gesture falls in first, since it
+  // is the likelier to shrink the radius.
+  if (d <= node.mu) {
+    if (d - state.radius <= node.mu) searchNode(node.inside, state);
+    if (d + state.radius >= node.mu) searchNode(node.outside, state);
+  } else {
+    if (d + state.radius >= node.mu) searchNode(node.outside, state);
+    if (d - state.radius <= node.mu) searchNode(node.inside, state);
+  }
+}
+
+/**
+ * Search the root node and its inside subtree only
+ * The caller's half of a parallel search.
+ */
+static void HOT_CODE searchInsideHalf(SearchState& state) {
+  visitNode(nodes[root], state);
+  searchNode(nodes[root].inside, state);
+}
+
+//=====================================
+// Core 0 Worker
+//=====================================
+
+static TaskHandle_t workerHandle = NULL;
+static TaskHandle_t callerHandle = NULL;
+
+// Shared results buffer: written by the caller before the worker is
+// notified, by the worker before it notifies back. Task notifications
+// order the accesses, so no lock is needed.
+static SearchState workerState;
+static int16_t workerSubtree = -1;
+
+// Benchmark override of the PARALLEL_MIN_TEMPLATES cut-over
+enum class SearchMode : uint8_t { AUTO, SINGLE, DUAL };
+static SearchMode searchMode = SearchMode::AUTO;
+
+/**
+ * Worker task: searches one subtree per notification
+ */
+static void HOT_CODE spellIndexWorker(void*) {
+  LOG_DEBUG("Spell index worker started on Core %d", xPortGetCoreID());
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    searchNode(workerSubtree, workerState);
+    xTaskNotifyGive(callerHandle);
+  }
+}
+
+void initSpellIndexWorker() {
+  if (workerHandle != NULL) return;
+  BaseType_t created = xTaskCreatePinnedToCore(
+    spellIndexWorker,       // Task function
+    "SpellIndex",           // Task name
+    SPELL_INDEX_WORKER_STACK, // Stack size (recursion depth is ~log2 of library size)
+    NULL,                   // Parameters
+    2,                      // Priority (above WiFi task so a search isn't held up by the portal)
+    &workerHandle,          // Task handle
+    0                       // Core 0 (loop task matches on Core 1)
+  );
+  if (created != pdPASS) {
+    workerHandle = NULL;
+    LOG_ALWAYS("Failed to create spell index worker - matching stays single-core");
+  }
+}
+
+int HOT_CODE searchSpellIndex(const std::vector<Point>& resampled, const ShapeSignature& signature,
+                     float& bestScore) {
+  evaluations = 0;
+  lastSearchParallel = false;
+  if (resampled.size() != RESAMPLE_POINTS || root < 0) return -1;
+
+  // Gesture in template form, shared read-only by both halves
+#ifdef QUANTIZED_TEMPLATES
+  QuantizedPattern gesture = quantizePattern(resampled);
+#else
+  const std::vector<Point>& gesture = resampled;
+#endif
+  SearchState state = startSearch(gesture, signature, bestScore);
+
+  bool parallel = workerHandle != NULL && searchMode != SearchMode::SINGLE &&
+                  (searchMode == SearchMode::DUAL || nodes.size() >= PARALLEL_MIN_TEMPLATES);
+  if (!parallel) {
+    searchNode(root, state);
+    evaluations = state.evaluations;
+    bestScore = state.bestScore;
+    return state.bestSpell;
+  }
+
+  // Hand the outside half to core 0, search the rest here
+  workerState = startSearch(gesture, signature, bestScore);
+  workerSubtree = nodes[root].outside;
+  callerHandle = xTaskGetCurrentTaskHandle();
+  xTaskNotifyGive(workerHandle);
+
+  searchInsideHalf(state);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+  // Merge the two halves
+  if (workerState.bestScore > state.bestScore) {
+    state.bestScore = workerState.bestScore;
+    state.bestSpell = workerState.bestSpell;
+  }
+  evaluations = state.evaluations + workerState.evaluations;
+  lastSearchParallel = true;
+  bestScore = state.bestScore;
+  return state.bestSpell;
+}
+
+size_t lastIndexEvaluations() {
+  return evaluations;
+}
+
+bool lastIndexSearchParallel() {
+  return lastSearchParallel;
+}
+
+size_t spellIndexSize() {
+  return nodes.size();
+}
+
+//=====================================
+// Benchmark
+//=====================================
+
+#ifdef BENCHMARK_MATCHING
+
+#define BENCHMARK_GESTURES 40           // Gestures timed per library size
+#define BENCHMARK_JITTER 40             // Max per-point jitter (normalized units)
+#define BENCHMARK_HEAP_RESERVE 32768    // Free heap left untouched (bytes)
+
+/**
+ * Jittered copy of a trajectory, normalized and resampled
+ * Jitter is a random walk so the copy stays a plausible stroke.
+ */
+static std::vector<Point> jitterTrajectory(const std::vector<Point>& source) {
+  std::vector<Point> out;
+  out.reserve(source.size());
+  int ox = 0, oy = 0;
+  for (const Point& p : source) {
+    ox = constrain(ox + (int)random(-8, 9), -BENCHMARK_JITTER, BENCHMARK_JITTER);
+    oy = constrain(oy + (int)random(-8, 9), -BENCHMARK_JITTER, BENCHMARK_JITTER);
+    out.push_back({p.x + ox, p.y + oy, p.timestamp});
+  }
+  return resampleTrajectory(normalizeTrajectory(out), RESAMPLE_POINTS);
+}
+
+/**
+ * Average search time over a set of gestures
+ * return Microseconds per gesture
+ */
+static float timeSearches(const std::vector<std::vector<Point>>& gestures,
+                          const std::vector<ShapeSignature>& signatures) {
+  int64_t start = esp_timer_get_time();
+  for (size_t i = 0; i < gestures.size(); i++) {
+    float score = 0;
+    searchSpellIndex(gestures[i], signatures[i], score);
+  }
+  return (float)(esp_timer_get_time() - start) / gestures.size();
+}
+
+void benchmarkSpellIndex() {
+  if (workerHandle == NULL) {
+    LOG_ALWAYS("Benchmark: spell index worker not running");
+    return;
+  }
+  static const size_t sizes[] = {16, 32, 48, 64, 96, 128, 192};
+  FastVector<SpellPattern> original = spellPatterns;
+  size_t baseCount = 0;
+  for (const auto& spell : original) {
+    if (!spell.anyOrder) baseCount++;
+  }
+  if (baseCount == 0) {
+    LOG_ALWAYS("Benchmark: no ordered spells loaded");
+    return;
+  }
+
+  // Gestures: jittered copies of the loaded spells
+  std::vector<std::vector<Point>> gestures;
+  std::vector<ShapeSignature> signatures;
+  for (int i = 0; gestures.size() < BENCHMARK_GESTURES; i++) {
+    const SpellPattern& spell = original[i % original.size()];
+    if (spell.anyOrder) continue;
+    gestures.push_back(jitterTrajectory(exemplarPoints(spell, 0)));
+    signatures.push_back(computeSignature(gestures.back()));
+  }
+
+  LOG_ALWAYS("=== Spell Index Benchmark (us per gesture) ===");
+  LOG_ALWAYS("  templates  single   dual   speedup");
+
+#ifdef QUANTIZED_TEMPLATES
+  size_t templateBytes = sizeof(SpellPattern);
+#else
+  size_t templateBytes = RESAMPLE_POINTS * sizeof(Point) + sizeof(SpellPattern);
+#endif
+  size_t source = 0;
+  for (size_t size : sizes) {
+    // Grow the library with jittered copies, stopping before memory runs low
+    if (size > spellPatterns.size() &&
+        ESP.getFreeHeap() < (size - spellPatterns.size()) * templateBytes + BENCHMARK_HEAP_RESERVE) {
+      LOG_ALWAYS("  %d: skipped (free heap %lu)", size, (unsigned long)ESP.getFreeHeap());
+      break;
+    }
+    while (spellPatterns.size() < size) {
+      const SpellPattern& base = original[source++ % original.size()];
+      if (base.anyOrder) continue;
+      SpellPattern copy = base;
+      copy.pattern = jitterTrajectory(exemplarPoints(base, 0));
+      copy.alternates.clear();
+      finalizeSpellPattern(copy);
+      spellPatterns.push_back(copy);
+    }
+    buildSpellIndex();
+
+    // Both modes forced regardless of PARALLEL_MIN_TEMPLATES, to show
+    // where the cut-over should sit
+    searchMode = SearchMode::SINGLE;
+    float single = timeSearches(gestures, signatures);
+    searchMode = SearchMode::DUAL;
+    float dual = timeSearches(gestures, signatures);
+    searchMode = SearchMode::AUTO;
+    LOG_ALWAYS("  %9d %7.0f %7.0f   %.2fx", nodes.size(), single, dual, single / dual);
+  }
+
+  // Restore the real library
+  spellPatterns = original;
+  buildSpellIndex();
+  LOG_ALWAYS("==============================================");
+}
+
+#endif // BENCHMARK_MATCHING
@@ -0,0 +1,121 @@
+/*
+================================================================================
+  Spell Index - Vantage-Point Tree Over Spell Templates Header
+================================================================================
+
+  Metric index that lets findBestSpell() skip most of a large library
+  without scoring it.
+
+  Metric:
+    - Average point distance between resampled trajectories (the position
+      term of calculateSimilarity()) obeys the triangle inequality
+    - Since direction similarity is at most 1, a template can only reach
+      score S if its average distance is within
+          MAX_POINT_DISTANCE * (1 - (S - DIRECTION_WEIGHT) / POSITION_WEIGHT)
+      of the gesture, turning "best score" into a shrinking search radius
+
+  Tree:
+    - Built over the ordered (non-cloud) templates - every exemplar of
+      every spell - whenever the library is (re)loaded: each node holds
+      a vantage template and the median distance mu from it to the
+      templates below
+    - Templates within mu go in the inside subtree, the rest outside
+
+  Search:
+    - Starts with the radius for MATCH_THRESHOLD and shrinks it as better
+      templates are found
+    - A subtree is skipped when the triangle inequality proves every
+      template in it lies outside the radius
+    - Signature prefilter and direction term only run on templates inside
+      the radius
+    - QUANTIZED_TEMPLATES builds index and search the 8-bit templates;
+      the quantized point distance is a metric too
+
+  Dual-Core Search:
+    - With PARALLEL_MIN_TEMPLATES or more templates, half the tree (the
+      root's outside subtree) is searched by a worker task pinned to
+      core 0, woken by task notification, while the loop task searches
+      the other half on core 1
+    - Smaller libraries are searched on the calling core only, where
+      the notification round trip would cost more than it saves
+    - Build with -D BENCHMARK_MATCHING to print single- vs dual-core
+      timings across library sizes at boot (for tuning the cut-over)
+
+================================================================================
+*/
+
+#ifndef SPELL_INDEX_H
+#define SPELL_INDEX_H
+
+#include <Arduino.h>
+#include <vector>
+#include "spell_patterns.h"
+
+//=====================================
+// Index Configuration
+//=====================================
+
+#define PARALLEL_MIN_TEMPLATES 64       // Smallest index searched on both cores
+#define SPELL_INDEX_WORKER_STACK 3072   // Worker task stack (bytes)
+
+//=====================================
+// Index Functions
+//=====================================
+
+/**
+ * Start the core 0 search worker
+ * Call once at startup. Until (or unless) the worker runs, every search
+ * stays on the calling core.
+ */
+void initSpellIndexWorker();
+
+/**
+ * Rebuild the index from spellPatterns
+ * Call after any change to the library (spells added, removed or
+ * re-patterned). Cloud (anyOrder) spells are left out - they aren't
+ * comparable under the point-distance metric and are scanned separately.
+ */
+void buildSpellIndex();
+
+/**
+ * Find the best ordered template for a gesture
+ * Only templates able to reach max(bestScore, MATCH_THRESHOLD) are
+ * scored; weaker ones may be skipped unseen. Blocks until both halves
+ * finish when the search is split across cores. Not reentrant - call
+ * from one task only (the loop task), which is also the only task that
+ * rebuilds the library (reloadSpellLibraryIfPending()).
+ * resampled: Gesture normalized and resampled to RESAMPLE_POINTS
+ * signature: Gesture shape signature (prefilter)
+ * bestScore: In: score to beat (0 for none). Out: best score found
+ * return Index into spellPatterns of the best template, or -1 if none beat bestScore
+ */
+int searchSpellIndex(const std::vector<Point>& resampled, const ShapeSignature& signature,
+                     float& bestScore);
+
+/**
+ * Templates scored by the last search (distance evaluations)
+ * For checking how much of the library the index skips.
+ */
+size_t lastIndexEvaluations();
+
+/**
+ * Whether the last search was split across both cores
+ */
+bool lastIndexSearchParallel();
+
+/**
+ * Number of templates in the index
+ */
+size_t spellIndexSize();
+
+#ifdef BENCHMARK_MATCHING
+/**
+ * Time single- vs dual-core search over synthetic libraries
+ * Grows the library with jittered copies of the loaded spells, prints
+ * per-gesture timings and speedup for each size, then restores the
+ * library and index. Call after initSpellIndexWorker().
+ */
+void benchmarkSpellIndex();
+#endif
+
+#endif // SPELL_INDEX_H
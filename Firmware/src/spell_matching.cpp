@@ -19,6 +19,48 @@
     - Length invariant: Fast and slow gestures match if shape is the same
     - Rotation partially addressed through direction similarity
   
+  Signature Prefilter:
+    - Every template and gesture gets a ShapeSignature: 8x8 occupancy
+      grid, start/end cells and a direction-sector mask
+    - findBestSpell() skips templates whose signature distance exceeds
+      SIGNATURE_MAX_DISTANCE, so full scoring only runs on plausible ones
+  
+  Spell Index:
+    - Ordered spells are searched through a vantage-point tree (see
+      spellIndex.h) instead of a linear scan; cloud spells stay linear
+  
+  Chain-Code Mode (CHAIN_MATCHING preference):
+    - Lightweight alternative for ordered spells: paths reduce to 64
+      direction symbols (16 sectors, neighbours count as equal) and are
+      compared by bit-parallel edit distance, one 64-bit word per symbol
+    - Tolerates wobbles and hesitations (local insertions/deletions)
+      that misalign the point-by-point matcher; ignores position
+  
+  Prefix Ranking:
+    - rankSpellPrefixes() guesses the likely spells while a gesture is
+      still being drawn: the partial path's chain symbols are compared
+      position-by-position with the first quarter, half, three quarters
+      and all of each ordered template's chain code
+    - A few bit tests per symbol, cheap enough to rerun every few frames;
+      only used to warm media (-D PREFETCH_MEDIA, see mediaPrefetch.h),
+      never to cast
+  
+  Quantized Templates (-D QUANTIZED_TEMPLATES):
+    - Ordered templates are stored as QuantizedPattern (8-bit points and
+      8-bit segment angles) and the gesture is quantized once per search,
+      so scoring is integer deltas, one sqrtf per point and int8_t angle
+      differences instead of two atan2 calls per segment
+  
+  Point-Cloud Mode ($P):
+    - Spells marked "order": "any" in spells.json are matched as unordered
+      clouds of CLOUD_POINTS points, so stars, crosses etc. match from any
+      start point and stroke order
+    - Greedy matching from sqrt(n) start points in both directions
+    - Exact lower bound: each point's distance to its nearest neighbour in
+      the other cloud (ignoring matching) bounds the greedy cost from
+      below, so start points and whole templates that can't beat the best
+      score so far are skipped without matching
+  
   Similarity Scoring:
     - Position: Lower average distance = higher similarity
     - Direction: More parallel strokes = higher similarity
@@ -26,9 +68,22 @@
     - Threshold: 0.70 (70% similarity required for successful match)  
 ================================================================================
 */
+
+#define LOG_MODULE LogModule::MATCHING
+
 #include "spell_matching.h"
+#include "spellIndex.h"
+#include "preferenceFunctions.h"
+#include "logFunctions.h"
+#include "hotPath.h"
 #include <Arduino.h>
 #include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#ifdef QUANTIZED_TEMPLATES
+static_assert(QUANTIZED_POINTS == RESAMPLE_POINTS, "QUANTIZED_POINTS must match RESAMPLE_POINTS");
+#endif
 
 /**
  * Normalize trajectory to 0-1000 coordinate space
@@ -42,7 +97,7 @@
  * traj: The raw trajectory points from IR tracking
  * return Normalized trajectory with coordinates in 0-1000 range
  */
-std::vector<Point> normalizeTrajectory(const std::vector<Point>& traj) {
+std::vector<Point> HOT_CODE normalizeTrajectory(const std::vector<Point>& traj) {
   if (traj.size() < 2) return traj;
   
   // Find bounding box - the smallest rectangle that contains all points
@@ -93,7 +148,7 @@ std::vector<Point> normalizeTrajectory(const std::vector<Point>& traj) {
  * numPoints: The desired number of points (typically 20 for spell matching)
  * return Resampled trajectory with exactly numPoints evenly-spaced points
  */
-std::vector<Point> resampleTrajectory(const std::vector<Point>& traj, int numPoints) {
+std::vector<Point> HOT_CODE resampleTrajectory(const std::vector<Point>& traj, int numPoints) {
   if (traj.size() < 2) return traj;
   
   // Calculate total path length by summing all segment distances
@@ -168,7 +223,7 @@ std::vector<Point> resampleTrajectory(const std::vector<Point>& traj, int numPoi
  * traj2: Second trajectory (resampled to same length as traj1)
  * return Similarity score from 0 (opposite directions) to 1 (identical directions)
  */
-float calculateDirectionSimilarity(const std::vector<Point>& traj1, const std::vector<Point>& traj2) {
+float HOT_CODE calculateDirectionSimilarity(const std::vector<Point>& traj1, const std::vector<Point>& traj2) {
   if (traj1.size() != traj2.size() || traj1.size() < 2) return 0;
   
   float totalAngleDiff = 0;
@@ -224,112 +279,872 @@ float calculateDirectionSimilarity(const std::vector<Point>& traj1, const std::v
  * traj2: Second trajectory (normalized and resampled)
  * return Similarity score from 0 (completely different) to 1 (identical)
  */
-float calculateSimilarity(const std::vector<Point>& traj1, const std::vector<Point>& traj2) {
+float HOT_CODE calculateSimilarity(const std::vector<Point>& traj1, const std::vector<Point>& traj2) {
   if (traj1.size() != traj2.size() || traj1.empty()) return 0;
   
   // Calculate position similarity by measuring point-to-point distances
-  float totalDistance = 0;
-  float maxPossibleDistance = 1414.0; // Diagonal of 1000x1000 normalized space (sqrt(1000² + 1000²))
+  // and normalizing the average to 0-1 range
+  float avgDistance = averagePointDistance(traj1, traj2);
+  float positionSimilarity = 1.0 - (avgDistance / MAX_POINT_DISTANCE);
+  
+  // Calculate direction similarity (how well the flow/direction matches)
+  float directionSimilarity = calculateDirectionSimilarity(traj1, traj2);
+  
+  // Combined score: weighted average
+  // 60% position (shape) + 40% direction (flow)
+  // This weighting was chosen to prioritize overall shape while still
+  // distinguishing between gestures drawn in opposite directions
+  float combinedSimilarity = (positionSimilarity * POSITION_WEIGHT) + (directionSimilarity * DIRECTION_WEIGHT);
+  
+  return max(0.0f, combinedSimilarity);
+}
+
+/**
+ * Average Euclidean distance between corresponding points
+ * This is a metric on equal-length trajectories (mean of per-point
+ * Euclidean metrics), which the spell index relies on for pruning.
+ * traj1: First trajectory (normalized and resampled)
+ * traj2: Second trajectory (same number of points as traj1)
+ * return Average point distance in normalized units
+ */
+float HOT_CODE averagePointDistance(const std::vector<Point>& traj1, const std::vector<Point>& traj2) {
+  if (traj1.size() != traj2.size() || traj1.empty()) return MAX_POINT_DISTANCE;
   
   // Sum distances between corresponding points
+  float totalDistance = 0;
   for (size_t i = 0; i < traj1.size(); i++) {
     float dx = traj1[i].x - traj2[i].x;
     float dy = traj1[i].y - traj2[i].y;
     totalDistance += sqrt(dx*dx + dy*dy);  // Euclidean distance
   }
+  return totalDistance / traj1.size();
+}
+
+/**
+ * Quantize a path to 8-bit points and segment angles
+ * Angles use the same atan2 as calculateDirectionSimilarity(), mapped to
+ * 256 steps per turn (128 = pi).
+ */
+QuantizedPattern HOT_CODE quantizePattern(const std::vector<Point>& resampled) {
+  QuantizedPattern quantized;
+  if (resampled.size() != QUANTIZED_POINTS) return quantized;
+  
+  for (int i = 0; i < QUANTIZED_POINTS; i++) {
+    quantized.x[i] = (uint8_t)constrain(lroundf(resampled[i].x / QUANTIZED_STEP), 0, 255);
+    quantized.y[i] = (uint8_t)constrain(lroundf(resampled[i].y / QUANTIZED_STEP), 0, 255);
+  }
+  for (int i = 0; i < QUANTIZED_POINTS - 1; i++) {
+    float angle = atan2(resampled[i+1].y - resampled[i].y, resampled[i+1].x - resampled[i].x);
+    quantized.direction[i] = (uint8_t)(lroundf(angle * 128 / M_PI) & 0xFF);
+  }
+  quantized.filled = true;
+  return quantized;
+}
+
+std::vector<Point> dequantizePattern(const QuantizedPattern& quantized) {
+  std::vector<Point> points;
+  if (!quantized.filled) return points;
+  points.reserve(QUANTIZED_POINTS);
+  for (int i = 0; i < QUANTIZED_POINTS; i++) {
+    points.push_back({(int)lroundf(quantized.x[i] * QUANTIZED_STEP),
+                      (int)lroundf(quantized.y[i] * QUANTIZED_STEP), 0});
+  }
+  return points;
+}
+
+/**
+ * Average point distance on quantized paths
+ * Euclidean on the 8-bit grid (so still a metric), in normalized units.
+ */
+float HOT_CODE averagePointDistance(const QuantizedPattern& traj1, const QuantizedPattern& traj2) {
+  if (!traj1.filled || !traj2.filled) return MAX_POINT_DISTANCE;
   
-  // Average the distances and normalize to 0-1 range
-  float avgDistance = totalDistance / traj1.size();
-  float positionSimilarity = 1.0 - (avgDistance / maxPossibleDistance);
+  float totalDistance = 0;
+  for (int i = 0; i < QUANTIZED_POINTS; i++) {
+    int dx = traj1.x[i] - traj2.x[i];
+    int dy = traj1.y[i] - traj2.y[i];
+    totalDistance += sqrtf((float)(dx*dx + dy*dy));
+  }
+  return totalDistance * QUANTIZED_STEP / QUANTIZED_POINTS;
+}
+
+/**
+ * Direction similarity on quantized paths
+ * The difference of two 8-bit angles, read as int8_t, is already wrapped
+ * to the shorter arc (-128 to 127 steps = -pi to just under pi).
+ */
+float HOT_CODE calculateDirectionSimilarity(const QuantizedPattern& traj1, const QuantizedPattern& traj2) {
+  if (!traj1.filled || !traj2.filled) return 0;
   
-  // Calculate direction similarity (how well the flow/direction matches)
+  int totalAngleDiff = 0;
+  for (int i = 0; i < QUANTIZED_POINTS - 1; i++) {
+    totalAngleDiff += abs((int8_t)(traj1.direction[i] - traj2.direction[i]));
+  }
+  return 1.0f - (float)totalAngleDiff / (128 * (QUANTIZED_POINTS - 1));
+}
+
+float HOT_CODE calculateSimilarity(const QuantizedPattern& traj1, const QuantizedPattern& traj2) {
+  if (!traj1.filled || !traj2.filled) return 0;
+  float positionSimilarity = 1.0f - averagePointDistance(traj1, traj2) / MAX_POINT_DISTANCE;
   float directionSimilarity = calculateDirectionSimilarity(traj1, traj2);
+  return max(0.0f, positionSimilarity * POSITION_WEIGHT + directionSimilarity * DIRECTION_WEIGHT);
+}
+
+/**
+ * Reduce a path to CHAIN_LENGTH direction symbols
+ * Zero-length segments (repeated points) repeat the previous symbol
+ * rather than reading atan2(0, 0) as "east".
+ */
+void HOT_CODE computeChainSymbols(const std::vector<Point>& traj, uint8_t symbols[CHAIN_LENGTH]) {
+  computeChainSymbols(traj, symbols, CHAIN_LENGTH);
+}
+
+/**
+ * Reduce a path to count direction symbols
+ * As computeChainSymbols(), at any resolution (prefix ranking compares a
+ * partial gesture against the first count symbols of a template).
+ */
+void HOT_CODE computeChainSymbols(const std::vector<Point>& traj, uint8_t* symbols, int count) {
+  std::vector<Point> path = resampleTrajectory(traj, count + 1);
+  const float sectorWidth = 2 * M_PI / CHAIN_DIRECTIONS;
+  uint8_t previous = 0;
   
-  // Combined score: weighted average
-  // 60% position (shape) + 40% direction (flow)
-  // This weighting was chosen to prioritize overall shape while still
-  // distinguishing between gestures drawn in opposite directions
-  float combinedSimilarity = (positionSimilarity * 0.6) + (directionSimilarity * 0.4);
+  for (int i = 0; i < count; i++) {
+    float dx = path[i+1].x - path[i].x;
+    float dy = path[i+1].y - path[i].y;
+    if (dx == 0 && dy == 0) {
+      symbols[i] = previous;
+      continue;
+    }
+    // Same segment angle as calculateDirectionSimilarity(), in sectors
+    int sector = (int)lroundf((atan2(dy, dx) + M_PI) / sectorWidth);
+    symbols[i] = previous = sector % CHAIN_DIRECTIONS;
+  }
+}
+
+/**
+ * Build the chain-code template of a path
+ * peq[d] marks the template positions a gesture symbol d matches: the
+ * symbol's own sector and its two neighbours, so a stroke straddling a
+ * sector boundary doesn't cost an edit.
+ */
+ChainCode computeChainCode(const std::vector<Point>& traj) {
+  uint8_t symbols[CHAIN_LENGTH];
+  computeChainSymbols(traj, symbols);
   
-  return max(0.0f, combinedSimilarity);
+  ChainCode code;
+  for (int i = 0; i < CHAIN_LENGTH; i++) {
+    uint64_t bit = 1ULL << i;
+    code.peq[symbols[i]] |= bit;
+    code.peq[(symbols[i] + 1) % CHAIN_DIRECTIONS] |= bit;
+    code.peq[(symbols[i] + CHAIN_DIRECTIONS - 1) % CHAIN_DIRECTIONS] |= bit;
+  }
+  return code;
 }
 
 /**
- * Attempt to match a drawn gesture against all known spell patterns
- * This is the main entry point for spell recognition. It takes a raw trajectory
- * from the IR camera and compares it against all predefined spell patterns to
- * find the best match.
- * Process:
- * 1. Validate trajectory has minimum points
- * 2. Normalize and resample user's gesture to standard form
- * 3. Compare against each spell pattern (also normalized and resampled)
- * 4. Find the spell with highest similarity score
- * 5. Check if best match exceeds threshold (defined in spell_matching.h)
- * 6. Output result to serial for debugging and UI display
- * currentTrajectory: The raw trajectory points captured from IR tracking
+ * Bit-parallel Levenshtein distance (Myers 1999, Hyyrö's formulation)
+ * Pv/Mv hold the vertical +1/-1 deltas of the current DP column, one bit
+ * per template symbol. Each gesture symbol advances the column with a
+ * handful of word operations; the score tracks the bottom cell. Shifting
+ * a 1 into Ph makes it a global (whole-template vs whole-gesture)
+ * distance rather than a substring search.
  */
-void matchSpell(const std::vector<Point>& currentTrajectory) {
-  // Reject trajectories that are too short to be meaningful gestures
-  if (currentTrajectory.size() < MIN_TRAJECTORY_POINTS) {
-    Serial.println("SPELL: Too short");
-    return;
+uint8_t HOT_CODE chainEditDistance(const uint8_t symbols[CHAIN_LENGTH], const ChainCode& pattern) {
+  const uint64_t lastBit = 1ULL << (CHAIN_LENGTH - 1);
+  uint64_t Pv = ~0ULL;
+  uint64_t Mv = 0;
+  int score = CHAIN_LENGTH;
+  
+  for (int j = 0; j < CHAIN_LENGTH; j++) {
+    uint64_t Eq = pattern.peq[symbols[j]];
+    uint64_t Xv = Eq | Mv;
+    uint64_t Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+    uint64_t Ph = Mv | ~(Xh | Pv);
+    uint64_t Mh = Pv & Xh;
+    if (Ph & lastBit) {
+      score++;
+    } else if (Mh & lastBit) {
+      score--;
+    }
+    Ph = (Ph << 1) | 1;
+    Mh <<= 1;
+    Pv = Mh | ~(Xv | Ph);
+    Mv = Ph & Xv;
   }
+  return (uint8_t)score;
+}
+
+/**
+ * Chain-code similarity
+ * Linear in edit distance, clamped at 0 beyond CHAIN_DISTANCE_SCALE.
+ */
+float HOT_CODE calculateChainSimilarity(const uint8_t symbols[CHAIN_LENGTH], const ChainCode& pattern) {
+  float distance = chainEditDistance(symbols, pattern);
+  return max(0.0f, 1.0f - distance / CHAIN_DISTANCE_SCALE);
+}
+
+/**
+ * One greedy $P matching pass
+ * Points of `from` are taken in order starting at `start`; each is paired
+ * with its nearest still-unmatched point of `to`. Earlier pairs weigh more
+ * (weight 1 - k/n), as in the $P recognizer.
+ * bound: Stop early once the weighted sum reaches this
+ * return Weighted sum of matched distances (>= bound if abandoned)
+ */
+static float HOT_CODE greedyCloudDistance(const std::vector<Point>& from, const std::vector<Point>& to,
+                                 size_t start, float bound) {
+  const size_t n = from.size();
+  bool matched[CLOUD_POINTS] = {false};
+  float sum = 0;
   
-  // Prepare the user's gesture for comparison:
-  // - Normalize to standard 0-1000 coordinate space (scale/translation invariant)
-  // - Resample to exactly RESAMPLE_POINTS evenly-spaced points (consistent comparison)
-  std::vector<Point> normalized = normalizeTrajectory(currentTrajectory);
-  std::vector<Point> resampled = resampleTrajectory(normalized, RESAMPLE_POINTS);
+  for (size_t k = 0; k < n; k++) {
+    const Point& p = from[(start + k) % n];
+    float minDist = FLT_MAX;
+    size_t index = 0;
+    for (size_t j = 0; j < n; j++) {
+      if (matched[j]) continue;
+      float dx = p.x - to[j].x;
+      float dy = p.y - to[j].y;
+      float d = sqrtf(dx*dx + dy*dy);
+      if (d < minDist) {
+        minDist = d;
+        index = j;
+      }
+    }
+    matched[index] = true;
+    sum += (1.0f - (float)k / n) * minDist;
+    if (sum >= bound) break;  // Can't beat the best pass so far
+  }
+  return sum;
+}
+
+/**
+ * Lower bound on greedyCloudDistance() for a start point
+ * Any pairing is at least as far as each point's unconstrained nearest
+ * neighbour, so weighting those distances the same way gives a bound.
+ * nearest: Nearest-neighbour distance for each point of the `from` cloud
+ */
+static float HOT_CODE cloudLowerBound(const float* nearest, size_t n, size_t start) {
+  float bound = 0;
+  for (size_t k = 0; k < n; k++) {
+    bound += (1.0f - (float)k / n) * nearest[(start + k) % n];
+  }
+  return bound;
+}
+
+/**
+ * Calculate point-cloud similarity between two clouds
+ * Tries start points every sqrt(n) points, matching cloud1 onto cloud2 and
+ * cloud2 onto cloud1, and keeps the cheapest pass. Start points whose
+ * lower bound can't beat the current best are skipped, and the best is
+ * seeded from minSimilarity so hopeless templates are abandoned outright.
+ * cloud1: First cloud (CLOUD_POINTS points, normalized)
+ * cloud2: Second cloud (CLOUD_POINTS points, normalized)
+ * minSimilarity: Scores below this are reported as 0
+ * return Similarity score from 0 (no match) to 1 (identical clouds)
+ */
+float HOT_CODE calculateCloudSimilarity(const std::vector<Point>& cloud1, const std::vector<Point>& cloud2,
+                               float minSimilarity) {
+  const size_t n = CLOUD_POINTS;
+  if (cloud1.size() != n || cloud2.size() != n) return 0;
   
-  // Calculate gesture duration for debugging/display
-  // (not used in matching - we removed speed constraints)
-  uint32_t duration = currentTrajectory.back().timestamp - currentTrajectory.front().timestamp;
+  // Sum of weights (1 - k/n) over k = 0..n-1
+  const float weightSum = (n + 1) / 2.0f;
   
-  // Compare against all known spell patterns
-  // Find the spell with the highest similarity score
-  // Note: Spell patterns are already normalized and resampled to 40 points during initialization
-  float bestMatch = 0;
-  const char* bestSpell = "Unknown";
+  // Weighted distance that corresponds to minSimilarity
+  const float bound = (1.0f - max(0.0f, minSimilarity)) * CLOUD_DISTANCE_SCALE * weightSum;
   
-  Serial.println("=== Spell Matching Results ===");
+  // Nearest-neighbour distances in both directions (one n^2 pass)
+  float nearest1[CLOUD_POINTS];
+  float nearest2[CLOUD_POINTS];
+  for (size_t i = 0; i < n; i++) {
+    nearest1[i] = FLT_MAX;
+    nearest2[i] = FLT_MAX;
+  }
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      float dx = cloud1[i].x - cloud2[j].x;
+      float dy = cloud1[i].y - cloud2[j].y;
+      float d = sqrtf(dx*dx + dy*dy);
+      nearest1[i] = min(nearest1[i], d);
+      nearest2[j] = min(nearest2[j], d);
+    }
+  }
   
-  for (const auto& spell : spellPatterns) {
-    // Calculate position similarity separately for diagnostics
-    float totalDistance = 0;
-    float maxPossibleDistance = 1414.0;
-    for (size_t i = 0; i < resampled.size(); i++) {
-      float dx = resampled[i].x - spell.pattern[i].x;
-      float dy = resampled[i].y - spell.pattern[i].y;
-      totalDistance += sqrt(dx*dx + dy*dy);
+  float best = bound;
+  const size_t step = max((size_t)1, (size_t)sqrtf(n));
+  for (size_t start = 0; start < n; start += step) {
+    if (cloudLowerBound(nearest1, n, start) < best) {
+      best = min(best, greedyCloudDistance(cloud1, cloud2, start, best));
     }
-    float avgDistance = totalDistance / resampled.size();
-    float positionSimilarity = 1.0 - (avgDistance / maxPossibleDistance);
-    
-    // Calculate direction similarity for diagnostics
-    float directionSimilarity = calculateDirectionSimilarity(resampled, spell.pattern);
-    
-    // Combined similarity
-    float similarity = (positionSimilarity * 0.6) + (directionSimilarity * 0.4);
+    if (cloudLowerBound(nearest2, n, start) < best) {
+      best = min(best, greedyCloudDistance(cloud2, cloud1, start, best));
+    }
+  }
+  
+  if (best >= bound) return 0;  // Abandoned: below minSimilarity
+  
+  float avgDistance = best / weightSum;
+  return max(0.0f, 1.0f - avgDistance / CLOUD_DISTANCE_SCALE);
+}
+
+//=====================================
+// Shape Signature Prefilter
+//=====================================
+
+/**
+ * Grid cell of a normalized point (8x8 over 0-1000)
+ */
+static uint8_t HOT_CODE signatureCell(const Point& p) {
+  int col = constrain(p.x * 8 / 1001, 0, 7);
+  int row = constrain(p.y * 8 / 1001, 0, 7);
+  return (uint8_t)(row * 8 + col);
+}
+
+/**
+ * Grow an 8x8 occupancy grid by one cell in all eight directions
+ * Column shifts mask off the wrapped edge column.
+ */
+static uint64_t HOT_CODE dilateGrid(uint64_t grid) {
+  const uint64_t notColumn0 = 0xFEFEFEFEFEFEFEFEULL;  // Clears bits shifted into column 0
+  const uint64_t notColumn7 = 0x7F7F7F7F7F7F7F7FULL;  // Clears bits shifted into column 7
+  uint64_t horizontal = grid | ((grid << 1) & notColumn0) | ((grid >> 1) & notColumn7);
+  return horizontal | (horizontal << 8) | (horizontal >> 8);
+}
+
+/**
+ * Compute the shape signature of a normalized, resampled path
+ * Resampled points are evenly spaced well under one cell apart, so marking
+ * the cell of each point traces the whole path.
+ */
+ShapeSignature HOT_CODE computeSignature(const std::vector<Point>& traj) {
+  ShapeSignature sig;
+  if (traj.empty()) return sig;
+  
+  float sectorLength[8] = {0};
+  float totalLength = 0;
+  
+  for (size_t i = 0; i < traj.size(); i++) {
+    sig.occupancy |= 1ULL << signatureCell(traj[i]);
     
-    // Print detailed breakdown
-    Serial.printf("  %s: %.2f%% (pos: %.2f%%, dir: %.2f%%)\n", 
-                  spell.name, similarity * 100, positionSimilarity * 100, directionSimilarity * 100);
+    // Directions over SIGNATURE_DIRECTION_STRIDE points, so jitter between
+    // neighbouring points doesn't light up spurious sectors
+    if (i < SIGNATURE_DIRECTION_STRIDE || i % SIGNATURE_DIRECTION_STRIDE != 0) continue;
+    float dx = traj[i].x - traj[i - SIGNATURE_DIRECTION_STRIDE].x;
+    float dy = traj[i].y - traj[i - SIGNATURE_DIRECTION_STRIDE].y;
+    float length = sqrtf(dx*dx + dy*dy);
+    if (length == 0) continue;
     
-    // Track the best match found so far
-    if (similarity > bestMatch) {
-      bestMatch = similarity;
-      bestSpell = spell.name;
+    // Sector 0 = +X, counting 45° steps toward +Y
+    int sector = (int)lroundf(atan2f(dy, dx) / (float)(M_PI / 4)) & 7;
+    sectorLength[sector] += length;
+    totalLength += length;
+  }
+  
+  sig.dilated = dilateGrid(sig.occupancy);
+  sig.startCell = signatureCell(traj.front());
+  sig.endCell = signatureCell(traj.back());
+  for (int s = 0; s < 8; s++) {
+    if (totalLength > 0 && sectorLength[s] >= SIGNATURE_DIRECTION_SHARE * totalLength) {
+      sig.directions |= 1 << s;
+    }
+  }
+  return sig;
+}
+
+/**
+ * Grow a direction-sector mask by one sector each way (cyclic)
+ */
+static uint8_t HOT_CODE dilateSectors(uint8_t sectors) {
+  return sectors | (uint8_t)((sectors << 1) | (sectors >> 7)) | (uint8_t)((sectors >> 1) | (sectors << 7));
+}
+
+/**
+ * Chebyshev distance between two grid cells
+ */
+static int HOT_CODE cellDistance(uint8_t a, uint8_t b) {
+  return max(abs((a & 7) - (b & 7)), abs((a >> 3) - (b >> 3)));
+}
+
+/**
+ * Distance between two shape signatures
+ * Occupancy is compared against the other side's dilated grid, so a path
+ * shifted by up to one cell costs nothing.
+ */
+uint8_t HOT_CODE signatureDistance(const ShapeSignature& a, const ShapeSignature& b, bool anyOrder) {
+  int distance = __builtin_popcountll(a.occupancy & ~b.dilated) +
+                 __builtin_popcountll(b.occupancy & ~a.dilated);
+  if (!anyOrder) {
+    distance += __builtin_popcount(a.directions & (uint8_t)~dilateSectors(b.directions)) +
+                __builtin_popcount(b.directions & (uint8_t)~dilateSectors(a.directions));
+    if (cellDistance(a.startCell, b.startCell) > 1) distance += 2;
+    if (cellDistance(a.endCell, b.endCell) > 1) distance += 2;
+  }
+  return (uint8_t)min(distance, 255);
+}
+
+size_t HOT_CODE exemplarCount(const SpellPattern& spell) {
+  return 1 + spell.alternates.size();
+}
+
+const MatchTemplate& HOT_CODE exemplarTemplate(const SpellPattern& spell, size_t exemplar) {
+#ifdef QUANTIZED_TEMPLATES
+  return exemplar == 0 ? spell.quantized : spell.alternates[exemplar - 1].quantized;
+#else
+  return exemplar == 0 ? spell.pattern : spell.alternates[exemplar - 1].pattern;
+#endif
+}
+
+const std::vector<Point>& HOT_CODE exemplarCloud(const SpellPattern& spell, size_t exemplar) {
+  return exemplar == 0 ? spell.cloud : spell.alternates[exemplar - 1].cloud;
+}
+
+const ShapeSignature& HOT_CODE exemplarSignature(const SpellPattern& spell, size_t exemplar) {
+  return exemplar == 0 ? spell.signature : spell.alternates[exemplar - 1].signature;
+}
+
+const ChainCode& HOT_CODE exemplarChain(const SpellPattern& spell, size_t exemplar) {
+  return exemplar == 0 ? spell.chain : spell.alternates[exemplar - 1].chain;
+}
+
+bool HOT_CODE exemplarMatchable(const SpellPattern& spell, size_t exemplar) {
+#ifdef QUANTIZED_TEMPLATES
+  return exemplarTemplate(spell, exemplar).filled;
+#else
+  return exemplarTemplate(spell, exemplar).size() == RESAMPLE_POINTS;
+#endif
+}
+
+std::vector<Point> exemplarPoints(const SpellPattern& spell, size_t exemplar) {
+#ifdef QUANTIZED_TEMPLATES
+  return dequantizePattern(exemplarTemplate(spell, exemplar));
+#else
+  return exemplarTemplate(spell, exemplar);
+#endif
+}
+
+/**
+ * Score a gesture against one exemplar of a spell
+ * Ordered spells use calculateSimilarity(); anyOrder spells use cloud
+ * matching, building the gesture's cloud on first use so it is shared
+ * across all cloud templates in one search.
+ */
+float HOT_CODE scoreExemplar(const SpellPattern& spell, size_t exemplar, const std::vector<Point>& resampled,
+                    std::vector<Point>& cloud, float minSimilarity) {
+  const std::vector<Point>& templateCloud = exemplarCloud(spell, exemplar);
+  if (spell.anyOrder && !templateCloud.empty()) {
+    if (cloud.empty()) {
+      cloud = resampleTrajectory(resampled, CLOUD_POINTS);
+    }
+    return calculateCloudSimilarity(cloud, templateCloud, minSimilarity);
+  }
+#ifdef QUANTIZED_TEMPLATES
+  return calculateSimilarity(quantizePattern(resampled), exemplarTemplate(spell, exemplar));
+#else
+  return calculateSimilarity(resampled, exemplarTemplate(spell, exemplar));
+#endif
+}
+
+/**
+ * Score a gesture against one library spell (best exemplar)
+ * Later cloud exemplars only need to beat the best so far, so they are
+ * abandoned early once they can't.
+ */
+float HOT_CODE scoreSpell(const SpellPattern& spell, const std::vector<Point>& resampled,
+                 std::vector<Point>& cloud, float minSimilarity) {
+  float best = 0;
+  for (size_t e = 0; e < exemplarCount(spell); e++) {
+    float similarity = scoreExemplar(spell, e, resampled, cloud, max(minSimilarity, best));
+    best = max(best, similarity);
+    if (best >= SPELL_EXEMPLAR_EARLY_EXIT) break;
+  }
+  return best;
+}
+
+/**
+ * Bring one pattern into matching form and build its signature/chain/cloud
+ * Works on a SpellPattern or a SpellExemplar (same member names).
+ * Quantized builds then swap the Point vector for the 8-bit template,
+ * restoring it first if the exemplar was already finalized.
+ */
+template <typename Exemplar>
+static void finalizeExemplar(Exemplar& exemplar, bool anyOrder) {
+#ifdef QUANTIZED_TEMPLATES
+  if (exemplar.pattern.empty() && exemplar.quantized.filled) {
+    exemplar.pattern = dequantizePattern(exemplar.quantized);
+  }
+#endif
+  std::vector<Point>& pattern = exemplar.pattern;
+  pattern = resampleTrajectory(normalizeTrajectory(pattern), RESAMPLE_POINTS);
+  exemplar.signature = computeSignature(pattern);
+  exemplar.chain = computeChainCode(pattern);
+  exemplar.cloud.clear();
+  if (anyOrder) {
+    exemplar.cloud = resampleTrajectory(pattern, CLOUD_POINTS);
+  }
+#ifdef QUANTIZED_TEMPLATES
+  exemplar.quantized = quantizePattern(pattern);
+  std::vector<Point>().swap(pattern);  // Release the Point copy
+#endif
+}
+
+/**
+ * Prepare a library spell for matching
+ * Brings the pattern and alternates into the normalized, resampled form
+ * that gestures are compared in, then builds point clouds if the spell is
+ * order-free.
+ */
+void finalizeSpellPattern(SpellPattern& spell) {
+  finalizeExemplar(spell, spell.anyOrder);
+  for (auto& alternate : spell.alternates) {
+    finalizeExemplar(alternate, spell.anyOrder);
+  }
+}
+
+/**
+ * Pick k representative takes by k-medoid clustering
+ * Takes are few (a handful of recordings), so the full pairwise distance
+ * matrix is computed up front.
+ */
+std::vector<size_t> selectMedoids(const std::vector<std::vector<Point>>& takes, size_t k, bool anyOrder) {
+  size_t n = takes.size();
+  k = min(k, n);
+  std::vector<size_t> medoids;
+  if (k == 0) return medoids;
+  
+  // Pairwise distances: 1 - matcher similarity
+  std::vector<std::vector<Point>> clouds;
+  if (anyOrder) {
+    for (const auto& take : takes) clouds.push_back(resampleTrajectory(take, CLOUD_POINTS));
+  }
+  std::vector<float> distance(n * n, 0);
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = i + 1; j < n; j++) {
+      float similarity = anyOrder ? calculateCloudSimilarity(clouds[i], clouds[j])
+                                  : calculateSimilarity(takes[i], takes[j]);
+      distance[i * n + j] = distance[j * n + i] = 1.0f - similarity;
     }
   }
   
-  Serial.println("==============================");
+  // Distance from each take to its nearest medoid
+  std::vector<float> nearest(n, FLT_MAX);
+  auto totalCostWith = [&](size_t candidate) {
+    float cost = 0;
+    for (size_t i = 0; i < n; i++) cost += min(nearest[i], distance[i * n + candidate]);
+    return cost;
+  };
   
-  // Output result to serial for debugging
-  // MATCH_THRESHOLD is typically 0.7 (70% similarity required)
+  // Build: greedily add the take that most reduces total distance
+  // (the first pick is the take closest to all others)
+  std::vector<bool> isMedoid(n, false);
+  while (medoids.size() < k) {
+    size_t bestTake = 0;
+    float bestCost = FLT_MAX;
+    for (size_t c = 0; c < n; c++) {
+      if (isMedoid[c]) continue;
+      float cost = totalCostWith(c);
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestTake = c;
+      }
+    }
+    medoids.push_back(bestTake);
+    isMedoid[bestTake] = true;
+    for (size_t i = 0; i < n; i++) nearest[i] = min(nearest[i], distance[i * n + bestTake]);
+  }
+  
+  // Refine: assign takes to their nearest medoid, then move each medoid
+  // to the member of its cluster with the least total distance
+  std::vector<size_t> cluster(n, 0);
+  for (int iteration = 0; iteration < MEDOID_MAX_ITERATIONS; iteration++) {
+    for (size_t i = 0; i < n; i++) {
+      cluster[i] = 0;
+      for (size_t m = 1; m < k; m++) {
+        if (distance[i * n + medoids[m]] < distance[i * n + medoids[cluster[i]]]) cluster[i] = m;
+      }
+    }
+    bool changed = false;
+    for (size_t m = 0; m < k; m++) {
+      size_t bestTake = medoids[m];
+      float bestCost = FLT_MAX;
+      for (size_t c = 0; c < n; c++) {
+        if (cluster[c] != m) continue;
+        float cost = 0;
+        for (size_t i = 0; i < n; i++) {
+          if (cluster[i] == m) cost += distance[i * n + c];
+        }
+        if (cost < bestCost) {
+          bestCost = cost;
+          bestTake = c;
+        }
+      }
+      if (bestTake != medoids[m]) {
+        medoids[m] = bestTake;
+        changed = true;
+      }
+    }
+    if (!changed) break;
+  }
+  
+  // Most central first (the primary pattern is the best single stand-in)
+  auto centrality = [&](size_t take) {
+    float cost = 0;
+    for (size_t i = 0; i < n; i++) cost += distance[i * n + take];
+    return cost;
+  };
+  std::sort(medoids.begin(), medoids.end(),
+            [&](size_t a, size_t b) { return centrality(a) < centrality(b); });
+  return medoids;
+}
+
+/**
+ * Set a spell's exemplars from recorded takes
+ */
+void compactSpellTakes(SpellPattern& spell, const std::vector<std::vector<Point>>& takes) {
+  std::vector<std::vector<Point>> prepared;
+  for (const auto& take : takes) {
+    if (take.size() < 2) continue;
+    prepared.push_back(resampleTrajectory(normalizeTrajectory(take), RESAMPLE_POINTS));
+  }
+  spell.alternates.clear();
+  if (prepared.empty()) {
+    spell.pattern.clear();
+#ifdef QUANTIZED_TEMPLATES
+    spell.quantized = QuantizedPattern();
+#endif
+    return;
+  }
+  
+  std::vector<size_t> keep = selectMedoids(prepared, SPELL_MAX_EXEMPLARS, spell.anyOrder);
+  spell.pattern = prepared[keep[0]];
+  for (size_t i = 1; i < keep.size(); i++) {
+    SpellExemplar alternate;
+    alternate.pattern = prepared[keep[i]];
+    spell.alternates.push_back(alternate);
+  }
+  finalizeSpellPattern(spell);
+}
+
+/**
+ * Find the best-scoring spell for a prepared gesture
+ * Ordered spells come from the spell index (only templates that could
+ * reach MATCH_THRESHOLD are scored); cloud spells that pass the signature
+ * prefilter are scanned. Callers still compare the returned score against
+ * MATCH_THRESHOLD (or a stricter threshold of their own).
+ * resampled: Gesture normalized and resampled to RESAMPLE_POINTS
+ * bestMatch: Output similarity of the best spell
+ * return ID of the best spell, or SPELL_ID_NONE if nothing was scored
+ */
+SpellId HOT_CODE findBestSpellId(const std::vector<Point>& resampled, float& bestMatch) {
+  bestMatch = 0;
+  SpellId bestSpell = SPELL_ID_NONE;
+  std::vector<Point> cloud;  // Built on first cloud template
+  ShapeSignature signature = computeSignature(resampled);
+  
+  if (CHAIN_MATCHING) {
+    // Ordered spells by chain code: a few word operations per symbol, so
+    // a linear scan (the index's pruning radius is for the point metric)
+    uint8_t symbols[CHAIN_LENGTH];
+    computeChainSymbols(resampled, symbols);
+    for (size_t s = 0; s < spellPatterns.size(); s++) {
+      const SpellPattern& spell = spellPatterns[s];
+      if (spell.anyOrder) continue;
+      for (size_t e = 0; e < exemplarCount(spell); e++) {
+        if (signatureDistance(signature, exemplarSignature(spell, e), false) > SIGNATURE_MAX_DISTANCE) {
+          continue;
+        }
+        float similarity = calculateChainSimilarity(symbols, exemplarChain(spell, e));
+        if (similarity > bestMatch) {
+          bestMatch = similarity;
+          bestSpell = (SpellId)s;
+        }
+        if (similarity >= SPELL_EXEMPLAR_EARLY_EXIT) break;
+      }
+    }
+  } else {
+    // Ordered spells: vantage-point tree search
+    int indexed = searchSpellIndex(resampled, signature, bestMatch);
+    if (indexed >= 0) bestSpell = (SpellId)indexed;
+  }
+  
+  // Cloud spells aren't in the index - scan their exemplars, pruned by
+  // the best so far
+  for (size_t s = 0; s < spellPatterns.size(); s++) {
+    const SpellPattern& spell = spellPatterns[s];
+    if (!spell.anyOrder) continue;
+    for (size_t e = 0; e < exemplarCount(spell); e++) {
+      if (signatureDistance(signature, exemplarSignature(spell, e), true) > SIGNATURE_MAX_DISTANCE) {
+        continue;  // Shape too different to be worth scoring
+      }
+      float similarity = scoreExemplar(spell, e, resampled, cloud, bestMatch);
+      if (similarity > bestMatch) {
+        bestMatch = similarity;
+        bestSpell = (SpellId)s;
+      }
+      if (similarity >= SPELL_EXEMPLAR_EARLY_EXIT) break;  // Spell's other takes can't matter
+    }
+  }
+  return bestSpell;
+}
+
+/**
+ * Find the best-scoring spell for a prepared gesture, by name
+ * return Name of the best spell, or "Unknown" if nothing was scored
+ */
+const char* findBestSpell(const std::vector<Point>& resampled, float& bestMatch) {
+  return spellName(findBestSpellId(resampled, bestMatch));
+}
+
+/**
+ * Rank spells by how well a partial gesture matches their beginning
+ * Template prefixes of PREFIX_RANK_STEPS lengths are tried; the partial
+ * path is reduced to as many symbols as each prefix and scored by the
+ * share of positions whose symbol the template accepts (its own sector or
+ * a neighbour). A spell scores its best prefix over all exemplars.
+ * The partial is not normalized: templates are, but a partial's bounding
+ * box says little about the finished gesture's, and raw directions are
+ * closer for roughly square spells.
+ */
+size_t HOT_CODE rankSpellPrefixes(const std::vector<Point>& partial, SpellId* ids, float* scores, size_t maxCount) {
+  if (partial.size() < 2 || maxCount == 0) return 0;
+  
+  // Partial path at each prefix resolution
+  uint8_t symbols[PREFIX_RANK_STEPS][CHAIN_LENGTH];
+  int lengths[PREFIX_RANK_STEPS];
+  for (int step = 0; step < PREFIX_RANK_STEPS; step++) {
+    lengths[step] = CHAIN_LENGTH * (step + 1) / PREFIX_RANK_STEPS;
+    computeChainSymbols(partial, symbols[step], lengths[step]);
+  }
+  
+  size_t ranked = 0;
+  for (size_t s = 0; s < spellPatterns.size(); s++) {
+    const SpellPattern& spell = spellPatterns[s];
+    if (spell.anyOrder) continue;  // No stroke order, so no meaningful prefix
+    
+    float best = 0;
+    for (size_t e = 0; e < exemplarCount(spell); e++) {
+      const ChainCode& chain = exemplarChain(spell, e);
+      for (int step = 0; step < PREFIX_RANK_STEPS; step++) {
+        int agree = 0;
+        for (int i = 0; i < lengths[step]; i++) {
+          agree += (chain.peq[symbols[step][i]] >> i) & 1;
+        }
+        best = max(best, (float)agree / lengths[step]);
+      }
+    }
+    
+    // Insert into the top maxCount, highest first
+    size_t pos = ranked;
+    while (pos > 0 && scores[pos - 1] < best) pos--;
+    if (pos >= maxCount) continue;
+    if (ranked < maxCount) ranked++;
+    for (size_t i = ranked - 1; i > pos; i--) {
+      ids[i] = ids[i - 1];
+      scores[i] = scores[i - 1];
+    }
+    ids[pos] = (SpellId)s;
+    scores[pos] = best;
+  }
+  return ranked;
+}
+
+/**
+ * Summary line of matchSpell()
+ * MATCH_THRESHOLD is typically 0.7 (70% similarity required)
+ */
+static void logMatchResult(const char* bestSpell, float bestMatch, size_t points, uint32_t duration) {
   if (bestMatch >= MATCH_THRESHOLD) {
-    Serial.printf("SPELL: %s (%.2f%% match, %d points, %dms)\n", 
-                  bestSpell, bestMatch * 100, currentTrajectory.size(), duration);
+    LOG_ALWAYS("SPELL: %s (%.2f%% match, %d points, %dms)", bestSpell, bestMatch * 100, points, duration);
   } else {
-    Serial.printf("SPELL: No match (best: %s %.2f%%)\n", bestSpell, bestMatch * 100);
+    LOG_ALWAYS("SPELL: No match (best: %s %.2f%%)", bestSpell, bestMatch * 100);
+  }
+}
+
+/**
+ * Log the recognizer's answer for a drawn gesture
+ * The caller has already searched the library once; this prints the
+ * summary line and, only with debug logging on, a per-template breakdown
+ * (the one place every template is scored).
+ * currentTrajectory: The raw trajectory points captured from IR tracking
+ * resampled: The same gesture normalized and resampled, as searched
+ * bestSpell: Best spell found by findBestSpellId()
+ * bestMatch: Its score
+ */
+void matchSpell(const std::vector<Point>& currentTrajectory, const std::vector<Point>& resampled,
+                SpellId bestSpell, float bestMatch) {
+  // Calculate gesture duration for debugging/display
+  // (not used in matching - we removed speed constraints)
+  uint32_t duration = currentTrajectory.empty() ? 0 :
+      currentTrajectory.back().timestamp - currentTrajectory.front().timestamp;
+  
+  // The per-template breakdown is only for the log
+  if (!LOG_ENABLED(LOG_LEVEL_DEBUG)) {
+    logMatchResult(spellName(bestSpell), bestMatch, currentTrajectory.size(), duration);
+    return;
   }
+  
+  LOG_DEBUG("=== Spell Matching Results ===");
+  
+  std::vector<Point> cloud;  // Built on first cloud template
+  ShapeSignature signature = computeSignature(resampled);
+  uint8_t symbols[CHAIN_LENGTH];
+  computeChainSymbols(resampled, symbols);
+#ifdef QUANTIZED_TEMPLATES
+  QuantizedPattern gesture = quantizePattern(resampled);
+#else
+  const std::vector<Point>& gesture = resampled;
+#endif
+  for (const auto& spell : spellPatterns) {
+    // One line per exemplar (take), numbered when a spell has several.
+    // Signature distance is printed for calibrating SIGNATURE_MAX_DISTANCE;
+    // every exemplar is still scored here so rejected ones can be checked
+    for (size_t e = 0; e < exemplarCount(spell); e++) {
+      const MatchTemplate& pattern = exemplarTemplate(spell, e);
+      int sigDistance = signatureDistance(signature, exemplarSignature(spell, e), spell.anyOrder);
+      const char* sigMark = (sigDistance > SIGNATURE_MAX_DISTANCE) ? " REJECT" : "";
+      char label[48];
+      if (exemplarCount(spell) > 1) {
+        snprintf(label, sizeof(label), "%s #%d", spell.name, (int)e + 1);
+      } else {
+        snprintf(label, sizeof(label), "%s", spell.name);
+      }
+      
+      if (spell.anyOrder) {
+        // Point-cloud spell - no position/direction breakdown
+        float similarity = scoreExemplar(spell, e, resampled, cloud);
+        LOG_DEBUG("  %s: %.2f%% (cloud, sig: %d%s)", label, similarity * 100, sigDistance, sigMark);
+        continue;
+      }
+      
+      // Calculate position similarity separately for diagnostics
+      float avgDistance = averagePointDistance(gesture, pattern);
+      float positionSimilarity = 1.0 - (avgDistance / MAX_POINT_DISTANCE);
+      
+      // Calculate direction similarity for diagnostics
+      float directionSimilarity = calculateDirectionSimilarity(gesture, pattern);
+      
+      // Combined similarity, or chain-code similarity in CHAIN_MATCHING mode
+      // (the other is printed alongside for comparison)
+      float pointSimilarity = (positionSimilarity * POSITION_WEIGHT) + (directionSimilarity * DIRECTION_WEIGHT);
+      float chainSimilarity = calculateChainSimilarity(symbols, exemplarChain(spell, e));
+      float similarity = CHAIN_MATCHING ? chainSimilarity : pointSimilarity;
+      
+      // Print detailed breakdown
+      LOG_DEBUG("  %s: %.2f%% (pos: %.2f%%, dir: %.2f%%, chain: %.2f%%, sig: %d%s)",
+                label, similarity * 100, positionSimilarity * 100, directionSimilarity * 100,
+                chainSimilarity * 100, sigDistance, sigMark);
+    }
+  }
+  
+  // Index effectiveness: templates the caller's search actually visited
+  if (!CHAIN_MATCHING) {
+    LOG_DEBUG("  (index visited %d of %d ordered templates, %s)",
+              lastIndexEvaluations(), spellIndexSize(),
+              lastIndexSearchParallel() ? "dual-core" : "single-core");
+  }
+  
+  LOG_DEBUG("==============================");
+  
+  logMatchResult(spellName(bestSpell), bestMatch, currentTrajectory.size(), duration);
 }
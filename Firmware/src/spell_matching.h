@@ -16,6 +16,8 @@
   Tunable Parameters:
     - MIN_TRAJECTORY_POINTS: Minimum points required for valid gesture (50)
     - MATCH_THRESHOLD: Similarity threshold for successful match (0.70 = 70%)
+    - MATCH_THRESHOLD, RESAMPLE_POINTS and the position/direction weights
+      can be overridden with -D build flags (Tools/tuner emits these)
 ================================================================================
 */
 
@@ -30,8 +32,9 @@
 //=====================================
 
 /**
- * Minimum trajectory points required for valid gesture
- * Gestures with fewer points are rejected as "too short".
+ * Minimum captured samples required for valid gesture
+ * Gestures with fewer samples are rejected as "too short". Counted before
+ * online simplification, so it still reflects gesture duration.
  * Prevents accidental triggers from brief IR detections.
  */
 #define MIN_TRAJECTORY_POINTS 50
@@ -43,7 +46,9 @@
  * Lower values = more lenient matching, more false positives.
  * Current: 0.70 (70% similarity required)
  */
+#ifndef MATCH_THRESHOLD
 #define MATCH_THRESHOLD 0.75
+#endif
 
 /**
  * Number of points to resample trajectories to for matching
@@ -53,7 +58,106 @@
  * Recommended range: 20-50 points
  * Current: 50 points
  */
+#ifndef RESAMPLE_POINTS
 #define RESAMPLE_POINTS 100
+#endif
+
+/**
+ * Similarity weighting (see calculateSimilarity())
+ * Position similarity is 1 - average point distance / MAX_POINT_DISTANCE,
+ * the diagonal of the 1000x1000 normalized space. The weights should sum
+ * to 1 so scores stay on the MATCH_THRESHOLD scale.
+ */
+#ifndef POSITION_WEIGHT
+#define POSITION_WEIGHT 0.6f
+#endif
+#ifndef DIRECTION_WEIGHT
+#define DIRECTION_WEIGHT 0.4f
+#endif
+#define MAX_POINT_DISTANCE 1414.0f
+
+/**
+ * Number of points in a point-cloud template
+ * Spells with "order": "any" are matched as unordered clouds of this many
+ * points ($P recognizer). Cloud matching is O(n^2) per start point, so
+ * clouds are much sparser than RESAMPLE_POINTS.
+ */
+#define CLOUD_POINTS 32
+
+/**
+ * Cloud distance that maps to zero similarity
+ * Average matched-point distance (0-1000 space) is divided by this to get
+ * a 0-1 score comparable with calculateSimilarity(). Greedy matching pairs
+ * each point with a nearby partner, so distances run well below the
+ * index-matched ones and a smaller scale than the 1414 diagonal is used.
+ */
+#define CLOUD_DISTANCE_SCALE 700.0f
+
+/**
+ * Signature prefilter bound
+ * Templates whose signatureDistance() to the gesture exceeds this are
+ * rejected without scoring. Calibrated on the built-in spells drawn with
+ * ~15% shear/scale error and ~20px jitter: no correct match is lost and
+ * about half the templates are skipped. Lower it to skip more at the risk
+ * of rejecting sloppy casts; matchSpell() prints each template's distance
+ * (REJECT marks ones above the bound) for re-calibration.
+ */
+#define SIGNATURE_MAX_DISTANCE 12
+
+/**
+ * Minimum share of path length for a direction sector to count
+ * Sectors below this are treated as noise in the direction signature.
+ */
+#define SIGNATURE_DIRECTION_SHARE 0.12f
+
+/**
+ * Point spacing used for direction sectors in the signature
+ * Directions are taken between every Nth resampled point.
+ */
+#define SIGNATURE_DIRECTION_STRIDE 5
+
+/**
+ * Chain-code edit distance that maps to zero similarity
+ * Similarity in CHAIN_MATCHING mode is 1 - distance / this, so the score
+ * is comparable with calculateSimilarity() and MATCH_THRESHOLD applies
+ * unchanged (0.75 allows 16 edits out of CHAIN_LENGTH symbols). At that
+ * bound, match_bench (Tools/) accepts ~99% of clean casts of the built-in
+ * spells and none of the wrong spells, which come no closer than ~22.
+ */
+#define CHAIN_DISTANCE_SCALE 64.0f
+
+/**
+ * Template prefix lengths tried by rankSpellPrefixes()
+ * Prefixes of CHAIN_LENGTH * k / PREFIX_RANK_STEPS symbols, k = 1..steps.
+ */
+#define PREFIX_RANK_STEPS 4
+
+/**
+ * Normalized units per quantized grid step (QuantizedPattern)
+ * The 0-1000 box maps onto 0-255, so points are within ~2 units of
+ * their float position.
+ */
+#define QUANTIZED_STEP (1000.0f / 255.0f)
+
+/**
+ * Most exemplars (recorded takes) kept per spell
+ * Spells with more takes are compacted to this many medoids on load, so
+ * recording more takes improves coverage without growing the library or
+ * the match time beyond this bound.
+ */
+#define SPELL_MAX_EXEMPLARS 3
+
+/**
+ * Exemplar score that ends a spell's scoring early
+ * Once one exemplar scores this well, the spell's remaining exemplars
+ * are skipped (another take can't change the outcome meaningfully).
+ */
+#define SPELL_EXEMPLAR_EARLY_EXIT 0.9f
+
+/**
+ * Iteration cap for k-medoid refinement (compactSpellTakes())
+ */
+#define MEDOID_MAX_ITERATIONS 8
 
 //=====================================
 // Trajectory Processing Functions
@@ -101,23 +205,250 @@ float calculateDirectionSimilarity(const std::vector<Point>& traj1, const std::v
  */
 float calculateSimilarity(const std::vector<Point>& traj1, const std::vector<Point>& traj2);
 
+/**
+ * Average Euclidean distance between corresponding points
+ * The position term of calculateSimilarity(). A true metric, so it can
+ * drive triangle-inequality pruning in the spell index.
+ * traj1: First trajectory (normalized and resampled)
+ * traj2: Second trajectory (same number of points)
+ * return Average distance (0-1414 in normalized space)
+ */
+float averagePointDistance(const std::vector<Point>& traj1, const std::vector<Point>& traj2);
+
+/**
+ * Quantize a normalized, resampled path to 8 bits per value
+ * Directions come from the float points, so they carry only the angle
+ * rounding error (under 1 degree), not the grid error.
+ * resampled: Path normalized and resampled to RESAMPLE_POINTS
+ * return Quantized path (left unfilled if the length is wrong)
+ */
+QuantizedPattern quantizePattern(const std::vector<Point>& resampled);
+
+/**
+ * Expand a quantized path back to points in 0-1000 space
+ * return RESAMPLE_POINTS points, or none if the pattern is unfilled
+ */
+std::vector<Point> dequantizePattern(const QuantizedPattern& quantized);
+
+/**
+ * Similarity terms computed directly on quantized paths
+ * Same definitions as the float versions above: integer point deltas
+ * and int8_t angle differences, scaled back to normalized units. The
+ * point distance is still a metric, so the spell index works unchanged.
+ */
+float averagePointDistance(const QuantizedPattern& traj1, const QuantizedPattern& traj2);
+float calculateDirectionSimilarity(const QuantizedPattern& traj1, const QuantizedPattern& traj2);
+float calculateSimilarity(const QuantizedPattern& traj1, const QuantizedPattern& traj2);
+
+/**
+ * Reduce a path to CHAIN_LENGTH direction symbols (chain code)
+ * The path is resampled to CHAIN_LENGTH segments; each symbol is the
+ * segment's atan2 angle (as in calculateDirectionSimilarity()) quantized
+ * to one of CHAIN_DIRECTIONS sectors.
+ * traj: Normalized path
+ * symbols: Output, CHAIN_LENGTH symbols (0 to CHAIN_DIRECTIONS-1)
+ */
+void computeChainSymbols(const std::vector<Point>& traj, uint8_t symbols[CHAIN_LENGTH]);
+
+/**
+ * Reduce a path to count direction symbols (count <= CHAIN_LENGTH)
+ * traj: Path
+ * symbols: Output, count symbols
+ * count: Number of segments/symbols
+ */
+void computeChainSymbols(const std::vector<Point>& traj, uint8_t* symbols, int count);
+
+/**
+ * Build the chain-code template (match masks) of a path
+ * Symbols within one sector of each other count as equal.
+ * traj: Normalized path
+ */
+ChainCode computeChainCode(const std::vector<Point>& traj);
+
+/**
+ * Edit distance between a gesture's chain code and a template
+ * Myers/Hyyrö bit-parallel Levenshtein distance: one 64-bit word per
+ * column, so one pass over the gesture's CHAIN_LENGTH symbols. Local
+ * insertions and deletions (wobbles, hesitations) cost one edit each
+ * instead of misaligning every later point.
+ * symbols: Gesture chain code from computeChainSymbols()
+ * pattern: Template chain code
+ * return Edit distance (0 to CHAIN_LENGTH)
+ */
+uint8_t chainEditDistance(const uint8_t symbols[CHAIN_LENGTH], const ChainCode& pattern);
+
+/**
+ * Chain-code similarity (CHAIN_MATCHING mode)
+ * symbols: Gesture chain code from computeChainSymbols()
+ * pattern: Template chain code
+ * return Similarity score (0.0 to 1.0), scaled by CHAIN_DISTANCE_SCALE
+ */
+float calculateChainSimilarity(const uint8_t symbols[CHAIN_LENGTH], const ChainCode& pattern);
+
+/**
+ * Find the best-scoring spell for a prepared gesture
+ * Ordered spells are searched through the spell index, which only scores
+ * templates able to reach MATCH_THRESHOLD, or by chain code when the
+ * CHAIN_MATCHING preference is set. Cloud templates are scanned and
+ * abandoned early once they can't beat the best.
+ * resampled: Gesture normalized and resampled to RESAMPLE_POINTS
+ * bestMatch: Output similarity of the best spell. Exact when it reaches
+ *            MATCH_THRESHOLD; below that, weaker templates may be unscored
+ * return ID of the best spell, or SPELL_ID_NONE if nothing was scored
+ */
+SpellId findBestSpellId(const std::vector<Point>& resampled, float& bestMatch);
+
+/**
+ * Find the best-scoring spell for a prepared gesture, by name
+ * As findBestSpellId(), for callers that only log or display the result.
+ * return Name of the best spell, or "Unknown" if nothing was scored
+ */
+const char* findBestSpell(const std::vector<Point>& resampled, float& bestMatch);
+
+/**
+ * Rank spells by how well a partial gesture matches their beginning
+ * Cheap guess at the spell being drawn, for prefetching its media. Ordered
+ * spells only; compares chain codes against template prefixes.
+ * partial: Trajectory drawn so far (raw, not normalized)
+ * ids: Output, best spells first
+ * scores: Output, prefix agreement (0.0 to 1.0) per spell in ids
+ * maxCount: Capacity of ids/scores
+ * return Number of spells written
+ */
+size_t rankSpellPrefixes(const std::vector<Point>& partial, SpellId* ids, float* scores, size_t maxCount);
+
+/**
+ * Calculate point-cloud similarity between two clouds ($P recognizer)
+ * Greedily matches each point of one cloud to its nearest unmatched point
+ * in the other, trying several start points in both directions, so the
+ * score ignores drawing order and start point.
+ * cloud1: First cloud (CLOUD_POINTS points, normalized)
+ * cloud2: Second cloud (CLOUD_POINTS points, normalized)
+ * minSimilarity: Scores below this are not needed; matching abandons
+ *                early once they are certain, returning 0
+ * return Similarity score (0.0 to 1.0)
+ */
+float calculateCloudSimilarity(const std::vector<Point>& cloud1, const std::vector<Point>& cloud2,
+                               float minSimilarity = 0);
+
+/**
+ * Compute the shape signature of a normalized, resampled path
+ * One pass over the points: grid occupancy, start/end cells and the
+ * direction sectors carrying at least SIGNATURE_DIRECTION_SHARE of length.
+ * traj: Path in 0-1000 normalized space
+ */
+ShapeSignature computeSignature(const std::vector<Point>& traj);
+
+/**
+ * Distance between two shape signatures
+ * Sum of: occupied cells of either path more than one cell away from the
+ * other's path (popcount against the dilated grid), direction sectors of
+ * either path more than one sector away from the other's, and start/end
+ * cells more than one cell apart (2 each). Order-free comparisons skip the
+ * direction and start/end terms.
+ * anyOrder: Compare occupancy only
+ * return Mismatch count (0 = indistinguishable)
+ */
+uint8_t signatureDistance(const ShapeSignature& a, const ShapeSignature& b, bool anyOrder);
+
+/**
+ * Number of exemplars of a spell (primary pattern + alternates)
+ */
+size_t exemplarCount(const SpellPattern& spell);
+
+/**
+ * Exemplar data by index (0 = primary pattern, 1+ = alternates)
+ * exemplarTemplate() is the stored, scored form (QuantizedPattern in
+ * QUANTIZED_TEMPLATES builds).
+ */
+const MatchTemplate& exemplarTemplate(const SpellPattern& spell, size_t exemplar);
+const std::vector<Point>& exemplarCloud(const SpellPattern& spell, size_t exemplar);
+const ShapeSignature& exemplarSignature(const SpellPattern& spell, size_t exemplar);
+const ChainCode& exemplarChain(const SpellPattern& spell, size_t exemplar);
+
+/**
+ * Whether an exemplar has a full-length template to score
+ */
+bool exemplarMatchable(const SpellPattern& spell, size_t exemplar);
+
+/**
+ * Exemplar as normalized, resampled points (a copy)
+ * For display and saving; dequantized in QUANTIZED_TEMPLATES builds.
+ */
+std::vector<Point> exemplarPoints(const SpellPattern& spell, size_t exemplar);
+
+/**
+ * Score a gesture against one exemplar of a spell using the spell's mode
+ * resampled: Gesture normalized and resampled to RESAMPLE_POINTS
+ * cloud: Gesture cloud (CLOUD_POINTS), or empty if not yet built
+ * minSimilarity: Early-abandon bound passed to cloud matching
+ * return Similarity score (0.0 to 1.0)
+ */
+float scoreExemplar(const SpellPattern& spell, size_t exemplar, const std::vector<Point>& resampled,
+                    std::vector<Point>& cloud, float minSimilarity = 0);
+
+/**
+ * Score a gesture against one library spell using the spell's mode
+ * Best score over the spell's exemplars, stopping early once one reaches
+ * SPELL_EXEMPLAR_EARLY_EXIT.
+ * resampled: Gesture normalized and resampled to RESAMPLE_POINTS
+ * cloud: Gesture cloud (CLOUD_POINTS), or empty if not yet built
+ * minSimilarity: Early-abandon bound passed to cloud matching
+ * return Similarity score (0.0 to 1.0)
+ */
+float scoreSpell(const SpellPattern& spell, const std::vector<Point>& resampled,
+                 std::vector<Point>& cloud, float minSimilarity = 0);
+
+/**
+ * Prepare a library spell for matching
+ * Normalizes and resamples the pattern (and any alternates) to
+ * RESAMPLE_POINTS and builds signatures and per-mode template data (e.g.
+ * the point cloud for anyOrder spells). Call after a spell's patterns or
+ * mode change.
+ */
+void finalizeSpellPattern(SpellPattern& spell);
+
+/**
+ * Pick k representative takes by k-medoid clustering
+ * Greedy build (most central take first, then whichever take most reduces
+ * total distance) followed by alternating reassignment/medoid-update
+ * passes until stable or MEDOID_MAX_ITERATIONS. Distance is 1 - the
+ * similarity the matcher itself uses, so kept takes cover the others as
+ * the matcher sees them.
+ * takes: Normalized, resampled takes
+ * k: Number of medoids to keep
+ * anyOrder: Compare as point clouds
+ * return Indices into takes, most central first (all takes if k >= count)
+ */
+std::vector<size_t> selectMedoids(const std::vector<std::vector<Point>>& takes, size_t k, bool anyOrder);
+
+/**
+ * Set a spell's exemplars from recorded takes
+ * Normalizes and resamples each take, keeps at most SPELL_MAX_EXEMPLARS
+ * medoids (the most central becomes the primary pattern, the rest
+ * alternates) and finalizes the spell. Set anyOrder first.
+ * spell: Spell to fill
+ * takes: Raw takes in any coordinate space (at least one)
+ */
+void compactSpellTakes(SpellPattern& spell, const std::vector<std::vector<Point>>& takes);
+
 //=====================================
 // Main Matching Function
 //=====================================
 
 /**
- * Match gesture against all known spell patterns
- * Process:
- *   1. Check if trajectory has enough points (MIN_TRAJECTORY_POINTS)
- *   2. Normalize and resample trajectory
- *   3. Compare against all spell patterns in spellPatterns vector
- *   4. Calculate similarity score for each pattern
- *   5. Find best match above MATCH_THRESHOLD
- *   6. Trigger spell actions (LED, display, MQTT) if matched
- * Outputs detailed diagnostics to serial console showing similarity scores
- * for all patterns (helpful for tuning and debugging).
- * currentTrajectory: Recorded gesture trajectory from camera
+ * Log the result of a spell search
+ * Takes the caller's findBestSpellId() answer, so the library is searched
+ * once per cast; call after the cast's feedback has started. The index
+ * statistics printed are those of that search. Prints the summary line; with debug logging on, also
+ * the similarity of every template (helpful for tuning and debugging) -
+ * the only extra work, and only then.
+ * currentTrajectory: Recorded gesture trajectory from camera (points, duration)
+ * resampled: Normalized, resampled gesture that was searched
+ * bestSpell: Best spell found (SPELL_ID_NONE if none)
+ * bestMatch: Its score (0.0 to 1.0)
  */
-void matchSpell(const std::vector<Point>& currentTrajectory);
+void matchSpell(const std::vector<Point>& currentTrajectory, const std::vector<Point>& resampled,
+                SpellId bestSpell, float bestMatch);
 
 #endif // SPELL_MATCHING_H
@@ -41,10 +41,17 @@
 ================================================================================
 */
 
+#define LOG_MODULE LogModule::MATCHING
+
 #include "spell_patterns.h"
 #include "spell_matching.h"
+#include "spellIndex.h"
 #include "sdFunctions.h"
+#include "spellActions.h"
+#include "spellCombos.h"
+#include "logFunctions.h"
 #include <Arduino.h>
+#include <atomic>
 #include <cmath>
 
 //=====================================
@@ -58,7 +65,7 @@ std::vector<Point> resampleTrajectory(const std::vector<Point>& traj, int numPoi
 // Global Pattern Storage
 //=====================================
 /// Global vector of all available spell patterns (built-in + custom from SD)
-std::vector<SpellPattern> spellPatterns;
+FastVector<SpellPattern> spellPatterns;
 
 //=====================================
 // Pattern Initialization
@@ -78,6 +85,9 @@ std::vector<SpellPattern> spellPatterns;
  * Note: Must be called during setup() before WiFiManager (patterns used in web portal)
  */
 void initSpellPatterns() {
+  // Start from an empty library - this is also called to reload spells
+  spellPatterns.clear();
+  
   //-----------------------------------
   // Pattern 1: Unlock
   //-----------------------------------
@@ -343,13 +353,15 @@ void initSpellPatterns() {
   // Normalize and resample all patterns to 50 points for consistent matching
   // This allows patterns to be defined with a small number of key points,
   // then extrapolated to match the resolution used for recorded gestures
-  Serial.println("Resampling spell patterns to 50 points...");
+  LOG_DEBUG("Resampling spell patterns to 50 points...");
   for (auto& spell : spellPatterns) {
-    std::vector<Point> normalized = normalizeTrajectory(spell.pattern);
-    spell.pattern = resampleTrajectory(normalized, RESAMPLE_POINTS);
+    finalizeSpellPattern(spell);
   }
   
-  Serial.printf("Loaded and resampled %d spell patterns\n", spellPatterns.size());
+  LOG_DEBUG("Loaded and resampled %d spell patterns", spellPatterns.size());
+  buildSpellIndex();
+  invalidateSpellActions();  // IDs reassigned
+  invalidateSpellCombos();
 }
 
 // Visualize spell patterns on screen (forward declaration from screenFunctions.h)
@@ -357,11 +369,11 @@ void visualizeSpellPattern(const char* name, const std::vector<Point>& pattern);
 
 // Show all spell patterns on screen for debugging
 void showSpellPatterns() {
-  Serial.println("Visualizing spell patterns...");
+  LOG_DEBUG("Visualizing spell patterns...");
   for (const auto& spell : spellPatterns) {
-    visualizeSpellPattern(spell.name, spell.pattern);
+    visualizeSpellPattern(spell.name, exemplarPoints(spell, 0));
   }
-  Serial.println("Pattern visualization complete");
+  LOG_DEBUG("Pattern visualization complete");
 }
 
 // Apply custom spell configurations from SD card
@@ -369,3 +381,33 @@ void showSpellPatterns() {
 void applyCustomSpells() {
   loadCustomSpells();
 }
+
+// Set from any task; the loop task applies it between casts
+static std::atomic<bool> libraryReloadPending(false);
+
+void requestSpellLibraryReload() {
+  libraryReloadPending.store(true);
+}
+
+bool reloadSpellLibraryIfPending() {
+  if (!libraryReloadPending.exchange(false)) return false;
+  initSpellPatterns();  // Load built-in spells
+  loadCustomSpells();   // Apply customizations from spells.json
+  LOG_DEBUG("Spell library reloaded");
+  return true;
+}
+
+// Find a spell's interned ID by name
+SpellId findSpellId(const char* name) {
+  if (name == nullptr || name[0] == '\0') return SPELL_ID_NONE;
+  for (size_t i = 0; i < spellPatterns.size(); i++) {
+    if (strcasecmp(spellPatterns[i].name, name) == 0) return (SpellId)i;
+  }
+  return SPELL_ID_NONE;
+}
+
+// Name of an interned spell
+const char* spellName(SpellId id) {
+  if (id < 0 || (size_t)id >= spellPatterns.size()) return "Unknown";
+  return spellPatterns[id].name;
+}
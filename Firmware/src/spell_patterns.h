@@ -20,6 +20,15 @@
   Customization:
     - Patterns can be modified/added/replaced via spells.json on SD card
     - Custom image files (.bmp format) can be specified per spell
+    - Spells may carry several recorded takes (exemplars), compacted to
+      at most SPELL_MAX_EXEMPLARS representative ones on load
+
+  Quantized Storage (build with -D QUANTIZED_TEMPLATES):
+    - Templates are kept as 8-bit points and 8-bit segment directions
+      (QuantizedPattern, 3 bytes per point instead of 12) and scored in
+      that form; the Point vectors are released once finalized
+    - For very large libraries in internal RAM - use exemplarPoints()
+      (spell_matching.h) rather than .pattern to read a template back
   
 ================================================================================
 */
@@ -29,6 +38,7 @@
 
 #include <Arduino.h>
 #include <vector>
+#include "memoryPolicy.h"
 
 //=====================================
 // Data Structures
@@ -45,14 +55,98 @@ struct Point {
   uint32_t timestamp;  ///< Timestamp in milliseconds (unused in patterns)
 };
 
+/**
+ * Compact shape signature for cheap template rejection
+ * Computed from the normalized, resampled path. Comparing two signatures
+ * is a few popcounts (see signatureDistance() in spell_matching.h).
+ */
+struct ShapeSignature {
+  uint64_t occupancy = 0;   ///< 8x8 grid cells the path passes through (bit = row * 8 + col)
+  uint64_t dilated = 0;     ///< occupancy grown by one cell in every direction
+  uint8_t startCell = 0;    ///< Grid cell of the first point
+  uint8_t endCell = 0;      ///< Grid cell of the last point
+  uint8_t directions = 0;   ///< Bit per 45° sector carrying a significant share of path length
+};
+
+/**
+ * Chain code sizes
+ * A path is reduced to CHAIN_LENGTH direction symbols, each one of
+ * CHAIN_DIRECTIONS sectors. CHAIN_LENGTH is one machine word of bits so
+ * bit-parallel edit distance runs in a single word per symbol.
+ */
+#define CHAIN_DIRECTIONS 16
+#define CHAIN_LENGTH 64
+
+/**
+ * Chain-code template for bit-parallel edit distance
+ * Stores the match masks rather than the symbols: bit i of peq[d] is set
+ * if template symbol i is within one sector of direction d (see
+ * calculateChainSimilarity() in spell_matching.h).
+ */
+struct ChainCode {
+  uint64_t peq[CHAIN_DIRECTIONS] = {};
+};
+
+/**
+ * Points in a quantized template
+ * Must equal RESAMPLE_POINTS (checked in QUANTIZED_TEMPLATES builds).
+ */
+#define QUANTIZED_POINTS 100
+
+/**
+ * 8-bit template (QUANTIZED_TEMPLATES builds)
+ * Resampled points on a 256-step grid over the 0-1000 normalized box, and
+ * each segment's direction as a 256-step angle: a full turn wraps at 256,
+ * so an angle difference is one int8_t subtraction.
+ */
+struct QuantizedPattern {
+  uint8_t x[QUANTIZED_POINTS];
+  uint8_t y[QUANTIZED_POINTS];
+  uint8_t direction[QUANTIZED_POINTS - 1];  ///< Angle of segment i -> i+1
+  bool filled = false;                      ///< False until quantized from a full-length pattern
+};
+
+/**
+ * Stored form of an ordered template, as scored by the matcher
+ */
+#ifdef QUANTIZED_TEMPLATES
+typedef QuantizedPattern MatchTemplate;
+#else
+typedef std::vector<Point> MatchTemplate;
+#endif
+
+/**
+ * Additional template for a spell (one recorded take)
+ * Same matching data as the primary pattern of a SpellPattern.
+ */
+struct SpellExemplar {
+  std::vector<Point> pattern;         ///< Normalized, resampled take
+  std::vector<Point> cloud;           ///< Precomputed cloud (anyOrder spells only)
+  ShapeSignature signature;           ///< Prefilter signature of the take
+  ChainCode chain;                    ///< Chain-code template of the take
+#ifdef QUANTIZED_TEMPLATES
+  QuantizedPattern quantized;         ///< 8-bit template (pattern is released once finalized)
+#endif
+};
+
 /**
  * Spell pattern definition
  * Contains all information needed to recognize and display a spell.
+ * A spell matches if any of its exemplars does: the primary pattern
+ * (most representative take) or one of the alternates.
  */
 struct SpellPattern {
   const char* name;                   ///< Spell name (e.g., "Ignite")
   std::vector<Point> pattern;         ///< Sequence of points defining gesture
   String customImageFilename;         ///< Optional custom image filename (empty = use default naming)
+  bool anyOrder = false;              ///< Match as a point cloud (stroke order/start point ignored)
+  std::vector<Point> cloud;           ///< Precomputed CLOUD_POINTS cloud (anyOrder spells only)
+  ShapeSignature signature;           ///< Prefilter signature of the resampled pattern
+  ChainCode chain;                    ///< Chain-code template (CHAIN_MATCHING mode)
+#ifdef QUANTIZED_TEMPLATES
+  QuantizedPattern quantized;         ///< 8-bit template (pattern is released once finalized)
+#endif
+  std::vector<SpellExemplar> alternates; ///< Further takes kept by compaction (see compactSpellTakes())
 };
 
 //=====================================
@@ -64,8 +158,34 @@ struct SpellPattern {
  * Populated by initSpellPatterns() with built-in spells, then optionally
  * modified by applyCustomSpells() from SD card configuration.
  * Patterns are normalized and resampled to 40 points during initialization.
+ * Searched on every cast, so always kept in internal SRAM (FAST policy).
+ */
+extern FastVector<SpellPattern> spellPatterns;
+
+/**
+ * Interned spell identifier - the spell's index in spellPatterns
+ * IDs are assigned when the library is (re)loaded and stay valid until
+ * the next initSpellPatterns()/loadCustomSpells(). Matching reports IDs
+ * so casting can index per-spell tables (see spellActions.h) instead of
+ * comparing names.
+ */
+typedef int16_t SpellId;
+#define SPELL_ID_NONE -1                // No spell (nothing scored / not in library)
+
+/**
+ * Look up the ID of a spell by name (case-insensitive)
+ * Linear scan - for table builds, not the cast path.
+ * name: Spell name (nullptr or empty never matches)
+ * return Spell ID, or SPELL_ID_NONE if no spell has that name
  */
-extern std::vector<SpellPattern> spellPatterns;
+SpellId findSpellId(const char* name);
+
+/**
+ * Name of an interned spell
+ * id: Spell ID
+ * return Spell name, or "Unknown" for SPELL_ID_NONE / out of range
+ */
+const char* spellName(SpellId id);
 
 //=====================================
 // Initialization Functions
@@ -102,4 +222,20 @@ void showSpellPatterns();
  */
 void applyCustomSpells();
 
+/**
+ * Ask for the spell library to be reloaded from spells.json
+ * Safe from any task (portal renames on the WiFi task, spell saves on the
+ * UI task): matching walks spellPatterns and the spell index on the loop
+ * task, so only the loop task may rebuild them.
+ */
+void requestSpellLibraryReload();
+
+/**
+ * Reload the library if requested (initSpellPatterns() + applyCustomSpells())
+ * Called by loop() between casts, holding the UI lock so menus don't
+ * read spellPatterns mid-rebuild.
+ * return true if the library was reloaded
+ */
+bool reloadSpellLibraryIfPending();
+
 #endif // SPELL_PATTERNS_H
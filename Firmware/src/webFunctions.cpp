@@ -52,6 +52,8 @@
  * 
  */
 
+#define LOG_MODULE LogModule::NETWORK
+
 #include "webFunctions.h"
 #include <WiFiManager.h>
 #include "preferenceFunctions.h"
@@ -62,36 +64,30 @@
 #include "sdFunctions.h"
 #include <cctype>
 #include "screenFunctions.h"
+#include "heapFunctions.h"
+#include "spellActions.h"
+#include "apiServer.h"
 #include "version.h"
 
 // WiFiManager instance
 WiFiManager wm;
 
 /**
- * Find the least congested WiFi channel for AP mode
- * Scans nearby networks and counts how many are on each channel.
- * Returns the least congested of channels 1, 6, or 11 (non-overlapping 2.4GHz channels).
+ * Pick the least congested WiFi channel for AP mode from finished scan results
+ * Counts how many networks are on each channel and returns the least congested
+ * of channels 1, 6, or 11 (non-overlapping 2.4GHz channels).
+ * Frees the scan results.
  * 
+ * numNetworks: Result of WiFi.scanComplete() (networks found, or negative on failure)
  * return Best channel to use (1, 6, or 11)
  */
-int findBestWiFiChannel() {
-    LOG_DEBUG("Scanning for WiFi networks to find best AP channel...");
-    
-    // Fully reset WiFi state before scanning to avoid mode conflicts
-    WiFi.disconnect(true);  // Disconnect and clear credentials from RAM
-    WiFi.mode(WIFI_OFF);    // Turn off WiFi completely
-    delay(100);             // Let hardware settle
-    
-    // Initialize WiFi in station mode for scanning
-    WiFi.mode(WIFI_STA);
-    delay(100);             // Let STA mode initialize
-    
-    int numNetworks = WiFi.scanNetworks(false, true);  // Don't block, show hidden
+static int pickBestWiFiChannel(int numNetworks) {
     LOG_DEBUG("Found %d networks", numNetworks);
     
     if (numNetworks <= 0) {
-        LOG_DEBUG("No networks found, defaulting to channel 6");
-        return 6;  // Default to channel 6 if scan fails
+        LOG_DEBUG("No networks found, defaulting to channel %d", WIFI_DEFAULT_AP_CHANNEL);
+        WiFi.scanDelete();
+        return WIFI_DEFAULT_AP_CHANNEL;  // Default channel if scan fails
     }
     
     // Count networks on each channel (channels 1-13 for 2.4GHz)
@@ -116,11 +112,8 @@ int findBestWiFiChannel() {
     
     LOG_DEBUG("Channel scores - Ch1: %d, Ch6: %d, Ch11: %d", score1, score6, score11);
     
-    // Clean up scan results and reset WiFi state for AP mode
+    // Clean up scan results
     WiFi.scanDelete();
-    WiFi.disconnect(true);  // Clear any connection state
-    WiFi.mode(WIFI_OFF);    // Turn off WiFi to reset state completely
-    delay(100);             // Allow hardware to fully reset before WiFiManager takes over
     
     // Pick channel with lowest score
     int bestChannel = 6;  // Default
@@ -178,6 +171,8 @@ WiFiManagerParameter custom_Start_Stillness_Time_text("<p>How long the wand need
 WiFiManagerParameter custom_End_STillness_Time_text("<p>How long the wand needs to remain still to end tracking</p>");
 WiFiManagerParameter custom_Max_Gesture_Time_text("<p>Maximum time to track a spell before timing out</p>");
 WiFiManagerParameter custom_IR_Loss_Timeout_text("<p>Max time tracking can be lost before tracking is ended</p>");
+WiFiManagerParameter custom_Spotting_text("<p>Recognize spells mid-motion without holding the wand still first</p>");
+WiFiManagerParameter custom_Chain_Matching_text("<p>Match by stroke directions only (faster, but misses many sloppy or wobbly casts)</p>");
 WiFiManagerParameter custom_User_Spell_Names_Header_Text("</div><div class='settings-group'><h2>Custom Spell Names</h2>");
 WiFiManagerParameter custom_User_Spell_Names_Text("<p>Rename custom spells recorded via the device.</p>");
 WiFiManagerParameter custom_Tuning_Close_Div("</div>");  // Closes the last settings group
@@ -278,6 +273,12 @@ WiFiManagerParameter custom_Nightlight_Lower_Dropdown(nightlightLowerHTML.c_str(
 // Sound settings checkbox (custom HTML will be set in loadCustomParameters)
 WiFiManagerParameter custom_sound_enabled("sound_enabled", "Enable Sound Effects", "T", 2, "type=\"checkbox\"", WFM_LABEL_AFTER);
 
+// Spotting mode checkbox (custom HTML will be set in loadCustomParameters)
+WiFiManagerParameter custom_spotting_enabled("spotting_enabled", "Continuous Spotting", "T", 2, "type=\"checkbox\"", WFM_LABEL_AFTER);
+
+// Chain-code matching checkbox (custom HTML will be set in loadCustomParameters)
+WiFiManagerParameter custom_chain_matching("chain_matching", "Lightweight Matching", "T", 2, "type=\"checkbox\"", WFM_LABEL_AFTER);
+
 WiFiManagerParameter* showAdvOptsBtn = new WiFiManagerParameter("<button id=\"showadvopts\">Show Advanced Options</button>");
 
 
@@ -380,6 +381,16 @@ void LoadCustomParameters() {
     } else {
         new (&custom_sound_enabled) WiFiManagerParameter("sound_enabled", "Enable Sound Effects", "T", 2, "type=\"checkbox\"", WFM_LABEL_AFTER);
     }
+    if (SPOTTING_ENABLED) {
+        new (&custom_spotting_enabled) WiFiManagerParameter("spotting_enabled", "Continuous Spotting", "T", 2, "type=\"checkbox\" checked", WFM_LABEL_AFTER);
+    } else {
+        new (&custom_spotting_enabled) WiFiManagerParameter("spotting_enabled", "Continuous Spotting", "T", 2, "type=\"checkbox\"", WFM_LABEL_AFTER);
+    }
+    if (CHAIN_MATCHING) {
+        new (&custom_chain_matching) WiFiManagerParameter("chain_matching", "Lightweight Matching", "T", 2, "type=\"checkbox\" checked", WFM_LABEL_AFTER);
+    } else {
+        new (&custom_chain_matching) WiFiManagerParameter("chain_matching", "Lightweight Matching", "T", 2, "type=\"checkbox\"", WFM_LABEL_AFTER);
+    }
     
     generateAdjusters();
     generateDropdowns();
@@ -399,6 +410,7 @@ void LoadCustomParameters() {
 }
 
 void saveCustomParameters() {
+    HEAP_SCOPE(HeapTag::WEB);
     LOG_DEBUG("Processing web form parameters...");
     // Dump all posted form args for debugging
     int postedArgs = wm.server->args();
@@ -501,6 +513,7 @@ void saveCustomParameters() {
         NIGHTLIGHT_LOWER_SPELL = newNightlightLower;
         pendingSaveToPreferences = true;
     }
+    invalidateSpellActions();  // Recompile nightlight roles before the next cast
 
     //-----------------------------------
     // Tuning Parameters
@@ -531,6 +544,18 @@ void saveCustomParameters() {
         IR_LOSS_TIMEOUT = newIRLossTimeout;
         pendingSaveToPreferences = true;
     }
+    bool newSpottingEnabled = wm.server->hasArg("spotting_enabled");
+    if (newSpottingEnabled != SPOTTING_ENABLED) {
+        SPOTTING_ENABLED = newSpottingEnabled;
+        pendingSaveToPreferences = true;
+        LOG_DEBUG("Spotting mode changed to: %s", newSpottingEnabled ? "enabled" : "disabled");
+    }
+    bool newChainMatching = wm.server->hasArg("chain_matching");
+    if (newChainMatching != CHAIN_MATCHING) {
+        CHAIN_MATCHING = newChainMatching;
+        pendingSaveToPreferences = true;
+        LOG_DEBUG("Chain-code matching changed to: %s", newChainMatching ? "enabled" : "disabled");
+    }
 
     //-----------------------------------
     // Custom Spell Rename Handling (read generated fields)
@@ -679,6 +704,10 @@ void processBackgroundSaves() {
         setPref(PrefKey::GESTURE_TIMEOUT, GESTURE_TIMEOUT);
         yield();
         setPref(PrefKey::IR_LOSS_TIMEOUT, IR_LOSS_TIMEOUT);
+        yield();
+        setPref(PrefKey::SPOTTING_ENABLED, SPOTTING_ENABLED);
+        yield();
+        setPref(PrefKey::CHAIN_MATCHING, CHAIN_MATCHING);
         
         pendingSaveToPreferences = false;
         LOG_DEBUG("Background save: NVS preferences updated successfully");
@@ -712,16 +741,56 @@ void processBackgroundSaves() {
     }
 }
 
-bool initWM(int timeout) {
+static uint32_t webPortalUsedAt = 0;            // millis() of the last configuration page request
+
+/**
+ * Notes every request to WiFiManager's server and handles none
+ * Keeps the station-mode configuration pages open while they are in use
+ * (see updateWebPortal()). Runs on the WiFi task, like the server.
+ */
+class PortalActivityHandler : public RequestHandler {
+public:
+    bool canHandle(HTTPMethod, String) override {
+        webPortalUsedAt = millis();
+        return false;  // Fall through to the real routes
+    }
+};
+
+/**
+ * Register extra portal endpoints
+ * Called by WiFiManager each time it (re)creates its web server, so routes
+ * survive portal restarts. WiFiManager adds its own pages after this, so
+ * the activity handler sees every request first.
+ */
+void bindPortalRoutes() {
+    wm.server->addHandler(new PortalActivityHandler());  // Owned by the server
+    // Log levels and drop count (JSON); ?module=<name|all>&level=<off|always|debug> changes a level
+    wm.server->on("/log", HTTP_GET, []() {
+        if (wm.server->hasArg("module") &&
+            !setLogLevelByName(wm.server->arg("module"), wm.server->arg("level"))) {
+            wm.server->send(400, "text/plain", "Unknown module or level");
+            return;
+        }
+        wm.server->send(200, "application/json", logStatusJson());
+    });
+    // JSON reports shared with the API server (/status, /memory, /heap, /prefetch, /tasks)
+    for (size_t i = 0; i < API_ROUTE_COUNT; i++) {
+        const ApiRoute* route = &API_ROUTES[i];
+        wm.server->on(route->path, HTTP_GET, [route]() {
+            wm.server->send(200, "application/json", route->json());
+        });
+    }
+}
+
+static void onWiFiEvent(arduino_event_id_t event);
+
+void initWM() {
+    HEAP_SCOPE(HeapTag::WEB);
     LOG_DEBUG("Initializing WiFiManager...");
-    
-    // Find the least congested WiFi channel before starting AP
-    int bestChannel = findBestWiFiChannel();
 
     // Load stored parameters into buffers (also regenerates dropdowns)
     LoadCustomParameters();
-    wm.setWiFiAPChannel(bestChannel); // Use auto-detected best channel
-    wm.setConfigPortalBlocking(false); // Non-blocking - device continues even if WiFi fails
+    wm.setConfigPortalBlocking(false); // Non-blocking - the link state machine drives it
     //wm.setConfigPortalTimeout(timeout); // Config portal timeout: 60 seconds
     wm.setCaptivePortalEnable(true); // Enable Captive Portal
 
@@ -825,6 +894,11 @@ bool initWM(int timeout) {
 
     wm.addParameter(&custom_IR_Loss_Timeout_text);
     wm.addParameter(&custom_IR_Loss_timeout_adjust);
+
+    wm.addParameter(&custom_Spotting_text);
+    wm.addParameter(&custom_spotting_enabled);
+    wm.addParameter(&custom_Chain_Matching_text);
+    wm.addParameter(&custom_chain_matching);
     wm.addParameter(&custom_Tuning_Close_Div);  // Close the last settings group
 
     // (custom spell fields will be created/added earlier in the function)
@@ -832,52 +906,263 @@ bool initWM(int timeout) {
     // ensure settings are saved when changed
     wm.setSaveParamsCallback(saveCustomParameters);
 
+    // Extra endpoints (diagnostics) are added whenever the server starts
+    wm.setWebServerCallback(bindPortalRoutes);
+
     // Custom Menu
     std::vector<const char*> menu = {"wifi", "param", "info", "sep", "restart"};
     wm.setMenu(menu);
 
-    wm.setConnectTimeout(15); // 15 seconds to connect to WiFi
+    wm.setConnectTimeout(WIFI_CONNECT_TIMEOUT_MS / 1000); // Credentials entered in the portal
+    wm.setWiFiAutoReconnect(false);  // Reconnects are driven by processWiFiLink()
 
-    // Try to connect to saved WiFi or start config portal
-    if (!wm.autoConnect("GlyphReader-Setup")) {
-        LOG_ALWAYS("Failed to connect to WiFi - continuing without network");
-        
-        // Log detailed AP status for debugging
-        LOG_ALWAYS("AP Status - SSID: %s, IP: %s, Channel: %d", 
-                   WiFi.softAPSSID().c_str(),
-                   WiFi.softAPIP().toString().c_str(),
-                   WiFi.channel());
-        LOG_ALWAYS("AP MAC: %s, Stations: %d", 
-                   WiFi.softAPmacAddress().c_str(),
-                   WiFi.softAPgetStationNum());
-        
-        // Don't call WiFi.mode(WIFI_AP) here - it can disrupt the already-running portal!
-        // WiFiManager's autoConnect already set up the AP mode.
-        
-        // Explicitly start/restart the web portal to ensure HTTP server is running
-        // This is critical for non-blocking mode where autoConnect returns immediately
-        wm.startWebPortal();
-        LOG_ALWAYS("Web portal explicitly started on 192.168.4.1");
-        
-        // Device continues operating without WiFi
-        return false;  // Indicates no WiFi, but device still functional
+    // Scan results and link changes wake the WiFi task instead of it polling
+    WiFi.onEvent(onWiFiEvent);
+
+    // No connection attempt here - processWiFiLink() starts it from the WiFi task
+}
+
+//=====================================
+// WiFi Link State Machine
+//=====================================
+
+static volatile WiFiLinkState linkState = WiFiLinkState::START;
+static volatile bool portalRequested = false;   // Set from any core, consumed by the WiFi task
+static volatile bool webPortalRequested = false; // Set by the API server, consumed by the WiFi task
+static uint32_t linkStateSince = 0;             // millis() when linkState was entered
+static bool channelRefreshed = false;           // Background channel scan done this boot
+static bool refreshScanRunning = false;         // Background scan in progress (CONNECTED)
+static void (*wifiConnectedCallback)() = nullptr;
+
+const char* wifiLinkStateName(WiFiLinkState state) {
+    switch (state) {
+        case WiFiLinkState::START:      return "start";
+        case WiFiLinkState::CONNECTING: return "connecting";
+        case WiFiLinkState::CONNECTED:  return "connected";
+        case WiFiLinkState::SCANNING:   return "scanning";
+        case WiFiLinkState::PORTAL:     return "portal";
+    }
+    return "?";
+}
+
+/**
+ * Move the link to a new state
+ */
+static void enterLinkState(WiFiLinkState state) {
+    LOG_DEBUG("WiFi link: %s -> %s", wifiLinkStateName(linkState), wifiLinkStateName(state));
+    linkState = state;
+    linkStateSince = millis();
+}
+
+/**
+ * Store a newly chosen AP channel so the next boot can open the portal without scanning
+ */
+static void cacheApChannel(int channel) {
+    if (channel == WIFI_AP_CHANNEL) return;
+    WIFI_AP_CHANNEL = channel;
+    setPref(PrefKey::WIFI_AP_CHANNEL, channel);
+    LOG_DEBUG("Cached AP channel %d", channel);
+}
+
+/**
+ * Start a station connection with the saved credentials
+ */
+static void beginStation() {
+    WiFi.mode(WIFI_STA);
+    WiFi.begin();  // Saved SSID/password from NVS
+    enterLinkState(WiFiLinkState::CONNECTING);
+}
+
+/**
+ * Open the setup AP and config portal (non-blocking)
+ * Without a cached channel, an asynchronous scan runs first (SCANNING).
+ */
+static void openPortal() {
+    if (WIFI_AP_CHANNEL == 0) {
+        // Stop any connection attempt, the radio can't scan while it retries
+        WiFi.disconnect(false, false);  // Keep saved credentials
+        WiFi.mode(WIFI_STA);
+        WiFi.scanNetworks(true, true);  // Async, include hidden networks
+        enterLinkState(WiFiLinkState::SCANNING);
+        return;
+    }
+
+    // The captive portal needs port 80
+    if (wm.getWebPortalActive()) wm.stopWebPortal();
+    stopApiServer();
+    wm.setHttpPort(80);
+    wm.setWiFiAPChannel(WIFI_AP_CHANNEL);
+    wm.startConfigPortal(WIFI_AP_NAME);  // Returns at once in non-blocking mode
+    LOG_ALWAYS("Setup portal '%s' on channel %d: http://192.168.4.1", WIFI_AP_NAME, WIFI_AP_CHANNEL);
+    enterLinkState(WiFiLinkState::PORTAL);
+}
+
+/**
+ * Station link is up: serve the API on the station IP and run network setup
+ */
+static void onStationConnected() {
+    LOG_DEBUG("Connected to WiFi!");
+    LOG_DEBUG("Station IP: %s", WiFi.localIP().toString().c_str());
+    enterLinkState(WiFiLinkState::CONNECTED);
+    startApiServer();  // Configuration pages open on demand (see updateWebPortal())
+    if (wifiConnectedCallback) wifiConnectedCallback();
+}
+
+/**
+ * Open or close the configuration pages in station mode
+ * Opened by a request to the API server's /config, closed again after
+ * WEB_PORTAL_OPEN_MS without a request to either that or the pages
+ * themselves, so the WiFi task only has to poll WiFiManager's server
+ * while someone is configuring.
+ */
+static void updateWebPortal() {
+    if (webPortalRequested) {
+        webPortalRequested = false;
+        webPortalUsedAt = millis();
+        if (linkState == WiFiLinkState::CONNECTED && !wm.getWebPortalActive()) {
+            wm.setHttpPort(WEB_PORTAL_PORT);
+            wm.startWebPortal();
+            LOG_DEBUG("Configuration pages open on port %d", WEB_PORTAL_PORT);
+        }
+    } else if (wm.getWebPortalActive() && millis() - webPortalUsedAt > WEB_PORTAL_OPEN_MS) {
+        wm.stopWebPortal();
+        LOG_DEBUG("Configuration pages closed");
+    }
+}
+
+/**
+ * WiFi driver event: wake the WiFi task to act on it
+ */
+static void onWiFiEvent(arduino_event_id_t event) {
+    wakeWiFiTask();
+}
+
+/**
+ * Refresh the cached AP channel once per boot while connected
+ * The scan briefly leaves the station channel; only the WiFi task waits on it.
+ */
+static void refreshApChannel() {
+    if (channelRefreshed) return;
+    if (!refreshScanRunning) {
+        if (millis() - linkStateSince < WIFI_CHANNEL_REFRESH_MS) return;
+        WiFi.scanNetworks(true, true);
+        refreshScanRunning = true;
+        return;
+    }
+    int result = WiFi.scanComplete();
+    if (result == WIFI_SCAN_RUNNING) return;
+    refreshScanRunning = false;
+    channelRefreshed = true;
+    if (result >= 0) {
+        cacheApChannel(pickBestWiFiChannel(result));
     } else {
-        LOG_DEBUG("Connected to WiFi!");
-        LOG_DEBUG("Station IP: %s", WiFi.localIP().toString().c_str());
-        wm.startWebPortal();  // Keep web portal available for configuration changes
-        return true;  // WiFi connected successfully
+        WiFi.scanDelete();
     }
+}
+
+void processWiFiLink() {
+    HEAP_SCOPE(HeapTag::WEB);
+
+    // Portal requested from elsewhere (e.g. the UI on core 1)
+    if (portalRequested) {
+        portalRequested = false;
+        if (linkState != WiFiLinkState::PORTAL && linkState != WiFiLinkState::SCANNING) {
+            refreshScanRunning = false;
+            WiFi.scanDelete();
+            openPortal();
+        }
+    }
+
+    uint32_t elapsed = millis() - linkStateSince;
+
+    switch (linkState) {
+        case WiFiLinkState::START:
+            if (wm.getWiFiIsSaved()) {
+                beginStation();
+            } else {
+                LOG_ALWAYS("No saved WiFi network - opening setup portal");
+                openPortal();
+            }
+            break;
+
+        case WiFiLinkState::CONNECTING:
+            if (WiFi.status() == WL_CONNECTED) {
+                onStationConnected();
+            } else if (elapsed > WIFI_CONNECT_TIMEOUT_MS) {
+                LOG_ALWAYS("Failed to connect to WiFi - opening setup portal, tracking continues offline");
+                openPortal();
+            }
+            break;
+
+        case WiFiLinkState::CONNECTED:
+            if (WiFi.status() != WL_CONNECTED) {
+                LOG_ALWAYS("WiFi connection lost - reconnecting");
+                refreshScanRunning = false;
+                WiFi.scanDelete();
+                beginStation();
+            } else {
+                refreshApChannel();
+                updateWebPortal();
+            }
+            break;
+
+        case WiFiLinkState::SCANNING: {
+            int result = WiFi.scanComplete();
+            if (result == WIFI_SCAN_RUNNING && elapsed < WIFI_SCAN_TIMEOUT_MS) break;
+            cacheApChannel(result == WIFI_SCAN_RUNNING ? WIFI_DEFAULT_AP_CHANNEL : pickBestWiFiChannel(result));
+            channelRefreshed = true;
+            openPortal();
+            break;
+        }
+
+        case WiFiLinkState::PORTAL:
+            if (WiFi.status() == WL_CONNECTED) {
+                // Credentials saved in the portal connected (wm.process() below
+                // finishes the portal), or the saved network came back
+                if (wm.getConfigPortalActive()) wm.stopConfigPortal();
+                WiFi.mode(WIFI_STA);
+                onStationConnected();
+            } else if (elapsed > WIFI_PORTAL_RETRY_MS && WiFi.softAPgetStationNum() == 0 && wm.getWiFiIsSaved()) {
+                // Nobody is configuring: close the AP and retry the saved network
+                LOG_DEBUG("Setup portal idle - retrying saved WiFi network");
+                wm.stopConfigPortal();
+                beginStation();
+            }
+            break;
+    }
+
+    // Serve the config portal (AP) or configuration pages (station) while open
+    if (wm.getConfigPortalActive() || wm.getWebPortalActive()) wm.process();
+}
+
+uint32_t wifiTaskWaitMs() {
+    // WiFiManager's server is polled; everything else arrives as an event
+    if (wm.getConfigPortalActive() || wm.getWebPortalActive()) return WEB_PORTAL_POLL_MS;
+    return WIFI_IDLE_WAIT_MS;
+}
+
+void wakeWiFiTask() {
+    if (wifiTaskHandle != NULL) xTaskNotifyGive(wifiTaskHandle);
+}
+
+WiFiLinkState getWiFiLinkState() {
+    return linkState;
+}
+
+bool isWiFiConnected() {
+    return linkState == WiFiLinkState::CONNECTED;
+}
+
+void requestConfigPortal() {
+    portalRequested = true;
+    wakeWiFiTask();
+}
 
+void requestWebPortal() {
+    webPortalRequested = true;
+    wakeWiFiTask();
 }
 
-// This function launches a blocking WiFiManager portal at runtime
-// and returns when the user exits or times out.
-void launchBlockingWiFiPortal() {
-    // Show message on screen
-    displayMessage("WiFi Setup...", 0x07E0);
-    delay(500);
-    initWM(120);
-    displayMessage("Portal Closed", 0xFFE0);
-    delay(1000);
-    clearDisplay();
+void setWiFiConnectedCallback(void (*callback)()) {
+    wifiConnectedCallback = callback;
 }
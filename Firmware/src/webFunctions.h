@@ -12,6 +12,19 @@
     - Captive portal for easy configuration (http://192.168.4.1)
     - Custom parameter fields for device-specific settings
   
+  Link State Machine:
+    - All WiFi work (connecting, scanning, AP/STA switching, opening the
+      portals) runs in processWiFiLink(), called only from the WiFi task on
+      core 0; setup() and the tracking loop on core 1 never wait on it
+    - START -> CONNECTING (saved credentials) -> CONNECTED, falling back to
+      PORTAL after WIFI_CONNECT_TIMEOUT_MS; a lost link goes back to
+      CONNECTING; an idle portal retries the saved network every
+      WIFI_PORTAL_RETRY_MS
+    - The AP channel comes from an asynchronous scan cached in NVS: the
+      first boot scans (SCANNING) before opening the portal, later boots
+      open it at once and refresh the cache in the background while
+      connected
+  
   Configuration Portal:
     - WiFi SSID/password selection
     - MQTT broker settings (host, port, topic)
@@ -25,8 +38,14 @@
     - Nightlight spell dropdowns (generated from spellPatterns vector)
   
   Portal Access:
-    - Station mode: http://glyphreader.local (via mDNS)
+    - Station mode: http://glyphreader.local (via mDNS) is the API server
+      (apiServer.h); it opens the configuration pages on demand at
+      http://glyphreader.local:8080 (WEB_PORTAL_PORT), which close again
+      after WEB_PORTAL_OPEN_MS without a request
     - AP mode: http://192.168.4.1 (captive portal)
+    - WiFiManager's server is polled, so the WiFi task only wakes every
+      WEB_PORTAL_POLL_MS while it is open; otherwise it sleeps until a
+      WiFi event, a request or WIFI_IDLE_WAIT_MS
   
   Implementation Notes:
     - Custom parameters must be initialized before wm.process()
@@ -41,7 +60,34 @@
 #define WEBFUNCTIONS_H
 
 #include <Arduino.h>
-#include <WiFiManager.h>
+
+class WiFiManager;  // <WiFiManager.h> clashes with the API server's HTTP_* names
+
+//=====================================
+// Link Configuration
+//=====================================
+
+#define WIFI_AP_NAME "GlyphReader-Setup"   // Setup portal SSID
+#define WIFI_DEFAULT_AP_CHANNEL 6          // AP channel when a scan finds nothing
+#define WIFI_CONNECT_TIMEOUT_MS 15000      // Station attempt before opening the portal
+#define WIFI_PORTAL_RETRY_MS 300000        // Idle portal retries the saved network after this
+#define WIFI_SCAN_TIMEOUT_MS 10000         // Give up on the channel scan after this
+#define WIFI_CHANNEL_REFRESH_MS 60000      // Connected this long before refreshing the channel cache
+#define WIFI_IDLE_WAIT_MS 500              // WiFi task wake-up with no portal open (MQTT keepalive, timeouts)
+#define WEB_PORTAL_POLL_MS 10              // WiFi task wake-up while WiFiManager's server is open
+#define WEB_PORTAL_PORT 8080               // Station-mode configuration pages (the API server has port 80)
+#define WEB_PORTAL_OPEN_MS 600000          // Configuration pages close after this long unused
+
+/**
+ * WiFi link states (see processWiFiLink())
+ */
+enum class WiFiLinkState : uint8_t {
+  START,        ///< Not started yet
+  CONNECTING,   ///< Station joining the saved network
+  CONNECTED,    ///< Station up, API server on the station IP
+  SCANNING,     ///< Picking a quiet AP channel (no cached channel yet)
+  PORTAL        ///< Setup AP and config portal open
+};
 
 //=====================================
 // Global WiFiManager Object
@@ -65,15 +111,70 @@ extern bool pendingSaveCustomSpellsToSD;
 //=====================================
 
 /**
- * Initialize WiFiManager and configure web portal
+ * Configure WiFiManager and the web portal parameters
+ * Returns at once - the connection is made by processWiFiLink().
  * Portal URLs:
  *   - Station mode: http://glyphreader.local
  *   - AP mode: http://192.168.4.1
- * return true if connected to WiFi, false if in AP mode
  * note: Must be called AFTER initSpellPatterns() (spell dropdowns require patterns)
- * note: WiFiManager will automatically manage AP mode when WiFi is disconnected
  */
-bool initWM(int timeout);
+void initWM();
+
+/**
+ * Advance the WiFi link state machine and serve the portal
+ * Call repeatedly from the WiFi task only. Never waits on a scan or a
+ * connection (a connect to credentials just entered in the portal is the
+ * one blocking step, and it blocks only the WiFi task).
+ */
+void processWiFiLink();
+
+/**
+ * Current WiFi link state (safe from any core)
+ */
+WiFiLinkState getWiFiLinkState();
+
+/**
+ * Name of a link state ("connected", "portal", ...)
+ */
+const char* wifiLinkStateName(WiFiLinkState state);
+
+/**
+ * return true if the station link is up
+ */
+bool isWiFiConnected();
+
+/**
+ * Ask the WiFi task to open the setup AP and config portal
+ * Safe from any core; returns at once.
+ */
+void requestConfigPortal();
+
+/**
+ * Ask the WiFi task to open the configuration pages on WEB_PORTAL_PORT
+ * (station mode). Safe from any core; returns at once.
+ */
+void requestWebPortal();
+
+/**
+ * How long the WiFi task may sleep before its next pass
+ * WEB_PORTAL_POLL_MS while WiFiManager's polled server is open, otherwise
+ * WIFI_IDLE_WAIT_MS; WiFi events and requests wake it sooner.
+ */
+uint32_t wifiTaskWaitMs();
+
+/**
+ * Wake the WiFi task early (safe from any task)
+ */
+void wakeWiFiTask();
+
+/// WiFi task handle (defined in main.cpp)
+extern TaskHandle_t wifiTaskHandle;
+
+/**
+ * Set a function run in the WiFi task each time the station link comes up
+ * (NTP, location lookup, mDNS)
+ */
+void setWiFiConnectedCallback(void (*callback)());
 
 /**
  * Process background saves to NVS preferences
@@ -30,11 +30,16 @@
  * 
  */
 
+#define LOG_MODULE LogModule::NETWORK
+
 #include "wifiFunctions.h"
 #include "glyphReader.h"
 #include "preferenceFunctions.h"
+#include "heapFunctions.h"
+#include "memoryPolicy.h"
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
+#include <atomic>
 #include <time.h>
 
 // WiFi and MQTT
@@ -45,6 +50,7 @@ uint32_t lastMqttReconnect = 0;
 uint32_t mqttBackoffInterval = 5000;       // Start at 5 seconds, max 1 hour
 const uint32_t MQTT_BACKOFF_MAX = 3600000; // 1 hour maximum backoff
 bool mqttWasConnected = false;             // Track if we've ever connected this session
+static std::atomic<bool> mqttUp(false);    // Last state seen by the WiFi task (see isMqttConnected())
 
 /**
  * Maintain MQTT broker connection with auto-reconnect
@@ -60,11 +66,13 @@ bool mqttWasConnected = false;             // Track if we've ever connected this
 void reconnectMQTT() {
   // Don't try to connect if no MQTT host is configured
   if (MQTT_HOST.length() == 0) {
+    mqttUp = false;
     return;  // MQTT disabled - skip
   }
   
   // If connected, reset backoff and track connection state
-  if (mqttClient.connected()) {
+  mqttUp = mqttClient.connected();
+  if (mqttUp) {
     if (!mqttWasConnected) {
       mqttWasConnected = true;
       mqttBackoffInterval = 5000;  // Reset backoff on successful connection
@@ -81,6 +89,7 @@ void reconnectMQTT() {
       LOG_DEBUG("Attempting MQTT connection (backoff: %lu sec)...", mqttBackoffInterval / 1000);
       
       if (mqttClient.connect(mqttClientId)) {
+        mqttUp = true;
         LOG_DEBUG("MQTT connected");
         mqttWasConnected = true;
         mqttBackoffInterval = 5000;  // Reset backoff on success
@@ -95,6 +104,10 @@ void reconnectMQTT() {
   }
 }
 
+bool isMqttConnected() {
+  return mqttUp;
+}
+
 /**
  * Publish recognized spell name to MQTT broker
  * spellName: Null-terminated string containing spell name (e.g., "Illuminate")
@@ -108,11 +121,12 @@ void reconnectMQTT() {
  * Called from spell_matching.cpp when spell confidence exceeds threshold.
  */
 void publishSpell(const char* spellName) {
+  HEAP_SCOPE(HeapTag::WEB);
   if (mqttClient.connected()) {
-    Serial.printf("Publishing spell to MQTT: %s\n", spellName);
+    LOG_DEBUG("Publishing spell to MQTT: %s", spellName);
     mqttClient.publish(MQTT_TOPIC.c_str(), spellName);  // Send spell name to topic
   } else {
-    Serial.println("MQTT not connected, cannot publish spell");
+    LOG_ALWAYS("MQTT not connected, cannot publish spell");
   }
 }
 
@@ -146,7 +160,7 @@ JsonDocument* fetchJsonFromApi(const String& url, const JsonDocument& filter) {
         return nullptr;
     }
 
-    JsonDocument* doc = new JsonDocument;
+    JsonDocument* doc = new JsonDocument(bulkJsonAllocator());
     
     DeserializationError err = deserializeJson(*doc, http.getStream(), DeserializationOption::Filter(filter));
     http.end();
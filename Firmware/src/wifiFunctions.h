@@ -61,6 +61,14 @@ extern char mqttClientId[32];
  */
 void reconnectMQTT();
 
+/**
+ * MQTT connection state as of the WiFi task's last reconnectMQTT()
+ * For other tasks (status reports): mqttClient.connected() tears down a
+ * dropped connection, so only the WiFi task may call it.
+ * return true if connected to the broker
+ */
+bool isMqttConnected();
+
 /**
  * Publish spell detection event to MQTT broker
  * Sends spell name to configured MQTT topic.
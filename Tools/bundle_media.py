@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""
+Media Bundler for the Flash Media Partition
+Packs the built-in spell images and sounds into one image for the
+"media" flash partition (firmware built with the MEDIA_PARTITION flag)
+
+Files are stored unchanged under the same paths the firmware uses on the
+SD card (/<spell>.bmp, /<spell>.anim, /sounds/<name>.wav), so a file on
+the card with the same path overrides the built-in one. Only formats the
+firmware can play are packed: 24-bit uncompressed BMPs, animations from
+encode_animation.py and 16-bit PCM WAVs.
+
+Bundle layout (little endian, see mediaBundle.h):
+  header   magic "GRMB", u16 version, u16 count, u32 size, u32 reserved
+  index    count x (char path[56], u32 offset, u32 size)
+  data     each file, 4-byte aligned
+
+Usage:
+  python bundle_media.py --out media.bin
+  python bundle_media.py --out media.bin --port COM4   (also flashes it)
+"""
+
+import argparse
+import os
+import struct
+import subprocess
+import sys
+
+MAGIC = b'GRMB'
+VERSION = 1
+HEADER_FORMAT = '<4sHHII'
+ENTRY_FORMAT = '<56sII'
+PATH_LENGTH = 56    # Including terminator
+ALIGN = 4
+
+FIRMWARE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'Firmware')
+
+
+def read_partition(csv_path, label):
+    """Offset and size of a partition in a partition table CSV"""
+    with open(csv_path) as table:
+        for line in table:
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+            fields = [field.strip() for field in line.split(',')]
+            if fields[0] == label:
+                return int(fields[3], 0), int(fields[4], 0)
+    sys.exit(f"No '{label}' partition in {csv_path}")
+
+
+def check_bmp(data):
+    """Reason the firmware can't draw a BMP, or None"""
+    if len(data) < 54 or data[:2] != b'BM':
+        return 'not a BMP'
+    bit_depth, compression = struct.unpack_from('<HI', data, 28)
+    if bit_depth != 24 or compression != 0:
+        return f'{bit_depth}-bit/compression {compression} (needs 24-bit uncompressed)'
+    return None
+
+
+def check_wav(data):
+    """Reason the firmware can't play a WAV, or None"""
+    if len(data) < 36 or data[:4] != b'RIFF' or data[8:12] != b'WAVE' or data[12:16] != b'fmt ':
+        return 'not a RIFF/WAVE file'
+    audio_format, channels = struct.unpack_from('<HH', data, 20)
+    bits = struct.unpack_from('<H', data, 34)[0]
+    if audio_format != 1 or bits != 16 or channels not in (1, 2):
+        return f'format {audio_format}, {bits}-bit, {channels} channels (needs 16-bit PCM mono/stereo)'
+    return None
+
+
+def check_anim(data):
+    """Reason the firmware can't play an animation, or None"""
+    if len(data) < 20 or data[:4] != b'GRAN' or struct.unpack_from('<H', data, 4)[0] != 1:
+        return 'not an encode_animation.py file (version 1)'
+    return None
+
+
+def collect(directory, extension, prefix, check):
+    """(path, data) for each playable file in a directory"""
+    assets = []
+    for name in sorted(os.listdir(directory)):
+        if not name.lower().endswith(extension):
+            continue
+        with open(os.path.join(directory, name), 'rb') as source:
+            data = source.read()
+        problem = check(data)
+        if problem:
+            print(f"  skipped {name}: {problem}")
+            continue
+        path = prefix + name.lower()
+        if len(path) >= PATH_LENGTH:
+            print(f"  skipped {name}: path longer than {PATH_LENGTH - 1} characters")
+            continue
+        assets.append((path, data))
+    return assets
+
+
+def build_bundle(assets):
+    """Bundle bytes for a list of (path, data)"""
+    data_start = struct.calcsize(HEADER_FORMAT) + len(assets) * struct.calcsize(ENTRY_FORMAT)
+    index = b''
+    body = b''
+    for path, data in assets:
+        offset = data_start + len(body)
+        index += struct.pack(ENTRY_FORMAT, path.encode('ascii'), offset, len(data))
+        body += data + b'\0' * (-len(data) % ALIGN)
+    size = data_start + len(body)
+    return struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(assets), size, 0) + index + body
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Pack built-in media for the MEDIA_PARTITION build')
+    parser.add_argument('--images', default=os.path.join(FIRMWARE_DIR, 'images'), help='Spell image directory')
+    parser.add_argument('--sounds', default=os.path.join(FIRMWARE_DIR, 'sound files'), help='Sound directory')
+    parser.add_argument('--partitions', default=os.path.join(FIRMWARE_DIR, 'partitions_media.csv'),
+                        help='Partition table with the media partition')
+    parser.add_argument('--out', default='media.bin', help='Bundle file to write')
+    parser.add_argument('--port', help='Also flash the bundle to the reader on this serial port')
+    args = parser.parse_args()
+
+    offset, capacity = read_partition(args.partitions, 'media')
+
+    print('Packing media...')
+    assets = collect(args.images, '.bmp', '/', check_bmp)
+    assets += collect(args.images, '.anim', '/', check_anim)
+    assets += collect(args.sounds, '.wav', '/sounds/', check_wav)
+    bundle = build_bundle(assets)
+
+    for path, data in assets:
+        print(f"  {path:<32} {len(data):>9} bytes")
+    print(f"{len(assets)} files, {len(bundle)} of {capacity} bytes ({100 * len(bundle) / capacity:.0f}%)")
+    if len(bundle) > capacity:
+        sys.exit('Bundle does not fit the media partition - remove files or grow the partition')
+
+    with open(args.out, 'wb') as out:
+        out.write(bundle)
+    print(f"Wrote {args.out} (flash at 0x{offset:X})")
+
+    if args.port:
+        subprocess.run([sys.executable, '-m', 'esptool', '--chip', 'esp32s3', '--port', args.port,
+                        'write_flash', f'0x{offset:X}', args.out], check=True)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""
+Spell Animation Encoder
+Turns a frame sequence or GIF into a .anim file for the reader's display
+
+Frames are drawn like spell BMPs: black is background, grays are tinted
+with the user's primary color and lime (0,255,0) becomes the accent
+color. Copy the result next to the spell's image on the SD card with the
+same name (e.g. /ignite.anim beside /ignite.bmp), or into the images
+directory before running bundle_media.py.
+
+Colors are reduced to a 256-entry palette; black, lime and grays are kept
+exact where possible so tinting still applies. Frames are delta-encoded
+against the previous frame, with a keyframe every --key-interval frames
+so a reader that falls behind can skip ahead. See spellAnimation.h for
+the container layout.
+
+Usage:
+  python encode_animation.py frames/ --fps 15 --out ignite.anim
+  python encode_animation.py sparks.gif --out ignite.anim
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+from PIL import Image, ImageSequence
+
+MAGIC = b'GRAN'
+VERSION = 1
+HEADER_FORMAT = '<4sHHHHHHHH'
+MAX_SIZE = 240          # Display is 240x240
+MAX_FRAME_RATE = 30
+MAX_COUNT = 64          # Pixels or rows per op
+MIN_SKIP = 6            # Shorter unchanged gaps are redrawn (a new span costs more)
+
+SKIP, RUN, LITERAL, SKIP_ROWS = range(4)
+BLACK = (0, 0, 0)
+ACCENT = (0, 255, 0)
+
+
+def load_frames(source):
+    """RGB frames from a GIF/animated image or a directory of images"""
+    if os.path.isdir(source):
+        names = sorted(name for name in os.listdir(source)
+                       if name.lower().endswith(('.png', '.bmp', '.gif', '.jpg')))
+        return [Image.open(os.path.join(source, name)).convert('RGB') for name in names]
+    return [frame.convert('RGB') for frame in ImageSequence.Iterator(Image.open(source))]
+
+
+def is_gray(color):
+    return color[0] == color[1] == color[2]
+
+
+def reduce_color(color, shift):
+    """Drop low bits, keeping grays gray and black/lime exact"""
+    if color in (BLACK, ACCENT):
+        return color
+    return tuple((channel >> shift) << shift for channel in color)
+
+
+def build_palette(frames):
+    """Palette (list of RGB) and a color -> code map covering every pixel"""
+    colors = set()
+    for frame in frames:
+        colors.update(color for _, color in frame.getcolors(1 << 24))
+    for shift in range(8):
+        reduced = {color: reduce_color(color, shift) for color in colors}
+        palette = sorted(set(reduced.values()), key=lambda c: (c != BLACK, not is_gray(c), c))
+        if len(palette) <= 256:
+            if shift:
+                print(f"  {len(colors)} colors, reduced to {len(palette)} (dropped {shift} bits)")
+            codes = {color: index for index, color in enumerate(palette)}
+            return palette, {color: codes[reduced[color]] for color in colors}
+    sys.exit('Too many colors')
+
+
+def encode_ops(codes, previous, width):
+    """Op bytes for one row; previous is None for a keyframe"""
+    # Pixels to draw: changed ones, plus unchanged gaps too short to skip
+    if previous is None:
+        draw = [True] * width
+    else:
+        draw = [code != old for code, old in zip(codes, previous)]
+        x = 0
+        while x < width:
+            end = x
+            while end < width and not draw[end]:
+                end += 1
+            if 0 < x and end < width and end - x < MIN_SKIP:
+                draw[x:end] = [True] * (end - x)
+            x = end + 1
+
+    ops = bytearray()
+    x = 0
+    while x < width:
+        end = x
+        while end < width and draw[end] == draw[x]:
+            end += 1
+        if not draw[x]:
+            while x < end:
+                count = min(end - x, MAX_COUNT)
+                ops.append((SKIP << 6) | (count - 1))
+                x += count
+            continue
+
+        # Runs of three or more, literals in between
+        literal = []
+        while x < end:
+            run = 1
+            while x + run < end and codes[x + run] == codes[x] and run < MAX_COUNT:
+                run += 1
+            if run >= 3:
+                ops += flush_literal(literal)
+                ops.append((RUN << 6) | (run - 1))
+                ops.append(codes[x])
+                x += run
+            else:
+                literal.append(codes[x])
+                x += 1
+        ops += flush_literal(literal)
+    return ops
+
+
+def flush_literal(literal):
+    """Literal op bytes for pending codes (emptied)"""
+    ops = bytearray()
+    while literal:
+        chunk = literal[:MAX_COUNT]
+        del literal[:MAX_COUNT]
+        ops.append((LITERAL << 6) | (len(chunk) - 1))
+        ops += bytes(chunk)
+    return ops
+
+
+def encode_frame(rows, previous_rows, width):
+    """Encoded bytes for one frame"""
+    data = bytearray()
+    skipped = 0
+    for y, row in enumerate(rows):
+        previous = previous_rows[y] if previous_rows is not None else None
+        if previous == row:
+            skipped += 1
+            continue
+        while skipped:
+            count = min(skipped, MAX_COUNT)
+            data.append((SKIP_ROWS << 6) | (count - 1))
+            skipped -= count
+        data += encode_ops(row, previous, width)
+    return data     # Trailing unchanged rows are implied
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Encode a spell animation for the reader')
+    parser.add_argument('source', help='GIF/animated image, or directory of frame images (sorted by name)')
+    parser.add_argument('--out', required=True, help='.anim file to write')
+    parser.add_argument('--fps', type=int, help='Frame rate (default: GIF timing, else 15)')
+    parser.add_argument('--key-interval', type=int, default=8, help='Frames between keyframes')
+    args = parser.parse_args()
+
+    frames = load_frames(args.source)
+    if not frames:
+        sys.exit('No frames found')
+    width, height = frames[0].size
+    if width > MAX_SIZE or height > MAX_SIZE or any(frame.size != (width, height) for frame in frames):
+        sys.exit(f'Frames must all be the same size, at most {MAX_SIZE}x{MAX_SIZE}')
+
+    fps = args.fps
+    if fps is None:
+        duration = Image.open(args.source).info.get('duration') if not os.path.isdir(args.source) else None
+        fps = round(1000 / duration) if duration else 15
+    fps = max(1, min(fps, MAX_FRAME_RATE))
+
+    print(f"Encoding {len(frames)} frames, {width}x{height} at {fps} fps...")
+    palette, code_of = build_palette(frames)
+
+    encoded = []
+    previous_rows = None
+    for index, frame in enumerate(frames):
+        data = frame.tobytes()
+        pixels = [code_of[tuple(data[i:i + 3])] for i in range(0, len(data), 3)]
+        rows = [pixels[y * width:(y + 1) * width] for y in range(height)]
+        key = index % args.key_interval == 0
+        encoded.append(encode_frame(rows, None if key else previous_rows, width))
+        previous_rows = rows
+
+    header = struct.pack(HEADER_FORMAT, MAGIC, VERSION, width, height, len(frames), fps,
+                         args.key_interval, len(palette), 0)
+    palette_bytes = bytes(channel for color in palette for channel in color)
+    palette_bytes += b'\0' * (-len(palette_bytes) % 4)
+    offset = len(header) + len(palette_bytes) + 8 * len(encoded)
+    table = b''
+    for data in encoded:
+        table += struct.pack('<II', offset, len(data))
+        offset += len(data)
+
+    with open(args.out, 'wb') as out:
+        out.write(header + palette_bytes + table + b''.join(encoded))
+
+    raw = width * height * 2
+    sizes = [len(data) for data in encoded]
+    print(f"Wrote {args.out}: {offset} bytes, largest frame {max(sizes)} bytes "
+          f"(raw RGB565 frame {raw}), average {sum(sizes) // len(sizes)}")
+
+
+if __name__ == '__main__':
+    main()
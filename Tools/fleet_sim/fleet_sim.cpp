@@ -0,0 +1,381 @@
+/*
+================================================================================
+  Fleet Sim - Host Simulation of Several Readers Arbitrating Casts
+================================================================================
+
+  Runs the firmware's fleet protocol (fleetProtocol.cpp, FLEET_SYNC) in
+  several simulated readers on one PC, talking over real UDP multicast
+  on the loopback interface, and checks that each cast is published
+  exactly once.
+
+  Each reader is a thread with its own socket and its own clock: a
+  random offset of up to a minute and a random drift, so the clock
+  offset estimation has real work to do. Readers first exchange HELLOs
+  to sync, then the same casts are fed to the readers that "see" them,
+  a little apart in time and with different scores, as when several
+  readers watch one wand.
+
+  Reports:
+    - exactly once / duplicate / lost publishes per cast
+    - best score: the publishing reader had the highest score
+    - latency:    cast to publish decision (the window plus scheduling)
+    - clock:      estimated minus true peer offset, after the run
+
+  Exits with 2 if any cast was lost (published by no reader).
+
+  Build (from this directory):
+    g++ -O2 -std=gnu++17 -pthread -I../../Firmware/src fleet_sim.cpp \
+        ../../Firmware/src/fleetProtocol.cpp -o fleet_sim
+    ./fleet_sim [--readers 3] [--casts 200] [--skew 6] [--detect 0.9]
+                [--loss 0] [--jitter 1] [--drift 50] [--window 12]
+                [--unicast]
+
+  --skew is the largest gap (ms) between readers recognizing one cast,
+  --loss the fraction of datagrams dropped, --jitter extra random
+  delivery delay (ms). --unicast sends to every reader's own port on
+  127.0.0.1 instead, for hosts without a loopback multicast route.
+
+================================================================================
+*/
+
+#include "fleetProtocol.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+//=====================================
+// Simulation Settings
+//=====================================
+
+#define SIM_GROUP "239.71.82.1"         // Same group as the firmware
+#define SIM_PORT 47821                  // Same port as the firmware
+#define SIM_WARMUP_MS 3500              // HELLO exchange before the first cast
+#define SIM_CAST_SPACING_MS 60          // Between casts
+#define SIM_SETTLE_MS 300               // After the last cast
+#define SIM_OFFSET_RANGE_US 60000000LL  // Reader clocks differ by up to this
+
+struct SimOptions {
+  int readers = 3;
+  int casts = 200;
+  double skewMs = 6;
+  double detect = 0.9;
+  double loss = 0;
+  double jitterMs = 1;
+  double driftPpm = 50;
+  int windowMs = FLEET_WINDOW_MS;
+  bool unicast = false;
+};
+
+//=====================================
+// Simulated Reader
+//=====================================
+
+/**
+ * A cast fed to one reader
+ */
+struct SimCast {
+  int64_t at;               // Real time it is recognized (us since start)
+  int event;                // Which cast
+  float score;
+};
+
+/**
+ * A datagram held back for simulated jitter
+ */
+struct SimDelivery {
+  int64_t at;               // Real time to deliver (us since start)
+  std::vector<uint8_t> data;
+};
+
+/**
+ * One decision, collected for the report
+ */
+struct SimOutcome {
+  int reader;
+  int event;
+  bool publish;
+  int64_t latency;          // us
+};
+
+struct SimReader {
+  int index;
+  FleetNode node;
+  int64_t clockOffset;      // Reader clock minus real clock at start (us)
+  double drift;             // Fractional rate error
+  int socket = -1;
+  std::vector<SimCast> casts;
+};
+
+static SimOptions options;
+static std::chrono::steady_clock::time_point simStart;
+static std::vector<SimReader> readers;
+static std::mutex outcomesLock;
+static std::vector<SimOutcome> outcomes;
+static std::atomic<bool> running(true);
+
+/**
+ * Real time since start (us)
+ */
+static int64_t realNow() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - simStart).count();
+}
+
+/**
+ * A reader's clock at a real time
+ */
+static int64_t readerClock(const SimReader& reader, int64_t real) {
+  return reader.clockOffset + real + (int64_t)llround(real * reader.drift);
+}
+
+/**
+ * Open a reader's socket
+ * return false if the host cannot join the group on loopback
+ */
+static bool openSocket(SimReader& reader) {
+  reader.socket = socket(AF_INET, SOCK_DGRAM, 0);
+  int on = 1;
+  setsockopt(reader.socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  setsockopt(reader.socket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options.unicast ? SIM_PORT + reader.index : SIM_PORT);
+  address.sin_addr.s_addr = options.unicast ? htonl(INADDR_LOOPBACK) : htonl(INADDR_ANY);
+  if (bind(reader.socket, (sockaddr*)&address, sizeof(address)) != 0) return false;
+  if (options.unicast) return true;
+
+  ip_mreq membership = {};
+  inet_pton(AF_INET, SIM_GROUP, &membership.imr_multiaddr);
+  membership.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+  if (setsockopt(reader.socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+    return false;
+  }
+  in_addr interface = {};
+  interface.s_addr = htonl(INADDR_LOOPBACK);
+  setsockopt(reader.socket, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface));
+  unsigned char loop = 1;
+  setsockopt(reader.socket, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+  return true;
+}
+
+/**
+ * Send a datagram to the group (or every reader's port)
+ */
+static void sendPacket(const SimReader& reader, const FleetPacket& packet, size_t length) {
+  if (length == 0) return;
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  if (!options.unicast) {
+    address.sin_port = htons(SIM_PORT);
+    inet_pton(AF_INET, SIM_GROUP, &address.sin_addr);
+    sendto(reader.socket, &packet, length, 0, (sockaddr*)&address, sizeof(address));
+    return;
+  }
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  for (const SimReader& other : readers) {
+    if (other.index == reader.index) continue;
+    address.sin_port = htons(SIM_PORT + other.index);
+    sendto(reader.socket, &packet, length, 0, (sockaddr*)&address, sizeof(address));
+  }
+}
+
+/**
+ * Reader thread: the same loop as the firmware's fleet task
+ */
+static void runReader(SimReader& reader, uint32_t seed) {
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::vector<SimDelivery> held;
+  size_t nextCast = 0;
+  FleetPacket packet;
+
+  while (running) {
+    int64_t real = realNow();
+    int64_t now = readerClock(reader, real);
+
+    // Due casts, held datagrams, HELLOs and decisions
+    while (nextCast < reader.casts.size() && reader.casts[nextCast].at <= real) {
+      const SimCast& cast = reader.casts[nextCast++];
+      std::string payload = "cast" + std::to_string(cast.event);
+      sendPacket(reader, packet, fleetAnnounceCast(reader.node, payload.c_str(), cast.score, now, packet));
+    }
+    for (size_t i = 0; i < held.size();) {
+      if (held[i].at <= real) {
+        fleetReceive(reader.node, held[i].data.data(), held[i].data.size(), now);
+        held.erase(held.begin() + i);
+      } else {
+        i++;
+      }
+    }
+    sendPacket(reader, packet, fleetHello(reader.node, now, packet));
+    FleetDecision decision;
+    while (fleetDecide(reader.node, now, decision)) {
+      {
+        std::lock_guard<std::mutex> guard(outcomesLock);
+        outcomes.push_back({reader.index, atoi(decision.payload + 4), decision.publish, decision.latency});
+      }
+      sendPacket(reader, packet, fleetClaim(reader.node, decision, now, packet));
+    }
+
+    // Sleep until the next due item or a datagram
+    int64_t wake = real + (fleetNextEvent(reader.node) - now);
+    if (nextCast < reader.casts.size()) wake = std::min(wake, reader.casts[nextCast].at);
+    for (const SimDelivery& delivery : held) wake = std::min(wake, delivery.at);
+    wake = std::min(wake, real + 50000);  // Check running now and then
+    int64_t wait = std::max<int64_t>(0, wake - realNow());
+    timespec timeout = {(time_t)(wait / 1000000), (long)(wait % 1000000) * 1000};
+    pollfd poller = {reader.socket, POLLIN, 0};
+    if (ppoll(&poller, 1, &timeout, nullptr) <= 0) continue;
+
+    uint8_t buffer[512];
+    ssize_t length = recv(reader.socket, buffer, sizeof(buffer), 0);
+    if (length <= 0 || unit(random) < options.loss) continue;
+    int64_t arrive = realNow() + (int64_t)(unit(random) * options.jitterMs * 1000);
+    held.push_back({arrive, std::vector<uint8_t>(buffer, buffer + length)});
+  }
+  close(reader.socket);
+}
+
+//=====================================
+// Main
+//=====================================
+
+static void parseOptions(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : "0";
+    if (flag == "--readers") options.readers = std::max(2, std::min(FLEET_MAX_PEERS + 1, atoi(value))), i++;
+    else if (flag == "--casts") options.casts = atoi(value), i++;
+    else if (flag == "--skew") options.skewMs = atof(value), i++;
+    else if (flag == "--detect") options.detect = atof(value), i++;
+    else if (flag == "--loss") options.loss = atof(value), i++;
+    else if (flag == "--jitter") options.jitterMs = atof(value), i++;
+    else if (flag == "--drift") options.driftPpm = atof(value), i++;
+    else if (flag == "--window") options.windowMs = atoi(value), i++;
+    else if (flag == "--unicast") options.unicast = true;
+    else {
+      fprintf(stderr, "Unknown option %s\n", argv[i]);
+      exit(1);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  parseOptions(argc, argv);
+  std::mt19937 random(1234);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+  // Readers with their own clocks
+  readers.resize(options.readers);
+  for (int i = 0; i < options.readers; i++) {
+    SimReader& reader = readers[i];
+    reader.index = i;
+    reader.clockOffset = (int64_t)((unit(random) - 0.5) * SIM_OFFSET_RANGE_US);
+    reader.drift = (unit(random) - 0.5) * 2 * options.driftPpm * 1e-6;
+    initFleetNode(reader.node, 0x100 + i, reader.clockOffset);
+    reader.node.config.window = options.windowMs * 1000LL;
+    if (!openSocket(reader)) {
+      fprintf(stderr, "Could not open reader %d's socket%s\n", i,
+              options.unicast ? "" : " (no loopback multicast? try --unicast)");
+      return 1;
+    }
+  }
+
+  // The same casts seen by several readers, a little apart, scored differently
+  std::vector<std::vector<float>> scores(options.casts, std::vector<float>(options.readers, -1));
+  for (int event = 0; event < options.casts; event++) {
+    int64_t at = (SIM_WARMUP_MS + (int64_t)event * SIM_CAST_SPACING_MS) * 1000;
+    for (SimReader& reader : readers) {
+      if (unit(random) >= options.detect) continue;
+      float score = 0.6f + 0.4f * (float)unit(random);
+      int64_t skew = (int64_t)(unit(random) * options.skewMs * 1000);
+      reader.casts.push_back({at + skew, event, score});
+      scores[event][reader.index] = score;
+    }
+  }
+
+  printf("Fleet sim: %d readers, %d casts, skew %.1f ms, detect %.0f%%, loss %.0f%%, jitter %.1f ms, window %d ms (%s)\n",
+         options.readers, options.casts, options.skewMs, options.detect * 100, options.loss * 100,
+         options.jitterMs, options.windowMs, options.unicast ? "unicast" : "multicast");
+
+  simStart = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (SimReader& reader : readers) threads.emplace_back(runReader, std::ref(reader), 99 + reader.index);
+  int64_t end = (SIM_WARMUP_MS + (int64_t)options.casts * SIM_CAST_SPACING_MS + SIM_SETTLE_MS) * 1000;
+  std::this_thread::sleep_for(std::chrono::microseconds(end));
+  running = false;
+  for (std::thread& thread : threads) thread.join();
+  int64_t finish = realNow();
+
+  // Publishes per cast
+  int seen = 0, once = 0, duplicate = 0, lost = 0, best = 0;
+  std::vector<int64_t> latencies;
+  for (int event = 0; event < options.casts; event++) {
+    int detectors = 0, publishers = 0, winner = -1;
+    for (int i = 0; i < options.readers; i++) detectors += scores[event][i] >= 0;
+    if (detectors == 0) continue;
+    seen++;
+    for (const SimOutcome& outcome : outcomes) {
+      if (outcome.event != event) continue;
+      latencies.push_back(outcome.latency);
+      if (outcome.publish) publishers++, winner = outcome.reader;
+    }
+    if (publishers == 1) {
+      once++;
+      float top = *std::max_element(scores[event].begin(), scores[event].end());
+      if (scores[event][winner] == top) best++;
+    } else if (publishers > 1) {
+      duplicate++;
+    } else {
+      lost++;
+    }
+  }
+  std::sort(latencies.begin(), latencies.end());
+
+  printf("\n%-14s %8s\n", "casts seen", std::to_string(seen).c_str());
+  printf("%-14s %7.1f%%\n", "exactly once", 100.0 * once / std::max(seen, 1));
+  printf("%-14s %7.1f%%\n", "duplicate", 100.0 * duplicate / std::max(seen, 1));
+  printf("%-14s %7.1f%%\n", "lost", 100.0 * lost / std::max(seen, 1));
+  printf("%-14s %7.1f%%  (of exactly once)\n", "best score", 100.0 * best / std::max(once, 1));
+  if (!latencies.empty()) {
+    printf("%-14s %7.2f ms median, %.2f ms max\n", "latency",
+           latencies[latencies.size() / 2] / 1000.0, latencies.back() / 1000.0);
+  }
+
+  // Clock offset estimates against the true offsets at the end of the run
+  double errorSum = 0, errorMax = 0;
+  int pairs = 0, unsynced = 0;
+  for (const SimReader& reader : readers) {
+    for (const SimReader& other : readers) {
+      if (other.index == reader.index) continue;
+      const FleetPeer* peer = fleetFindPeer(reader.node, other.node.id);
+      if (peer == nullptr || !peer->synced) {
+        unsynced++;
+        continue;
+      }
+      double truth = (double)(readerClock(other, finish) - readerClock(reader, finish));
+      double error = fabs(peer->offset - truth);
+      errorSum += error;
+      errorMax = std::max(errorMax, error);
+      pairs++;
+    }
+  }
+  printf("%-14s %7.0f us mean, %.0f us max error (%d pairs, %d unsynced)\n", "clock",
+         pairs ? errorSum / pairs : 0.0, errorMax, pairs, unsynced);
+  return lost == 0 ? 0 : 2;  // Duplicates are allowed under loss, lost casts never
+}
@@ -0,0 +1,58 @@
+/*
+  Minimal Arduino API for building the firmware's matching code on a PC.
+  Only what spell_patterns/spell_matching/spellIndex use - not a port.
+*/
+#ifndef MATCH_BENCH_ARDUINO_H
+#define MATCH_BENCH_ARDUINO_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include "freertos/FreeRTOS.h"   // ESP32 Arduino.h includes these too
+#include "freertos/task.h"
+
+using std::min;
+using std::max;
+using std::abs;   // As the ESP32 core does - without it abs(float) truncates to int
+
+template <class T, class L, class H>
+T constrain(T value, L low, H high) { return value < low ? low : (value > high ? high : value); }
+
+typedef uint8_t byte;
+
+inline long map(long x, long inLow, long inHigh, long outLow, long outHigh) {
+  return (x - inLow) * (outHigh - outLow) / (inHigh - inLow) + outLow;
+}
+
+// Time and randomness - declared only; tools that run code calling them
+// define them (the tuner replays recordings on a virtual clock)
+uint32_t millis();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+long random(long low, long high);
+long random(long high);
+
+class String {
+ public:
+  String() {}
+  String(const char* s) : value(s ? s : "") {}
+  const char* c_str() const { return value.c_str(); }
+  size_t length() const { return value.size(); }
+  bool equalsIgnoreCase(const String& other) const { return strcasecmp(c_str(), other.c_str()) == 0; }
+ private:
+  std::string value;
+};
+
+// Firmware serial output is discarded; the benchmark prints with printf
+class HardwareSerial {
+ public:
+  int printf(const char*, ...) { return 0; }
+  void print(const char*) {}
+  void println(const char* = "") {}
+};
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,5 @@
+// Declarations only - preferenceFunctions.h names this type
+#ifndef MATCH_BENCH_PREFERENCES_H
+#define MATCH_BENCH_PREFERENCES_H
+class Preferences {};
+#endif
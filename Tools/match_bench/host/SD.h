@@ -0,0 +1,6 @@
+// Declarations only - sdFunctions.h names these types, the benchmark never calls them
+#ifndef MATCH_BENCH_SD_H
+#define MATCH_BENCH_SD_H
+#define FILE_READ "r"
+class File {};
+#endif
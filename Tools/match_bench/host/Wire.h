@@ -0,0 +1 @@
+// Not used by the matching code (pulled in by glyphReader.h)
@@ -0,0 +1,14 @@
+// Task API subset used by spellIndex.cpp (worker never starts on the host)
+#ifndef MATCH_BENCH_FREERTOS_H
+#define MATCH_BENCH_FREERTOS_H
+#include <cstdint>
+typedef void* TaskHandle_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void*);
+#define pdPASS 1
+#define pdTRUE 1
+#define portMAX_DELAY 0xffffffff
+inline BaseType_t xPortGetCoreID() { return 1; }
+#endif
@@ -0,0 +1,254 @@
+/*
+================================================================================
+  Match Bench - Host Benchmark of the Spell Matchers
+================================================================================
+
+  Builds the firmware's matching code (spell_patterns, spell_matching,
+  spellIndex) on a PC and compares the default point/direction matcher
+  with the chain-code matcher (CHAIN_MATCHING preference) on synthetic
+  casts of the built-in spells.
+
+  Casts:
+    - clean:  small shear/scale error and hand jitter
+    - sloppy: larger shear/scale error and jitter
+    - wobble: clean, plus hesitations - small back-and-forth zig-zags
+              inserted mid-stroke, as from a pause or a shaky hand
+
+  For each cast type and matcher it reports:
+    - accuracy: correct spell at or above MATCH_THRESHOLD
+    - wrong:    a different spell at or above MATCH_THRESHOLD
+    - score:    mean score of the correct spell
+    - us/cast:  findBestSpell() time per gesture
+
+  Then the error of 8-bit templates (QuantizedPattern) against the float
+  path over every cast/template pair: mean and worst score difference,
+  how often the best spell changes, and bytes per template.
+
+  Build (from this directory):
+    g++ -O2 -std=gnu++17 -DENV_PROD -Ihost -I../../Firmware/src match_bench.cpp \
+        ../../Firmware/src/spell_patterns.cpp ../../Firmware/src/spell_matching.cpp \
+        ../../Firmware/src/spellIndex.cpp -o match_bench
+    ./match_bench [casts per spell, default 200]
+
+  Add -DQUANTIZED_TEMPLATES to run the matcher table on quantized storage.
+  Host timings show the relative cost of the matchers; absolute numbers
+  on the ESP32-S3 are far higher.
+
+================================================================================
+*/
+
+#include "spell_matching.h"
+#include "spellIndex.h"
+#include "logFunctions.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+//=====================================
+// Firmware Symbols Not Under Test
+//=====================================
+
+HardwareSerial Serial;
+bool CHAIN_MATCHING = false;
+
+bool loadCustomSpells() { return true; }
+void invalidateSpellActions() {}
+void invalidateSpellCombos() {}
+void visualizeSpellPattern(const char*, const std::vector<Point>&) {}
+
+// Logging off: every module at LOG_LEVEL_OFF, nothing is ever queued
+uint8_t logLevels[(size_t)LogModule::COUNT] = {};
+LogSlot* logReserve() { return nullptr; }
+void logPublish(LogSlot*) {}
+void logPack(LogPacker&, const char*) {}
+
+// Memory policy: host has one heap
+void* policyMalloc(size_t size, AllocPolicy) { return malloc(size); }
+void policyFree(void* buffer) { free(buffer); }
+
+//=====================================
+// Synthetic Casts
+//=====================================
+
+enum class CastType { CLEAN, SLOPPY, WOBBLE };
+
+static const char* castName(CastType type) {
+  switch (type) {
+    case CastType::CLEAN: return "clean";
+    case CastType::SLOPPY: return "sloppy";
+    case CastType::WOBBLE: return "wobble";
+  }
+  return "";
+}
+
+/**
+ * Draw a spell the way a hand might
+ * Random affine distortion plus correlated jitter on the resampled
+ * template; WOBBLE casts also get 1-3 zig-zag hesitations.
+ */
+static std::vector<Point> drawCast(const std::vector<Point>& pattern, CastType type, std::mt19937& rng) {
+  std::normal_distribution<float> noise(0, 1);
+  float amount = (type == CastType::SLOPPY) ? 2.0f : 1.0f;
+  float a = 1 + 0.15f * amount * noise(rng), b = 0.15f * amount * noise(rng);
+  float c = 0.15f * amount * noise(rng), d = 1 + 0.15f * amount * noise(rng);
+
+  std::vector<Point> cast;
+  float ox = 0, oy = 0;
+  for (const Point& p : pattern) {
+    ox = 0.8f * ox + 12 * amount * noise(rng);
+    oy = 0.8f * oy + 12 * amount * noise(rng);
+    cast.push_back({(int)(a * p.x + b * p.y + ox), (int)(c * p.x + d * p.y + oy), 0});
+  }
+
+  if (type == CastType::WOBBLE) {
+    std::uniform_int_distribution<int> hesitations(1, 3);
+    for (int h = hesitations(rng); h > 0; h--) {
+      size_t at = 5 + rng() % (cast.size() - 10);
+      Point p = cast[at];
+      float dx = cast[at + 1].x - cast[at - 1].x;
+      float dy = cast[at + 1].y - cast[at - 1].y;
+      float length = std::max(1.0f, sqrtf(dx * dx + dy * dy));
+      // Back and forth along the stroke, then on again
+      std::vector<Point> zigzag;
+      for (int k = 1; k <= 3; k++) {
+        float back = (k % 2) ? -60.0f : 0.0f;
+        zigzag.push_back({(int)(p.x + dx / length * back), (int)(p.y + dy / length * back), 0});
+      }
+      cast.insert(cast.begin() + at + 1, zigzag.begin(), zigzag.end());
+    }
+  }
+  return cast;
+}
+
+//=====================================
+// Benchmark
+//=====================================
+
+struct Result {
+  int correct = 0;
+  int wrong = 0;
+  double scoreSum = 0;
+  double micros = 0;
+};
+
+static Result run(const std::vector<std::vector<Point>>& casts, const std::vector<size_t>& truth, bool chain) {
+  CHAIN_MATCHING = chain;
+  Result result;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < casts.size(); i++) {
+    float score = 0;
+    const char* spell = findBestSpell(casts[i], score);
+    if (score >= MATCH_THRESHOLD) {
+      if (strcmp(spell, spellPatterns[truth[i]].name) == 0) {
+        result.correct++;
+      } else {
+        result.wrong++;
+      }
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  result.micros = std::chrono::duration<double, std::micro>(end - start).count() / casts.size();
+
+  // Correct-spell score (separately, so it doesn't count in the timing)
+  uint8_t symbols[CHAIN_LENGTH];
+  std::vector<Point> cloud;
+  for (size_t i = 0; i < casts.size(); i++) {
+    const SpellPattern& spell = spellPatterns[truth[i]];
+    if (chain) {
+      computeChainSymbols(casts[i], symbols);
+      result.scoreSum += calculateChainSimilarity(symbols, spell.chain);
+    } else {
+      result.scoreSum += scoreExemplar(spell, 0, casts[i], cloud);
+    }
+  }
+  return result;
+}
+
+/**
+ * Quantized vs float scores of every cast against every ordered template
+ * Casts are quantized once, as findBestSpell() does per gesture.
+ */
+static void quantizationError(const std::vector<std::vector<Point>>& casts) {
+  double sum = 0, worst = 0;
+  size_t pairs = 0, flips = 0;
+  for (const auto& cast : casts) {
+    QuantizedPattern castQuantized = quantizePattern(cast);
+    float bestFloat = -1, bestQuantized = -1;
+    size_t bestFloatSpell = 0, bestQuantizedSpell = 0;
+    for (size_t s = 0; s < spellPatterns.size(); s++) {
+      if (spellPatterns[s].anyOrder) continue;
+      std::vector<Point> points = exemplarPoints(spellPatterns[s], 0);
+      float exact = calculateSimilarity(cast, points);
+      float approx = calculateSimilarity(castQuantized, quantizePattern(points));
+      double error = fabs(exact - approx);
+      sum += error;
+      worst = std::max(worst, error);
+      pairs++;
+      if (exact > bestFloat) { bestFloat = exact; bestFloatSpell = s; }
+      if (approx > bestQuantized) { bestQuantized = approx; bestQuantizedSpell = s; }
+    }
+    if (bestFloatSpell != bestQuantizedSpell) flips++;
+  }
+  printf("        8-bit  error mean %.4f, worst %.4f, best spell changed %zu/%zu\n",
+         sum / pairs, worst, flips, casts.size());
+}
+
+int main(int argc, char** argv) {
+  int perSpell = (argc > 1) ? atoi(argv[1]) : 200;
+  initSpellPatterns();
+  std::mt19937 rng(1);
+
+  printf("%zu spells, %d casts each, MATCH_THRESHOLD %.2f\n\n", spellPatterns.size(), perSpell,
+         (float)MATCH_THRESHOLD);
+  printf("%-7s %-6s %9s %7s %7s %8s\n", "cast", "match", "accuracy", "wrong", "score", "us/cast");
+
+  for (CastType type : {CastType::CLEAN, CastType::SLOPPY, CastType::WOBBLE}) {
+    std::vector<std::vector<Point>> casts;
+    std::vector<size_t> truth;
+    for (size_t s = 0; s < spellPatterns.size(); s++) {
+      if (spellPatterns[s].anyOrder) continue;
+      for (int i = 0; i < perSpell; i++) {
+        std::vector<Point> cast = drawCast(exemplarPoints(spellPatterns[s], 0), type, rng);
+        casts.push_back(resampleTrajectory(normalizeTrajectory(cast), RESAMPLE_POINTS));
+        truth.push_back(s);
+      }
+    }
+
+    for (bool chain : {false, true}) {
+      Result r = run(casts, truth, chain);
+      printf("%-7s %-6s %8.1f%% %6.1f%% %6.2f %8.1f\n", castName(type), chain ? "chain" : "point",
+             100.0 * r.correct / casts.size(), 100.0 * r.wrong / casts.size(),
+             r.scoreSum / casts.size(), r.micros);
+    }
+    quantizationError(casts);
+  }
+
+  // Per-template cost, without prefilter or index
+  std::vector<Point> cast = exemplarPoints(spellPatterns[0], 0);
+  std::vector<std::vector<Point>> floats;
+  std::vector<QuantizedPattern> quantized;
+  for (const auto& spell : spellPatterns) {
+    floats.push_back(exemplarPoints(spell, 0));
+    quantized.push_back(quantizePattern(floats.back()));
+  }
+  QuantizedPattern castQuantized = quantizePattern(cast);
+  uint8_t symbols[CHAIN_LENGTH];
+  computeChainSymbols(cast, symbols);
+  const int repeats = 20000;
+  volatile float sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeats; i++) sink = sink + calculateSimilarity(cast, floats[i % floats.size()]);
+  auto t1 = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeats; i++) sink = sink + calculateSimilarity(castQuantized, quantized[i % quantized.size()]);
+  auto t2 = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeats; i++) sink = sink + calculateChainSimilarity(symbols, spellPatterns[i % spellPatterns.size()].chain);
+  auto t3 = std::chrono::steady_clock::now();
+  printf("\nper template: point %.3f us, quantized %.3f us, chain %.3f us\n",
+         std::chrono::duration<double, std::micro>(t1 - t0).count() / repeats,
+         std::chrono::duration<double, std::micro>(t2 - t1).count() / repeats,
+         std::chrono::duration<double, std::micro>(t3 - t2).count() / repeats);
+  printf("template bytes: point %zu, quantized %zu\n", RESAMPLE_POINTS * sizeof(Point),
+         sizeof(QuantizedPattern));
+  return 0;
+}
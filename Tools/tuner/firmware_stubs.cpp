@@ -0,0 +1,102 @@
+/*
+  Firmware symbols outside the capture/matching path, stubbed for the tuner.
+  LEDs, screen, sound and MQTT do nothing; publishSpell() records the cast
+  for the replay. Preference globals are set per configuration by tuner.cpp.
+*/
+
+#include "glyphReader.h"
+#include "buttonFunctions.h"
+#include "customSpellFunctions.h"
+#include "led_control.h"
+#include "preferenceFunctions.h"
+#include "replay.h"
+#include "screenFunctions.h"
+#include "spell_matching.h"
+
+HardwareSerial Serial;
+Adafruit_GC9A01A tft;
+
+// Logging off: every module at LOG_LEVEL_OFF, nothing is ever queued
+uint8_t logLevels[(size_t)LogModule::COUNT] = {};
+LogSlot* logReserve() { return nullptr; }
+void logPublish(LogSlot*) {}
+void logPack(LogPacker&, const char*) {}
+
+// Memory policy: host has one heap
+void* policyMalloc(size_t size, AllocPolicy) { return malloc(size); }
+void policyFree(void* buffer) { free(buffer); }
+
+//=====================================
+// Tunables (tuner_params.h)
+//=====================================
+
+float tunerMatchThreshold = 0.75f;
+int tunerResamplePoints = 100;
+float tunerPositionWeight = 0.6f;
+int tunerMinBoundingBox = 200;
+int tunerPointJump = 40;
+
+//=====================================
+// Preferences
+//=====================================
+
+String NIGHTLIGHT_ON_SPELL;
+String NIGHTLIGHT_OFF_SPELL;
+String NIGHTLIGHT_RAISE_SPELL;
+String NIGHTLIGHT_LOWER_SPELL;
+int NIGHTLIGHT_BRIGHTNESS = 150;
+int MOVEMENT_THRESHOLD = DEFAULT_MOVEMENT_THRESHOLD;
+int STILLNESS_THRESHOLD = DEFAULT_STILLNESS_THRESHOLD;
+int READY_STILLNESS_TIME = DEFAULT_READY_STILLNESS_TIME;
+int GESTURE_TIMEOUT = DEFAULT_GESTURE_TIMEOUT;
+int IR_LOSS_TIMEOUT = DEFAULT_IR_LOSS_TIMEOUT;
+bool SPOTTING_ENABLED = false;
+bool CHAIN_MATCHING = false;
+
+void setPref(PrefKey, int) {}
+
+//=====================================
+// Application State
+//=====================================
+
+unsigned long screenOnTime = 0;
+unsigned long ledOnTime = 0;
+unsigned long screenSpellOnTime = 0;
+bool nightlightActive = false;
+bool inSettingsMode = false;
+bool isRecordingCustomSpell = false;
+SpellRecordingState spellRecordingState = SPELL_RECORD_IDLE;
+std::vector<Point> recordedSpellPattern;
+std::vector<std::vector<Point>> recordedSpellTakes;
+
+bool loadCustomSpells() { return true; }
+bool hasSpellImage(const char*) { return false; }
+String getSpellImageFilename(const char*) { return ""; }
+String getSpellAnimationFilename(const char*) { return ""; }
+
+//=====================================
+// Output
+//=====================================
+
+void publishSpell(const char* spellName) {
+  if (replayCast.empty()) replayCast = spellName;
+}
+
+void displaySpellName(const char*) {}
+void displaySpellName(const char*, const char*, const char*) {}
+void drawIRPoint(int, int, bool) {}
+void clearDisplay() {}
+void backlightOn() {}
+void showReadyBackground() {}
+void visualizeSpellPattern(const char*, const std::vector<Point>&) {}
+void visualizeMatchComparison(const char*, const std::vector<Point>&, const std::vector<Point>&, float) {}
+
+void lockUi() {}
+void unlockUi() {}
+
+void ledOff() {}
+void ledSolid(const char*) {}
+void ledNightlight(int) {}
+void ledRandomEffect() {}
+
+bool playSound(const char*) { return true; }
@@ -0,0 +1 @@
+// Not used by the replayed code (pulled in by screenFunctions.h)
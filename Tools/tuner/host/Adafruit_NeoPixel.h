@@ -0,0 +1,5 @@
+// Declarations only - led_control.h names this type
+#ifndef TUNER_NEOPIXEL_H
+#define TUNER_NEOPIXEL_H
+class Adafruit_NeoPixel {};
+#endif
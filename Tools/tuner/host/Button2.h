@@ -0,0 +1,5 @@
+// Declarations only - buttonFunctions.h names this type
+#ifndef TUNER_BUTTON2_H
+#define TUNER_BUTTON2_H
+class Button2 {};
+#endif
@@ -0,0 +1,5 @@
+// Declarations only - wifiFunctions.h names this type
+#ifndef TUNER_PUBSUBCLIENT_H
+#define TUNER_PUBSUBCLIENT_H
+class PubSubClient {};
+#endif
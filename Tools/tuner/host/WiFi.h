@@ -0,0 +1,5 @@
+// Declarations only - wifiFunctions.h names this type
+#ifndef TUNER_WIFI_H
+#define TUNER_WIFI_H
+class WiFiClient {};
+#endif
@@ -0,0 +1,28 @@
+/*
+  I2C replay for the tuner: requestFrom() hands readCameraData() the
+  Pixart frame currently being replayed (see replay.cpp).
+*/
+#ifndef TUNER_WIRE_H
+#define TUNER_WIRE_H
+
+#include <cstdint>
+#include <cstddef>
+
+class TwoWire {
+ public:
+  void beginTransmission(int) {}
+  size_t write(uint8_t) { return 1; }
+  uint8_t endTransmission(bool = true) { return 0; }
+  uint8_t requestFrom(int address, int length);
+  int available() { return length - position; }
+  int read() { return position < length ? frame[position++] : -1; }
+
+  uint8_t frame[16] = {};   ///< Packet returned by the next requestFrom()
+ private:
+  int length = 0;
+  int position = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+Corpus Recorder for the Gesture Tuner
+Saves cast attempts from the wand camera as replayable log files
+
+Reads the IR lines printed by a build with the OUTPUT_POINTS flag and
+writes one file per attempt to <out>/<spell>/NNN.log. An attempt ends
+when no IR point has been seen for GAP_MS; each file keeps the wand
+being raised, held, the cast and the wand being lowered, so the tuner
+replays the whole state machine. Record motion that should NOT cast
+anything with --spell none.
+
+Usage:
+  python record_corpus.py --port COM4 --spell Unlock --count 30
+"""
+
+import argparse
+import os
+import sys
+
+import serial
+
+BAUD_RATE = 115200
+GAP_MS = 1000  # IR absent this long ends an attempt
+
+
+def frame_has_ir(line):
+    """True if any of the four blobs in an IR line was detected"""
+    fields = line.split(',')
+    return len(fields) == 14 and any(fields[2 + i * 3] != '-1' for i in range(4))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Record cast attempts for Tools/tuner')
+    parser.add_argument('--port', default='COM4', help='Serial port of the reader')
+    parser.add_argument('--spell', required=True, help='Spell being cast, or "none"')
+    parser.add_argument('--count', type=int, default=30, help='Attempts to record')
+    parser.add_argument('--out', default='corpus', help='Corpus directory')
+    args = parser.parse_args()
+
+    directory = os.path.join(args.out, args.spell)
+    os.makedirs(directory, exist_ok=True)
+    number = len([name for name in os.listdir(directory) if name.endswith('.log')])
+
+    port = serial.Serial(args.port, BAUD_RATE, timeout=1)
+    print(f"Recording {args.count} attempts of '{args.spell}' into {directory} (Ctrl+C to stop)")
+
+    attempt = []        # Lines of the attempt in progress
+    last_seen = None    # Timestamp of the last frame with IR
+    recorded = 0
+    try:
+        while recorded < args.count:
+            line = port.readline().decode('utf-8', errors='ignore').strip()
+            if not line.startswith('IR,'):
+                continue
+            time = int(line.split(',')[1])
+            if frame_has_ir(line):
+                last_seen = time
+            if last_seen is None:
+                continue  # Idle before the first attempt
+            attempt.append(line)
+
+            if time - last_seen >= GAP_MS:
+                number += 1
+                recorded += 1
+                path = os.path.join(directory, f'{number:03d}.log')
+                with open(path, 'w') as file:
+                    file.write('\n'.join(attempt) + '\n')
+                print(f'  {recorded}/{args.count}: {path} ({len(attempt)} frames)')
+                attempt = []
+                last_seen = None
+    except KeyboardInterrupt:
+        pass
+    finally:
+        port.close()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
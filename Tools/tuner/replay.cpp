@@ -0,0 +1,278 @@
+/*
+================================================================================
+  Replay - Gesture Corpus Through the Firmware State Machine
+================================================================================
+
+  Virtual Clock:
+    millis() returns the timestamp of the frame being replayed. delay()
+    moves the clock forward and frames that arrive while the firmware is
+    "blocked" are dropped, as the device would not have read them.
+
+  Between attempts 1.5 s of empty frames are fed so the state machine is
+  back in WAITING_FOR_IR (and any IR-loss processing has run) before the
+  next attempt starts.
+
+================================================================================
+*/
+
+#include "replay.h"
+#include "cameraFunctions.h"
+#include "spell_matching.h"
+#include <Wire.h>
+#include <ctime>
+#include <dirent.h>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+//=====================================
+// Virtual Clock and I2C
+//=====================================
+
+TwoWire Wire;
+
+static uint32_t virtualTime = 0;
+static std::mt19937 firmwareRandom(1);
+
+uint32_t millis() { return virtualTime; }
+void delay(uint32_t ms) { virtualTime += ms; }
+void delayMicroseconds(uint32_t) {}
+long random(long low, long high) { return low + (long)(firmwareRandom() % (uint32_t)(high - low)); }
+long random(long high) { return random(0, high); }
+
+uint8_t TwoWire::requestFrom(int, int count) {
+  length = count < 16 ? count : 16;
+  position = 0;
+  return length;
+}
+
+/**
+ * Pack a frame into the Pixart's 16-byte blob report
+ * Absent blobs are sent as 0x3FF coordinates, as the camera does.
+ */
+static void packFrame(const Frame& frame) {
+  memset(Wire.frame, 0, sizeof(Wire.frame));
+  for (int i = 0; i < 4; i++) {
+    int offset = 1 + i * 3;
+    int x = frame.x[i] < 0 ? 0x3FF : frame.x[i];
+    int y = frame.x[i] < 0 ? 0x3FF : frame.y[i];
+    Wire.frame[offset] = x & 0xFF;
+    Wire.frame[offset + 1] = y & 0xFF;
+    Wire.frame[offset + 2] = ((y >> 2) & 0xC0) | ((x >> 4) & 0x30) | (frame.size[i] & 0x0F);
+  }
+}
+
+//=====================================
+// Cast Outcomes
+//=====================================
+
+std::string replayCast;
+
+//=====================================
+// Corpus
+//=====================================
+
+/**
+ * Parse one OUTPUT_POINTS line: IR,<ms>,x,y,size x4
+ * return false for anything else
+ */
+static bool parseFrame(const std::string& line, Frame& frame) {
+  if (line.compare(0, 3, "IR,") != 0) return false;
+  long values[13];
+  std::istringstream in(line.substr(3));
+  std::string field;
+  int count = 0;
+  while (count < 13 && std::getline(in, field, ',')) {
+    char* end = nullptr;
+    values[count] = strtol(field.c_str(), &end, 10);
+    if (end == field.c_str()) return false;
+    count++;
+  }
+  if (count != 13) return false;
+  frame.time = (uint32_t)values[0];
+  for (int i = 0; i < 4; i++) {
+    frame.x[i] = (int16_t)values[1 + i * 3];
+    frame.y[i] = (int16_t)values[2 + i * 3];
+    frame.size[i] = values[3 + i * 3] < 0 ? 0 : (uint8_t)values[3 + i * 3];
+    if (frame.y[i] < 0) frame.x[i] = -1;
+  }
+  return true;
+}
+
+static std::vector<std::string> listDirectory(const std::string& path, bool directories) {
+  std::vector<std::string> names;
+  DIR* dir = opendir(path.c_str());
+  if (!dir) return names;
+  while (dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] == '.') continue;
+    bool isDirectory = (entry->d_type == DT_DIR);
+    if (isDirectory == directories) names.push_back(entry->d_name);
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+bool loadCorpus(const std::string& directory, std::vector<Attempt>& attempts) {
+  for (const std::string& label : listDirectory(directory, true)) {
+    std::string spellDirectory = directory + "/" + label;
+    for (const std::string& file : listDirectory(spellDirectory, false)) {
+      std::ifstream in(spellDirectory + "/" + file);
+      Attempt attempt;
+      attempt.label = label;
+      attempt.source = label + "/" + file;
+      std::string line;
+      Frame frame;
+      while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (parseFrame(line, frame)) attempt.frames.push_back(frame);
+      }
+      if (!attempt.frames.empty()) attempts.push_back(attempt);
+    }
+  }
+  return !attempts.empty();
+}
+
+//=====================================
+// Synthetic Corpus
+//=====================================
+
+static Frame blobFrame(uint32_t time, int x, int y) {
+  Frame frame = {time, {-1, -1, -1, -1}, {-1, -1, -1, -1}, {0, 0, 0, 0}};
+  frame.x[0] = (int16_t)constrain(x, 0, 1022);
+  frame.y[0] = (int16_t)constrain(y, 0, 766);
+  frame.size[0] = 3;
+  return frame;
+}
+
+/**
+ * Hold, draw the path at ~100 Hz, then lower the wand
+ * path: Points in 0-1000 template space
+ */
+static Attempt drawAttempt(const std::string& label, const std::vector<Point>& path, std::mt19937& rng) {
+  std::normal_distribution<float> noise(0, 1);
+  std::uniform_real_distribution<float> unit(0, 1);
+  float size = 300 + 100 * unit(rng);
+  float a = 1 + 0.12f * noise(rng), b = 0.12f * noise(rng);
+  float c = 0.12f * noise(rng), d = 1 + 0.12f * noise(rng);
+  float originX = 512 - size / 2 + 60 * noise(rng);
+  float originY = 384 - size / 2 + 40 * noise(rng);
+
+  Attempt attempt;
+  attempt.label = label;
+  attempt.source = "synthetic";
+  uint32_t time = 0;
+  auto place = [&](const Point& p, float& x, float& y) {
+    x = originX + size * (a * p.x + b * p.y) / 1000;
+    y = originY + size * (c * p.x + d * p.y) / 1000;
+  };
+
+  // Hold still at the start point
+  float x, y;
+  place(path.front(), x, y);
+  for (; time < 800; time += 10) {
+    attempt.frames.push_back(blobFrame(time, x + noise(rng), y + noise(rng)));
+  }
+
+  // Draw: each template step is one 10 ms frame, with correlated jitter
+  float jitterX = 0, jitterY = 0;
+  for (const Point& p : path) {
+    place(p, x, y);
+    jitterX = 0.7f * jitterX + 3 * noise(rng);
+    jitterY = 0.7f * jitterY + 3 * noise(rng);
+    Frame frame = blobFrame(time, x + jitterX, y + jitterY);
+    float roll = unit(rng);
+    if (roll < 0.03f) {
+      frame.x[0] = frame.y[0] = -1;                  // Dropout
+    } else if (roll < 0.05f) {
+      frame.x[0] = (int16_t)(unit(rng) * 1000);      // Reflection
+      frame.y[0] = (int16_t)(unit(rng) * 760);
+    }
+    attempt.frames.push_back(frame);
+    time += 10;
+  }
+  // Wand lowered: the replay's trailing empty frames end the gesture
+  return attempt;
+}
+
+void synthesizeCorpus(int perSpell, uint32_t seed, std::vector<Attempt>& attempts) {
+  std::mt19937 rng(seed);
+  for (const SpellPattern& spell : spellPatterns) {
+    if (spell.anyOrder) continue;
+    std::vector<Point> path = exemplarPoints(spell, 0);
+    for (int i = 0; i < perSpell; i++) {
+      attempts.push_back(drawAttempt(spell.name, path, rng));
+    }
+  }
+
+  // Scribbles that shouldn't cast: smooth random walks
+  std::normal_distribution<float> noise(0, 1);
+  int scribbles = std::max(1, perSpell * (int)spellPatterns.size() / 10);
+  for (int i = 0; i < scribbles; i++) {
+    std::vector<Point> path;
+    float x = 500, y = 500, vx = 0, vy = 0;
+    for (int k = 0; k < 100; k++) {
+      vx = 0.9f * vx + 8 * noise(rng);
+      vy = 0.9f * vy + 8 * noise(rng);
+      x = constrain(x + vx, 0.0f, 1000.0f);
+      y = constrain(y + vy, 0.0f, 1000.0f);
+      path.push_back({(int)x, (int)y, 0});
+    }
+    attempts.push_back(drawAttempt("none", path, rng));
+  }
+}
+
+//=====================================
+// Replay
+//=====================================
+
+/**
+ * Feed one frame to readCameraData() at its time on the virtual clock
+ * Frames that fall inside a firmware delay() are skipped.
+ */
+static void replayFrame(const Frame& frame, uint32_t offset) {
+  uint32_t time = frame.time + offset;
+  if ((int32_t)(time - virtualTime) < 0) return;
+  virtualTime = time;
+  packFrame(frame);
+  readCameraData();
+}
+
+static double cpuMicros() {
+  timespec now;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+ReplayScore replayCorpus(const std::vector<Attempt>& attempts) {
+  ReplayScore score;
+  Frame empty = {0, {-1, -1, -1, -1}, {-1, -1, -1, -1}, {0, 0, 0, 0}};
+  firmwareRandom.seed(1);
+
+  for (const Attempt& attempt : attempts) {
+    // Recorded timestamps restart per file; continue from the clock
+    uint32_t offset = virtualTime + 10 - attempt.frames.front().time;
+    replayCast.clear();
+
+    double start = cpuMicros();
+    for (const Frame& frame : attempt.frames) {
+      replayFrame(frame, offset);
+    }
+    uint32_t end = virtualTime;
+    for (uint32_t t = 10; t <= 1500; t += 10) {
+      empty.time = end + t;
+      replayFrame(empty, 0);
+    }
+    score.cpuMicros += cpuMicros() - start;
+
+    score.attempts++;
+    if (replayCast.empty()) {
+      if (attempt.label == "none") score.correct++;
+    } else if (strcasecmp(replayCast.c_str(), attempt.label.c_str()) == 0) {
+      score.correct++;
+    } else {
+      score.wrongCasts++;
+    }
+  }
+  return score;
+}
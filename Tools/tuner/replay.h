@@ -0,0 +1,89 @@
+/*
+================================================================================
+  Replay - Gesture Corpus Through the Firmware State Machine
+================================================================================
+
+  Feeds recorded (or synthetic) camera frames to the firmware's own
+  readCameraData() on a virtual clock and collects what it does: the
+  spell it casts, or why it rejects the gesture.
+
+  Corpus Layout:
+    corpus/<Spell>/<any>.log   one cast attempt per file, labelled by its
+                               directory; "none" holds motion that should
+                               NOT cast anything
+    Files are serial logs from an OUTPUT_POINTS build ("IR,<ms>,x,y,size"
+    x4 per frame); other lines are ignored (record_corpus.py saves them)
+
+================================================================================
+*/
+
+#ifndef TUNER_REPLAY_H
+#define TUNER_REPLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//=====================================
+// Corpus
+//=====================================
+
+/**
+ * One camera frame: up to 4 blobs, x < 0 where none was seen
+ */
+struct Frame {
+  uint32_t time;
+  int16_t x[4];
+  int16_t y[4];
+  uint8_t size[4];
+};
+
+/**
+ * One cast attempt and the spell it was meant to be ("none" = no cast)
+ */
+struct Attempt {
+  std::string label;
+  std::string source;
+  std::vector<Frame> frames;
+};
+
+/**
+ * Load corpus/<Spell>/<attempt>.log
+ * return false if the directory can't be read or holds no attempts
+ */
+bool loadCorpus(const std::string& directory, std::vector<Attempt>& attempts);
+
+/**
+ * Synthetic attempts drawn from the built-in spells (for smoke tests)
+ * Hold still, draw the template with distortion, jitter, dropouts and the
+ * odd reflection, then lower the wand. A tenth as many "none" scribbles.
+ */
+void synthesizeCorpus(int perSpell, uint32_t seed, std::vector<Attempt>& attempts);
+
+//=====================================
+// Replay
+//=====================================
+
+/**
+ * Outcome of replaying a corpus under one configuration
+ */
+struct ReplayScore {
+  uint32_t attempts = 0;
+  uint32_t correct = 0;      ///< Right spell cast, or nothing cast for "none"
+  uint32_t wrongCasts = 0;   ///< A spell other than the label was cast
+  double cpuMicros = 0;      ///< CPU time inside readCameraData(), total
+};
+
+/**
+ * First spell cast during the attempt being replayed (empty if none)
+ * Set by the publishSpell() stub in firmware_stubs.cpp.
+ */
+extern std::string replayCast;
+
+/**
+ * Replay every attempt through readCameraData() under the current config
+ * Call initSpellPatterns() first if RESAMPLE_POINTS changed.
+ */
+ReplayScore replayCorpus(const std::vector<Attempt>& attempts);
+
+#endif // TUNER_REPLAY_H
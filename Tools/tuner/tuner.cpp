@@ -0,0 +1,471 @@
+/*
+================================================================================
+  Tuner - Gesture Parameter Search on Recorded Casts
+================================================================================
+
+  Replays a corpus of recorded casts through the firmware's own capture
+  state machine and matcher (cameraFunction, motionFilter, gestureSpotter,
+  spell_matching, spellIndex) under many parameter configurations, and
+  reports the trade-off between recognition accuracy and CPU cost.
+
+  Search:
+    1. The default configuration, plus the full grid of candidate values
+       if it has at most --samples configurations, otherwise --samples
+       random ones
+    2. --rounds refinement rounds: every configuration on the Pareto front
+       (no other is as accurate, with as few wrong casts, and as cheap,
+       and better in one of them) has each parameter moved one candidate
+       up and down, and the new neighbours evaluated
+    Configurations are spread over --jobs forked worker processes (the
+    firmware state is global, so workers are processes, not threads).
+
+  Metrics (per configuration):
+    - accuracy: labelled casts that cast their spell, plus "none" attempts
+                that cast nothing
+    - wrong:    casts of a different spell than the label
+    - us/cast:  host CPU time in readCameraData() per attempt - relative
+                cost only, the ESP32-S3 is far slower
+
+  Output:
+    The Pareto front, and --out (tuned.ini): a PlatformIO environment with
+    the cheapest front configuration that is at least as accurate as the
+    defaults (or --min-accuracy) and casts no more wrong spells (or
+    --max-wrong) - a wrong cast is a false home-automation trigger, so it
+    is never traded for speed. Build with it by adding to platformio.ini:
+      [platformio]
+      extra_configs = tuned.ini
+    then `pio run -e tuned`. The gesture thresholds are preferences: the
+    DEFAULT_* flags only seed devices without saved values, so reset them
+    on the web portal or enter the tuned values there.
+
+  Build (from this directory):
+    g++ -O2 -std=gnu++17 -DENV_PROD -include tuner_params.h -Ihost \
+        -I../match_bench/host -I../../Firmware/src \
+        tuner.cpp replay.cpp firmware_stubs.cpp \
+        ../../Firmware/src/cameraFunction.cpp ../../Firmware/src/motionFilter.cpp \
+        ../../Firmware/src/gestureSpotter.cpp ../../Firmware/src/spell_patterns.cpp \
+        ../../Firmware/src/spell_matching.cpp ../../Firmware/src/spellIndex.cpp \
+        ../../Firmware/src/spellActions.cpp ../../Firmware/src/spellCombos.cpp -o tuner
+
+  Usage:
+    ./tuner --corpus corpus              (see record_corpus.py)
+    ./tuner --synthetic 20               (casts drawn from the built-in
+                                          spells - a smoke test, not tuning)
+    Options: --samples N (600), --rounds N (3), --jobs N (all cores),
+             --min-accuracy PCT, --max-wrong PCT (defaults' rate),
+             --set NAME=v1,v2,... (candidate values), --seed N,
+             --out FILE (tuned.ini)
+
+================================================================================
+*/
+
+#include <Arduino.h>
+#include "replay.h"
+#include "preferenceFunctions.h"
+#include "spell_matching.h"
+#include "spellActions.h"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <set>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//=====================================
+// Parameters
+//=====================================
+
+/**
+ * One tunable: its candidate values and how to apply one
+ * flag: printf format of the -D build flag for a chosen value
+ */
+struct TunerParam {
+  const char* name;
+  const char* flag;
+  std::vector<double> values;
+  double defaultValue;
+  void (*apply)(double value);
+};
+
+static std::vector<TunerParam> params = {
+  {"MATCH_THRESHOLD", "MATCH_THRESHOLD=%.2f", {0.65, 0.70, 0.75, 0.80}, 0.75,
+   [](double v) { tunerMatchThreshold = (float)v; }},
+  {"RESAMPLE_POINTS", "RESAMPLE_POINTS=%.0f", {32, 48, 64, 100}, 100,
+   [](double v) { tunerResamplePoints = (int)v; }},
+  {"POSITION_WEIGHT", "POSITION_WEIGHT=%.2ff", {0.5, 0.6, 0.7}, 0.6,
+   [](double v) { tunerPositionWeight = (float)v; }},
+  {"POINT_JUMP_THRESHOLD", "POINT_JUMP_THRESHOLD=%.0f", {30, 40, 60}, 40,
+   [](double v) { tunerPointJump = (int)v; }},
+  {"MIN_BOUNDING_BOX_SIZE", "MIN_BOUNDING_BOX_SIZE=%.0f", {150, 200, 250}, 200,
+   [](double v) { tunerMinBoundingBox = (int)v; }},
+  {"MOVEMENT_THRESHOLD", "DEFAULT_MOVEMENT_THRESHOLD=%.0f", {10, 15, 25}, DEFAULT_MOVEMENT_THRESHOLD,
+   [](double v) { MOVEMENT_THRESHOLD = (int)v; }},
+  {"STILLNESS_THRESHOLD", "DEFAULT_STILLNESS_THRESHOLD=%.0f", {15, 20, 30}, DEFAULT_STILLNESS_THRESHOLD,
+   [](double v) { STILLNESS_THRESHOLD = (int)v; }},
+  {"READY_STILLNESS_TIME", "DEFAULT_READY_STILLNESS_TIME=%.0f", {400, 600}, DEFAULT_READY_STILLNESS_TIME,
+   [](double v) { READY_STILLNESS_TIME = (int)v; }},
+  {"IR_LOSS_TIMEOUT", "DEFAULT_IR_LOSS_TIMEOUT=%.0f", {200, 300, 400}, DEFAULT_IR_LOSS_TIMEOUT,
+   [](double v) { IR_LOSS_TIMEOUT = (int)v; }},
+  {"GESTURE_TIMEOUT", "DEFAULT_GESTURE_TIMEOUT=%.0f", {5000}, DEFAULT_GESTURE_TIMEOUT,
+   [](double v) { GESTURE_TIMEOUT = (int)v; }},
+};
+
+/// Candidate index per parameter
+typedef std::vector<uint8_t> Config;
+
+static Config defaultConfig() {
+  Config config;
+  for (const TunerParam& param : params) {
+    size_t index = 0;
+    for (size_t i = 0; i < param.values.size(); i++) {
+      if (param.values[i] == param.defaultValue) index = i;
+    }
+    config.push_back((uint8_t)index);
+  }
+  return config;
+}
+
+static void applyConfig(const Config& config) {
+  for (size_t p = 0; p < params.size(); p++) {
+    params[p].apply(params[p].values[config[p]]);
+  }
+  initSpellPatterns();  // Templates depend on RESAMPLE_POINTS
+  updateSpellActions();  // As loop() does between casts
+}
+
+/**
+ * Replace a parameter's candidates from NAME=v1,v2,...
+ * return false if the name is unknown or no values were given
+ */
+static bool setCandidates(const char* argument) {
+  std::string text(argument);
+  size_t equals = text.find('=');
+  if (equals == std::string::npos) return false;
+  std::string name = text.substr(0, equals);
+  for (TunerParam& param : params) {
+    if (name != param.name) continue;
+    param.values.clear();
+    const char* cursor = argument + equals + 1;
+    while (*cursor) {
+      char* end = nullptr;
+      double value = strtod(cursor, &end);
+      if (end == cursor) return false;
+      param.values.push_back(value);
+      cursor = (*end == ',') ? end + 1 : end;
+    }
+    // Always keep the default, so the baseline can be evaluated
+    if (std::find(param.values.begin(), param.values.end(), param.defaultValue) == param.values.end()) {
+      param.values.push_back(param.defaultValue);
+    }
+    std::sort(param.values.begin(), param.values.end());
+    return true;
+  }
+  return false;
+}
+
+//=====================================
+// Parallel Evaluation
+//=====================================
+
+struct Evaluation {
+  Config config;
+  ReplayScore score;
+
+  double accuracy() const { return 100.0 * score.correct / score.attempts; }
+  double wrong() const { return 100.0 * score.wrongCasts / score.attempts; }
+  double cost() const { return score.cpuMicros / score.attempts; }
+};
+
+/// Record a worker sends back per configuration
+struct WorkerResult {
+  uint32_t index;
+  ReplayScore score;
+};
+
+/**
+ * Evaluate configurations in forked workers, each taking every jobs-th one
+ * return One evaluation per configuration, in order
+ */
+static std::vector<Evaluation> evaluateAll(const std::vector<Config>& configs,
+                                           const std::vector<Attempt>& corpus, int jobs) {
+  std::vector<Evaluation> evaluations(configs.size());
+  for (size_t i = 0; i < configs.size(); i++) evaluations[i].config = configs[i];
+  jobs = std::max(1, std::min(jobs, (int)configs.size()));
+
+  fflush(stdout);
+  std::vector<int> pipes;
+  std::vector<pid_t> workers;
+  for (int worker = 0; worker < jobs; worker++) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+      perror("pipe");
+      exit(1);
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("fork");
+      exit(1);
+    }
+    if (pid == 0) {
+      close(fds[0]);
+      for (size_t i = worker; i < configs.size(); i += jobs) {
+        applyConfig(configs[i]);
+        WorkerResult result = {(uint32_t)i, replayCorpus(corpus)};
+        if (write(fds[1], &result, sizeof(result)) != (ssize_t)sizeof(result)) _exit(1);
+      }
+      _exit(0);
+    }
+    close(fds[1]);
+    pipes.push_back(fds[0]);
+    workers.push_back(pid);
+  }
+
+  // Results are small; reading the workers in turn can't stall them
+  size_t received = 0;
+  for (int fd : pipes) {
+    WorkerResult result;
+    while (read(fd, &result, sizeof(result)) == (ssize_t)sizeof(result)) {
+      evaluations[result.index].score = result.score;
+      received++;
+    }
+    close(fd);
+  }
+  for (pid_t pid : workers) waitpid(pid, nullptr, 0);
+  if (received != configs.size()) {
+    fprintf(stderr, "Only %zu of %zu configurations evaluated\n", received, configs.size());
+    exit(1);
+  }
+  return evaluations;
+}
+
+//=====================================
+// Search
+//=====================================
+
+/**
+ * Whether a is no worse than b on accuracy, wrong casts and cost, and
+ * better on at least one
+ */
+static bool dominates(const Evaluation& a, const Evaluation& b) {
+  if (a.accuracy() < b.accuracy() || a.wrong() > b.wrong() || a.cost() > b.cost()) return false;
+  return a.accuracy() > b.accuracy() || a.wrong() < b.wrong() || a.cost() < b.cost();
+}
+
+/**
+ * Configurations no other one dominates (see dominates())
+ * return Indices into evaluations, cheapest first
+ */
+static std::vector<size_t> paretoFront(const std::vector<Evaluation>& evaluations) {
+  std::vector<size_t> front;
+  for (size_t i = 0; i < evaluations.size(); i++) {
+    bool dominated = false;
+    for (size_t j = 0; j < evaluations.size() && !dominated; j++) {
+      dominated = dominates(evaluations[j], evaluations[i]);
+    }
+    if (!dominated) front.push_back(i);
+  }
+  std::sort(front.begin(), front.end(), [&](size_t a, size_t b) {
+    return evaluations[a].cost() < evaluations[b].cost();
+  });
+  return front;
+}
+
+static std::vector<Config> initialConfigs(int samples, std::mt19937& rng) {
+  std::vector<Config> configs = {defaultConfig()};
+  std::set<Config> seen(configs.begin(), configs.end());
+
+  double gridSize = 1;
+  for (const TunerParam& param : params) gridSize *= param.values.size();
+
+  if (gridSize <= samples) {
+    Config config(params.size(), 0);
+    while (true) {
+      if (seen.insert(config).second) configs.push_back(config);
+      size_t p = 0;
+      while (p < params.size() && ++config[p] == params[p].values.size()) config[p++] = 0;
+      if (p == params.size()) break;
+    }
+  } else {
+    // Duplicates are skipped; the attempt cap stops a tiny grid spinning
+    for (int attempt = 0; (int)configs.size() < samples && attempt < samples * 10; attempt++) {
+      Config config;
+      for (const TunerParam& param : params) config.push_back((uint8_t)(rng() % param.values.size()));
+      if (seen.insert(config).second) configs.push_back(config);
+    }
+  }
+  return configs;
+}
+
+static std::vector<Config> neighbours(const std::vector<Evaluation>& evaluations,
+                                      const std::vector<size_t>& front) {
+  std::set<Config> seen;
+  for (const Evaluation& evaluation : evaluations) seen.insert(evaluation.config);
+  std::vector<Config> configs;
+  for (size_t i : front) {
+    for (size_t p = 0; p < params.size(); p++) {
+      for (int step : {-1, 1}) {
+        Config config = evaluations[i].config;
+        int index = config[p] + step;
+        if (index < 0 || index >= (int)params[p].values.size()) continue;
+        config[p] = (uint8_t)index;
+        if (seen.insert(config).second) configs.push_back(config);
+      }
+    }
+  }
+  return configs;
+}
+
+//=====================================
+// Output
+//=====================================
+
+static std::string describe(const Config& config) {
+  std::string text;
+  char value[48];
+  for (size_t p = 0; p < params.size(); p++) {
+    if (params[p].values.size() < 2) continue;
+    snprintf(value, sizeof(value), "%s%s=%g", text.empty() ? "" : " ", params[p].name,
+             params[p].values[config[p]]);
+    text += value;
+  }
+  return text;
+}
+
+static bool writeIni(const char* path, const Evaluation& chosen, const Evaluation& baseline,
+                     const char* corpusName) {
+  FILE* out = fopen(path, "w");
+  if (!out) return false;
+  fprintf(out, "; Generated by Tools/tuner from %s (%u attempts)\n", corpusName, chosen.score.attempts);
+  fprintf(out, "; accuracy %.1f%% (defaults %.1f%%), wrong casts %.1f%% (defaults %.1f%%)\n",
+          chosen.accuracy(), baseline.accuracy(), chosen.wrong(), baseline.wrong());
+  fprintf(out, "; host CPU per attempt %.1f us (defaults %.1f us)\n", chosen.cost(), baseline.cost());
+  fprintf(out, ";\n; Use: add to platformio.ini\n;   [platformio]\n;   extra_configs = tuned.ini\n");
+  fprintf(out, "; and build env:tuned. DEFAULT_* values only seed devices without saved\n");
+  fprintf(out, "; gesture settings - reset them on the web portal or enter them there.\n\n");
+  fprintf(out, "[env:tuned]\nextends = env:prod\nbuild_flags =\n\t${env:prod.build_flags}\n");
+  for (size_t p = 0; p < params.size(); p++) {
+    double value = params[p].values[chosen.config[p]];
+    fprintf(out, "\t-D ");
+    fprintf(out, params[p].flag, value);
+    fprintf(out, "\n");
+    if (strcmp(params[p].name, "POSITION_WEIGHT") == 0) {
+      // The firmware's weights are independent constants; keep the sum at 1
+      fprintf(out, "\t-D DIRECTION_WEIGHT=%.2ff\n", 1.0 - value);
+    }
+  }
+  fclose(out);
+  return true;
+}
+
+//=====================================
+// Main
+//=====================================
+
+static void usage() {
+  fprintf(stderr,
+          "usage: tuner (--corpus DIR | --synthetic N) [--samples N] [--rounds N] [--jobs N]\n"
+          "             [--min-accuracy PCT] [--max-wrong PCT] [--set NAME=v1,v2,...]\n"
+          "             [--seed N] [--out FILE]\n");
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  const char* corpusDir = nullptr;
+  const char* out = "tuned.ini";
+  int synthetic = 0, samples = 600, rounds = 3;
+  int jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  double minAccuracy = 0;
+  double maxWrong = -1;  // Defaults' wrong-cast rate
+  uint32_t seed = 1;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option = argv[i];
+    if (i + 1 >= argc) usage();
+    const char* value = argv[++i];
+    if (option == "--corpus") corpusDir = value;
+    else if (option == "--synthetic") synthetic = atoi(value);
+    else if (option == "--samples") samples = atoi(value);
+    else if (option == "--rounds") rounds = atoi(value);
+    else if (option == "--jobs") jobs = atoi(value);
+    else if (option == "--min-accuracy") minAccuracy = atof(value);
+    else if (option == "--max-wrong") maxWrong = atof(value);
+    else if (option == "--seed") seed = (uint32_t)atoi(value);
+    else if (option == "--out") out = value;
+    else if (option == "--set") {
+      if (!setCandidates(value)) {
+        fprintf(stderr, "Bad --set %s\n", value);
+        usage();
+      }
+    } else usage();
+  }
+  if (!corpusDir == !synthetic) usage();
+
+  // Synthetic casts are drawn from the templates at the default settings
+  applyConfig(defaultConfig());
+  std::vector<Attempt> corpus;
+  if (corpusDir) {
+    if (!loadCorpus(corpusDir, corpus)) {
+      fprintf(stderr, "No attempts found in %s\n", corpusDir);
+      return 1;
+    }
+  } else {
+    synthesizeCorpus(synthetic, seed, corpus);
+  }
+  std::map<std::string, int> labels;
+  for (const Attempt& attempt : corpus) labels[attempt.label]++;
+  printf("%zu attempts, %zu labels, %d workers\n", corpus.size(), labels.size(), jobs);
+
+  std::mt19937 rng(seed);
+  std::vector<Evaluation> evaluations = evaluateAll(initialConfigs(samples, rng), corpus, jobs);
+  printf("initial: %zu configurations\n", evaluations.size());
+  for (int round = 1; round <= rounds; round++) {
+    std::vector<Config> next = neighbours(evaluations, paretoFront(evaluations));
+    if (next.empty()) break;
+    std::vector<Evaluation> refined = evaluateAll(next, corpus, jobs);
+    evaluations.insert(evaluations.end(), refined.begin(), refined.end());
+    printf("round %d: %zu neighbours of the front\n", round, next.size());
+  }
+
+  const Evaluation& baseline = evaluations[0];
+  std::vector<size_t> front = paretoFront(evaluations);
+  printf("\n%9s %7s %8s  configuration\n", "accuracy", "wrong", "us/cast");
+  printf("%8.1f%% %6.1f%% %8.1f  (defaults)\n", baseline.accuracy(), baseline.wrong(), baseline.cost());
+  for (size_t i : front) {
+    const Evaluation& e = evaluations[i];
+    printf("%8.1f%% %6.1f%% %8.1f  %s\n", e.accuracy(), e.wrong(), e.cost(), describe(e.config).c_str());
+  }
+
+  // Cheapest front configuration meeting both targets; failing that the
+  // most accurate one within the wrong-cast limit, else the defaults
+  double target = std::max(minAccuracy, baseline.accuracy());
+  double wrongLimit = maxWrong >= 0 ? maxWrong : baseline.wrong();
+  size_t chosen = SIZE_MAX;
+  for (size_t i : front) {
+    if (evaluations[i].wrong() <= wrongLimit && evaluations[i].accuracy() >= target) {
+      chosen = i;
+      break;
+    }
+  }
+  for (size_t i : front) {
+    if (chosen != SIZE_MAX && evaluations[chosen].accuracy() >= target) break;
+    if (evaluations[i].wrong() <= wrongLimit &&
+        (chosen == SIZE_MAX || evaluations[i].accuracy() > evaluations[chosen].accuracy())) {
+      chosen = i;
+    }
+  }
+  if (chosen == SIZE_MAX) {
+    printf("\nno configuration casts at most %.1f%% wrong spells - keeping the defaults\n", wrongLimit);
+    chosen = 0;
+  }
+  const Evaluation& best = evaluations[chosen];
+  printf("\nchosen: %.1f%% accuracy, %.1f%% wrong, %.1f us/cast (%.0f%% of defaults)\n", best.accuracy(),
+         best.wrong(), best.cost(), 100.0 * best.cost() / baseline.cost());
+
+  if (!writeIni(out, best, baseline, corpusDir ? corpusDir : "synthetic casts")) {
+    fprintf(stderr, "Can't write %s\n", out);
+    return 1;
+  }
+  printf("wrote %s\n", out);
+  return 0;
+}
@@ -0,0 +1,23 @@
+/*
+  Firmware compile-time tunables redirected to runtime variables.
+  Force-included into every firmware source (-include tuner_params.h) so
+  one build can replay any configuration; the firmware's #ifndef guards
+  then leave these definitions in place.
+*/
+#ifndef TUNER_PARAMS_H
+#define TUNER_PARAMS_H
+
+extern float tunerMatchThreshold;
+extern int tunerResamplePoints;
+extern float tunerPositionWeight;
+extern int tunerMinBoundingBox;
+extern int tunerPointJump;
+
+#define MATCH_THRESHOLD tunerMatchThreshold
+#define RESAMPLE_POINTS tunerResamplePoints
+#define POSITION_WEIGHT tunerPositionWeight
+#define DIRECTION_WEIGHT (1.0f - tunerPositionWeight)
+#define MIN_BOUNDING_BOX_SIZE tunerMinBoundingBox
+#define POINT_JUMP_THRESHOLD tunerPointJump
+
+#endif